@@ -21,6 +21,10 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 extern ENGINE_API ULONG crc_aulCRCTable[256];
 
+// [Cecil] Tables for adding multiple bytes at once (slicing-by-8)
+// Table under index N-1 contains CRC values of bytes followed by N zero bytes
+extern ENGINE_API ULONG crc_aulCRCSliceTables[7][256];
+
 // begin crc calculation
 inline void CRC_Start(ULONG &ulCRC) { ulCRC = 0xFFFFFFFF; };
 
@@ -30,30 +34,26 @@ inline void CRC_AddBYTE( ULONG &ulCRC, UBYTE ub)
   ulCRC = (ulCRC>>8)^crc_aulCRCTable[UBYTE(ulCRC)^ub];
 };
 
+// [Cecil] Values are added with the highest byte first, same as byte by byte, but all bytes are processed at once
 inline void CRC_AddWORD( ULONG &ulCRC, UWORD uw)
 {
-  CRC_AddBYTE(ulCRC, UBYTE(uw>> 8));
-  CRC_AddBYTE(ulCRC, UBYTE(uw>> 0));
+  ulCRC = (ulCRC>>16)
+    ^ crc_aulCRCSliceTables[0][UBYTE(ulCRC     ^(uw>>8))]
+    ^ crc_aulCRCTable         [UBYTE((ulCRC>>8)^(uw   ))];
 };
 
 inline void CRC_AddLONG( ULONG &ulCRC, ULONG ul)
 {
-  CRC_AddBYTE(ulCRC, UBYTE(ul>>24));
-  CRC_AddBYTE(ulCRC, UBYTE(ul>>16));
-  CRC_AddBYTE(ulCRC, UBYTE(ul>> 8));
-  CRC_AddBYTE(ulCRC, UBYTE(ul>> 0));
+  ulCRC = crc_aulCRCSliceTables[2][UBYTE(ulCRC      ^(ul>>24))]
+        ^ crc_aulCRCSliceTables[1][UBYTE((ulCRC>> 8)^(ul>>16))]
+        ^ crc_aulCRCSliceTables[0][UBYTE((ulCRC>>16)^(ul>> 8))]
+        ^ crc_aulCRCTable         [UBYTE((ulCRC>>24)^(ul    ))];
 };
 
 inline void CRC_AddLONGLONG(ULONG &ulCRC, UQUAD ul)
 {
-  CRC_AddBYTE(ulCRC, UBYTE(ul >> 56));
-  CRC_AddBYTE(ulCRC, UBYTE(ul >> 48));
-  CRC_AddBYTE(ulCRC, UBYTE(ul >> 40));
-  CRC_AddBYTE(ulCRC, UBYTE(ul >> 32));
-  CRC_AddBYTE(ulCRC, UBYTE(ul >> 24));
-  CRC_AddBYTE(ulCRC, UBYTE(ul >> 16));
-  CRC_AddBYTE(ulCRC, UBYTE(ul >>  8));
-  CRC_AddBYTE(ulCRC, UBYTE(ul >>  0));
+  CRC_AddLONG(ulCRC, ULONG(ul >> 32));
+  CRC_AddLONG(ulCRC, ULONG(ul >>  0));
 };
 
 inline void CRC_AddFLOAT(ULONG &ulCRC, FLOAT f)
@@ -62,11 +62,16 @@ inline void CRC_AddFLOAT(ULONG &ulCRC, FLOAT f)
 };
 
 // add memory block to a CRC value
-inline void CRC_AddBlock(ULONG &ulCRC, UBYTE *pubBlock, ULONG ulSize)
+// [Cecil] Processes 8 bytes at once
+ENGINE_API void CRC_AddBlock(ULONG &ulCRC, const UBYTE *pubBlock, ULONG ulSize);
+
+// [Cecil] Add an array of longs, same as adding them one by one
+ENGINE_API void CRC_AddLONGs(ULONG &ulCRC, const ULONG *pul, INDEX ct);
+
+// [Cecil] Add an array of floats, same as adding them one by one
+inline void CRC_AddFLOATs(ULONG &ulCRC, const FLOAT *pf, INDEX ct)
 {
-  for (ULONG i = 0; i < ulSize; i++) {
-    CRC_AddBYTE(ulCRC, pubBlock[i]);
-  }
+  CRC_AddLONGs(ulCRC, (const ULONG *)pf, ct);
 };
 
 // end crc calculation
@@ -0,0 +1,212 @@
+/* Copyright (c) 2026 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "StdH.h"
+
+#include <Engine/Base/Jobs.h>
+#include <Engine/Base/Profiling.h>
+
+// Worker threads require C++11 multithreading
+#define SE1_JOB_THREADS (!SE1_SINGLE_THREAD && !SE1_INCOMPLETE_CPP11)
+
+#if SE1_JOB_THREADS
+  #include <atomic>
+  #include <condition_variable>
+  #include <mutex>
+  #include <thread>
+#endif
+
+// Amount of threads for parallel loops (0 - one per CPU core; 1 - only the calling thread)
+INDEX sys_iJobThreads = 0;
+
+// Index of the job thread that's running on this thread (0 for any non-worker thread)
+static SE1_THREADLOCAL INDEX _iThisJobThread = 0;
+
+#if SE1_JOB_THREADS
+
+// One running parallel loop
+struct ParallelLoop_t {
+  FJobFunc pFunc;
+  void *pvData;
+  INDEX ctItems;
+  INDEX ctBatch;
+  std::atomic<INDEX> iNextItem;
+};
+
+static std::mutex _mtxDispatch; // Held by the thread that runs a parallel loop
+static std::mutex _mtxWorkers; // Access to the worker state below
+static std::condition_variable _cvStart; // Workers wait on it for a new loop
+static std::condition_variable _cvDone; // Dispatching thread waits on it for workers to finish
+
+static std::thread *_apthrWorkers[JOB_MAX_THREADS];
+static INDEX _ctWorkers = 0;
+static ParallelLoop_t *_pplCurrent = NULL;
+static ULONG _ulLoopCount = 0; // Incremented for each new loop
+static INDEX _ctBusyWorkers = 0;
+static BOOL _bStopWorkers = FALSE;
+
+// Process batches of a loop until there are no more items
+static void ProcessBatches(ParallelLoop_t &pl, INDEX iThread) {
+  PRF_ZONE("JobBatches");
+
+  for (;;) {
+    const INDEX iFirst = pl.iNextItem.fetch_add(pl.ctBatch);
+    if (iFirst >= pl.ctItems) break;
+
+    pl.pFunc(pl.pvData, iFirst, Min(pl.ctBatch, pl.ctItems - iFirst), iThread);
+  }
+};
+
+// Worker starts waiting for loops after the last one that was started before its creation
+static void WorkerThread(INDEX iThread, ULONG ulLastLoop) {
+  _iThisJobThread = iThread;
+
+  std::unique_lock<std::mutex> lock(_mtxWorkers);
+
+  for (;;) {
+    // Wait for a new loop
+    while (!_bStopWorkers && ulLastLoop == _ulLoopCount) {
+      _cvStart.wait(lock);
+    }
+
+    if (_bStopWorkers) break;
+
+    ulLastLoop = _ulLoopCount;
+    ParallelLoop_t *ppl = _pplCurrent;
+
+    lock.unlock();
+    ProcessBatches(*ppl, iThread);
+    lock.lock();
+
+    // Last one to finish wakes up the dispatching thread
+    if (--_ctBusyWorkers == 0) {
+      _cvDone.notify_one();
+    }
+  }
+};
+
+// Stop workers without locking the dispatching mutex
+static void StopWorkers(void) {
+  if (_ctWorkers == 0) return;
+
+  {
+    std::lock_guard<std::mutex> lock(_mtxWorkers);
+    _bStopWorkers = TRUE;
+  }
+
+  _cvStart.notify_all();
+
+  for (INDEX i = 0; i < _ctWorkers; i++) {
+    _apthrWorkers[i]->join();
+    delete _apthrWorkers[i];
+    _apthrWorkers[i] = NULL;
+  }
+
+  _ctWorkers = 0;
+  _bStopWorkers = FALSE;
+};
+
+// Make sure that there's a specific amount of workers
+static void PrepareWorkers(INDEX ctWorkers) {
+  if (_ctWorkers == ctWorkers) return;
+
+  StopWorkers();
+
+  // Thread index 0 is reserved for the dispatching thread
+  for (INDEX i = 0; i < ctWorkers; i++) {
+    _apthrWorkers[i] = new std::thread(WorkerThread, i + 1, _ulLoopCount);
+  }
+
+  _ctWorkers = ctWorkers;
+};
+
+#endif // SE1_JOB_THREADS
+
+namespace IJobs {
+
+INDEX GetThreadCount(void) {
+#if SE1_JOB_THREADS
+  INDEX ct = sys_iJobThreads;
+
+  if (ct <= 0) {
+    ct = (INDEX)std::thread::hardware_concurrency();
+  }
+
+  return Clamp(ct, (INDEX)1, (INDEX)JOB_MAX_THREADS);
+
+#else
+  return 1;
+#endif
+};
+
+void ParallelFor(INDEX ctItems, INDEX ctBatch, FJobFunc pFunc, void *pvData) {
+  if (ctItems <= 0) return;
+
+  ctBatch = ClampDn(ctBatch, (INDEX)1);
+
+#if SE1_JOB_THREADS
+  const INDEX ctThreads = GetThreadCount();
+
+  // Run in parallel if there's enough work and no other loop is running
+  if (ctThreads > 1 && ctItems > ctBatch) {
+    std::unique_lock<std::mutex> lockDispatch(_mtxDispatch, std::try_to_lock);
+
+    if (lockDispatch.owns_lock()) {
+      PrepareWorkers(ctThreads - 1);
+
+      ParallelLoop_t pl;
+      pl.pFunc = pFunc;
+      pl.pvData = pvData;
+      pl.ctItems = ctItems;
+      pl.ctBatch = ctBatch;
+      pl.iNextItem = 0;
+
+      // Wake up the workers
+      {
+        std::lock_guard<std::mutex> lock(_mtxWorkers);
+        _pplCurrent = &pl;
+        _ctBusyWorkers = _ctWorkers;
+        _ulLoopCount++;
+      }
+
+      _cvStart.notify_all();
+
+      // Help with the loop and wait for the workers
+      ProcessBatches(pl, 0);
+
+      std::unique_lock<std::mutex> lock(_mtxWorkers);
+
+      while (_ctBusyWorkers > 0) {
+        _cvDone.wait(lock);
+      }
+
+      _pplCurrent = NULL;
+      return;
+    }
+  }
+#endif
+
+  // Process everything on the calling thread
+  pFunc(pvData, 0, ctItems, _iThisJobThread);
+};
+
+void Shutdown(void) {
+#if SE1_JOB_THREADS
+  std::lock_guard<std::mutex> lockDispatch(_mtxDispatch);
+  StopWorkers();
+#endif
+};
+
+}; // namespace
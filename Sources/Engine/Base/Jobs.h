@@ -0,0 +1,47 @@
+/* Copyright (c) 2026 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef SE_INCL_JOBS_H
+#define SE_INCL_JOBS_H
+
+#ifdef PRAGMA_ONCE
+  #pragma once
+#endif
+
+// Maximum amount of threads that can process jobs (including the calling thread)
+#define JOB_MAX_THREADS 32
+
+// Function that processes a range of items of a parallel loop
+// Thread index is always less than IJobs::GetThreadCount() and can be used for selecting per-thread buffers
+// (index 0 is shared by all threads that aren't workers, so loops with such buffers should only be started from one of them)
+typedef void (*FJobFunc)(void *pvData, INDEX iFirst, INDEX ctItems, INDEX iThread);
+
+// Pool of worker threads for splitting independent work between CPU cores
+namespace IJobs {
+
+// Get amount of threads that process parallel loops (including the calling thread)
+ENGINE_API INDEX GetThreadCount(void);
+
+// Process items in batches on all threads and wait until all of them are done
+// Items are processed on the calling thread only if there's just one batch, if threads are disabled
+// or if another parallel loop is already running (e.g. when called from within a job)
+ENGINE_API void ParallelFor(INDEX ctItems, INDEX ctBatch, FJobFunc pFunc, void *pvData);
+
+// Stop all worker threads
+ENGINE_API void Shutdown(void);
+
+}; // namespace
+
+#endif // include-once check
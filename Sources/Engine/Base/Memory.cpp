@@ -19,6 +19,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Base/Translation.h>
 
 #include <Engine/Base/ErrorReporting.h>
+#include <Engine/Base/Console.h>
 
 #if SE1_WIN
   // [Cecil] Undefine debug operator
@@ -39,6 +40,108 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 FLOAT _bCheckAllAllocations = FALSE;
 
+#if SE1_MEMORY_TRACKING
+
+// [Cecil] Counters of different tags are kept on separate cache lines, so threads that allocate
+// memory under different tags don't invalidate each other's counters
+#define MEMORY_CACHE_LINE 64
+
+#if !SE1_INCOMPLETE_CPP11
+  #include <atomic>
+  typedef std::atomic<SQUAD> MemoryCounter_t;
+  #define MEMORY_COUNTERS_ALIGN alignas(MEMORY_CACHE_LINE)
+
+  // Counters don't guard any other memory, so they don't need to be ordered
+  #define MEMORY_ADD(_Counter, _Value) ((_Counter).fetch_add(_Value, std::memory_order_relaxed) + (_Value))
+  #define MEMORY_LOAD(_Counter) ((_Counter).load(std::memory_order_relaxed))
+#else
+  typedef SQUAD MemoryCounter_t;
+  #define MEMORY_COUNTERS_ALIGN
+
+  #define MEMORY_ADD(_Counter, _Value) ((_Counter) += (_Value))
+  #define MEMORY_LOAD(_Counter) (_Counter)
+#endif
+
+// [Cecil] Counters of one memory tag
+// These are zero-initialized before any allocations that happen during static initialization
+struct MEMORY_COUNTERS_ALIGN MemoryTagCounters_t {
+  MemoryCounter_t llLiveBytes;
+  MemoryCounter_t llPeakBytes;
+  MemoryCounter_t ctAllocations;
+  MemoryCounter_t ctFrees; // Live blocks are counted from allocations and frees
+
+  // Fill the rest of the cache line
+  UBYTE aubPadding[MEMORY_CACHE_LINE - 4 * sizeof(MemoryCounter_t)];
+};
+
+static MemoryTagCounters_t _amtcTags[MEM_TAG_COUNT];
+
+// [Cecil] Header in front of each allocated block
+struct MemoryHeader_t {
+  size_t mh_size;
+  INDEX mh_iTag;
+};
+
+// [Cecil] Header size that keeps memory after it aligned like it would be from malloc()
+#define MEMORY_HEADER_SIZE 16
+
+// [Cecil] Header must fit and memory after it must stay aligned for any type
+#if !SE1_INCOMPLETE_CPP11
+  #include <cstddef>
+  static_assert(sizeof(MemoryHeader_t) <= MEMORY_HEADER_SIZE, "Memory header doesn't fit into MEMORY_HEADER_SIZE");
+  static_assert(MEMORY_HEADER_SIZE % alignof(std::max_align_t) == 0, "MEMORY_HEADER_SIZE breaks alignment of allocated memory");
+#else
+  typedef char MemoryHeaderFits_t[(sizeof(MemoryHeader_t) <= MEMORY_HEADER_SIZE) ? 1 : -1];
+  typedef char MemoryHeaderAligned_t[(MEMORY_HEADER_SIZE % sizeof(DOUBLE) == 0) ? 1 : -1];
+#endif
+
+// [Cecil] Remember size and tag of a new block and return memory after its header
+static void *TrackBlock(void *pvBlock, size_t memsize, INDEX iTag)
+{
+  MemoryHeader_t *pmh = (MemoryHeader_t *)pvBlock;
+  pmh->mh_size = memsize;
+  pmh->mh_iTag = iTag;
+
+  MemoryTagCounters_t &mtc = _amtcTags[iTag];
+  const SQUAD llLive = MEMORY_ADD(mtc.llLiveBytes, (SQUAD)memsize);
+  MEMORY_ADD(mtc.ctAllocations, 1);
+
+  // Raise the peak (only written while it's actually being exceeded)
+#if !SE1_INCOMPLETE_CPP11
+  SQUAD llPeak = MEMORY_LOAD(mtc.llPeakBytes);
+  while (llLive > llPeak && !mtc.llPeakBytes.compare_exchange_weak(llPeak, llLive, std::memory_order_relaxed));
+#else
+  if (llLive > mtc.llPeakBytes) mtc.llPeakBytes = llLive;
+#endif
+
+  return (UBYTE *)pvBlock + MEMORY_HEADER_SIZE;
+}
+
+// [Cecil] Forget about a block and return the actual allocated memory
+static void *UntrackBlock(void *pvMemory, INDEX &iTag)
+{
+  MemoryHeader_t *pmh = (MemoryHeader_t *)((UBYTE *)pvMemory - MEMORY_HEADER_SIZE);
+  iTag = pmh->mh_iTag;
+  ASSERT(iTag >= 0 && iTag < MEM_TAG_COUNT);
+
+  MemoryTagCounters_t &mtc = _amtcTags[iTag];
+  MEMORY_ADD(mtc.llLiveBytes, -(SQUAD)pmh->mh_size);
+  MEMORY_ADD(mtc.ctFrees, 1);
+
+  return pmh;
+}
+
+#else
+  #define MEMORY_HEADER_SIZE 0
+#endif // SE1_MEMORY_TRACKING
+
+// [Cecil] Tag for untagged allocations on this thread
+static SE1_THREADLOCAL INDEX _iMemoryTag = MEM_GENERAL;
+
+// [Cecil] Allocations before the last frame and during it
+static SQUAD _ctAllocationsBeforeFrame = 0;
+static INDEX _ctFrameAllocations = 0;
+
 #if SE1_WIN
 
 /*
@@ -101,18 +204,29 @@ CMemHandlerInit::CMemHandlerInit(void)
 #undef AllocMemory
 
 void *AllocMemory(size_t memsize)
+{
+  // [Cecil] Count under the current tag of this thread
+  return AllocMemoryTagged(memsize, _iMemoryTag);
+}
+
+// [Cecil] Allocate a block of memory for a specific subsystem
+void *AllocMemoryTagged(size_t memsize, INDEX iTag)
 {
   void *pmem;
   ASSERTMSG(memsize>0, "AllocMemory: Block size is less or equal zero.");
+  ASSERT(iTag >= 0 && iTag < MEM_TAG_COUNT);
   if (_bCheckAllAllocations) {
     _CrtCheckMemory();
   }
-  pmem = malloc( memsize);
+  pmem = malloc( memsize + MEMORY_HEADER_SIZE);
   // memory handler asures no null results here?!
   if (pmem==NULL) {
     _CrtCheckMemory();
     FatalError(TRANS("Not enough memory (%d bytes needed)!"), memsize);
   }
+#if SE1_MEMORY_TRACKING
+  pmem = TrackBlock(pmem, memsize, iTag);
+#endif
   return pmem;
 }
 
@@ -126,12 +240,15 @@ void *_debug_AllocMemory(size_t memsize, int iType, const char *strFile, int iLi
   if (_bCheckAllAllocations) {
     _CrtCheckMemory();
   }
-  pmem = _malloc_dbg( memsize, iType, strFile, iLine);
+  pmem = _malloc_dbg( memsize + MEMORY_HEADER_SIZE, iType, strFile, iLine);
   // memory handler asures no null results here?!
   if (pmem==NULL) {
     _CrtCheckMemory();
     FatalError(TRANS("Not enough memory (%d bytes needed)!"), memsize);
   }
+#if SE1_MEMORY_TRACKING
+  pmem = TrackBlock(pmem, memsize, _iMemoryTag);
+#endif
   return pmem;
 }
 
@@ -154,6 +271,10 @@ void FreeMemoryAligned(void *memory)
 void FreeMemory(void *memory )
 {
   ASSERTMSG(memory!=NULL, "FreeMemory: NULL pointer input.");
+#if SE1_MEMORY_TRACKING
+  INDEX iTag;
+  memory = UntrackBlock(memory, iTag);
+#endif
   free((char *)memory);
 }
 
@@ -162,12 +283,27 @@ void ResizeMemory(void **ppv, size_t slSize)
   if (_bCheckAllAllocations) {
     _CrtCheckMemory();
   }
+#if SE1_MEMORY_TRACKING
+  // [Cecil] Keep the tag of the existing block
+  INDEX iTag = _iMemoryTag;
+  void *pvBlock = NULL;
+
+  if (*ppv != NULL) {
+    pvBlock = UntrackBlock(*ppv, iTag);
+  }
+
+  void *pv = realloc(pvBlock, slSize + MEMORY_HEADER_SIZE);
+#else
   void *pv = realloc(*ppv, slSize);
+#endif
   // memory handler asures no null results here?!
   if (pv==NULL) {
     _CrtCheckMemory();
     FatalError(TRANS("Not enough memory (%d bytes needed)!"), slSize);
   }
+#if SE1_MEMORY_TRACKING
+  pv = TrackBlock(pv, slSize, iTag);
+#endif
   *ppv = pv;
 }
 
@@ -204,3 +340,85 @@ INDEX FindZero( UBYTE *pubMemory, INDEX iBytes)
   for( INDEX i=0; i<iBytes; i++) if( pubMemory[i]==0) return i;
   return iBytes;
 }
+
+// [Cecil] Set tag for untagged allocations on the current thread and return the previous one
+INDEX SetMemoryTag(INDEX iTag)
+{
+  ASSERT(iTag >= 0 && iTag < MEM_TAG_COUNT);
+  const INDEX iPrevious = _iMemoryTag;
+  _iMemoryTag = iTag;
+  return iPrevious;
+}
+
+// [Cecil] Get memory counted for some tag
+void GetMemoryTagStats(INDEX iTag, MemoryTagStats_t &mts)
+{
+  ASSERT(iTag >= 0 && iTag < MEM_TAG_COUNT);
+
+#if SE1_MEMORY_TRACKING
+  const MemoryTagCounters_t &mtc = _amtcTags[iTag];
+  mts.llLiveBytes = MEMORY_LOAD(mtc.llLiveBytes);
+  mts.llPeakBytes = MEMORY_LOAD(mtc.llPeakBytes);
+  mts.ctAllocations = MEMORY_LOAD(mtc.ctAllocations);
+  mts.ctLiveBlocks = mts.ctAllocations - MEMORY_LOAD(mtc.ctFrees);
+#else
+  memset(&mts, 0, sizeof(mts));
+#endif
+}
+
+// [Cecil] Remember how many allocations have been made since the last frame
+void MarkMemoryFrame(void)
+{
+  SQUAD ctAllocations = 0;
+
+  for (INDEX iTag = 0; iTag < MEM_TAG_COUNT; iTag++) {
+    MemoryTagStats_t mts;
+    GetMemoryTagStats(iTag, mts);
+    ctAllocations += mts.ctAllocations;
+  }
+
+  _ctFrameAllocations = INDEX(ctAllocations - _ctAllocationsBeforeFrame);
+  _ctAllocationsBeforeFrame = ctAllocations;
+}
+
+// [Cecil] Get amount of allocations made during the last frame
+INDEX GetFrameAllocations(void)
+{
+  return _ctFrameAllocations;
+}
+
+// [Cecil] Print memory counted for each tag
+void MemoryInfo(void)
+{
+#if SE1_MEMORY_TRACKING
+  static const char *astrTags[MEM_TAG_COUNT] = {
+    "General", "Textures", "Shadows", "Network", "Entities", "SKA",
+  };
+
+  const DOUBLE dToMB = 1.0 / (1024.0 * 1024.0);
+  MemoryTagStats_t mtsTotal;
+  memset(&mtsTotal, 0, sizeof(mtsTotal));
+
+  CPrintF("%-10s %10s %10s %10s %12s\n", "Tag", "Live MB", "Peak MB", "Blocks", "Allocations");
+
+  for (INDEX iTag = 0; iTag < MEM_TAG_COUNT; iTag++) {
+    MemoryTagStats_t mts;
+    GetMemoryTagStats(iTag, mts);
+
+    CPrintF("%-10s %10.2f %10.2f %10d %12.0f\n", astrTags[iTag], mts.llLiveBytes * dToMB, mts.llPeakBytes * dToMB,
+      (INDEX)mts.ctLiveBlocks, (DOUBLE)mts.ctAllocations);
+
+    mtsTotal.llLiveBytes += mts.llLiveBytes;
+    mtsTotal.ctLiveBlocks += mts.ctLiveBlocks;
+    mtsTotal.ctAllocations += mts.ctAllocations;
+  }
+
+  CPrintF("%-10s %10.2f %10s %10d %12.0f\n", "Total", mtsTotal.llLiveBytes * dToMB, "",
+    (INDEX)mtsTotal.ctLiveBlocks, (DOUBLE)mtsTotal.ctAllocations);
+
+  CPrintF(TRANS("Allocations during the last frame: %d\n"), GetFrameAllocations());
+
+#else
+  CPrintF(TRANS("Memory isn't being tracked in this build\n"));
+#endif
+}
@@ -21,6 +21,26 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include <Engine/Base/Types.h>
 
+// [Cecil] Subsystems that allocated memory is counted for
+enum EMemoryTag {
+  MEM_GENERAL = 0,
+  MEM_TEXTURES,
+  MEM_SHADOWS,
+  MEM_NETWORK,
+  MEM_ENTITIES,
+  MEM_SKA,
+
+  MEM_TAG_COUNT,
+};
+
+// [Cecil] Memory counted for one tag
+struct MemoryTagStats_t {
+  SQUAD llLiveBytes;   // Bytes in blocks that haven't been freed yet
+  SQUAD llPeakBytes;   // Most live bytes at any point
+  SQUAD ctLiveBlocks;  // Blocks that haven't been freed yet
+  SQUAD ctAllocations; // All allocations and reallocations so far
+};
+
 // global memory management functions
 
 /* Get amount of free memory in system. */
@@ -28,6 +48,8 @@ ENGINE_API extern SLONG GetFreeMemory( void );
 
 /* Allocate a block of memory - fatal error if not enough memory. */
 ENGINE_API extern void *AllocMemory(size_t memsize );
+// [Cecil] Allocate a block of memory for a specific subsystem
+ENGINE_API extern void *AllocMemoryTagged(size_t memsize, INDEX iTag);
 ENGINE_API extern void *_debug_AllocMemory(size_t memsize, int iType, const char *strFile, int iLine);
 ENGINE_API extern void *AllocMemoryAligned(size_t memsize, SLONG slAlignPow2);
 /* Free a block of memory. */
@@ -47,6 +69,30 @@ ENGINE_API extern BOOL AllMemoryFreed( void );
 // return position (offset) where we encounter zero byte or iBytes
 ENGINE_API extern INDEX FindZero( UBYTE *pubMemory, INDEX iBytes);
 
+// [Cecil] Set tag for untagged allocations on the current thread and return the previous one
+ENGINE_API extern INDEX SetMemoryTag(INDEX iTag);
+// [Cecil] Get memory counted for some tag
+ENGINE_API extern void GetMemoryTagStats(INDEX iTag, MemoryTagStats_t &mts);
+// [Cecil] Remember how many allocations have been made since the last frame
+ENGINE_API extern void MarkMemoryFrame(void);
+// [Cecil] Get amount of allocations made during the last frame
+ENGINE_API extern INDEX GetFrameAllocations(void);
+
+// [Cecil] Count untagged allocations on the current thread under some tag while in scope
+class CMemoryTagScope {
+  private:
+    INDEX mts_iPrevious;
+
+  public:
+    inline CMemoryTagScope(INDEX iTag) {
+      mts_iPrevious = SetMemoryTag(iTag);
+    };
+
+    inline ~CMemoryTagScope() {
+      SetMemoryTag(mts_iPrevious);
+    };
+};
+
 
 #if SE1_WIN
 #ifndef NDEBUG
@@ -16,6 +16,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "StdH.h"
 
 #include <Engine/Base/Profiling.h>
+#include <Engine/Base/Stream.h>
+#include <Engine/Base/Synchronization.h>
 
 /////////////////////////////////////////////////////////////////////
 // CProfileForm
@@ -193,6 +195,12 @@ void CProfileForm::StopTimer_internal(INDEX iTimer)
   if (pf_ctRunningTimers==0) {
     pf_tvOverAllElapsed += tvNow-pf_tvOverAllStarted;
   }
+  // [Cecil] Nest the timer inside the current zone (corrected times drift away from the real time)
+  if (prf_bTimeline) {
+    const SQUAD llEnd = _pTimer->GetHighPrecisionTimer().tv_llValue;
+    IProfileTimeline::AddZone(pt.pt_strName.ConstData(), llEnd - (tvNow - pt.pt_tvStarted).tv_llValue, llEnd);
+  }
+
   IFDEBUG(pt.pt_tvStarted.tv_llValue = SQUAD(-1));
   _tvCurrentProfilingEpsilon += _tvStopEpsilon;
 }
@@ -352,3 +360,138 @@ void CProfileForm::Report(CTString &strReport)
   // return the buffer
   strReport = aBuffer;
 }
+
+/////////////////////////////////////////////////////////////////////
+// [Cecil] Timeline of profiling zones
+
+INDEX prf_bTimeline = FALSE;
+
+// One zone that has ended
+struct TimelineZone_t {
+  const char *strName;
+  SQUAD llStart;
+  SQUAD llEnd;
+};
+
+// Ring buffer of zones from one thread
+struct TimelineThread_t {
+  TimelineZone_t atzZones[PRF_TIMELINE_EVENTS];
+  ULONG ulAdded; // Zones added since the start (the oldest ones are overwritten)
+};
+
+static CTCriticalSection _csProfileTimeline; // Threads register their timelines under this lock
+static TimelineThread_t *_apttThreads[PRF_TIMELINE_THREADS];
+static INDEX _ctTimelineThreads = 0;
+
+static SE1_THREADLOCAL TimelineThread_t *_pttThisThread = NULL;
+static SE1_THREADLOCAL BOOL _bNoTimelineSlots = FALSE;
+
+// Starts of the last frames
+static SQUAD _allFrameStarts[PRF_TIMELINE_FRAMES];
+static ULONG _ulFramesMarked = 0;
+
+// Get timeline of the current thread
+static TimelineThread_t *GetThreadTimeline(void) {
+  if (_pttThisThread != NULL || _bNoTimelineSlots) return _pttThisThread;
+
+  CTSingleLock slTimeline(&_csProfileTimeline, TRUE);
+
+  if (_ctTimelineThreads >= PRF_TIMELINE_THREADS) {
+    _bNoTimelineSlots = TRUE;
+    return NULL;
+  }
+
+  // Buffers are kept until the end, so that zones of finished threads can still be dumped
+  _pttThisThread = new TimelineThread_t;
+  _pttThisThread->ulAdded = 0;
+  _apttThreads[_ctTimelineThreads++] = _pttThisThread;
+
+  return _pttThisThread;
+};
+
+namespace IProfileTimeline {
+
+void Init(void) {
+  _csProfileTimeline.cs_eIndex = EThreadMutexType::E_MTX_IGNORE;
+};
+
+void AddZone(const char *strName, SQUAD llStart, SQUAD llEnd) {
+  TimelineThread_t *ptt = GetThreadTimeline();
+  if (ptt == NULL) return;
+
+  TimelineZone_t &tz = ptt->atzZones[ptt->ulAdded % PRF_TIMELINE_EVENTS];
+  tz.strName = strName;
+  tz.llStart = llStart;
+  tz.llEnd = llEnd;
+  ptt->ulAdded++;
+};
+
+void MarkFrame(void) {
+  if (!prf_bTimeline) return;
+
+  const SQUAD llNow = _pTimer->GetHighPrecisionTimer().tv_llValue;
+
+  // Add the whole previous frame as a zone
+  if (_ulFramesMarked > 0) {
+    AddZone("Frame", _allFrameStarts[(_ulFramesMarked - 1) % PRF_TIMELINE_FRAMES], llNow);
+  }
+
+  _allFrameStarts[_ulFramesMarked % PRF_TIMELINE_FRAMES] = llNow;
+  _ulFramesMarked++;
+};
+
+void Dump_t(const CTString &fnm, INDEX ctFrames) {
+  if (_ulFramesMarked == 0) ThrowF_t(TRANS("No frames have been recorded"));
+
+  // Start from the oldest requested frame that is still known
+  const ULONG ulFrames = ClampUp((ULONG)ClampDn(ctFrames, (INDEX)1), ClampUp(_ulFramesMarked, (ULONG)PRF_TIMELINE_FRAMES));
+  const SQUAD llFrom = _allFrameStarts[(_ulFramesMarked - ulFrames) % PRF_TIMELINE_FRAMES];
+
+  CTFileStream strm;
+  strm.Create_t(fnm);
+  strm.PutString_t("{\"traceEvents\":[\n");
+  strm.FPrintF_t("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"Serious Engine\"}}");
+
+  CTSingleLock slTimeline(&_csProfileTimeline, TRUE);
+  INDEX ctZones = 0;
+
+  for (INDEX iThread = 0; iThread < _ctTimelineThreads; iThread++) {
+    const TimelineThread_t &tt = *_apttThreads[iThread];
+    strm.FPrintF_t(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"Thread %d\"}}", iThread, iThread);
+
+    const ULONG ulAdded = tt.ulAdded;
+    const ULONG ulFirst = (ulAdded > PRF_TIMELINE_EVENTS) ? ulAdded - PRF_TIMELINE_EVENTS : 0;
+
+    for (ULONG ulZone = ulFirst; ulZone < ulAdded; ulZone++) {
+      const TimelineZone_t &tz = tt.atzZones[ulZone % PRF_TIMELINE_EVENTS];
+      if (tz.llEnd < llFrom) continue;
+
+      // Skip indentation of timer names and leave out characters that would break the string
+      CTString strName = tz.strName;
+      strName.TrimSpacesLeft();
+      strName.ReplaceChar('"', '\'');
+      strName.ReplaceChar('\\', '/');
+
+      // Timestamps are in microseconds
+      strm.FPrintF_t(",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+        strName.ConstData(), iThread, DOUBLE(tz.llStart - llFrom) / 1000.0, DOUBLE(tz.llEnd - tz.llStart) / 1000.0);
+      ctZones++;
+    }
+  }
+
+  strm.PutString_t("\n]}\n");
+
+  CPrintF(TRANS("Dumped %d zones from %d frames into '%s'\n"), ctZones, (INDEX)ulFrames, fnm.ConstData());
+};
+
+}; // namespace
+
+// Dump the last few frames of the timeline into a temporary file
+void DumpProfileTimeline(INDEX ctFrames) {
+  try {
+    IProfileTimeline::Dump_t(ExpandPath::ToTemp("Timeline.json"), ctFrames);
+
+  } catch (char *strError) {
+    CPrintF(TRANS("Cannot dump profiling timeline: %s\n"), strError);
+  }
+};
@@ -187,6 +187,51 @@ ENGINE_API extern CProfileForm &_pfWorldEditingProfile;
 // profile form for profiling phisics
 ENGINE_API extern CProfileForm &_pfPhysicsProfile;
 
+// [Cecil] Timeline of profiling zones for finding spikes in specific frames
+#include <Engine/Base/Timer.h>
+
+#define PRF_TIMELINE_EVENTS  65536 // Zones kept for each thread
+#define PRF_TIMELINE_FRAMES  1024  // Frame starts kept
+#define PRF_TIMELINE_THREADS 64    // Threads that can record zones
+
+// Record profiling zones into the timeline
+ENGINE_API extern INDEX prf_bTimeline;
+
+namespace IProfileTimeline {
+
+// Prepare the timeline for recording
+void Init(void);
+
+// Add a zone that has ended on the current thread
+ENGINE_API void AddZone(const char *strName, SQUAD llStart, SQUAD llEnd);
+
+// Mark the start of a new frame
+ENGINE_API void MarkFrame(void);
+
+// Write zones from the last few frames as Chrome trace events
+ENGINE_API void Dump_t(const CTString &fnm, INDEX ctFrames); // throw char *
+
+}; // namespace
+
+// [Cecil] Zone that is added to the timeline from its construction until its destruction
+class CProfileZone {
+  private:
+    const char *pz_strName;
+    SQUAD pz_llStart;
+
+  public:
+    inline CProfileZone(const char *strName) : pz_strName(strName), pz_llStart(-1) {
+      if (prf_bTimeline) pz_llStart = _pTimer->GetHighPrecisionTimer().tv_llValue;
+    };
+
+    inline ~CProfileZone() {
+      if (pz_llStart >= 0) IProfileTimeline::AddZone(pz_strName, pz_llStart, _pTimer->GetHighPrecisionTimer().tv_llValue);
+    };
+};
+
+// [Cecil] Add the rest of the current scope to the timeline
+#define PRF_ZONE(_Name) CProfileZone _pzScope(_Name)
+
 
 #endif  /* include-once check. */
 
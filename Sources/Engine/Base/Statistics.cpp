@@ -37,6 +37,9 @@ CStatForm::CStatForm()
   InitCounter( SCI_DETAILPOLYGONS,       101, "%.0f", 1);
   InitCounter( SCI_POLYGONEDGES,         101, "\npled=%.0f", 1);
   InitCounter( SCI_EDGETRANSITIONS,      101, "\nedtr=%.0f", 1);
+  InitCounter( SCI_POLYSETUPHITS,        101, "\npset=%.0f", 1); // [Cecil]
+  InitCounter( SCI_POLYSETUPMISSES,      101, "/%.0f", 1); // [Cecil]
+  InitCounter( SCI_PVSCULLED,            101, "\npvsc=%.0f", 1); // [Cecil]
   InitCounter( SCI_SOUNDSMIXING,         101, "^cDFDFAF\nsnds=%.0f", 1);
   InitCounter( SCI_SOUNDSACTIVE,         101, "/%.0f", 1);
                
@@ -54,12 +57,18 @@ CStatForm::CStatForm()
   InitCounter( SCI_TEXTUREUPLOADBYTES, 101, "/%.0fK", 1/1024.0f);
                
   InitCounter( SCI_PARTICLES,                101, "^c00EFEF\n\npart=%.0f", 1);
+  InitCounter( SCI_PARTICLESCULLED,          101, "\npcul=%.0f", 1); // [Cecil]
   InitCounter( SCI_MODELS,                   101, "^c00DFDF\nmdls=%.0f", 1);
   InitCounter( SCI_MODELSHADOWS,             101, "\nshds=%.0f", 1);
   InitCounter( SCI_TRIANGLES_USEDMIP,        101, "\ntris=%.0f", 1);
   InitCounter( SCI_TRIANGLES_FIRSTMIP,       101, "/%.0f", 1);
   InitCounter( SCI_SHADOWTRIANGLES_USEDMIP,  101, "\nstri=%.0f", 1);
   InitCounter( SCI_SHADOWTRIANGLES_FIRSTMIP, 101, "/%.0f", 1);
+  InitCounter( SCI_SKAPOSEHITS,              101, "\npose=%.0f", 1); // [Cecil]
+  InitCounter( SCI_SKAPOSEMISSES,            101, "/%.0f", 1); // [Cecil]
+  InitCounter( SCI_MDLFRAMEHITS,             101, "\nfrms=%.0f", 1); // [Cecil]
+  InitCounter( SCI_MDLFRAMEMISSES,           101, "/%.0f", 1); // [Cecil]
+  InitCounter( SCI_ALLOCATIONS,              101, "^cEFEFEF\nallc=%.0f", 1); // [Cecil]
                
   InitTimer( STI_WORLDTRANSFORM,     101, "^C\n\nwldtra=%2.0f ms", 1000.0f);
   InitTimer( STI_WORLDVISIBILITY,    101, "\nwldvis=%2.0f ms", 1000.0f);
@@ -67,6 +76,7 @@ CStatForm::CStatForm()
   InitTimer( STI_MODELSETUP,         101, "^c00FFFF\nmdlset=%2.0f ms", 1000.0f);
   InitTimer( STI_MODELRENDERING,     101, "\nmdlren=%2.0f ms", 1000.0f);
   InitTimer( STI_PARTICLERENDERING,  101, "\npartic=%2.0f ms", 1000.0f);
+  InitTimer( STI_PARTICLESORT,       101, "\nprtsrt=%2.0f ms", 1000.0f); // [Cecil]
   InitTimer( STI_FLARESRENDERING,    101, "\nflares=%2.0f ms", 1000.0f);
 
   InitTimer( STI_SOUNDUPDATE, 101, "^cFFFFCF\nsndupd=%2.0f ms", 1000.0f);
@@ -136,6 +146,25 @@ void CStatForm::InitTimer(INDEX iTimer, INDEX iOrder, const char *strFormat, FLO
   st.st_tvStarted.tv_llValue = -1;
   st.st_fFactor = fFactor;
   st.st_strFormat = strFormat;
+
+  // [Cecil] Take the name from the format without color codes and line breaks
+  st.st_strName = "";
+
+  for (const char *pch = strFormat; *pch != '\0' && *pch != '='; pch++) {
+    if (*pch == '^') {
+      // Skip "^cRRGGBB" or any other code
+      if (pch[1] == 'c') {
+        for (INDEX i = 0; i < 7 && pch[1] != '\0'; i++) pch++;
+      } else if (pch[1] != '\0') {
+        pch++;
+      }
+      continue;
+    }
+
+    if (*pch != '\n') st.st_strName.InsertChar(st.st_strName.Length(), *pch);
+  }
+
+  st.st_strName.TrimSpacesRight();
 }
 
 void CStatForm::InitLabel(INDEX iLabel, INDEX iOrder, const char *strFormat)
@@ -189,5 +218,7 @@ void STAT_Reset(void)
 // make a new report
 void STAT_Report(CTString &strReport)
 {
+  // [Cecil] Allocations are counted by the memory manager
+  _sfStats.IncrementCounter(CStatForm::SCI_ALLOCATIONS, GetFrameAllocations());
   _sfStats.Report(strReport);
 }
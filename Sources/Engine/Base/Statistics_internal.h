@@ -25,6 +25,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include <Engine/Base/CTString.h>
 #include <Engine/Base/Timer.h>
+#include <Engine/Base/Profiling.h>
 #include <Engine/Templates/StaticArray.h>
 
 class CStatEntry {
@@ -51,6 +52,7 @@ public:
 class CStatTimer : public CStatEntry {
 public:
   CTString st_strFormat;  // printing format (must contain one %f or %g or %e)
+  CTString st_strName;    // [Cecil] name for the profiling timeline
   CTimerValue st_tvStarted; // time when the timer was started last time
   CTimerValue st_tvElapsed; // total elapsed time of the timer
   FLOAT st_fFactor;       // printout factor
@@ -91,6 +93,7 @@ public:
     STI_MODELSETUP,
     STI_MODELRENDERING,
     STI_PARTICLERENDERING,
+    STI_PARTICLESORT, // [Cecil] Sorting particles by depth
     STI_FLARESRENDERING,
 
     STI_SOUNDUPDATE,
@@ -117,6 +120,9 @@ public:
     SCI_DETAILPOLYGONS,
     SCI_POLYGONEDGES,
     SCI_EDGETRANSITIONS,
+    SCI_POLYSETUPHITS, // [Cecil] Reused view-independent setups of brush polygon layers
+    SCI_POLYSETUPMISSES, // [Cecil] Remade view-independent setups of brush polygon layers
+    SCI_PVSCULLED, // [Cecil] Portals skipped because nothing behind them is potentially visible
 
     SCI_SOUNDSMIXING,
     SCI_SOUNDSACTIVE,
@@ -135,12 +141,18 @@ public:
     SCI_TEXTUREUPLOADBYTES,
 
     SCI_PARTICLES,
+    SCI_PARTICLESCULLED, // [Cecil] Particles that have been rejected before rendering
     SCI_MODELS,
     SCI_MODELSHADOWS,
     SCI_TRIANGLES_USEDMIP,
     SCI_TRIANGLES_FIRSTMIP,
     SCI_SHADOWTRIANGLES_USEDMIP,
     SCI_SHADOWTRIANGLES_FIRSTMIP,
+    SCI_SKAPOSEHITS, // [Cecil] Reused animation poses of SKA models
+    SCI_SKAPOSEMISSES, // [Cecil] Matched animation poses of SKA models
+    SCI_MDLFRAMEHITS, // [Cecil] Reused unpacked frames of MDL models
+    SCI_MDLFRAMEMISSES, // [Cecil] Unpacked frames of MDL models
+    SCI_ALLOCATIONS, // [Cecil] Memory allocations during the last frame
 
     SCI_COUNT
   };
@@ -163,7 +175,14 @@ public:
   inline void StopTimer(INDEX iTimer) {
     CStatTimer &st = sf_astTimers[iTimer];
     ASSERT( sf_astTimers[iTimer].st_tvStarted.tv_llValue != -1);
-    st.st_tvElapsed += _pTimer->GetHighPrecisionTimer()-st.st_tvStarted;
+    CTimerValue tvNow = _pTimer->GetHighPrecisionTimer(); // [Cecil]
+    st.st_tvElapsed += tvNow-st.st_tvStarted;
+
+    // [Cecil] Add to the profiling timeline
+    if (prf_bTimeline) {
+      IProfileTimeline::AddZone(st.st_strName.ConstData(), st.st_tvStarted.tv_llValue, tvNow.tv_llValue);
+    }
+
     st.st_tvStarted.tv_llValue = -1;
   };
 
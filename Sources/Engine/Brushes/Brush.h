@@ -184,6 +184,7 @@ public:
   PIX bsl_pixSizeV;
   SLONG bsl_slSizeInPixels; // size of bit mask in pixels (with all mip-maps)
   UBYTE *bsl_pubLayer;  // bit mask set where the polygon is lighted
+  SLONG bsl_slPackedSize; // [Cecil] size of run-length encoded bit mask (0 if it isn't encoded)
   COLOR bsl_colLastAnim;  // last animating color cached
 
 // interface:
@@ -194,6 +195,11 @@ public:
   // get shadow/light percentage at given coordinates in shadow layer
   FLOAT GetLightStrength(PIX pixU, PIX pixV, FLOAT fLt, FLOAT fUp);
 
+  // [Cecil] Run-length encode the bit mask if it's allowed and saves memory
+  void PackLayer(void);
+  // [Cecil] Get the bit mask, decoding it into a buffer if it's encoded
+  UBYTE *GetLayerMask(CStaticStackArray<UBYTE> &aubBuffer);
+
   // get amount of memory used by this object
   SLONG GetUsedMemory(void);
 };
@@ -537,6 +543,8 @@ public:
   INDEX bsc_ispo0;   // screen polygons used in rendering
   INDEX bsc_ctspo;
   INDEX bsc_ivvx0;   // view vertices used in rendering
+  class CBrushRayTree *bsc_prtRayTree; // [Cecil] polygon tree for ray casting (built on demand)
+  ULONG bsc_ulRayPacketMask; // [Cecil] rays of the packet being cast that have already added this sector
 
   /* Default constructor. */
   CBrushSector(void);
@@ -569,6 +577,11 @@ public:
   /* Calculate bounding boxes of all polygons. */
   void CalculateBoundingBoxes(CSimpleProjection3D_DOUBLE &prRelativeToAbsolute);
 
+  // [Cecil] Get polygon tree for ray casting, building it if needed (NULL if the sector is too small)
+  CBrushRayTree *GetRayTree(void);
+  // [Cecil] Discard polygon tree after polygons or vertices have changed
+  void DiscardRayTree(void);
+
   // sectors may be selected
   IMPLEMENT_SELECTING(bsc_ulFlags)
 
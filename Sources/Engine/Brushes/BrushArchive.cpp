@@ -24,11 +24,16 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Base/Stream.h>
 #include <Engine/Entities/Entity.h>
 #include <Engine/Base/ListIterator.inl>
+#include <Engine/Light/Shadows_internal.h>
 
 #include <Engine/Templates/BSP.h>
 #include <Engine/Templates/BSP_internal.h>
 #include <Engine/Templates/DynamicArray.cpp>
 #include <Engine/Templates/StaticArray.cpp>
+#include <Engine/Templates/StaticStackArray.cpp>
+
+// [Cecil] How many shadowmaps to cache between progress updates
+#define SHADOWMAPS_PER_BATCH 256
 
 BOOL _bPortalSectorLinksPreLoaded = FALSE;
 BOOL _bEntitySectorLinksPreLoaded = FALSE;
@@ -105,6 +110,9 @@ void CBrushArchive::LinkPortalsAndSectors(void)
   _pfWorldEditingProfile.StartTimer(CWorldEditingProfile::PTI_LINKPORTALSANDSECTORS);
   ASSERT(GetFPUPrecision()==FPT_53BIT);
 
+  // [Cecil] Potentially visible sets are made from the links that are about to change
+  ClearPVS();
+
   // for each of the zoning brushes
   FOREACHINDYNAMICARRAY(ba_abrBrushes, CBrush3D, itbr1) {
     if (itbr1->br_penEntity==NULL || !(itbr1->br_penEntity->en_ulFlags&ENF_ZONING)) {
@@ -166,6 +174,229 @@ void CBrushArchive::LinkPortalsAndSectors(void)
   _pfWorldEditingProfile.StopTimer(CWorldEditingProfile::PTI_LINKPORTALSANDSECTORS);
 }
 
+// [Cecil] How far behind a plane a polygon may be while still counting as being in front of it
+#define PVS_EPSILON 0.01f
+// [Cecil] How many sectors may be entered through portal chains from one sector before giving up
+#define PVS_MAX_STEPS 65536
+
+// [Cecil] State of the potentially visible set calculation
+static CBrushArchive *_pbaPVS = NULL;
+static ULONG *_pulPVSRow = NULL; // Row of the sector that is being calculated
+static CStaticArray<UBYTE> _aubPVSOnPath; // Sectors in the current portal chain
+static CStaticArray<UBYTE> _aubPVSFlooded; // Sectors that have been flooded without any constraints
+static CStaticStackArray<CBrushPolygon *> _apbpoPVSChain; // Portals that lead to the current sector
+static CStaticStackArray<CBrushSector *> _apbscPVSFlood;
+static INDEX _ctPVSStepsLeft = 0;
+
+static inline void MarkPVSSector(const CBrushSector *pbsc) {
+  const INDEX iSector = pbsc->bsc_iInWorld;
+  _pulPVSRow[iSector >> 5] |= (1UL << (iSector & 31));
+};
+
+// [Cecil] Check if any vertex of a polygon lies behind a plane
+static BOOL HasVertexBehindPlane(const CBrushPolygon &bpo, const FLOATplane3D &pl) {
+  const INDEX ctVertices = bpo.bpo_apbvxTriangleVertices.Count();
+
+  for (INDEX iVtx = 0; iVtx < ctVertices; iVtx++) {
+    if (pl.PointDistance(bpo.bpo_apbvxTriangleVertices[iVtx]->bvx_vAbsolute) < PVS_EPSILON) return TRUE;
+  }
+
+  return FALSE;
+};
+
+// [Cecil] Check if any vertex of a polygon lies in front of a plane
+static BOOL HasVertexInFrontOfPlane(const CBrushPolygon &bpo, const FLOATplane3D &pl) {
+  const INDEX ctVertices = bpo.bpo_apbvxTriangleVertices.Count();
+
+  for (INDEX iVtx = 0; iVtx < ctVertices; iVtx++) {
+    if (pl.PointDistance(bpo.bpo_apbvxTriangleVertices[iVtx]->bvx_vAbsolute) > -PVS_EPSILON) return TRUE;
+  }
+
+  return FALSE;
+};
+
+// [Cecil] Mark all sectors that can be reached from some sector through any portals
+static void FloodPVS(CBrushSector *pbscStart) {
+  if (_aubPVSFlooded[pbscStart->bsc_iInWorld]) return;
+
+  _aubPVSFlooded[pbscStart->bsc_iInWorld] = TRUE;
+  _apbscPVSFlood.PopAll();
+  _apbscPVSFlood.Push() = pbscStart;
+
+  while (_apbscPVSFlood.Count() > 0) {
+    CBrushSector *pbsc = _apbscPVSFlood.Pop();
+    MarkPVSSector(pbsc);
+
+    FOREACHINSTATICARRAY(pbsc->bsc_abpoPolygons, CBrushPolygon, itbpo) {
+      if (!(itbpo->bpo_ulFlags & BPOF_PORTAL)) continue;
+
+      {FOREACHDSTOFSRC(itbpo->bpo_rsOtherSideSectors, CBrushSector, bsc_rdOtherSidePortals, pbscOther)
+        if (!_aubPVSFlooded[pbscOther->bsc_iInWorld]) {
+          _aubPVSFlooded[pbscOther->bsc_iInWorld] = TRUE;
+          _apbscPVSFlood.Push() = pbscOther;
+        }
+      ENDFOR}
+    }
+  }
+};
+
+// [Cecil] Mark sectors that may be seen through the current portal chain from a sector that it leads into
+static void ScanPVSChain(CBrushSector *pbsc) {
+  // Out of budget
+  if (--_ctPVSStepsLeft < 0) return;
+
+  // Sectors that can move around can see anything behind them
+  if (_pbaPVS->ba_aiPVSRows[pbsc->bsc_iInWorld] < 0) {
+    FloodPVS(pbsc);
+    return;
+  }
+
+  _aubPVSOnPath[pbsc->bsc_iInWorld] = TRUE;
+  const INDEX ctChain = _apbpoPVSChain.Count();
+
+  FOREACHINSTATICARRAY(pbsc->bsc_abpoPolygons, CBrushPolygon, itbpo) {
+    CBrushPolygon &bpoNext = *itbpo;
+    if (!(bpoNext.bpo_ulFlags & BPOF_PORTAL)) continue;
+
+    const FLOATplane3D &plNext = bpoNext.bpo_pbplPlane->bpl_plAbsolute;
+    BOOL bSeen = TRUE;
+
+    // A line of sight through the chain can only get to the next portal if the next portal
+    // is behind every previous portal and every previous portal is in front of the next one
+    for (INDEX iPortal = 0; iPortal < ctChain; iPortal++) {
+      const CBrushPolygon &bpoPrev = *_apbpoPVSChain[iPortal];
+
+      if (!HasVertexBehindPlane(bpoNext, bpoPrev.bpo_pbplPlane->bpl_plAbsolute)
+       || !HasVertexInFrontOfPlane(bpoPrev, plNext)) {
+        bSeen = FALSE;
+        break;
+      }
+    }
+
+    if (!bSeen) continue;
+
+    _apbpoPVSChain.Push() = &bpoNext;
+
+    {FOREACHDSTOFSRC(bpoNext.bpo_rsOtherSideSectors, CBrushSector, bsc_rdOtherSidePortals, pbscOther)
+      MarkPVSSector(pbscOther);
+
+      if (!_aubPVSOnPath[pbscOther->bsc_iInWorld]) {
+        ScanPVSChain(pbscOther);
+      }
+    ENDFOR}
+
+    _apbpoPVSChain.Pop();
+  }
+
+  _aubPVSOnPath[pbsc->bsc_iInWorld] = FALSE;
+};
+
+// [Cecil] Calculate potentially visible sets of all static zoning sectors
+void CBrushArchive::CalculatePVS(void)
+{
+  ClearPVS();
+  MakeIndices();
+
+  const INDEX ctSectors = ba_apbsc.Count();
+  if (ctSectors == 0) return;
+
+  // Only sectors of zoning brushes that never move get their own sets
+  INDEX ctRows = 0;
+  ba_aiPVSRows.New(ctSectors);
+
+  for (INDEX iSector = 0; iSector < ctSectors; iSector++) {
+    CEntity *pen = ba_apbsc[iSector]->bsc_pbmBrushMip->bm_pbrBrush->br_penEntity;
+
+    if (pen != NULL && (pen->en_ulFlags & ENF_ZONING) && !(pen->en_ulPhysicsFlags & EPF_MOVABLE)) {
+      ba_aiPVSRows[iSector] = ctRows++;
+    } else {
+      ba_aiPVSRows[iSector] = -1;
+    }
+  }
+
+  if (ctRows == 0) {
+    ClearPVS();
+    return;
+  }
+
+  ba_ctPVSRowLength = (ctSectors + 31) / 32;
+  ba_aulPVS.New(ctRows * ba_ctPVSRowLength);
+  memset(&ba_aulPVS[0], 0, ba_aulPVS.Count() * sizeof(ULONG));
+
+  _pbaPVS = this;
+  _aubPVSOnPath.New(ctSectors);
+  _aubPVSFlooded.New(ctSectors);
+
+  for (INDEX iSector = 0; iSector < ctSectors; iSector++) {
+    const INDEX iRow = ba_aiPVSRows[iSector];
+    if (iRow < 0) continue;
+
+    CBrushSector *pbsc = ba_apbsc[iSector];
+
+    _pulPVSRow = &ba_aulPVS[iRow * ba_ctPVSRowLength];
+    memset(&_aubPVSOnPath[0], 0, ctSectors);
+    memset(&_aubPVSFlooded[0], 0, ctSectors);
+    _apbpoPVSChain.PopAll();
+    _ctPVSStepsLeft = PVS_MAX_STEPS;
+
+    MarkPVSSector(pbsc);
+    _aubPVSOnPath[iSector] = TRUE;
+
+    // Anything behind portals of this sector may be seen from some point in it
+    FOREACHINSTATICARRAY(pbsc->bsc_abpoPolygons, CBrushPolygon, itbpo) {
+      if (!(itbpo->bpo_ulFlags & BPOF_PORTAL)) continue;
+
+      _apbpoPVSChain.Push() = itbpo;
+
+      {FOREACHDSTOFSRC(itbpo->bpo_rsOtherSideSectors, CBrushSector, bsc_rdOtherSidePortals, pbscOther)
+        MarkPVSSector(pbscOther);
+
+        if (!_aubPVSOnPath[pbscOther->bsc_iInWorld]) {
+          ScanPVSChain(pbscOther);
+        }
+      ENDFOR}
+
+      _apbpoPVSChain.Pop();
+    }
+
+    // Chains got too long, so assume that everything that can be reached is visible
+    if (_ctPVSStepsLeft < 0) {
+      FloodPVS(pbsc);
+    }
+  }
+
+  _pbaPVS = NULL;
+  _pulPVSRow = NULL;
+  _aubPVSOnPath.Clear();
+  _aubPVSFlooded.Clear();
+  _apbpoPVSChain.Clear();
+  _apbscPVSFlood.Clear();
+}
+
+// [Cecil] Discard potentially visible sets (e.g. when the geometry changes)
+void CBrushArchive::ClearPVS(void)
+{
+  ba_aiPVSRows.Clear();
+  ba_aulPVS.Clear();
+  ba_ctPVSRowLength = 0;
+}
+
+// [Cecil] Get bit row of sectors that may be seen from some sector (NULL if unknown)
+const ULONG *CBrushArchive::GetPVSRow(const CBrushSector *pbsc) const
+{
+  // Indices of sectors that have been added after the calculation are not valid
+  const INDEX iSector = pbsc->bsc_iInWorld;
+
+  if (iSector < 0 || iSector >= ba_aiPVSRows.Count() || iSector >= ba_apbsc.Count() || ba_apbsc[iSector] != pbsc) {
+    return NULL;
+  }
+
+  const INDEX iRow = ba_aiPVSRows[iSector];
+  if (iRow < 0) return NULL;
+
+  return &ba_aulPVS[iRow * ba_ctPVSRowLength];
+}
+
 
 // remove shadow layers without valid light source in all brushes
 void CBrushArchive::RemoveDummyLayers(void)
@@ -188,41 +419,48 @@ void CBrushArchive::RemoveDummyLayers(void)
 // cache all shadowmaps 
 void CBrushArchive::CacheAllShadowmaps(void)
 {
-  // count all shadowmaps
-  INDEX ctShadowMaps=0;
+  // [Cecil] Gather all shadowmaps
+  CStaticStackArray<CBrushShadowMap *> apbsm;
+  apbsm.SetAllocationStep(1024);
+
   {FOREACHINDYNAMICARRAY( ba_abrBrushes, CBrush3D, itbr) { // for each mip
     if( itbr->br_penEntity==NULL) continue; // skip brush without entity
     FOREACHINLIST( CBrushMip, bm_lnInBrush, itbr->br_lhBrushMips, itbm) { // for each sector in the brush mip
       FOREACHINDYNAMICARRAY( itbm->bm_abscSectors, CBrushSector, itbsc) { // for each polygon in the sector
         FOREACHINSTATICARRAY( itbsc->bsc_abpoPolygons, CBrushPolygon, itbpo) {
-          if( !itbpo->bpo_smShadowMap.bsm_lhLayers.IsEmpty()) ctShadowMaps++; // count shadowmap if the one exist
+          if( !itbpo->bpo_smShadowMap.bsm_lhLayers.IsEmpty()) apbsm.Push() = &itbpo->bpo_smShadowMap; // add shadowmap if the one exist
         }
       }
     }
   }}
 
+  const INDEX ctShadowMaps = apbsm.Count();
+
   try {
     SetProgressDescription( TRANS("caching shadowmaps"));
     CallProgressHook_t(0.0f);
-    // for each brush
-    INDEX iCurrentShadowMap=0;
-    {FOREACHINDYNAMICARRAY( ba_abrBrushes, CBrush3D, itbr) { // for each mip
-      if( itbr->br_penEntity==NULL) continue; // skip brush without entity
-      FOREACHINLIST( CBrushMip, bm_lnInBrush, itbr->br_lhBrushMips, itbm) { // for each sector in the brush mip
-        FOREACHINDYNAMICARRAY( itbm->bm_abscSectors, CBrushSector, itbsc) { // for each polygon in the sector
-          FOREACHINSTATICARRAY( itbsc->bsc_abpoPolygons, CBrushPolygon, itbpo) {
-            // cache shadowmap if the one exist
-            CBrushShadowMap &bsm = itbpo->bpo_smShadowMap;
-            if( bsm.bsm_lhLayers.IsEmpty()) continue;
-            bsm.CheckLayersUpToDate();
-            bsm.Prepare();
-            bsm.SetAsCurrent();
-            iCurrentShadowMap++;
-            CallProgressHook_t( (FLOAT)iCurrentShadowMap/ctShadowMaps);
-          }
-        }
+
+    // [Cecil] Cache shadowmaps in batches, mixing layers of each batch on all job threads
+    for (INDEX iFirst = 0; iFirst < ctShadowMaps; iFirst += SHADOWMAPS_PER_BATCH) {
+      const INDEX iLast = Min(iFirst + SHADOWMAPS_PER_BATCH, ctShadowMaps);
+
+      DeferShadowMapMixing();
+
+      for (INDEX iPrepare = iFirst; iPrepare < iLast; iPrepare++) {
+        CBrushShadowMap &bsm = *apbsm[iPrepare];
+        bsm.CheckLayersUpToDate();
+        bsm.Prepare();
       }
-    }}
+
+      MixDeferredShadowMaps();
+
+      for (INDEX iUpload = iFirst; iUpload < iLast; iUpload++) {
+        apbsm[iUpload]->SetAsCurrent();
+      }
+
+      CallProgressHook_t((FLOAT)iLast / ctShadowMaps);
+    }
+
     // all done
     CallProgressHook_t(1.0f);
   }
@@ -452,6 +690,94 @@ void CBrushArchive::WriteEntitySectorLinks_t( CTStream &strm) // throw char *
   strm.WriteID_t("ESLE");   // entity-sector links end
 }
 
+// [Cecil] Read potentially visible sets if there are any
+void CBrushArchive::ReadPVS_t( CTStream &strm)  // throw char *
+{
+  ClearPVS();
+
+  // if the chunk is not there
+  if (!(strm.PeekID_t()==CChunkID("SPVS"))) {   // sector PVS
+    // do nothing
+    return;
+  }
+
+  strm.ExpectID_t("SPVS");   // sector PVS
+  INDEX iVersion;
+  strm>>iVersion;
+  ASSERT(iVersion==1);
+  // read chunk size
+  SLONG slChunkSizePos = strm.GetPos_t();
+  SLONG slChunkSize;
+  strm>>slChunkSize;
+
+  INDEX ctSectors, ctRowLength, ctRows;
+  strm>>ctSectors>>ctRowLength>>ctRows;
+
+  // sets are only valid for the exact same sectors
+  MakeIndices();
+
+  if (ctSectors!=ba_apbsc.Count() || ctRowLength!=(ctSectors+31)/32 || ctRows<=0) {
+    // skip the sets
+    strm.SetPos_t(slChunkSizePos+sizeof(INDEX)+slChunkSize);
+    strm.ExpectID_t("SPVE");   // sector PVS end
+    return;
+  }
+
+  ba_aiPVSRows.New(ctSectors);
+  strm.Read_t(&ba_aiPVSRows[0], ctSectors*sizeof(INDEX));
+  ba_aulPVS.New(ctRows*ctRowLength);
+  strm.Read_t(&ba_aulPVS[0], ctRows*ctRowLength*sizeof(ULONG));
+  ba_ctPVSRowLength = ctRowLength;
+
+  // check chunk size
+  ASSERT(strm.GetPos_t()-slChunkSizePos-sizeof(INDEX)==slChunkSize);
+  // check end id
+  strm.ExpectID_t("SPVE");   // sector PVS end
+
+  // discard the sets if any row is invalid
+  for (INDEX iSector=0; iSector<ctSectors; iSector++) {
+    if (ba_aiPVSRows[iSector]>=ctRows) {
+      ClearPVS();
+      return;
+    }
+  }
+}
+
+// [Cecil] Write potentially visible sets if there are any
+void CBrushArchive::WritePVS_t( CTStream &strm) // throw char *
+{
+  // first make indices for all sectors
+  MakeIndices();
+
+  // sets don't match the sectors anymore
+  if (!HasPVS() || ba_aiPVSRows.Count()!=ba_apbsc.Count()) {
+    return;
+  }
+
+  const INDEX ctSectors = ba_aiPVSRows.Count();
+  const INDEX ctRows = ba_aulPVS.Count()/ba_ctPVSRowLength;
+
+  // write chunk id and current version
+  strm.WriteID_t("SPVS");   // sector PVS
+  strm<<INDEX(1);
+  // leave room for chunk size
+  SLONG slChunkSizePos = strm.GetPos_t();
+  strm<<SLONG(0);
+
+  strm<<ctSectors<<ba_ctPVSRowLength<<ctRows;
+  strm.Write_t(&ba_aiPVSRows[0], ctSectors*sizeof(INDEX));
+  strm.Write_t(&ba_aulPVS[0], ba_aulPVS.Count()*sizeof(ULONG));
+
+  // write back the chunk size
+  SLONG slEndPos = strm.GetPos_t();
+  strm.SetPos_t(slChunkSizePos);
+  strm<<SLONG(slEndPos-slChunkSizePos-sizeof(INDEX));
+  strm.SetPos_t(slEndPos);
+
+  // write end id for checking
+  strm.WriteID_t("SPVE");   // sector PVS end
+}
+
 /*
  * Read from stream.
  */
@@ -36,6 +36,11 @@ public:
   CStaticArray<CBrushPolygon *> ba_apbpo;
   CStaticArray<CBrushSector *> ba_apbsc;
 
+  // [Cecil] Potentially visible sets of sectors in static zoning brushes (empty if not calculated)
+  CStaticArray<INDEX> ba_aiPVSRows; // PVS row of each sector in ba_apbsc or -1 if it has none
+  CStaticArray<ULONG> ba_aulPVS; // Bit rows of sectors that may be seen from each sector
+  INDEX ba_ctPVSRowLength; // Amount of ULONGs in each row
+
   // overrides from CSerial
   /* Read/write to/from stream. */
   void Read_t( CTStream *istrFile);  // throw char *
@@ -44,6 +49,11 @@ public:
   void WritePortalSectorLinks_t( CTStream &strm); // throw char *
   void ReadEntitySectorLinks_t( CTStream &strm);  // throw char *
   void WriteEntitySectorLinks_t( CTStream &strm); // throw char *
+  void ReadPVS_t( CTStream &strm);  // throw char * // [Cecil]
+  void WritePVS_t( CTStream &strm); // throw char * // [Cecil]
+
+  // [Cecil] Constructor
+  CBrushArchive(void) : ba_pwoWorld(NULL), ba_ctPVSRowLength(0) {};
 
   /* Calculate bounding boxes in all brushes. */
   void CalculateBoundingBoxes(void);
@@ -55,6 +65,19 @@ public:
   void RemoveDummyLayers(void);
   // cache all shadowmaps (upon loading of world)
   void CacheAllShadowmaps(void);
+
+  // [Cecil] Calculate potentially visible sets of all static zoning sectors
+  void CalculatePVS(void);
+  // [Cecil] Discard potentially visible sets (e.g. when the geometry changes)
+  void ClearPVS(void);
+
+  // [Cecil] Check if there are potentially visible sets
+  inline BOOL HasPVS(void) const {
+    return ba_ctPVSRowLength > 0;
+  };
+
+  // [Cecil] Get bit row of sectors that may be seen from some sector (NULL if unknown)
+  const ULONG *GetPVSRow(const CBrushSector *pbsc) const;
 };
 
 
@@ -0,0 +1,278 @@
+/* Copyright (c) 2026 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "StdH.h"
+
+#include <Engine/Brushes/Brush.h>
+#include <Engine/Brushes/BrushRayTree.h>
+#include <Engine/Templates/StaticArray.cpp>
+#include <Engine/Templates/StaticStackArray.cpp>
+
+// Maximum amount of polygons in one leaf
+#define MAX_LEAF_POLYGONS 4
+
+// Maximum depth of the tree (also limits the traversal stack)
+#define MAX_TREE_DEPTH 48
+
+// How much to expand polygon bounds to account for the difference
+// between relative and absolute vertex precision when testing rays
+#define POLYGON_BOX_EPSILON 0.05f
+
+// Polygon data used while building the tree
+struct BuildPolygon_t {
+  FLOATaabbox3D boxBounds;
+  FLOAT3D vCenter;
+
+  inline void Clear(void) {};
+};
+
+CBrushRayTree::CBrushRayTree(void) : rt_pbpoFirst(NULL), rt_pbvxFirst(NULL), rt_ctPolygons(0)
+{
+};
+
+void CBrushRayTree::Clear(void) {
+  rt_aNodes.Clear();
+  rt_aiPolygons.Clear();
+  rt_pbpoFirst = NULL;
+  rt_pbvxFirst = NULL;
+  rt_ctPolygons = 0;
+};
+
+BOOL CBrushRayTree::IsValidFor(const CBrushSector &bsc) const {
+  const INDEX ctPolygons = bsc.bsc_abpoPolygons.Count();
+  if (ctPolygons != rt_ctPolygons || ctPolygons == 0) return FALSE;
+
+  return rt_pbpoFirst == bsc.bsc_abpoPolygons.sa_Array
+      && rt_pbvxFirst == bsc.bsc_abvxVertices.sa_Array;
+};
+
+// Recursively build nodes for a range of polygon indices
+static void BuildNode(CBrushRayTree &rt, const CStaticArray<BuildPolygon_t> &abp, INDEX iFirst, INDEX ct, INDEX iDepth)
+{
+  const INDEX iNode = rt.rt_aNodes.Count();
+  CBrushRayTree::Node_t &nodeNew = rt.rt_aNodes.Push();
+
+  // Gather bounds of the polygons and their centers
+  FLOATaabbox3D boxNode, boxCenters;
+
+  for (INDEX i = iFirst; i < iFirst + ct; i++) {
+    const BuildPolygon_t &bp = abp[rt.rt_aiPolygons[i]];
+    boxNode |= bp.boxBounds;
+    boxCenters |= FLOATaabbox3D(bp.vCenter);
+  }
+
+  nodeNew.boxBounds = boxNode;
+  nodeNew.iRight = -1;
+  nodeNew.iFirst = iFirst;
+  nodeNew.ct = ct;
+
+  // Make a leaf out of a few polygons
+  if (ct <= MAX_LEAF_POLYGONS || iDepth >= MAX_TREE_DEPTH) return;
+
+  // Split along the longest axis of the centers
+  const FLOAT3D vSize = boxCenters.Size();
+  INDEX iAxis = 1;
+  if (vSize(2) > vSize(iAxis)) iAxis = 2;
+  if (vSize(3) > vSize(iAxis)) iAxis = 3;
+
+  const FLOAT fSplit = boxCenters.Center()(iAxis);
+
+  // Partition polygons around the middle
+  INDEX iLeft = iFirst;
+  INDEX iRight = iFirst + ct - 1;
+
+  while (iLeft <= iRight) {
+    if (abp[rt.rt_aiPolygons[iLeft]].vCenter(iAxis) < fSplit) {
+      iLeft++;
+    } else {
+      Swap(rt.rt_aiPolygons[iLeft], rt.rt_aiPolygons[iRight]);
+      iRight--;
+    }
+  }
+
+  INDEX ctLeft = iLeft - iFirst;
+
+  // All centers are on one side, so just split in half
+  if (ctLeft == 0 || ctLeft == ct) {
+    ctLeft = ct / 2;
+  }
+
+  // Turn into an inner node (the node array may be reallocated during recursion)
+  rt.rt_aNodes[iNode].ct = 0;
+
+  BuildNode(rt, abp, iFirst, ctLeft, iDepth + 1);
+  rt.rt_aNodes[iNode].iRight = rt.rt_aNodes.Count();
+  BuildNode(rt, abp, iFirst + ctLeft, ct - ctLeft, iDepth + 1);
+};
+
+void CBrushRayTree::Build(CBrushSector &bsc) {
+  Clear();
+
+  const INDEX ctPolygons = bsc.bsc_abpoPolygons.Count();
+  if (ctPolygons == 0) return;
+
+  // Calculate polygon bounds in brush space
+  CStaticArray<BuildPolygon_t> abp;
+  abp.New(ctPolygons);
+
+  for (INDEX ipo = 0; ipo < ctPolygons; ipo++) {
+    CBrushPolygon &bpo = bsc.bsc_abpoPolygons[ipo];
+    BuildPolygon_t &bp = abp[ipo];
+
+    FOREACHINSTATICARRAY(bpo.bpo_abpePolygonEdges, CBrushPolygonEdge, itbpe) {
+      bp.boxBounds |= itbpe->bpe_pbedEdge->bed_pbvxVertex0->bvx_vRelative;
+      bp.boxBounds |= itbpe->bpe_pbedEdge->bed_pbvxVertex1->bvx_vRelative;
+    }
+
+    bp.boxBounds.Expand(POLYGON_BOX_EPSILON);
+    bp.vCenter = bp.boxBounds.Center();
+  }
+
+  rt_aiPolygons.New(ctPolygons);
+
+  for (INDEX i = 0; i < ctPolygons; i++) {
+    rt_aiPolygons[i] = i;
+  }
+
+  // A balanced tree needs slightly less than two nodes per leaf
+  rt_aNodes.SetAllocationStep(Max(ctPolygons / MAX_LEAF_POLYGONS, (INDEX)16));
+  BuildNode(*this, abp, 0, ctPolygons, 0);
+
+  rt_pbpoFirst = bsc.bsc_abpoPolygons.sa_Array;
+  rt_pbvxFirst = bsc.bsc_abvxVertices.sa_Array;
+  rt_ctPolygons = ctPolygons;
+};
+
+static int qsort_CompareIndices(const void *pi0, const void *pi1)
+{
+  const INDEX i0 = *(const INDEX *)pi0;
+  const INDEX i1 = *(const INDEX *)pi1;
+
+  if (i0 < i1) return -1;
+  if (i0 > i1) return +1;
+  return 0;
+};
+
+// Check if a ray segment intersects a box using precalculated inverse direction
+static inline BOOL RayHitsBox(const FLOATaabbox3D &box, const FLOAT3D &vOrigin, const FLOAT3D &vInvDir, FLOAT fMaxDistance)
+{
+  FLOAT tNear = 0.0f;
+  FLOAT tFar = fMaxDistance;
+
+  for (INDEX i = 1; i <= 3; i++) {
+    FLOAT t0 = (box.Min()(i) - vOrigin(i)) * vInvDir(i);
+    FLOAT t1 = (box.Max()(i) - vOrigin(i)) * vInvDir(i);
+    if (t0 > t1) Swap(t0, t1);
+
+    if (t0 > tNear) tNear = t0;
+    if (t1 < tFar) tFar = t1;
+    if (tNear > tFar) return FALSE;
+  }
+
+  return TRUE;
+};
+
+void CBrushRayTree::FindPolygons(const FLOAT3D &vOrigin, const FLOAT3D &vDir, FLOAT fMaxDistance, CStaticStackArray<INDEX> &aiPolygons) const
+{
+  if (rt_aNodes.Count() == 0) return;
+
+  // Parallel axes get a huge inverse instead of infinity to avoid NaNs in multiplications
+  FLOAT3D vInvDir;
+
+  for (INDEX i = 1; i <= 3; i++) {
+    if (Abs(vDir(i)) > 1e-9f) {
+      vInvDir(i) = 1.0f / vDir(i);
+    } else {
+      vInvDir(i) = (vDir(i) >= 0.0f) ? 1e30f : -1e30f;
+    }
+  }
+
+  const INDEX iFirstFound = aiPolygons.Count();
+
+  INDEX aiStack[MAX_TREE_DEPTH + 2];
+  INDEX ctStack = 0;
+  aiStack[ctStack++] = 0;
+
+  while (ctStack > 0) {
+    const INDEX iNode = aiStack[--ctStack];
+    const Node_t &node = rt_aNodes[iNode];
+
+    if (!RayHitsBox(node.boxBounds, vOrigin, vInvDir, fMaxDistance)) continue;
+
+    // Inner node
+    if (node.ct == 0) {
+      aiStack[ctStack++] = node.iRight;
+      aiStack[ctStack++] = iNode + 1;
+      continue;
+    }
+
+    // Leaf polygons
+    INDEX *piPolygons = aiPolygons.Push(node.ct);
+
+    for (INDEX i = 0; i < node.ct; i++) {
+      piPolygons[i] = rt_aiPolygons[node.iFirst + i];
+    }
+  }
+
+  // Keep the original polygon order
+  const INDEX ctFound = aiPolygons.Count() - iFirstFound;
+
+  if (ctFound > 1) {
+    qsort(&aiPolygons[iFirstFound], ctFound, sizeof(INDEX), qsort_CompareIndices);
+  }
+};
+
+void CBrushRayTree::FindPolygonsInBox(const FLOATaabbox3D &box, CStaticStackArray<INDEX> &aiPolygons) const
+{
+  if (rt_aNodes.Count() == 0) return;
+
+  const INDEX iFirstFound = aiPolygons.Count();
+
+  INDEX aiStack[MAX_TREE_DEPTH + 2];
+  INDEX ctStack = 0;
+  aiStack[ctStack++] = 0;
+
+  while (ctStack > 0) {
+    const INDEX iNode = aiStack[--ctStack];
+    const Node_t &node = rt_aNodes[iNode];
+
+    if (!node.boxBounds.HasContactWith(box)) continue;
+
+    // Inner node
+    if (node.ct == 0) {
+      aiStack[ctStack++] = node.iRight;
+      aiStack[ctStack++] = iNode + 1;
+      continue;
+    }
+
+    // Leaf polygons
+    INDEX *piPolygons = aiPolygons.Push(node.ct);
+
+    for (INDEX i = 0; i < node.ct; i++) {
+      piPolygons[i] = rt_aiPolygons[node.iFirst + i];
+    }
+  }
+
+  // Keep the original polygon order
+  const INDEX ctFound = aiPolygons.Count() - iFirstFound;
+
+  if (ctFound > 1) {
+    qsort(&aiPolygons[iFirstFound], ctFound, sizeof(INDEX), qsort_CompareIndices);
+  }
+};
+
+SLONG CBrushRayTree::GetUsedMemory(void) const {
+  return sizeof(CBrushRayTree) + rt_aNodes.sa_Count * sizeof(Node_t) + rt_aiPolygons.Count() * sizeof(INDEX);
+};
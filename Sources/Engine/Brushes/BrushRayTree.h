@@ -0,0 +1,77 @@
+/* Copyright (c) 2026 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef SE_INCL_BRUSHRAYTREE_H
+#define SE_INCL_BRUSHRAYTREE_H
+
+#ifdef PRAGMA_ONCE
+  #pragma once
+#endif
+
+#include <Engine/Math/AABBox.h>
+#include <Engine/Templates/StaticArray.h>
+#include <Engine/Templates/StaticStackArray.h>
+
+// Minimal amount of polygons in a sector for building a ray tree for it
+#define BRUSHRAYTREE_MINPOLYGONS 16
+
+// Bounding volume hierarchy of sector polygons in brush space that's used for ray casting
+class ENGINE_API CBrushRayTree {
+  public:
+    // One node of the tree
+    struct Node_t {
+      FLOATaabbox3D boxBounds; // Bounds of all polygons under this node
+      INDEX iRight; // Index of the right child node (left child node always follows its parent)
+      INDEX iFirst; // First polygon index in the leaf
+      INDEX ct; // Amount of polygons in the leaf (0 for inner nodes)
+
+      inline void Clear(void) {};
+    };
+
+    CStaticStackArray<Node_t> rt_aNodes; // Nodes in depth-first order
+    CStaticArray<INDEX> rt_aiPolygons; // Sector polygon indices in leaf order
+
+    // Arrays the tree was built for (to detect reallocated sector arrays)
+    const CBrushPolygon *rt_pbpoFirst;
+    const CBrushVertex *rt_pbvxFirst;
+    INDEX rt_ctPolygons;
+
+  public:
+    // Constructor
+    CBrushRayTree(void);
+
+    // Clear the tree
+    void Clear(void);
+
+    // Check whether the tree was built for the current sector geometry
+    BOOL IsValidFor(const CBrushSector &bsc) const;
+
+    // Build the tree from relative polygon coordinates of a sector
+    void Build(CBrushSector &bsc);
+
+    // Gather indices of polygons whose bounds intersect a ray in brush space
+    // The ray is defined by its origin, normalized direction and maximum distance
+    // Indices are added in ascending order so they can be tested like a regular polygon array
+    void FindPolygons(const FLOAT3D &vOrigin, const FLOAT3D &vDir, FLOAT fMaxDistance, CStaticStackArray<INDEX> &aiPolygons) const;
+
+    // Gather indices of polygons whose bounds intersect a box in brush space
+    // Used for a group of rays that all lie inside the box; indices are added in ascending order
+    void FindPolygonsInBox(const FLOATaabbox3D &box, CStaticStackArray<INDEX> &aiPolygons) const;
+
+    // Get amount of memory used by the tree
+    SLONG GetUsedMemory(void) const;
+};
+
+#endif // include-once check
@@ -17,6 +17,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include <Engine/Brushes/Brush.h>
 #include <Engine/Brushes/BrushTransformed.h>
+#include <Engine/Brushes/BrushRayTree.h>
 #include <Engine/Math/Geometry.inl>
 #include <Engine/Base/Console.h>
 #include <Engine/World/World.h>
@@ -53,12 +54,44 @@ CBrushSector::CBrushSector(void)
 , bsc_ulVisFlags(0)
 , bsc_strName("")
 , bsc_bspBSPTree(*new DOUBLEbsptree3D)
+, bsc_prtRayTree(NULL) // [Cecil]
+, bsc_ulRayPacketMask(0) // [Cecil]
 {
 
 };
 CBrushSector::~CBrushSector(void)
 {
   delete &bsc_bspBSPTree;
+  DiscardRayTree(); // [Cecil]
+}
+
+// [Cecil] Get polygon tree for ray casting, building it if needed
+CBrushRayTree *CBrushSector::GetRayTree(void)
+{
+  // not worth it for a few polygons
+  if (bsc_abpoPolygons.Count() < BRUSHRAYTREE_MINPOLYGONS) {
+    return NULL;
+  }
+
+  if (bsc_prtRayTree == NULL) {
+    bsc_prtRayTree = new CBrushRayTree;
+  }
+
+  // rebuild if polygon or vertex arrays have been replaced
+  if (!bsc_prtRayTree->IsValidFor(*this)) {
+    bsc_prtRayTree->Build(*this);
+  }
+
+  return bsc_prtRayTree;
+}
+
+// [Cecil] Discard polygon tree after polygons or vertices have changed
+void CBrushSector::DiscardRayTree(void)
+{
+  if (bsc_prtRayTree != NULL) {
+    delete bsc_prtRayTree;
+    bsc_prtRayTree = NULL;
+  }
 }
 
 /*
@@ -80,6 +113,9 @@ void CBrushSector::CalculateBoundingBoxes(CSimpleProjection3D_DOUBLE &prRelative
   avdAbsoluteVertices.New(bsc_abvxVertices.Count());
   bsc_boxRelative = FLOATaabbox3D();
 
+  // [Cecil] ray tree is kept in relative space, so it only needs to be rebuilt if the shape changes
+  BOOL bRelativeChanged = FALSE;
+
   // for each vertex in sector
   for(INDEX ivx=0; ivx<bsc_abvxVertices.Count(); ivx++) {
     // make the original vertex point to absolute vertex
@@ -89,8 +125,15 @@ void CBrushSector::CalculateBoundingBoxes(CSimpleProjection3D_DOUBLE &prRelative
     prRelativeToAbsolute.ProjectCoordinate(bsc_abvxVertices[ivx].bvx_vdPreciseRelative, avdAbsoluteVertices[ivx]);
     // remember the absolute and relative coordinates in lower precision
     bsc_abvxVertices[ivx].bvx_vAbsolute = DOUBLEtoFLOAT(avdAbsoluteVertices[ivx]);
+
+    // [Cecil] check if relative coordinates are changing
+    const FLOAT3D vRelative = DOUBLEtoFLOAT(bsc_abvxVertices[ivx].bvx_vdPreciseRelative);
+    if (bsc_prtRayTree != NULL && bsc_abvxVertices[ivx].bvx_vRelative != vRelative) {
+      bRelativeChanged = TRUE;
+    }
+
     bsc_awvxVertices[ivx].wvx_vRelative =
-    bsc_abvxVertices[ivx].bvx_vRelative = DOUBLEtoFLOAT(bsc_abvxVertices[ivx].bvx_vdPreciseRelative);
+    bsc_abvxVertices[ivx].bvx_vRelative = vRelative;
     // add vertex to relative box
     bsc_boxRelative |= bsc_abvxVertices[ivx].bvx_vRelative;
   }
@@ -118,6 +161,11 @@ void CBrushSector::CalculateBoundingBoxes(CSimpleProjection3D_DOUBLE &prRelative
       bsc_abplPlanes[ipl].bpl_iPlaneMajorAxis2);
   }
 
+  // [Cecil] vertices have been moved
+  if (bRelativeChanged) {
+    DiscardRayTree();
+  }
+
   // clear the bounding box of the sector
   bsc_boxBoundingBox = FLOATaabbox3D();
   // for all polygons in this sector
@@ -270,6 +318,7 @@ void CBrushSector::Clear(void)
   bsc_rsEntities.Clear();
   bsc_strName.Clear();
 //  bsc_bspBSPTree.Destroy();
+  DiscardRayTree(); // [Cecil]
 }
 
 /*
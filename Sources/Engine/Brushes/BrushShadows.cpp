@@ -25,6 +25,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Base/ListIterator.inl>
 #include <Engine/Graphics/Color.h>
 #include <Engine/Templates/StaticArray.cpp>
+#include <Engine/Templates/StaticStackArray.cpp>
 #include <Engine/World/World.h>
 #include <Engine/Entities/Entity.h>
 
@@ -35,6 +36,180 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 // max allowed size of shadowmap in pixels
 #define MAX_SHADOWMAP_SIZE 65536
 
+extern INDEX shd_bCompressLayers; // [Cecil]
+
+// [Cecil] Encode bytes using PackBits (headers 0..127 are followed by 1..128 literal bytes
+// and headers 129..255 are followed by one byte that's repeated 128..2 times)
+// Pairs of repeating bytes stay within literal runs, so the output is never larger than
+// slSize + slSize/128 + 1 bytes; returns -1 if the output wouldn't fit into slMaxPacked bytes
+static SLONG PackBits(const UBYTE *pubSrc, SLONG slSize, UBYTE *pubDst, SLONG slMaxPacked)
+{
+  UBYTE *pubOut = pubDst;
+  SLONG slByte = 0;
+
+  while (slByte < slSize) {
+    // count repeating bytes
+    SLONG ctRun = 1;
+    while (slByte + ctRun < slSize && ctRun < 128 && pubSrc[slByte + ctRun] == pubSrc[slByte]) ctRun++;
+
+    // only runs of at least three bytes are shorter than literals
+    if (ctRun >= 3) {
+      if (pubOut - pubDst + 2 > slMaxPacked) return -1;
+
+      *pubOut++ = UBYTE(257 - ctRun);
+      *pubOut++ = pubSrc[slByte];
+      slByte += ctRun;
+      continue;
+    }
+
+    // copy literal bytes until the next run
+    SLONG ctLiteral = 1;
+
+    while (slByte + ctLiteral < slSize && ctLiteral < 128) {
+      const SLONG slNext = slByte + ctLiteral;
+      if (slNext + 2 < slSize && pubSrc[slNext] == pubSrc[slNext + 1] && pubSrc[slNext] == pubSrc[slNext + 2]) break;
+      ctLiteral++;
+    }
+
+    if (pubOut - pubDst + 1 + ctLiteral > slMaxPacked) return -1;
+
+    *pubOut++ = UBYTE(ctLiteral - 1);
+    memcpy(pubOut, pubSrc + slByte, ctLiteral);
+    pubOut += ctLiteral;
+    slByte += ctLiteral;
+  }
+
+  return SLONG(pubOut - pubDst);
+}
+
+// [Cecil] Decode bytes encoded using PackBits
+static void UnpackBits(const UBYTE *pubSrc, UBYTE *pubDst, SLONG slSize)
+{
+  SLONG slByte = 0;
+
+  while (slByte < slSize) {
+    const UBYTE ubHeader = *pubSrc++;
+    SLONG ct;
+
+    if (ubHeader < 128) {
+      ct = ubHeader + 1;
+      memcpy(pubDst + slByte, pubSrc, ct);
+      pubSrc += ct;
+
+    } else {
+      ct = 257 - ubHeader;
+      memset(pubDst + slByte, *pubSrc++, ct);
+    }
+
+    slByte += ct;
+  }
+}
+
+// [Cecil] Get one byte encoded using PackBits without decoding the rest
+static UBYTE GetPackedByte(const UBYTE *pubSrc, SLONG slGetByte)
+{
+  SLONG slByte = 0;
+
+  for (;;) {
+    const UBYTE ubHeader = *pubSrc++;
+
+    if (ubHeader < 128) {
+      const SLONG ct = ubHeader + 1;
+      if (slGetByte < slByte + ct) return pubSrc[slGetByte - slByte];
+      pubSrc += ct;
+      slByte += ct;
+
+    } else {
+      const SLONG ct = 257 - ubHeader;
+      if (slGetByte < slByte + ct) return *pubSrc;
+      pubSrc++;
+      slByte += ct;
+    }
+  }
+}
+
+
+// [Cecil] Pack one pattern with some limit and make sure nothing is written past it and that it unpacks back
+static BOOL CheckPackedPattern(const UBYTE *pubSrc, SLONG slSize, SLONG slMaxPacked)
+{
+  // guard bytes right after the limit
+  const SLONG ctGuard = 16;
+  CStaticStackArray<UBYTE> aubPacked;
+  UBYTE *pubPacked = aubPacked.Push(slMaxPacked + ctGuard);
+  memset(pubPacked, 0xCD, slMaxPacked + ctGuard);
+
+  const SLONG slPacked = PackBits(pubSrc, slSize, pubPacked, slMaxPacked);
+
+  for (SLONG iGuard = 0; iGuard < ctGuard; iGuard++) {
+    if (pubPacked[slMaxPacked + iGuard] != 0xCD) return FALSE;
+  }
+
+  if (slPacked < 0) return TRUE;
+  if (slPacked > slMaxPacked) return FALSE;
+
+  CStaticStackArray<UBYTE> aubUnpacked;
+  UBYTE *pubUnpacked = aubUnpacked.Push(slSize);
+  UnpackBits(pubPacked, pubUnpacked, slSize);
+
+  if (memcmp(pubSrc, pubUnpacked, slSize) != 0) return FALSE;
+
+  for (SLONG slByte = 0; slByte < slSize; slByte += 7) {
+    if (GetPackedByte(pubPacked, slByte) != pubSrc[slByte]) return FALSE;
+  }
+
+  return TRUE;
+}
+
+// [Cecil] Pack shadow masks with patterns that are the hardest to encode
+void CheckShadowPacking(void)
+{
+  const SLONG aslSizes[] = { 1, 2, 3, 9, 128, 129, 300, 3000, 65536 / 8 };
+  const INDEX ctPatterns = 5;
+  static const char *astrPatterns[ctPatterns] = { "a bb c dd", "aab", "random", "same", "runs" };
+
+  INDEX ctFailed = 0;
+  ULONG ulRandom = 0x12345678;
+
+  for (INDEX iPattern = 0; iPattern < ctPatterns; iPattern++) {
+    for (INDEX iSize = 0; iSize < ARRAYCOUNT(aslSizes); iSize++) {
+      const SLONG slSize = aslSizes[iSize];
+      CStaticStackArray<UBYTE> aubSrc;
+      UBYTE *pubSrc = aubSrc.Push(slSize);
+
+      for (SLONG i = 0; i < slSize; i++) {
+        switch (iPattern) {
+          // single bytes and pairs one after another
+          case 0: { static const UBYTE aub[6] = { 1, 2, 2, 3, 4, 4 }; pubSrc[i] = aub[i % 6]; } break;
+          // pairs between single bytes
+          case 1: pubSrc[i] = UBYTE(i / 3 * 2 + ((i % 3) == 2)); break;
+          case 2: pubSrc[i] = UBYTE(NextRandomSeed(ulRandom) >> 16); break;
+          case 3: pubSrc[i] = 0xFF; break;
+          // runs of different lengths
+          default: pubSrc[i] = UBYTE((i * i / 37) & 1); break;
+        }
+      }
+
+      // limit that's used by the layers and the worst case without any limit
+      BOOL bPassed = CheckPackedPattern(pubSrc, slSize, slSize * 3 / 4)
+                  && CheckPackedPattern(pubSrc, slSize, slSize + slSize / 128 + 1);
+
+      // nothing should be rejected if there's enough space
+      CStaticStackArray<UBYTE> aubWorst;
+      UBYTE *pubWorst = aubWorst.Push(slSize + slSize / 128 + 1);
+      if (PackBits(pubSrc, slSize, pubWorst, slSize + slSize / 128 + 1) < 0) bPassed = FALSE;
+
+      if (!bPassed) {
+        CPrintF(TRANS("Packing '%s' pattern of %d bytes failed!\n"), astrPatterns[iPattern], slSize);
+        ctFailed++;
+      }
+    }
+  }
+
+  if (ctFailed == 0) {
+    CPrintF(TRANS("All shadow mask patterns have been packed correctly\n"));
+  }
+}
+
 
 CBrushShadowLayer::CBrushShadowLayer()
 {
@@ -47,6 +222,7 @@ CBrushShadowLayer::CBrushShadowLayer()
   bsl_pixSizeV = 0;
   bsl_slSizeInPixels = 0;
   bsl_pubLayer = NULL;
+  bsl_slPackedSize = 0; // [Cecil]
   bsl_colLastAnim = C_BLACK;
 }
 
@@ -66,10 +242,50 @@ void CBrushShadowLayer::DiscardShadows(void)
     FreeMemory(bsl_pubLayer);
     bsl_pubLayer = NULL;
     bsl_slSizeInPixels = 0;
+    bsl_slPackedSize = 0; // [Cecil]
   }
   bsl_ulFlags&=~(BSLF_CALCULATED|BSLF_ALLDARK|BSLF_ALLLIGHT);
 }
 
+// [Cecil] Run-length encode the bit mask if it's allowed and saves memory
+void CBrushShadowLayer::PackLayer(void)
+{
+  if (!shd_bCompressLayers || bsl_pubLayer == NULL || bsl_slPackedSize != 0) return;
+
+  const SLONG slSize = (bsl_slSizeInPixels + 7) / 8;
+  if (slSize <= 0) return;
+
+  // not worth decoding if it doesn't save at least a quarter
+  const SLONG slMaxPacked = slSize * 3 / 4;
+  if (slMaxPacked <= 0) return;
+
+  UBYTE *pubPacked = (UBYTE *)AllocMemoryTagged(slMaxPacked, MEM_SHADOWS);
+  const SLONG slPacked = PackBits(bsl_pubLayer, slSize, pubPacked, slMaxPacked);
+
+  if (slPacked < 0) {
+    FreeMemory(pubPacked);
+    return;
+  }
+
+  ShrinkMemory((void **)&pubPacked, slPacked);
+  FreeMemory(bsl_pubLayer);
+  bsl_pubLayer = pubPacked;
+  bsl_slPackedSize = slPacked;
+}
+
+// [Cecil] Get the bit mask, decoding it into a buffer if it's encoded
+UBYTE *CBrushShadowLayer::GetLayerMask(CStaticStackArray<UBYTE> &aubBuffer)
+{
+  if (bsl_slPackedSize == 0) return bsl_pubLayer;
+
+  const SLONG slSize = (bsl_slSizeInPixels + 7) / 8;
+  aubBuffer.PopAll();
+
+  UBYTE *pubMask = aubBuffer.Push(slSize);
+  UnpackBits(bsl_pubLayer, pubMask, slSize);
+  return pubMask;
+}
+
 
 /*
  * Discard shadow on the polygon.
@@ -187,10 +403,20 @@ FLOAT CBrushShadowLayer::GetLightStrength(PIX pixU, PIX pixV, FLOAT fLRRatio, FL
   ULONG ulOffsetDR = pixU1+pixV1*bsl_pixSizeU;
   // get light at the four pixels
   FLOAT fUL=0.0f, fUR=0.0f, fDL=0.0f, fDR=0.0f;
-  if (bsl_pubLayer[ulOffsetUL/8]&(1<<(ulOffsetUL%8))) { fUL = 1.0f; };
-  if (bsl_pubLayer[ulOffsetUR/8]&(1<<(ulOffsetUR%8))) { fUR = 1.0f; };
-  if (bsl_pubLayer[ulOffsetDL/8]&(1<<(ulOffsetDL%8))) { fDL = 1.0f; };
-  if (bsl_pubLayer[ulOffsetDR/8]&(1<<(ulOffsetDR%8))) { fDR = 1.0f; };
+
+  // [Cecil] Read bytes from the encoded mask
+  if (bsl_slPackedSize != 0) {
+    if (GetPackedByte(bsl_pubLayer, ulOffsetUL/8)&(1<<(ulOffsetUL%8))) { fUL = 1.0f; };
+    if (GetPackedByte(bsl_pubLayer, ulOffsetUR/8)&(1<<(ulOffsetUR%8))) { fUR = 1.0f; };
+    if (GetPackedByte(bsl_pubLayer, ulOffsetDL/8)&(1<<(ulOffsetDL%8))) { fDL = 1.0f; };
+    if (GetPackedByte(bsl_pubLayer, ulOffsetDR/8)&(1<<(ulOffsetDR%8))) { fDR = 1.0f; };
+
+  } else {
+    if (bsl_pubLayer[ulOffsetUL/8]&(1<<(ulOffsetUL%8))) { fUL = 1.0f; };
+    if (bsl_pubLayer[ulOffsetUR/8]&(1<<(ulOffsetUR%8))) { fUR = 1.0f; };
+    if (bsl_pubLayer[ulOffsetDL/8]&(1<<(ulOffsetDL%8))) { fDL = 1.0f; };
+    if (bsl_pubLayer[ulOffsetDR/8]&(1<<(ulOffsetDR%8))) { fDR = 1.0f; };
+  }
 
   // return interpolated value
   return Lerp( Lerp(fUL, fUR, fLRRatio), Lerp(fDL, fDR, fLRRatio), fUDRatio);
@@ -225,7 +451,7 @@ void CBrushShadowMap::ReadLayers_t( CTStream *pstrm)  // throw char *
         SLONG slLayerSize;
         *pstrm>>slLayerSize;
         if (slLayerSize != 0) {
-          pbsl->bsl_pubLayer = (UBYTE *)AllocMemory(slLayerSize);
+          pbsl->bsl_pubLayer = (UBYTE *)AllocMemoryTagged(slLayerSize, MEM_SHADOWS);
           pstrm->Read_t(pbsl->bsl_pubLayer, slLayerSize); // the bit packed layer mask
         } else {
           bUncalculated = TRUE;
@@ -324,8 +550,9 @@ void CBrushShadowMap::ReadLayers_t( CTStream *pstrm)  // throw char *
       *pstrm>>pbsl->bsl_slSizeInPixels;
       if (pbsl->bsl_slSizeInPixels != 0) {
         SLONG slLayerSize = (pbsl->bsl_slSizeInPixels+7)/8;
-        pbsl->bsl_pubLayer = (UBYTE *)AllocMemory(slLayerSize);
+        pbsl->bsl_pubLayer = (UBYTE *)AllocMemoryTagged(slLayerSize, MEM_SHADOWS);
         pstrm->Read_t(pbsl->bsl_pubLayer, slLayerSize); // the bit packed layer mask
+        pbsl->PackLayer(); // [Cecil]
       } else {
         bUncalculated = TRUE;
         pbsl->bsl_pubLayer = NULL;
@@ -374,6 +601,7 @@ void CBrushShadowMap::WriteLayers_t( CTStream *pstrm) // throw char *
     ctLayers++;
   }}
   *pstrm<<ctLayers;
+  CStaticStackArray<UBYTE> aubUnpacked; // [Cecil]
   // for each shadow layer
   FOREACHINLIST(CBrushShadowLayer, bsl_lnInShadowMap, bsm_lhLayers, itbsl) {
     CBrushShadowLayer &bsl = *itbsl;
@@ -387,7 +615,7 @@ void CBrushShadowMap::WriteLayers_t( CTStream *pstrm) // throw char *
     } else {
       *pstrm<<bsl.bsl_slSizeInPixels;
       SLONG slLayerSize = (bsl.bsl_slSizeInPixels+7)/8;
-      pstrm->Write_t(bsl.bsl_pubLayer, slLayerSize); // the bit packed layer mask
+      pstrm->Write_t(bsl.GetLayerMask(aubUnpacked), slLayerSize); // the bit packed layer mask
     }
     // write layer rectangle
     *pstrm<<bsl.bsl_pixMinU;
@@ -746,7 +974,8 @@ SLONG CBrushShadowMap::GetUsedMemory(void)
   FOREACHINLIST( CBrushShadowLayer, bsl_lnInShadowMap, bsm_lhLayers, itbsl) { // count shadow layers
     CBrushShadowLayer &bsl = *itbsl;
     slUsedMemory += sizeof(CBrushShadowLayer);
-    if( bsl.bsl_pubLayer!=NULL) slUsedMemory += bsl.bsl_pixSizeU * bsl.bsl_pixSizeV /8; 
+    if( bsl.bsl_slPackedSize!=0) slUsedMemory += bsl.bsl_slPackedSize; // [Cecil]
+    else if( bsl.bsl_pubLayer!=NULL) slUsedMemory += bsl.bsl_pixSizeU * bsl.bsl_pixSizeV /8; 
   }
 
   // done
@@ -89,6 +89,8 @@ static INDEX sys_iCPUModel = 0;
 static INDEX sys_iCPUStepping = 0;
 static BOOL  sys_bCPUHasMMX = 0;
 static BOOL  sys_bCPUHasCMOV = 0;
+       BOOL  sys_bCPUHasSSE2 = 0; // [Cecil]
+       BOOL  sys_bCPUHasAVX2 = 0; // [Cecil]
 static INDEX sys_iCPUMHz = 0;
        INDEX sys_iCPUMisc = 0;
 
@@ -113,6 +115,7 @@ static void DetectCPU(void)
   strVendor[12] = 0;
   ULONG ulTFMS = 0;
   ULONG ulFeatures = 0;
+  BOOL bAVX2 = FALSE; // [Cecil]
 
   // test MMX presence and update flag
 #if SE1_OLD_COMPILER || SE1_USE_ASM
@@ -157,6 +160,34 @@ static void DetectCPU(void)
 
   memcpy(&ulTFMS, &procID.EAX, 4);
   memcpy(&ulFeatures, &procID.EDX, 4);
+
+  // [Cecil] AVX2 can only be used if the OS saves AVX registers (OSXSAVE and AVX bits)
+  const UINT ulAVXBits = (1 << 27) | (1 << 28);
+
+  if ((procID.ECX & ulAVXBits) == ulAVXBits) {
+    UINT ulXCR0 = 0;
+
+    #if SE1_WIN
+      ulXCR0 = (UINT)_xgetbv(0);
+    #else
+      UINT ulXCR0High = 0;
+      __asm__ __volatile__(".byte 0x0F, 0x01, 0xD0" : "=a"(ulXCR0), "=d"(ulXCR0High) : "c"(0)); // xgetbv
+    #endif
+
+    // XMM and YMM state is enabled
+    if ((ulXCR0 & 6) == 6) {
+      #if SE1_WIN
+        __cpuid(procID.regs, 0);
+        const UINT ulMaxLeaf = procID.EAX;
+        if (ulMaxLeaf >= 7) __cpuidex(procID.regs, 7, 0);
+      #else
+        const UINT ulMaxLeaf = __get_cpuid_max(0, NULL);
+        if (ulMaxLeaf >= 7) __cpuid_count(7, 0, procID.EAX, procID.EBX, procID.ECX, procID.EDX);
+      #endif
+
+      bAVX2 = (ulMaxLeaf >= 7) && (procID.EBX & (1 << 5));
+    }
+  }
 #endif
 
   if (ulTFMS == 0) {
@@ -176,12 +207,15 @@ static void DetectCPU(void)
 
   BOOL bMMX  = ulFeatures & (1<<23);
   BOOL bCMOV = ulFeatures & (1<<15);
+  BOOL bSSE2 = ulFeatures & (1<<26); // [Cecil]
 
   const char *strYes = TRANS("Yes");
   const char *strNo = TRANS("No");
 
   CPrintF(TRANS("  MMX : %s\n"), bMMX ?strYes:strNo);
   CPrintF(TRANS("  CMOV: %s\n"), bCMOV?strYes:strNo);
+  CPrintF(TRANS("  SSE2: %s\n"), bSSE2?strYes:strNo); // [Cecil]
+  CPrintF(TRANS("  AVX2: %s\n"), bAVX2?strYes:strNo); // [Cecil]
   CPrintF(TRANS("  Clock: %.0fMHz\n"), _pTimer->GetCPUSpeedHz() / 1E6);
 
   sys_strCPUVendor = strVendor;
@@ -191,6 +225,8 @@ static void DetectCPU(void)
   sys_iCPUStepping = iStepping;
   sys_bCPUHasMMX = bMMX!=0;
   sys_bCPUHasCMOV = bCMOV!=0;
+  sys_bCPUHasSSE2 = bSSE2!=0; // [Cecil]
+  sys_bCPUHasAVX2 = bAVX2!=0; // [Cecil]
   sys_iCPUMHz = INDEX(_pTimer->GetCPUSpeedHz() / 1E6);
 
   if( !bMMX) FatalError( TRANS("MMX support required but not present!"));
@@ -329,6 +365,8 @@ void SE_InitEngine(const SeriousEngineSetup &engineSetup) {
   _pShell = new CShell;
   _pShell->Initialize();
 
+  IProfileTimeline::Init(); // [Cecil]
+
   _pTimer = new CTimer;
   _pGfx   = new CGfxLibrary;
   _pSound = new CSoundLibrary;
@@ -482,10 +520,12 @@ void SE_InitEngine(const SeriousEngineSetup &engineSetup) {
   extern INDEX wld_bFastObjectOptimization;
   extern INDEX fil_bPreferZips;
   extern FLOAT mth_fCSGEpsilon;
+  extern INDEX sys_iJobThreads; // [Cecil]
   _pShell->DeclareSymbol("user INDEX con_bNoWarnings;", &con_bNoWarnings);
   _pShell->DeclareSymbol("user INDEX wld_bFastObjectOptimization;", &wld_bFastObjectOptimization);
   _pShell->DeclareSymbol("user FLOAT mth_fCSGEpsilon;", &mth_fCSGEpsilon);
   _pShell->DeclareSymbol("persistent user INDEX fil_bPreferZips;", &fil_bPreferZips);
+  _pShell->DeclareSymbol("persistent user INDEX sys_iJobThreads;", &sys_iJobThreads); // [Cecil]
   // OS info
   _pShell->DeclareSymbol("user const CTString sys_strOS    ;", &sys_strOS);
   _pShell->DeclareSymbol("user const INDEX sys_iOSMajor    ;", &sys_iOSMajor);
@@ -500,6 +540,8 @@ void SE_InitEngine(const SeriousEngineSetup &engineSetup) {
   _pShell->DeclareSymbol("user const INDEX sys_iCPUStepping   ;", &sys_iCPUStepping);
   _pShell->DeclareSymbol("user const INDEX sys_bCPUHasMMX     ;", &sys_bCPUHasMMX  );
   _pShell->DeclareSymbol("user const INDEX sys_bCPUHasCMOV    ;", &sys_bCPUHasCMOV );
+  _pShell->DeclareSymbol("user const INDEX sys_bCPUHasSSE2    ;", &sys_bCPUHasSSE2 ); // [Cecil]
+  _pShell->DeclareSymbol("user const INDEX sys_bCPUHasAVX2    ;", &sys_bCPUHasAVX2 ); // [Cecil]
   _pShell->DeclareSymbol("user const INDEX sys_iCPUMHz        ;", &sys_iCPUMHz     );
   _pShell->DeclareSymbol("     const INDEX sys_iCPUMisc       ;", &sys_iCPUMisc    );
   // RAM info
@@ -594,6 +636,9 @@ void SE_InitEngine(const SeriousEngineSetup &engineSetup) {
 void SE_EndEngine(void) {
   ASSERT(_bSeriousEngineInitialized);
 
+  // [Cecil] Stop job threads before anything that they might use is gone
+  IJobs::Shutdown();
+
   // [Cecil] Remove default fonts *before* deleting the stocks, not after
   if (_pfdDisplayFont != NULL) { delete _pfdDisplayFont; _pfdDisplayFont = NULL; }
   if (_pfdConsoleFont != NULL) { delete _pfdConsoleFont; _pfdConsoleFont = NULL; }
@@ -143,6 +143,7 @@ CEntity::CEntity(void)
   en_fSpatialClassificationRadius = -1.0f;
   en_penParent = NULL;
   en_plpLastPositions = NULL;
+  en_iInCache = -1;
   _ctEntities++;
 }
 
@@ -725,6 +726,8 @@ void CEntity::Initialize_internal(const CEntityEvent &eeInput)
 
   // let derived class initialize according to the properties
   OnInitialize(eeInput);
+  // [Cecil] Render type and flags may have been set directly
+  UpdateCachedData();
   // derived class must set all properties
 //  ASSERT(en_RenderType != RT_ILLEGAL);
 
@@ -829,6 +832,7 @@ void CEntity::End_internal(void)
   }
   // clear entity type
   en_RenderType = RT_NONE;
+  UpdateCachedData(); // [Cecil]
 }
 
 // [Cecil] Reinitialize the entity with any event
@@ -1043,6 +1047,7 @@ void CEntity::SetPlacement_internal(const CPlacement3D &plNew, const FLOATmatrix
   // set new placement of the entity
   en_plPlacement = plNew;
   en_mRotation = mRotation;
+  UpdateCachedData(); // [Cecil]
   _pfPhysicsProfile.StopTimer(CPhysicsProfile::PTI_SETPLACEMENT_COORDSUPDATE);
 
   // if this is a brush entity
@@ -1169,6 +1174,15 @@ CPlacement3D CEntity::GetLerpedPlacement(void) const
 void CEntity::SetFlags(ULONG ulFlags)
 {
   en_ulFlags = ulFlags;
+  UpdateCachedData(); // [Cecil]
+}
+
+// [Cecil] Update data of this entity in the world's entity cache
+void CEntity::UpdateCachedData(void)
+{
+  if (en_iInCache >= 0) {
+    en_pwoWorld->wo_ecCache.UpdateEntity(this);
+  }
 }
 
 void CEntity::SetPhysicsFlags(ULONG ulFlags)
@@ -1273,6 +1287,7 @@ void CEntity::Destroy(void)
   en_rdSectors.Clear();
   // remove from active entities in the world
   en_pwoWorld->wo_cenEntities.Remove(this);
+  en_pwoWorld->wo_ecCache.RemoveEntity(this); // [Cecil]
   // remove the reference made by the entity itself (this can delete it!)
   RemReference();
 }
@@ -1782,6 +1797,7 @@ void CEntity::UpdateSpatialRange(void)
   // if zoning
   if (en_ulFlags&ENF_ZONING) {
     // do nothing
+    UpdateCachedData(); // [Cecil]
     return;
   }
 
@@ -1817,10 +1833,12 @@ void CEntity::UpdateSpatialRange(void)
     boxStretched = box;
     en_boxSpatialClassification = box;
   } else {
+    UpdateCachedData(); // [Cecil]
     return; // sound entities are not related to sectors !!!!
   }
   en_fSpatialClassificationRadius = Max( box.Min().Length(), box.Max().Length() );
   ASSERT(IsValidFloat(en_fSpatialClassificationRadius));
+  UpdateCachedData(); // [Cecil]
 }
 
 /* Find and remember all sectors that this entity is in. */
@@ -2065,8 +2083,22 @@ void CEntity::FindEntitiesInRange(
 {
   ASSERT(GetFPUPrecision()==FPT_24BIT);
 
+  // [Cecil] Check render types and flags in the entity cache to avoid touching every entity
+  CEntityCache &ec = en_pwoWorld->wo_ecCache;
+  const BOOL bUseCache = ec.Validate();
+  CDynamicContainer<CEntity> &cenEntities = en_pwoWorld->wo_cenEntities;
+  const INDEX ctEntities = cenEntities.Count();
+
   // for each entity in the world of this entity
-  FOREACHINDYNAMICCONTAINER(en_pwoWorld->wo_cenEntities, CEntity, iten) {
+  for (INDEX iEntity = 0; iEntity < ctEntities; iEntity++) {
+    // [Cecil] Skip non-zoning entities and zoning brushes far from the box using the cache
+    if (bUseCache) {
+      if (ec.ec_aubRenderTypes[iEntity] != RT_BRUSH || !(ec.ec_aulFlags[iEntity] & ENF_ZONING)) continue;
+      if (ec.IsOutsideBox(iEntity, boxRange)) continue;
+    }
+
+    CEntity *iten = cenEntities.Pointer(iEntity);
+
     // if it is zoning brush entity
     if (iten->en_RenderType == CEntity::RT_BRUSH && (iten->en_ulFlags&ENF_ZONING)) {
       // get first mip in its brush
@@ -2189,6 +2221,10 @@ void CEntity::HandleSentEvents(void)
     }
     // if the entity is not destroyed
     if (!(se.se_penEntity->en_ulFlags&ENF_DELETED)) {
+      // [Cecil] Measure it under the entity class
+      const INDEX iWork = (se.se_peeEvent->ee_slEvent == EVENTCODE_ETimer ? ECW_TIMERS : ECW_EVENTS);
+      CEntityClassTimer ect(se.se_penEntity, iWork);
+
       // handle the current event
       se.se_penEntity->HandleEvent(*se.se_peeEvent);
     }
@@ -2348,6 +2384,7 @@ void CEntity::SwitchToModel(void)
     // it must be model (not brush)
     ASSERT(FALSE);
   }
+  UpdateCachedData(); // [Cecil]
 }
 void CEntity::SwitchToEditorModel(void)
 {
@@ -2360,6 +2397,7 @@ void CEntity::SwitchToEditorModel(void)
     // it must be model (not brush)
     ASSERT(FALSE);
   }
+  UpdateCachedData(); // [Cecil]
 }
 
 /////////////////////////////////////////////////////////////////////
@@ -3498,29 +3536,35 @@ void CEntity::Precache(void)
 
 void CEntity::ChecksumForSync(ULONG &ulCRC, INDEX iExtensiveSyncCheck)
 {
+  // [Cecil] Gather all values in the same order to add them at once
+  ULONG aulValues[13];
+  INDEX ctValues = 0;
+
   if (iExtensiveSyncCheck>0) {
-    CRC_AddLONG(ulCRC, en_ulFlags&~
-      (ENF_SELECTED|ENF_INRENDERING|ENF_VALIDSHADINGINFO|ENF_FOUNDINGRIDSEARCH|ENF_WILLBEPREDICTED|ENF_PREDICTABLE));
-    CRC_AddLONG(ulCRC, en_ulPhysicsFlags);
-    CRC_AddLONG(ulCRC, en_ulCollisionFlags);
-    CRC_AddLONG(ulCRC, en_ctReferences);
+    aulValues[ctValues++] = en_ulFlags&~
+      (ENF_SELECTED|ENF_INRENDERING|ENF_VALIDSHADINGINFO|ENF_FOUNDINGRIDSEARCH|ENF_WILLBEPREDICTED|ENF_PREDICTABLE);
+    aulValues[ctValues++] = en_ulPhysicsFlags;
+    aulValues[ctValues++] = en_ulCollisionFlags;
+    aulValues[ctValues++] = en_ctReferences;
   }
-  CRC_AddLONG(ulCRC, en_RenderType);
+  aulValues[ctValues++] = en_RenderType;
   if (iExtensiveSyncCheck>0) {
-    CRC_AddLONG(ulCRC, en_ulID);
-    CRC_AddFLOAT(ulCRC, en_fSpatialClassificationRadius);
-    CRC_AddFLOAT(ulCRC, en_plPlacement.pl_PositionVector(1));
-    CRC_AddFLOAT(ulCRC, en_plPlacement.pl_PositionVector(2));
-    CRC_AddFLOAT(ulCRC, en_plPlacement.pl_PositionVector(3));
-    CRC_AddFLOAT(ulCRC, en_plPlacement.pl_OrientationAngle(1));
-    CRC_AddFLOAT(ulCRC, en_plPlacement.pl_OrientationAngle(2));
-    CRC_AddFLOAT(ulCRC, en_plPlacement.pl_OrientationAngle(3));
+    aulValues[ctValues++] = en_ulID;
+    aulValues[ctValues++] = (ULONG &)en_fSpatialClassificationRadius;
+    aulValues[ctValues++] = (ULONG &)en_plPlacement.pl_PositionVector(1);
+    aulValues[ctValues++] = (ULONG &)en_plPlacement.pl_PositionVector(2);
+    aulValues[ctValues++] = (ULONG &)en_plPlacement.pl_PositionVector(3);
+    aulValues[ctValues++] = (ULONG &)en_plPlacement.pl_OrientationAngle(1);
+    aulValues[ctValues++] = (ULONG &)en_plPlacement.pl_OrientationAngle(2);
+    aulValues[ctValues++] = (ULONG &)en_plPlacement.pl_OrientationAngle(3);
+    CRC_AddLONGs(ulCRC, aulValues, ctValues);
 
     CRC_AddBlock(ulCRC, (UBYTE*)(void*)&en_mRotation, sizeof(en_mRotation));
   } else {
-    CRC_AddLONG(ulCRC, (int)en_plPlacement.pl_PositionVector(1));
-    CRC_AddLONG(ulCRC, (int)en_plPlacement.pl_PositionVector(2));
-    CRC_AddLONG(ulCRC, (int)en_plPlacement.pl_PositionVector(3));
+    aulValues[ctValues++] = (int)en_plPlacement.pl_PositionVector(1);
+    aulValues[ctValues++] = (int)en_plPlacement.pl_PositionVector(2);
+    aulValues[ctValues++] = (int)en_plPlacement.pl_PositionVector(3);
+    CRC_AddLONGs(ulCRC, aulValues, ctValues);
   }
 }
 
@@ -3738,6 +3782,17 @@ void CLiveEntity::ReceiveDamage(CEntity *penInflictor, enum DamageType dmtType,
  */
 CRationalEntity::CRationalEntity(void)
 {
+  en_iInTimers = -1;
+  en_llTimerOrder = 0;
+}
+
+// [Cecil] Destructor
+CRationalEntity::~CRationalEntity(void)
+{
+  // make sure the world doesn't keep the entity as a timer
+  if (IsWaitingForTimer() && en_pwoWorld != NULL) {
+    en_pwoWorld->RemoveTimer(this);
+  }
 }
 
 /* Calculate physics for moving. */
@@ -3783,8 +3838,12 @@ void CRationalEntity::Copy(CEntity &enOther, ULONG ulFlags)
     CRationalEntity *prenOther = (CRationalEntity *)(&enOther);
     en_tckTimer = prenOther->en_tckTimer;
     en_stslStateStack = prenOther->en_stslStateStack;
-    if (prenOther->en_lnInTimers.IsLinked()) {
+    if (prenOther->IsWaitingForTimer()) {
       en_pwoWorld->AddTimer(this);
+
+    // [Cecil] Stay among the timers like before, but with the new tick
+    } else if (IsWaitingForTimer()) {
+      en_pwoWorld->UpdateTimer(this);
     }
   }
 }
@@ -3833,7 +3892,7 @@ void CRationalEntity::Write_t( CTStream *ostr) // throw char *
 {
   CLiveEntity::Write_t(ostr);
   // if not currently waiting for thinking
-  if (!en_lnInTimers.IsLinked()) {
+  if (!IsWaitingForTimer()) {
     // set dummy thinking time as a flag for later loading
     en_tckTimer = THINKTIME_NEVER;
   }
@@ -3869,8 +3928,8 @@ void CRationalEntity::SetTickAt(TICK tckAbsolute)
   if (en_tckTimer != THINKTIME_NEVER) {
     en_pwoWorld->AddTimer(this);
 
-  } else if (en_lnInTimers.IsLinked()) {
-    en_lnInTimers.Remove();
+  } else if (IsWaitingForTimer()) {
+    en_pwoWorld->RemoveTimer(this);
   }
 };
 
@@ -3884,8 +3943,8 @@ void CRationalEntity::SetTickAfter(TICK tckDelta) {
 void CRationalEntity::UnsetTimer(void)
 {
   en_tckTimer = THINKTIME_NEVER;
-  if (en_lnInTimers.IsLinked()) {
-    en_lnInTimers.Remove();
+  if (IsWaitingForTimer()) {
+    en_pwoWorld->RemoveTimer(this);
   }
 }
 
@@ -4001,8 +4060,8 @@ void CRationalEntity::OnInitialize(const CEntityEvent &eeInput)
 
   // do not think
   en_tckTimer = THINKTIME_NEVER;
-  if (en_lnInTimers.IsLinked()) {
-    en_lnInTimers.Remove();
+  if (IsWaitingForTimer()) {
+    en_pwoWorld->RemoveTimer(this);
   }
 
   // initialize state stack
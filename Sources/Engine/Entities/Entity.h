@@ -197,6 +197,7 @@ public:
   CLastPositions *en_plpLastPositions;    // last positions of entity
 
   class CWorld *en_pwoWorld;      // the world this entity belongs to
+  INDEX en_iInCache;              // [Cecil] Index in the world's entity cache (-1 if not in it)
 
 public: // imagine that this is private
   CRelationDst en_rdSectors;      // relation to sectors this entity is in
@@ -496,6 +497,8 @@ public:
   void Teleport(const CPlacement3D &plNew, BOOL bTelefrag=TRUE);
 
   void SetFlags(ULONG ulFlags);
+  // [Cecil] Update data of this entity in the world's entity cache
+  void UpdateCachedData(void);
   inline ULONG GetFlags(void) const { return en_ulFlags; };
   inline void SetSpawnFlags(ULONG ulFlags) { en_ulSpawnFlags = ulFlags; }
   inline ULONG GetSpawnFlags(void) const { return en_ulSpawnFlags; };
@@ -789,7 +792,10 @@ public:
  */
 class ENGINE_API CRationalEntity : public CLiveEntity {
 public:
-  CListNode en_lnInTimers;    // node in list of waiting timers - sorted by wait time
+  // [Cecil] Place in the world's heap of waiting timers (-1 if not in it)
+  INDEX en_iInTimers;
+  // [Cecil] Order among waiting timers with the same tick
+  SQUAD en_llTimerOrder;
 public:
   TICK en_tckTimer; // [Cecil] Moment in time this entity waits for timer (now in ticks instead of seconds)
 
@@ -835,6 +841,11 @@ public:
   /* Cancel eventual pending timer. */
   void UnsetTimer(void);
 
+  // [Cecil] Check if waiting for a timer event
+  inline BOOL IsWaitingForTimer(void) const {
+    return en_iInTimers >= 0;
+  };
+
   // [Cecil] Deprecated wrappers for new tick functions
   __forceinline void SetTimerAt(TIME tm) {
     if (tm == THINKTIME_NEVER) {
@@ -855,6 +866,8 @@ public:
 public:
   /* Constructor. */
   CRationalEntity(void);
+  // [Cecil] Destructor
+  ~CRationalEntity(void);
 
   /* Handle an event - return false if event was not handled. */
   virtual BOOL HandleEvent(const CEntityEvent &ee);
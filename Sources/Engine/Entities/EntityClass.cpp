@@ -22,6 +22,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Entities/Precaching.h>
 #include <Engine/Base/Translation.h>
 #include <Engine/Base/CRCTable.h>
+#include <Engine/Base/Timer.h>
 
 #include <Engine/Templates/Stock_CEntityClass.h>
 
@@ -35,6 +36,7 @@ CEntityClass::CEntityClass(void)
 {
   ec_fnmClassDLL.Clear();
   ec_pdecDLLClass = NULL;
+  ResetProfile(); // [Cecil]
 }
 /*
  * Constructor for a fixed class.
@@ -43,6 +45,7 @@ CEntityClass::CEntityClass(class CDLLEntityClass *pdecDLLClass)
 {
   ec_pdecDLLClass = pdecDLLClass;
   ec_fnmClassDLL.Clear();
+  ResetProfile(); // [Cecil]
 }
 
 /*
@@ -86,6 +89,176 @@ void CEntityClass::Clear(void)
   ec_fnmClassDLL.Clear();
 }
 
+// [Cecil] Measure time spent in entities of each class
+INDEX ent_bProfileClasses = FALSE;
+
+// [Cecil] Start measuring time from scratch
+void CEntityClass::ResetProfile(void)
+{
+  for (INDEX i = 0; i < ECW_MAX; i++) {
+    ec_allProfileTime[i] = 0;
+    ec_actProfileCalls[i] = 0;
+  }
+
+  ec_llProfileTickTime = 0;
+}
+
+// [Cecil] Get total time spent in all kinds of work
+SQUAD CEntityClass::GetProfileTime(void) const
+{
+  SQUAD llTotal = 0;
+
+  for (INDEX i = 0; i < ECW_MAX; i++) {
+    llTotal += ec_allProfileTime[i];
+  }
+
+  return llTotal;
+}
+
+// [Cecil] Innermost running measurement (entity logic only runs on one thread)
+static CEntityClassTimer *_pectCurrent = NULL;
+
+void CEntityClassTimer::Start(CEntity *pen, INDEX iWork)
+{
+  if (pen == NULL || pen->en_pecClass == NULL) return;
+
+  ect_pecClass = pen->en_pecClass;
+  ect_iWork = iWork;
+  ect_llTime = 0;
+  ect_llStarted = _pTimer->GetHighPrecisionTimer().tv_llValue;
+
+  // Pause the outer measurement
+  ect_pectOuter = _pectCurrent;
+
+  if (ect_pectOuter != NULL) {
+    ect_pectOuter->ect_llTime += ect_llStarted - ect_pectOuter->ect_llStarted;
+  }
+
+  _pectCurrent = this;
+}
+
+void CEntityClassTimer::Stop(void)
+{
+  const SQUAD llNow = _pTimer->GetHighPrecisionTimer().tv_llValue;
+  const SQUAD llTime = ect_llTime + (llNow - ect_llStarted);
+
+  ect_pecClass->ec_allProfileTime[ect_iWork] += llTime;
+  ect_pecClass->ec_actProfileCalls[ect_iWork]++;
+  ect_pecClass->ec_llProfileTickTime += llTime;
+
+  // Resume the outer measurement
+  _pectCurrent = ect_pectOuter;
+
+  if (ect_pectOuter != NULL) {
+    ect_pectOuter->ect_llStarted = llNow;
+  }
+}
+
+// [Cecil] Find the class whose entities took the most time since the last call and start counting anew
+CEntityClass *TakeSlowestEntityClass(SQUAD &llTime)
+{
+  CEntityClass *pecSlowest = NULL;
+  llTime = 0;
+
+  if (_pEntityClassStock == NULL) return NULL;
+
+  FOREACHINDYNAMICCONTAINER(_pEntityClassStock->st_ctObjects, CEntityClass, itec) {
+    CEntityClass &ec = *itec;
+
+    if (ec.ec_llProfileTickTime > llTime) {
+      pecSlowest = &ec;
+      llTime = ec.ec_llProfileTickTime;
+    }
+
+    ec.ec_llProfileTickTime = 0;
+  }
+
+  return pecSlowest;
+}
+
+// [Cecil] Sort classes from the slowest to the fastest
+static int qsort_CompareClassTimes(const void *pv0, const void *pv1)
+{
+  const SQUAD ll0 = (*(CEntityClass **)pv0)->GetProfileTime();
+  const SQUAD ll1 = (*(CEntityClass **)pv1)->GetProfileTime();
+
+  if (ll0 > ll1) return -1;
+  if (ll0 < ll1) return +1;
+  return 0;
+}
+
+// [Cecil] Print classes whose entities took the most time since the last reset
+void ListEntityClassTimes(INDEX ctTop)
+{
+  if (!ent_bProfileClasses) {
+    CPrintF(TRANS("Entity classes aren't being measured (ent_bProfileClasses is disabled)\n"));
+  }
+
+  // Gather all measured classes
+  CStaticStackArray<CEntityClass *> apecClasses;
+  SQUAD llTotal = 0;
+
+  if (_pEntityClassStock != NULL) {
+    FOREACHINDYNAMICCONTAINER(_pEntityClassStock->st_ctObjects, CEntityClass, itec) {
+      const SQUAD llTime = itec->GetProfileTime();
+      if (llTime <= 0) continue;
+
+      apecClasses.Push() = itec;
+      llTotal += llTime;
+    }
+  }
+
+  const INDEX ctClasses = apecClasses.Count();
+
+  if (ctClasses == 0) {
+    CPrintF(TRANS("No time has been measured\n"));
+    return;
+  }
+
+  qsort(&apecClasses[0], ctClasses, sizeof(CEntityClass *), qsort_CompareClassTimes);
+
+  // List all classes if no amount is specified
+  if (ctTop <= 0 || ctTop > ctClasses) {
+    ctTop = ctClasses;
+  }
+
+  const DOUBLE dToMs = 1000.0 / (DOUBLE)_llTimerValueSecondLen;
+
+  CPrintF("%-24s %9s %6s %9s %9s %9s %9s %9s %8s\n", "Class", "Total ms", "Share",
+    "Events", "Timers", "PreMove", "DoMove", "PostMove", "Calls");
+
+  for (INDEX i = 0; i < ctTop; i++) {
+    const CEntityClass &ec = *apecClasses[i];
+    const SQUAD llTime = ec.GetProfileTime();
+
+    INDEX ctCalls = 0;
+
+    for (INDEX iWork = 0; iWork < ECW_MAX; iWork++) {
+      ctCalls += ec.ec_actProfileCalls[iWork];
+    }
+
+    const char *strClass = (ec.ec_pdecDLLClass != NULL ? ec.ec_pdecDLLClass->dec_strName : "?");
+
+    CPrintF("%-24s %9.2f %5.1f%% %9.2f %9.2f %9.2f %9.2f %9.2f %8d\n", strClass,
+      llTime * dToMs, (DOUBLE)llTime / (DOUBLE)llTotal * 100.0,
+      ec.ec_allProfileTime[ECW_EVENTS] * dToMs, ec.ec_allProfileTime[ECW_TIMERS] * dToMs,
+      ec.ec_allProfileTime[ECW_PREMOVING] * dToMs, ec.ec_allProfileTime[ECW_DOMOVING] * dToMs,
+      ec.ec_allProfileTime[ECW_POSTMOVING] * dToMs, ctCalls);
+  }
+
+  CPrintF(TRANS("Total: %.2f ms in %d classes\n"), llTotal * dToMs, ctClasses);
+}
+
+// [Cecil] Start measuring all entity classes from scratch
+void ResetEntityClassTimes(void)
+{
+  if (_pEntityClassStock == NULL) return;
+
+  FOREACHINDYNAMICCONTAINER(_pEntityClassStock->st_ctObjects, CEntityClass, itec) {
+    itec->ResetProfile();
+  }
+}
+
 /* Check that all properties have been properly declared. */
 void CEntityClass::CheckClassProperties(void)
 {
@@ -23,6 +23,20 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Entities/Entity.h>
 #include <Engine/Entities/EntityProperties.h> /* rcg10042001 */
 
+// [Cecil] Measure time spent in entities of each class
+ENGINE_API extern INDEX ent_bProfileClasses;
+
+// [Cecil] Kinds of work that's measured per entity class
+enum EEntityClassWork {
+  ECW_EVENTS = 0, // Handling events other than timers
+  ECW_TIMERS,     // Handling timer events of thinkers
+  ECW_PREMOVING,
+  ECW_DOMOVING,
+  ECW_POSTMOVING,
+
+  ECW_MAX,
+};
+
 /*
  *  General structure of an entity class.
  */
@@ -32,6 +46,11 @@ public:
   OS::EngineModule ec_mdClassDLL;         // handle to the DLL with the class
   class CDLLEntityClass *ec_pdecDLLClass; // pointer to DLL class in the DLL
 
+  // [Cecil] Time (in timer units) and calls of entity work since the last reset
+  SQUAD ec_allProfileTime[ECW_MAX];
+  INDEX ec_actProfileCalls[ECW_MAX];
+  SQUAD ec_llProfileTickTime; // Total time since the last TakeSlowestEntityClass() call
+
   /* Default constructor. */
   CEntityClass(void);
   /* Constructor for a fixed class. */
@@ -48,6 +67,11 @@ public:
   /* Check that all properties have been properly declared. */
   void CheckClassProperties(void);
 
+  // [Cecil] Start measuring time from scratch
+  void ResetProfile(void);
+  // [Cecil] Get total time spent in all kinds of work
+  SQUAD GetProfileTime(void) const;
+
   /* Construct a new member of the class. */
   class CEntity *New(void);
 
@@ -72,6 +96,31 @@ public:
   void AddToCRCTable(void);
 };
 
+// [Cecil] Measures one piece of work of an entity under its class while it's in scope
+// Time of nested measurements is only attributed to the innermost one
+class ENGINE_API CEntityClassTimer {
+  private:
+    CEntityClass *ect_pecClass; // NULL if not measuring
+    INDEX ect_iWork;
+    SQUAD ect_llStarted; // When the measurement (re)started
+    SQUAD ect_llTime; // Time measured until the last nested measurement
+    CEntityClassTimer *ect_pectOuter;
+
+    void Start(CEntity *pen, INDEX iWork);
+    void Stop(void);
+
+  public:
+    inline CEntityClassTimer(CEntity *pen, INDEX iWork) : ect_pecClass(NULL) {
+      if (ent_bProfileClasses) Start(pen, iWork);
+    };
+
+    inline ~CEntityClassTimer() {
+      if (ect_pecClass != NULL) Stop();
+    };
+};
+
+// [Cecil] Find the class whose entities took the most time since the last call and start counting anew
+ENGINE_API CEntityClass *TakeSlowestEntityClass(SQUAD &llTime);
 
 #endif  /* include-once check. */
 
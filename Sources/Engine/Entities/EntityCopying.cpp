@@ -134,6 +134,7 @@ void CEntity::Copy(CEntity &enOther, ULONG ulFlags)
   en_ulFlags        = enOther.en_ulFlags &
     ~(ENF_SELECTED|ENF_FOUNDINGRIDSEARCH|ENF_VALIDSHADINGINFO|ENF_INRENDERING);
   en_ulSpawnFlags   = enOther.en_ulSpawnFlags;
+  UpdateCachedData(); // [Cecil]
 
   // if prediction
   if (bMakePredictor) {
@@ -705,6 +706,7 @@ void CWorld::CopyEntitiesToPredictors(CDynamicContainer<CEntity> &cenToCopy)
     // copy spatial classification
     penCopy->en_fSpatialClassificationRadius = penOriginal->en_fSpatialClassificationRadius;
     penCopy->en_boxSpatialClassification     = penOriginal->en_boxSpatialClassification;
+    penCopy->UpdateCachedData(); // [Cecil]
     // copy collision info
     penCopy->CopyCollisionInfo(*penOriginal);
     // for each sector around the original
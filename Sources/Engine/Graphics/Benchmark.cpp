@@ -22,6 +22,9 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include <Engine/Graphics/ViewPort.h>
 #include <Engine/Graphics/DrawPort.h>
+#include <Engine/Graphics/Raster.h>
+#include <Engine/Graphics/Gfx_wrapper_Counting.h> // [Cecil]
+#include <Engine/Base/Statistics_internal.h> // [Cecil]
 
 #include <Engine/Templates/StaticArray.cpp>
 #include <Engine/Templates/StaticStackArray.cpp>
@@ -440,3 +443,166 @@ void CGfxLibrary::Benchmark(CViewPort *pvp, CDrawPort *pdp)
   EndTris();
   EndTexture();
 }
+
+
+// [Cecil] Rendering stages that are timed by the rendering benchmark
+static const INDEX _aiRenderStages[] = {
+  CStatForm::STI_WORLDTRANSFORM,
+  CStatForm::STI_WORLDVISIBILITY,
+  CStatForm::STI_WORLDRENDERING,
+  CStatForm::STI_MODELSETUP,
+  CStatForm::STI_MODELRENDERING,
+  CStatForm::STI_PARTICLERENDERING,
+  CStatForm::STI_FLARESRENDERING,
+  CStatForm::STI_SHADOWUPDATE,
+  CStatForm::STI_EFFECTRENDER,
+  CStatForm::STI_GFXAPI,
+};
+
+static const char *_astrRenderStages[] = {
+  "transform",
+  "visibility",
+  "world",
+  "model setup",
+  "models",
+  "particles",
+  "flares",
+  "shadows",
+  "effect tex",
+  "gfx api",
+};
+
+// [Cecil] Fly through some world and time each rendering stage on the CPU
+// (graphical API is replaced with one that only counts calls but still lets world and models render through it,
+// so it works on dedicated servers)
+void BenchmarkRenderView(void *pArgs)
+{
+  const CTString strWorld = *NEXTARGUMENT(CTString *);
+  const INDEX ctFrames = Clamp(NEXTARGUMENT(INDEX), (INDEX)1, (INDEX)100000);
+
+  if (_pGfx->GetCurrentAPI() != GAT_NONE) {
+    CPrintF(TRANS("Rendering benchmark can only be used without a graphical API!\n"));
+    return;
+  }
+
+  CWorld woBenchmark;
+  CWorld *pwo = &woBenchmark;
+
+  try {
+    woBenchmark.Load_t(strWorld);
+  } catch (char *strError) {
+    CPrintF(TRANS("Cannot load world: %s\n"), strError);
+    return;
+  }
+
+  // gather entities inside sectors to fly through
+  CStaticStackArray<FLOAT3D> avEntities;
+
+  {FOREACHINDYNAMICCONTAINER(pwo->wo_cenEntities, CEntity, iten) {
+    if (!iten->en_rdSectors.IsEmpty()) {
+      avEntities.Push() = iten->en_plPlacement.pl_PositionVector;
+    }
+  }}
+
+  if (avEntities.Count() == 0) {
+    CPrintF(TRANS("No entities to fly through!\n"));
+    return;
+  }
+
+  // pick a limited amount of points along the path
+  const INDEX ctMaxPoints = 32;
+  const INDEX iStep = (avEntities.Count() + ctMaxPoints - 1) / ctMaxPoints;
+  CStaticStackArray<FLOAT3D> avPath;
+
+  for (INDEX iEntity = 0; iEntity < avEntities.Count(); iEntity += iStep) {
+    avPath.Push() = avEntities[iEntity] + FLOAT3D(0.0f, 1.0f, 0.0f);
+  }
+
+  const INDEX ctPoints = avPath.Count();
+  const INDEX ctStages = ARRAYCOUNT(_aiRenderStages);
+  ASSERT(ctStages == ARRAYCOUNT(_astrRenderStages));
+
+  // render into a raster without any window
+  CRaster raRender(640, 480, 0);
+  CDrawPort &dp = raRender.ra_MainDrawPort;
+
+  IGfxInterface *pgiOld = _pGfx->gl_pInterface;
+  IGfxCounting gfxCounting;
+  _pGfx->gl_pInterface = &gfxCounting;
+
+  CTimerValue atvStages[ARRAYCOUNT(_aiRenderStages)];
+
+  for (INDEX iStage = 0; iStage < ctStages; iStage++) {
+    atvStages[iStage] = _sfStats.sf_astTimers[_aiRenderStages[iStage]].st_tvElapsed;
+  }
+
+  DOUBLE dTotal = 0.0;
+  DOUBLE dWorst = 0.0;
+  CPlacement3D plCamera(FLOAT3D(0.0f, 0.0f, 0.0f), ANGLE3D(0.0f, 0.0f, 0.0f));
+
+  for (INDEX iFrame = 0; iFrame < ctFrames; iFrame++) {
+    // look around in one place
+    if (ctPoints == 1) {
+      plCamera.pl_PositionVector = avPath[0];
+      plCamera.pl_OrientationAngle(1) = FLOAT(iFrame) * 360.0f / ctFrames;
+
+    // move between points and look at the next one
+    } else {
+      const FLOAT fPath = FLOAT(iFrame) * (ctPoints - 1) / ctFrames;
+      const INDEX iPoint = Clamp((INDEX)fPath, (INDEX)0, ctPoints - 2);
+      const FLOAT3D &v0 = avPath[iPoint];
+      const FLOAT3D &v1 = avPath[iPoint + 1];
+      plCamera.pl_PositionVector = Lerp(v0, v1, fPath - iPoint);
+
+      FLOAT3D vDir = v1 - v0;
+
+      if (vDir.Length() > 0.01f) {
+        DirectionVectorToAngles(vDir.Normalize(), plCamera.pl_OrientationAngle);
+      }
+    }
+
+    CPerspectiveProjection3D prPerspective;
+    prPerspective.FOVL() = 90.0f;
+    prPerspective.ScreenBBoxL() = FLOATaabbox2D(FLOAT2D(0.0f, 0.0f), FLOAT2D((FLOAT)dp.GetWidth(), (FLOAT)dp.GetHeight()));
+    prPerspective.AspectRatioL() = 1.0f;
+    prPerspective.FrontClipDistanceL() = 0.3f;
+
+    CAnyProjection3D prProjection;
+    prProjection = prPerspective;
+    prProjection->ViewerPlacementL() = plCamera;
+
+    CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+
+    if (dp.Lock()) {
+      RenderView(*pwo, *(CEntity *)NULL, prProjection, dp);
+      dp.Unlock();
+    }
+
+    const DOUBLE dFrame = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+    dTotal += dFrame;
+    dWorst = Max(dWorst, dFrame);
+
+    // advance frames like after swapping buffers
+    _pGfx->gl_tvFrameTime = _pTimer->GetHighPrecisionTimer();
+    _pGfx->gl_iFrameNumber++;
+  }
+
+  _pGfx->gl_pInterface = pgiOld;
+
+  const IGfxCounting::Counters_t &gc = gfxCounting.gc_Counters;
+  const DOUBLE dFrames = ctFrames;
+
+  CPrintF(TRANS("Rendered %d frames of '%s' along %d points at %dx%d:\n"),
+    ctFrames, pwo->wo_fnmFileName.ConstData(), ctPoints, dp.GetWidth(), dp.GetHeight());
+  CPrintF(TRANS("  frame time:   %.3f ms average, %.3f ms worst\n"), dTotal * 1000.0 / dFrames, dWorst * 1000.0);
+
+  for (INDEX iStage = 0; iStage < ctStages; iStage++) {
+    const CTimerValue tvElapsed = _sfStats.sf_astTimers[_aiRenderStages[iStage]].st_tvElapsed - atvStages[iStage];
+    CPrintF("  %-13s %.3f ms\n", (CTString(_astrRenderStages[iStage]) + ":").ConstData(), tvElapsed.GetSeconds() * 1000.0 / dFrames);
+  }
+
+  CPrintF(TRANS("Per frame: %.1f draw calls, %.1f triangles, %.1f vertices, %.1f state changes, %.1f matrix changes\n"),
+    gc.ctDrawCalls / dFrames, gc.ctTriangles / dFrames, gc.ctVertices / dFrames, gc.ctStateChanges / dFrames, gc.ctMatrixChanges / dFrames);
+  CPrintF(TRANS("Textures: %.1f binds per frame, %d created, %d uploads (%.2f Mpix)\n"),
+    gc.ctTextureBinds / dFrames, gc.ctTexturesMade, gc.ctUploads, gc.slUploadPixels / 1000000.0);
+}
@@ -51,6 +51,8 @@ static CDrawPort *_pDP;
 static CStaticStackArray<GFXTexCoord> _atexFogHaze;
 static CTextureData *_ptd = NULL;
 static INDEX _iFrame = 0;
+static BOOL _bPerspective = FALSE; // [Cecil]
+static INDEX _ctQueuedParticles = 0; // [Cecil] All particles since the last flush (including rejected ones)
 
 
 
@@ -61,6 +63,7 @@ void Particle_PrepareSystem( CDrawPort *pdpDrawPort, CAnyProjection3D &prProject
   _pprProjection = (CProjection3D*)&*prProjection;
   _fNearClipDistance = -prProjection->pr_NearClipDistance;
   _fPerspectiveFactor = 1.0f;
+  _bPerspective = prProjection.IsPerspective(); // [Cecil]
   _Particle_iCurrentDrawPort = pdpDrawPort->GetID();
   
   // prepare projection and scale factor
@@ -191,6 +194,8 @@ void Particle_SetTexturePart( MEX mexWidth, MEX mexHeight, INDEX iCol, INDEX iRo
 // add one particle square to rendering queue
 void Particle_RenderSquare( const FLOAT3D &vPos, FLOAT fSize, ANGLE aRotation, COLOR col, FLOAT fYRatio/*=1.0f*/)
 {
+  _ctQueuedParticles++; // [Cecil]
+
   // trivial rejection
   if( fSize<0.0001f || ((col&CT_AMASK)>>CT_ASHIFT)<2) return;
 
@@ -288,6 +293,8 @@ void Particle_RenderSquare( const FLOAT3D &vPos, FLOAT fSize, ANGLE aRotation, C
 // add one particle line to rendering queue
 void Particle_RenderLine( const FLOAT3D &vPos0, const FLOAT3D &vPos1, FLOAT fWidth, COLOR col)
 {
+  _ctQueuedParticles++; // [Cecil]
+
   // trivial rejection
   if( fWidth<0 || ((col&CT_AMASK)>>CT_ASHIFT)<2) return;
 
@@ -304,8 +311,14 @@ void Particle_RenderLine( const FLOAT3D &vPos0, const FLOAT3D &vPos1, FLOAT fWid
   const FLOAT fR1 = fWidth * _fPerspectiveFactor *fK1;
   if( fR0<0.5f && fR1<0.5f) return;
 
-  // line might need clipping
-  _bNeedsClipping = TRUE;
+  // [Cecil] skip if the entire line with its width is outside the frustum
+  const FLOAT3D vCenter = (vProjected0+vProjected1)*0.5f;
+  const FLOAT fRadius = (vProjected1-vProjected0).Length()*0.5f + fWidth;
+  const INDEX iTest = _pprProjection->TestSphereToFrustum( vCenter, fRadius);
+  if( iTest<0) return;
+
+  // adjust the need for clipping
+  if( iTest==0) _bNeedsClipping = TRUE;
 
   COLOR col0, col1;
   col0 = col1 = col;
@@ -390,6 +403,8 @@ void Particle_RenderLine( const FLOAT3D &vPos0, const FLOAT3D &vPos1, FLOAT fWid
 void Particle_RenderQuad3D( const FLOAT3D &vPos0, const FLOAT3D &vPos1, const FLOAT3D &vPos2,
                             const FLOAT3D &vPos3, COLOR col)
 {
+  _ctQueuedParticles++; // [Cecil]
+
   // trivial rejection
   if( ((col&CT_AMASK)>>CT_ASHIFT)<2) return;
 
@@ -419,6 +434,19 @@ void Particle_RenderQuad3D( const FLOAT3D &vPos0, const FLOAT3D &vPos1, const FL
   const INDEX iTest = _pprProjection->TestSphereToFrustum( vNearest, fR);
   if( iTest<0) return;
 
+  // [Cecil] skip if smaller than a pixel even at its closest vertex
+  if( _bPerspective) {
+    const FLOAT fClosestZ = Max( Max(vProjected0(3),vProjected1(3)), Max(vProjected2(3),vProjected3(3)));
+    if( fClosestZ<_fNearClipDistance) {
+      FLOAT fExtent = 0.0f;
+      fExtent = Max( fExtent, Max( Abs(vProjected0(1)-fX), Abs(vProjected0(2)-fY)));
+      fExtent = Max( fExtent, Max( Abs(vProjected1(1)-fX), Abs(vProjected1(2)-fY)));
+      fExtent = Max( fExtent, Max( Abs(vProjected2(1)-fX), Abs(vProjected2(2)-fY)));
+      fExtent = Max( fExtent, Max( Abs(vProjected3(1)-fX), Abs(vProjected3(2)-fY)));
+      if( fExtent * _fPerspectiveFactor / fClosestZ < 0.5f) return;
+    }
+  }
+
   // adjust the need for clipping
   if( iTest==0) _bNeedsClipping = TRUE;
 
@@ -509,6 +537,8 @@ void Particle_Flush(void)
   // update stats
   const INDEX ctParticles = _avtxCommon.Count()/4;
   _sfStats.IncrementCounter( CStatForm::SCI_PARTICLES, ctParticles);
+  _sfStats.IncrementCounter( CStatForm::SCI_PARTICLESCULLED, ClampDn( _ctQueuedParticles-ctParticles, (INDEX)0)); // [Cecil]
+  _ctQueuedParticles = 0;
   _pGfx->gl_ctParticleTriangles += ctParticles*2;
 
   // determine need for clipping
@@ -563,84 +593,133 @@ void Particle_Flush(void)
 
 // SORTING ROUTINES
 
-static int qsort_CompareZ( const void *pI0, const void *pI1) {
-  const INDEX i0 = (*(INDEX*)pI0) *4;
-  const INDEX i1 = (*(INDEX*)pI1) *4;
-  const FLOAT fZ0 = _avtxCommon[i0].z;
-  const FLOAT fZ1 = _avtxCommon[i1].z;
-       if( fZ0<fZ1) return +1;
-  else if( fZ0>fZ1) return -1;
-  else              return  0;
+// [Cecil] Radix sort digits
+#define SORT_RADIX_BITS 11
+#define SORT_RADIX_SIZE (1 << SORT_RADIX_BITS)
+#define SORT_RADIX_MASK (SORT_RADIX_SIZE - 1)
+
+// [Cecil] Sort keys and particle indices (two buffers of each for sorting passes)
+static CStaticStackArray<ULONG> _aulSortKeys;
+static CStaticStackArray<INDEX> _aiSortIndices;
+
+// [Cecil] Particle data in sorted order
+static CStaticStackArray<GFXVertex4>  _avtxSorted;
+static CStaticStackArray<GFXTexCoord> _atexSorted;
+static CStaticStackArray<GFXColor>    _acolSorted;
+
+// [Cecil] Convert depth into a key that puts particles with higher depth first
+static inline ULONG DepthToSortKey( FLOAT fZ)
+{
+  ULONG ul = (ULONG &)fZ;
+  // order negative numbers in reverse and before positive ones
+  ul = (ul & 0x80000000) ? ~ul : (ul | 0x80000000);
+  return ~ul;
 }
 
-static int qsort_CompareZ3D( const void *pI0, const void *pI1) {
-  const INDEX i0 = (*(INDEX*)pI0) *4;
-  const INDEX i1 = (*(INDEX*)pI1) *4;
-  const FLOAT fZ0 = (_avtxCommon[i0].z + _avtxCommon[i0+1].z + _avtxCommon[i0+2].z + _avtxCommon[i0+3].z) / 4.0f;
-  const FLOAT fZ1 = (_avtxCommon[i1].z + _avtxCommon[i1+1].z + _avtxCommon[i1+2].z + _avtxCommon[i1+3].z) / 4.0f;
-       if( fZ0<fZ1) return +1;
-  else if( fZ0>fZ1) return -1;
-  else              return  0;
+// [Cecil] Sort particle indices by their keys and return the sorted indices
+// (key and index arrays must have room for twice as many particles)
+static const INDEX *RadixSortParticles( ULONG *pulKeys, INDEX *piIndices, INDEX ctParticles)
+{
+  ULONG *pulSrcKeys = pulKeys;
+  ULONG *pulDstKeys = pulKeys + ctParticles;
+  INDEX *piSrc = piIndices;
+  INDEX *piDst = piIndices + ctParticles;
+  INDEX actDigits[SORT_RADIX_SIZE];
+
+  for( INDEX iShift=0; iShift<32; iShift+=SORT_RADIX_BITS)
+  {
+    memset( actDigits, 0, sizeof(actDigits));
+    INDEX i;
+    for( i=0; i<ctParticles; i++) actDigits[(pulSrcKeys[i]>>iShift) & SORT_RADIX_MASK]++;
+
+    // skip the pass if all keys have the same digit
+    if( actDigits[(pulSrcKeys[0]>>iShift) & SORT_RADIX_MASK]==ctParticles) continue;
+
+    // turn digit counts into offsets
+    INDEX iOffset = 0;
+    for( i=0; i<SORT_RADIX_SIZE; i++) {
+      const INDEX ct = actDigits[i];
+      actDigits[i] = iOffset;
+      iOffset += ct;
+    }
+
+    // distribute keys in a stable way
+    for( i=0; i<ctParticles; i++) {
+      const ULONG ulKey = pulSrcKeys[i];
+      const INDEX iDst = actDigits[(ulKey>>iShift) & SORT_RADIX_MASK]++;
+      pulDstKeys[iDst] = ulKey;
+      piDst[iDst] = piSrc[i];
+    }
+
+    Swap( pulSrcKeys, pulDstKeys);
+    Swap( piSrc, piDst);
+  }
+
+  return piSrc;
 }
 
 
 // sorts particles by distance
+// [Cecil] Radix sort by depth instead of qsort
 void Particle_Sort( BOOL b3D/*=FALSE*/)
 {
   INDEX i;
   const INDEX ctParticles = _avtxCommon.Count()/4; 
-  if( ctParticles<=0) return; // nothing to do!
+  if( ctParticles<=1) return; // nothing to do!
 
-  // generate sort array
-  CStaticArray<INDEX> aiIndices;
-  aiIndices.New(ctParticles);
-  for( i=0; i<ctParticles; i++) aiIndices[i] = i;
+  _sfStats.StartTimer( CStatForm::STI_PARTICLESORT);
 
-  // bubble sort indices by vertex Z coord
-  if(b3D) qsort( &aiIndices[0], ctParticles, sizeof(INDEX), qsort_CompareZ3D);
-  else    qsort( &aiIndices[0], ctParticles, sizeof(INDEX), qsort_CompareZ);
+  // make sort keys from vertex Z coords
+  _aulSortKeys.PopAll();
+  _aiSortIndices.PopAll();
+  ULONG *pulKeys   = _aulSortKeys.Push( ctParticles*2);
+  INDEX *piIndices = _aiSortIndices.Push( ctParticles*2);
+  const GFXVertex4 *pvtx = &_avtxCommon[0];
 
-  // generate inverse table
-  CStaticArray<INDEX> aiInverse;
-  aiInverse.New(ctParticles);
   for( i=0; i<ctParticles; i++) {
-    const INDEX iOrig = aiIndices[i];
-    aiInverse[iOrig] = i;
+    const GFXVertex4 *pvtxParticle = pvtx + i*4;
+    FLOAT fZ = pvtxParticle[0].z;
+    if( b3D) fZ = (pvtxParticle[0].z + pvtxParticle[1].z + pvtxParticle[2].z + pvtxParticle[3].z) / 4.0f;
+    pulKeys[i] = DepthToSortKey(fZ);
+    piIndices[i] = i;
   }
 
-  // sort vertices by indices
-  for( i=0; i<ctParticles;) // i is incremented in loop
-  { // fetch destination
-    INDEX &iWhere = aiInverse[i];
-    ASSERT( iWhere<ctParticles);
-    // if current is already in place, advance to next index
-    if( iWhere==i) { i++; continue; }
-    // swap vertices
-    Swap( _avtxCommon[iWhere*4+0], _avtxCommon[i*4+0]);
-    Swap( _avtxCommon[iWhere*4+1], _avtxCommon[i*4+1]);
-    Swap( _avtxCommon[iWhere*4+2], _avtxCommon[i*4+2]);
-    Swap( _avtxCommon[iWhere*4+3], _avtxCommon[i*4+3]);
-    // swap texture coords
-    Swap( _atexCommon[iWhere*4+0], _atexCommon[i*4+0]);
-    Swap( _atexCommon[iWhere*4+1], _atexCommon[i*4+1]);
-    Swap( _atexCommon[iWhere*4+2], _atexCommon[i*4+2]);
-    Swap( _atexCommon[iWhere*4+3], _atexCommon[i*4+3]);
-    // swap colors
-    Swap( _acolCommon[iWhere*4+0], _acolCommon[i*4+0]);
-    Swap( _acolCommon[iWhere*4+1], _acolCommon[i*4+1]);
-    Swap( _acolCommon[iWhere*4+2], _acolCommon[i*4+2]);
-    Swap( _acolCommon[iWhere*4+3], _acolCommon[i*4+3]);
-    // swap indices
-    Swap( aiInverse[iWhere], aiInverse[i]);
+  const INDEX *piSorted = RadixSortParticles( pulKeys, piIndices, ctParticles);
+
+  // gather vertices, texture coords and colors in sorted order
+  const INDEX ctVertices = ctParticles*4;
+  _avtxSorted.PopAll();
+  _atexSorted.PopAll();
+  _acolSorted.PopAll();
+  GFXVertex4  *pvtxSorted = _avtxSorted.Push( ctVertices);
+  GFXTexCoord *ptexSorted = _atexSorted.Push( ctVertices);
+  GFXColor    *pcolSorted = _acolSorted.Push( ctVertices);
+  const GFXTexCoord *ptex = &_atexCommon[0];
+  const GFXColor    *pcol = &_acolCommon[0];
+
+  for( i=0; i<ctParticles; i++) {
+    const INDEX iSrc = piSorted[i]*4;
+    const INDEX iDst = i*4;
+    pvtxSorted[iDst+0] = pvtx[iSrc+0];  pvtxSorted[iDst+1] = pvtx[iSrc+1];
+    pvtxSorted[iDst+2] = pvtx[iSrc+2];  pvtxSorted[iDst+3] = pvtx[iSrc+3];
+    ptexSorted[iDst+0] = ptex[iSrc+0];  ptexSorted[iDst+1] = ptex[iSrc+1];
+    ptexSorted[iDst+2] = ptex[iSrc+2];  ptexSorted[iDst+3] = ptex[iSrc+3];
+    pcolSorted[iDst+0] = pcol[iSrc+0];  pcolSorted[iDst+1] = pcol[iSrc+1];
+    pcolSorted[iDst+2] = pcol[iSrc+2];  pcolSorted[iDst+3] = pcol[iSrc+3];
   }
 
+  memcpy( &_avtxCommon[0], pvtxSorted, ctVertices*sizeof(GFXVertex4));
+  memcpy( &_atexCommon[0], ptexSorted, ctVertices*sizeof(GFXTexCoord));
+  memcpy( &_acolCommon[0], pcolSorted, ctVertices*sizeof(GFXColor));
+
 #ifndef NDEBUG
   // test to see whether the array is sorted
-  INDEX      *pidx = &aiInverse[0];
-  GFXVertex4 *pvtx = &_avtxCommon[0];
-  for( i=0; i<ctParticles-1; i++) {
-    ASSERT( pidx[i] < pidx[i+1]);
-    ASSERT( pvtx[i*4].z >= pvtx[(i+1)*4].z);
+  if( !b3D) {
+    for( i=0; i<ctParticles-1; i++) {
+      ASSERT( _avtxCommon[i*4].z >= _avtxCommon[(i+1)*4].z);
+    }
   }
 #endif
+
+  _sfStats.StopTimer( CStatForm::STI_PARTICLESORT);
 }
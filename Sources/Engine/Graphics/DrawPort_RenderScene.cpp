@@ -50,6 +50,7 @@ extern INDEX wld_iDetailRemovingBias;
 extern INDEX wld_bAccurateColors;
 
 extern INDEX gfx_bRenderWorld;
+extern INDEX gfx_bSortSceneStates; // [Cecil]
 extern INDEX shd_iForceFlats;
 extern INDEX shd_bShowFlats;
 
@@ -578,7 +579,7 @@ static void RSSetTextureParameters( ULONG ulFlags)
       break;
     }
     // remember new flags
-    _ulLastBlends[0] = ulFlags;
+    _ulLastBlends[0] = ulBlendFlags; // [Cecil] Only blending flags are compared
   }
 }
 
@@ -1708,6 +1709,66 @@ static void RSEnd(void)
 }
 
 
+// [Cecil] Polygon with a key made out of its render state
+struct StatePolygon_t {
+  UQUAD ullKey;
+  ScenePolygon *pspo;
+
+  inline void Clear(void) {};
+};
+
+static CStaticStackArray<StatePolygon_t> _aspoStates;
+
+// [Cecil] Make a key out of the texture state of one polygon layer
+static inline ULONG RSLayerStateKey( ScenePolygon *pspo, INDEX iLayer)
+{
+  CTextureObject *pto = pspo->spo_aptoTextures[iLayer];
+  if( pto==NULL) return 0;
+
+  // same texture, frame and flags always result in the same key
+  const size_t ulData = (size_t)pto->GetData();
+  ULONG ulKey = ULONG(ulData>>4) * 2654435761UL;
+  ulKey ^= ULONG(pto->GetFrame()) <<8;
+  ulKey ^= pspo->spo_aubTextureFlags[iLayer];
+  return ulKey;
+}
+
+static int qsort_CompareStatePolygons( const void *pv0, const void *pv1)
+{
+  const UQUAD ullKey0 = ((const StatePolygon_t *)pv0)->ullKey;
+  const UQUAD ullKey1 = ((const StatePolygon_t *)pv1)->ullKey;
+  if( ullKey0<ullKey1) return -1;
+  if( ullKey0>ullKey1) return +1;
+  return 0;
+}
+
+// [Cecil] Sort polygons in a group by their textures, so consecutive polygons can share them
+// (blending and depth states are already the same for the whole group)
+static void RSSortGroupByState( ScenePolygon *&pspoGroup)
+{
+  _aspoStates.PopAll();
+
+  for( ScenePolygon *pspo=pspoGroup; pspo!=NULL; pspo=pspo->spo_pspoSucc) {
+    StatePolygon_t &sp = _aspoStates.Push();
+    sp.ullKey = (UQUAD(RSLayerStateKey( pspo, 0)) <<32)
+              | (RSLayerStateKey( pspo, 1) ^ (RSLayerStateKey( pspo, 2) * 31));
+    sp.pspo = pspo;
+  }
+
+  const INDEX ctPolygons = _aspoStates.Count();
+  if( ctPolygons<3) return;
+
+  qsort( &_aspoStates[0], ctPolygons, sizeof(StatePolygon_t), qsort_CompareStatePolygons);
+
+  // relink the polygons in sorted order
+  for( INDEX i=0; i<ctPolygons-1; i++) {
+    _aspoStates[i].pspo->spo_pspoSucc = _aspoStates[i+1].pspo;
+  }
+  _aspoStates[ctPolygons-1].pspo->spo_pspoSucc = NULL;
+  pspoGroup = _aspoStates[0].pspo;
+}
+
+
 void RenderScene( CDrawPort *pDP, ScenePolygon *pspoFirst, CAnyProjection3D &prProjection,
                   COLOR colSelection, BOOL bTranslucent)
 {
@@ -1715,7 +1776,7 @@ void RenderScene( CDrawPort *pDP, ScenePolygon *pspoFirst, CAnyProjection3D &prP
   eAPI = _pGfx->GetCurrentAPI();
   _pGfx->CheckAPI();
 
-  if (eAPI != GAT_OGL && eAPI != GAT_D3D) return;
+  if (!_pGfx->GetInterface()->CanRender()) return; // [Cecil]
 
   // some cvars cannot be altered in multiplayer mode!
   if( _bMultiPlayer) {
@@ -1780,7 +1841,11 @@ void RenderScene( CDrawPort *pDP, ScenePolygon *pspoFirst, CAnyProjection3D &prP
   for( INDEX iGroup=1; iGroup<_ctGroupsCount; iGroup++) {
     // get the group polygon list and render it if not empty
     ScenePolygon *pspoGroup = _apspoGroups[iGroup];
-    if( pspoGroup!=NULL) RSRenderGroup( pspoGroup, iGroup, 0);
+    if( pspoGroup==NULL) continue;
+
+    // [Cecil] order of opaque polygons doesn't matter, so group them by their textures
+    if( !bTranslucent && gfx_bSortSceneStates) RSSortGroupByState(pspoGroup);
+    RSRenderGroup( pspoGroup, iGroup, 0);
   }
   _pfGfxProfile.StopTimer( CGfxProfile::PTI_RS_RENDERGROUP);
 
@@ -49,6 +49,12 @@ class IGfxInterface
     // Unique graphical API type
     virtual GfxAPIType GetType(void) const = 0;
 
+    // [Cecil] Whether scenes should be rendered through this interface
+    virtual BOOL CanRender(void) const
+    {
+      return GetType() != GAT_NONE;
+    };
+
   // Graphical API methods
   public:
 
@@ -157,6 +163,12 @@ class IGfxInterface
      */
     void UploadTexture(ULONG *pulTexture, PIX pixWidth, PIX pixHeight, ULONG ulFormat, BOOL bNoDiscard);
 
+    // [Cecil] Texture upload without any graphical API (for interfaces that only keep track of them)
+    virtual void CountTextureUpload(PIX pixWidth, PIX pixHeight) {};
+
+    // [Cecil] Texture binding without any graphical API (for interfaces that only keep track of them)
+    virtual void CountTextureBind(void) {};
+
     // Returns size of uploaded texture
     SLONG GetTextureSize(ULONG ulTexObject, BOOL bHasMipmaps = TRUE);
 
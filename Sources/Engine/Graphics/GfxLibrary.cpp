@@ -139,9 +139,12 @@ INDEX shd_iDynamicSize = 8;
 INDEX shd_bFineQuality = FALSE; 
 INDEX shd_iFiltering = 3;     // >0 = blurring, 0 = no filtering
 INDEX shd_iDithering = 1;     // 0=none, 1,2=low, 3,4=medium, 5=high
+INDEX shd_iMixerSIMD = 2;     // [Cecil] Highest instruction set for mixing shadow maps (0=none, 1=SSE2, 2=AVX2)
 INDEX shd_iAllowDynamic = 1;    // 0=disallow, 1=allow on polys w/o 'NoDynamicLights' flag, 2=allow unconditionally
 INDEX shd_bDynamicMipmaps = TRUE;
 FLOAT shd_tmFlushDelay = 30.0f; // in seconds
+INDEX shd_iEvictFrames = 2;     // [Cecil] uncache shadowmaps not drawn for this many frames if over the cache size (0 = don't)
+INDEX shd_bCompressLayers = FALSE; // [Cecil] keep shadow layer masks run-length encoded
 FLOAT shd_fCacheSize   = 8.0f;  // in megabytes
 INDEX shd_bCacheAll    = FALSE; // cache all shadowmap at the level loading time (careful - memory eater!)
 INDEX shd_bAllowFlats = TRUE;   // allow optimization of single-color shadowmaps
@@ -206,11 +209,14 @@ INDEX mdl_iShadowQuality    = 1;
 FLOAT mdl_fLODMul           = 1.0f;
 FLOAT mdl_fLODAdd           = 0.0f;
 INDEX mdl_iLODDisappear     = 1; // 0=never, 1=ignore bias, 2=with bias
+INDEX mdl_bCacheFrames      = TRUE; // [Cecil]
 // ska controls
 INDEX ska_bShowSkeleton     = FALSE;
 INDEX ska_bShowColision     = FALSE;
 FLOAT ska_fLODMul           = 1.0f;
 FLOAT ska_fLODAdd           = 0.0f;
+INDEX ska_bFastSkinning     = TRUE; // [Cecil]
+INDEX ska_bCachePoses       = TRUE; // [Cecil]
 // terrain controls
 INDEX ter_bShowQuadTree     = FALSE;
 INDEX ter_bShowWireframe    = FALSE;
@@ -219,6 +225,7 @@ INDEX ter_bShowInfo         = FALSE;
 INDEX ter_bOptimizeRendering = TRUE;
 INDEX ter_bTempFreezeCast   = FALSE;
 INDEX ter_bNoRegeneration   = FALSE;
+INDEX ter_bParallelRegen    = TRUE; // [Cecil]
 
 // rendering control
 INDEX wld_bAlwaysAddAll         = FALSE;
@@ -231,10 +238,13 @@ INDEX wld_bTextureLayers        = 111;
 INDEX wld_bShowTriangles        = FALSE;
 INDEX wld_bShowDetailTextures   = FALSE;
 INDEX wld_iDetailRemovingBias   = 3;
+INDEX wld_bCachePolygonSetup    = TRUE; // [Cecil]
+INDEX wld_bUsePVS               = TRUE; // [Cecil]
 FLOAT wld_fEdgeOffsetI          = 0.0f; //0.125f;
 FLOAT wld_fEdgeAdjustK          = 1.0f; //1.0001f;
                                      
 INDEX gfx_bRenderWorld      = TRUE;
+INDEX gfx_bSortSceneStates  = TRUE; // [Cecil]
 INDEX gfx_bRenderParticles  = TRUE;
 INDEX gfx_bRenderModels     = TRUE;
 INDEX gfx_bRenderPredicted  = FALSE;
@@ -1184,12 +1194,15 @@ void CGfxLibrary::Init(void)
   _pShell->DeclareSymbol("persistent user INDEX mdl_bAllowOverbright;",  &mdl_bAllowOverbright);
   _pShell->DeclareSymbol("persistent user INDEX mdl_bFineQuality post:MdlPostFunc;", &mdl_bFineQuality);
   _pShell->DeclareSymbol("persistent user INDEX mdl_iShadowQuality;",  &mdl_iShadowQuality);
+  _pShell->DeclareSymbol("persistent user INDEX mdl_bCacheFrames;",    &mdl_bCacheFrames); // [Cecil]
   _pShell->DeclareSymbol("                INDEX mdl_bTruformWeapons;", &mdl_bTruformWeapons);
   
   _pShell->DeclareSymbol("           user INDEX ska_bShowSkeleton;",   &ska_bShowSkeleton);
   _pShell->DeclareSymbol("           user INDEX ska_bShowColision;",   &ska_bShowColision);
   _pShell->DeclareSymbol("persistent user FLOAT ska_fLODMul;",         &ska_fLODMul);
   _pShell->DeclareSymbol("persistent user FLOAT ska_fLODAdd;",         &ska_fLODAdd);
+  _pShell->DeclareSymbol("persistent user INDEX ska_bFastSkinning;",   &ska_bFastSkinning); // [Cecil]
+  _pShell->DeclareSymbol("persistent user INDEX ska_bCachePoses;",     &ska_bCachePoses); // [Cecil]
   
   _pShell->DeclareSymbol("           user INDEX ter_bShowQuadTree;",   &ter_bShowQuadTree);
   _pShell->DeclareSymbol("           user INDEX ter_bShowWireframe;",  &ter_bShowWireframe);
@@ -1198,6 +1211,7 @@ void CGfxLibrary::Init(void)
   _pShell->DeclareSymbol("           user INDEX ter_bOptimizeRendering;", &ter_bOptimizeRendering);
   _pShell->DeclareSymbol("           user INDEX ter_bTempFreezeCast;   ", &ter_bTempFreezeCast);
   _pShell->DeclareSymbol("           user INDEX ter_bNoRegeneration;   ", &ter_bNoRegeneration);
+  _pShell->DeclareSymbol("persistent user INDEX ter_bParallelRegen;", &ter_bParallelRegen); // [Cecil]
   
   
   
@@ -1239,7 +1253,10 @@ void CGfxLibrary::Init(void)
   _pShell->DeclareSymbol("persistent user INDEX shd_bDynamicMipmaps;", &shd_bDynamicMipmaps);
   _pShell->DeclareSymbol("persistent user INDEX shd_iFiltering;", &shd_iFiltering);
   _pShell->DeclareSymbol("persistent user INDEX shd_iDithering;", &shd_iDithering);
+  _pShell->DeclareSymbol("user INDEX shd_iMixerSIMD;", &shd_iMixerSIMD); // [Cecil]
   _pShell->DeclareSymbol("persistent user FLOAT shd_tmFlushDelay;", &shd_tmFlushDelay);
+  _pShell->DeclareSymbol("persistent user INDEX shd_iEvictFrames;", &shd_iEvictFrames); // [Cecil]
+  _pShell->DeclareSymbol("persistent user INDEX shd_bCompressLayers;", &shd_bCompressLayers); // [Cecil]
   _pShell->DeclareSymbol("persistent user FLOAT shd_fCacheSize;",   &shd_fCacheSize);
   _pShell->DeclareSymbol("persistent user INDEX shd_bCacheAll;",    &shd_bCacheAll);
   _pShell->DeclareSymbol("persistent user INDEX shd_bAllowFlats;", &shd_bAllowFlats);
@@ -1250,12 +1267,15 @@ void CGfxLibrary::Init(void)
   _pShell->DeclareSymbol("           user INDEX gfx_bRenderParticles;", &gfx_bRenderParticles);
   _pShell->DeclareSymbol("           user INDEX gfx_bRenderFog;",       &gfx_bRenderFog);
   _pShell->DeclareSymbol("           user INDEX gfx_bRenderWorld;",     &gfx_bRenderWorld);
+  _pShell->DeclareSymbol("persistent user INDEX gfx_bSortSceneStates;", &gfx_bSortSceneStates); // [Cecil]
   _pShell->DeclareSymbol("persistent user INDEX gfx_iLensFlareQuality;", &gfx_iLensFlareQuality);
   _pShell->DeclareSymbol("persistent user INDEX wld_bTextureLayers;", &wld_bTextureLayers);
   _pShell->DeclareSymbol("persistent user INDEX wld_bRenderMirrors;", &wld_bRenderMirrors);
   _pShell->DeclareSymbol("persistent user FLOAT wld_fEdgeOffsetI;",   &wld_fEdgeOffsetI);
   _pShell->DeclareSymbol("persistent user FLOAT wld_fEdgeAdjustK;",   &wld_fEdgeAdjustK);
   _pShell->DeclareSymbol("persistent user INDEX wld_iDetailRemovingBias;", &wld_iDetailRemovingBias);
+  _pShell->DeclareSymbol("persistent user INDEX wld_bCachePolygonSetup;", &wld_bCachePolygonSetup); // [Cecil]
+  _pShell->DeclareSymbol("persistent user INDEX wld_bUsePVS;", &wld_bUsePVS); // [Cecil]
   _pShell->DeclareSymbol("           user INDEX wld_bRenderEmptyBrushes;", &wld_bRenderEmptyBrushes);
   _pShell->DeclareSymbol("           user INDEX wld_bRenderShadowMaps;",   &wld_bRenderShadowMaps);
   _pShell->DeclareSymbol("           user INDEX wld_bRenderTextures;",     &wld_bRenderTextures);
@@ -1777,6 +1797,19 @@ void CGfxLibrary::ReduceShadows(void)
     ulUsedShadowMemory -= sm.Uncache();
     ASSERT( ulUsedShadowMemory>=0);
   }}
+
+  // [Cecil] If still over the cache size, also uncache shadowmaps that haven't been drawn
+  // for a few frames regardless of the delay; they are mixed again once they become visible
+  shd_iEvictFrames = ClampDn( shd_iEvictFrames, 0L);
+
+  if( shd_iEvictFrames>0 && ulUsedShadowMemory>ulShadowCacheSize) {
+    {FORDELETELIST( CShadowMap, sm_lnInGfx, _pGfx->gl_lhCachedShadows, itsm)
+    { // stop at the first shadow map that has been drawn recently (list is sorted by time)
+      CShadowMap &sm = *itsm;
+      if( gl_iFrameNumber-sm.sm_iLastDrawnFrame<shd_iEvictFrames || ulUsedShadowMemory<=ulShadowCacheSize) break;
+      ulUsedShadowMemory -= sm.Uncache();
+    }}
+  }
   // done
   _sfStats.StopTimer( CStatForm::STI_SHADOWUPDATE);
 }
@@ -2016,7 +2049,7 @@ BOOL CGfxLibrary::LockRaster( CRaster *praToLock)
 {
   // don't do this! it can break sync consistency in entities!
   // SetFPUPrecision(FPT_24BIT); 
-  ASSERT( praToLock->ra_pvpViewPort!=NULL);
+  ASSERT( praToLock->ra_pvpViewPort!=NULL || GetCurrentAPI()==GAT_NONE); // [Cecil] Rasters without windows
   BOOL bRes = SetCurrentViewport( praToLock->ra_pvpViewPort);
   if( bRes) {
     // must signal to picky Direct3D
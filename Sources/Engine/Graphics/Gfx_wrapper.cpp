@@ -311,6 +311,10 @@ void IGfxInterface::SetTexture( ULONG &ulTexObject, CTexParams &tpLocal)
     MimicTexParams_D3D(tpLocal);
   }
 #endif // SE1_DIRECT3D
+  // [Cecil] No API
+  else if (eAPI == GAT_NONE) {
+    CountTextureBind();
+  }
   // done
   _pfGfxProfile.StopTimer(CGfxProfile::PTI_SETCURRENTTEXTURE);
   _sfStats.StopTimer(CStatForm::STI_BINDTEXTURE);
@@ -342,6 +346,10 @@ void IGfxInterface::UploadTexture( ULONG *pulTexture, PIX pixWidth, PIX pixHeigh
     }
   } 
 #endif // SE1_DIRECT3D
+  // [Cecil] No API
+  else if (eAPI == GAT_NONE) {
+    CountTextureUpload(pixWidth, pixHeight);
+  }
   _sfStats.StopTimer(CStatForm::STI_GFXAPI);
 }
 
@@ -358,7 +366,7 @@ SLONG IGfxInterface::GetTextureSize( ULONG ulTexObject, BOOL bHasMipmaps/*=TRUE*
   const GfxAPIType eAPI = _pGfx->GetCurrentAPI();
   _pGfx->CheckAPI();
 
-  SLONG slMipSize;
+  SLONG slMipSize = 0; // [Cecil] Nothing without an API
 
   _sfStats.StartTimer(CStatForm::STI_GFXAPI);
 
@@ -0,0 +1,154 @@
+/* Copyright (c) 2026 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef SE_INCL_GFX_COUNTING_H
+#define SE_INCL_GFX_COUNTING_H
+
+#include <Engine/Graphics/Gfx_wrapper_Null.h>
+
+// Interface without any graphical API that keeps track of the work that would've been sent to it
+class IGfxCounting : public IGfxNull
+{
+  public:
+    // Amounts of API calls since the last reset
+    struct Counters_t {
+      INDEX ctDrawCalls;     // DrawElements() calls
+      INDEX ctTriangles;     // Triangles in all draw calls
+      INDEX ctVertices;      // Vertices in all vertex arrays
+      INDEX ctStateChanges;  // Render states, blending, depth and color arrays
+      INDEX ctMatrixChanges; // Projection, view and texture matrices
+      INDEX ctTexturesMade;  // Generated texture objects
+      INDEX ctTextureBinds;  // Textures set as current
+      INDEX ctUploads;       // Uploaded textures
+      SLONG slUploadPixels;  // Pixels in all uploaded textures
+    };
+
+    Counters_t gc_Counters;
+
+  private:
+    ULONG gc_ulLastTexture; // Last generated texture object
+
+  public:
+    // Constructor
+    IGfxCounting() : gc_ulLastTexture(0)
+    {
+      ResetCounters();
+    };
+
+    // Start counting from scratch
+    inline void ResetCounters(void)
+    {
+      memset(&gc_Counters, 0, sizeof(gc_Counters));
+    };
+
+    // Render scenes as if there was an API
+    virtual BOOL CanRender(void) const {
+      return TRUE;
+    };
+
+  // Graphical API methods
+  public:
+
+    // Enable operations
+    virtual void EnableDepthWrite(void) { gc_Counters.ctStateChanges++; };
+    virtual void EnableDepthBias(void)  { gc_Counters.ctStateChanges++; };
+    virtual void EnableDepthTest(void)  { gc_Counters.ctStateChanges++; };
+    virtual void EnableAlphaTest(void)  { gc_Counters.ctStateChanges++; };
+    virtual void EnableBlend(void)      { gc_Counters.ctStateChanges++; };
+    virtual void EnableDither(void)     { gc_Counters.ctStateChanges++; };
+    virtual void EnableTexture(void)    { gc_Counters.ctStateChanges++; };
+    virtual void EnableClipping(void)   { gc_Counters.ctStateChanges++; };
+    virtual void EnableClipPlane(void)  { gc_Counters.ctStateChanges++; };
+
+    // Disable operations
+    virtual void DisableDepthWrite(void) { gc_Counters.ctStateChanges++; };
+    virtual void DisableDepthBias(void)  { gc_Counters.ctStateChanges++; };
+    virtual void DisableDepthTest(void)  { gc_Counters.ctStateChanges++; };
+    virtual void DisableAlphaTest(void)  { gc_Counters.ctStateChanges++; };
+    virtual void DisableBlend(void)      { gc_Counters.ctStateChanges++; };
+    virtual void DisableDither(void)     { gc_Counters.ctStateChanges++; };
+    virtual void DisableTexture(void)    { gc_Counters.ctStateChanges++; };
+    virtual void DisableClipping(void)   { gc_Counters.ctStateChanges++; };
+    virtual void DisableClipPlane(void)  { gc_Counters.ctStateChanges++; };
+
+    virtual void BlendFunc(GfxBlend eSrc, GfxBlend eDst) { gc_Counters.ctStateChanges++; };
+    virtual void DepthFunc(GfxComp eFunc) { gc_Counters.ctStateChanges++; };
+    virtual void DepthRange(FLOAT fMin, FLOAT fMax) { gc_Counters.ctStateChanges++; };
+
+    virtual void SetColorMask(ULONG ulColorMask) {
+      _ulCurrentColorMask = ulColorMask;
+      gc_Counters.ctStateChanges++;
+    };
+
+  // Projections
+  public:
+
+    virtual void CullFace(GfxFace eFace) { gc_Counters.ctStateChanges++; };
+    virtual void FrontFace(GfxFace eFace) { gc_Counters.ctStateChanges++; };
+    virtual void ClipPlane(const DOUBLE *pdPlane) { gc_Counters.ctStateChanges++; };
+    virtual void PolygonMode(GfxPolyMode ePolyMode) { gc_Counters.ctStateChanges++; };
+
+    virtual void SetOrtho(const FLOAT fLeft, const FLOAT fRight, const FLOAT fTop,  const FLOAT fBottom, const FLOAT fNear, const FLOAT fFar, const BOOL bSubPixelAdjust) {
+      gc_Counters.ctMatrixChanges++;
+    };
+
+    virtual void SetFrustum(const FLOAT fLeft, const FLOAT fRight, const FLOAT fTop,  const FLOAT fBottom, const FLOAT fNear, const FLOAT fFar) {
+      gc_Counters.ctMatrixChanges++;
+    };
+
+    virtual void SetViewMatrix(const FLOAT *pfMatrix) { gc_Counters.ctMatrixChanges++; };
+    virtual void SetTextureMatrix(const FLOAT *pfMatrix) { gc_Counters.ctMatrixChanges++; };
+
+  // Textures
+  public:
+
+    virtual void SetTextureWrapping(enum GfxWrap eWrapU, enum GfxWrap eWrapV) { gc_Counters.ctStateChanges++; };
+    virtual void SetTextureModulation(INDEX iScale) { gc_Counters.ctStateChanges++; };
+
+    // Give out unique objects, so textures are only uploaded when they actually need to be
+    virtual void GenerateTexture(ULONG &ulTexObject) {
+      ulTexObject = ++gc_ulLastTexture;
+      gc_Counters.ctTexturesMade++;
+    };
+
+    virtual void DeleteTexture(ULONG &ulTexObject) {
+      ulTexObject = NONE;
+    };
+
+    virtual void CountTextureBind(void) {
+      gc_Counters.ctTextureBinds++;
+    };
+
+    virtual void CountTextureUpload(PIX pixWidth, PIX pixHeight) {
+      gc_Counters.ctUploads++;
+      gc_Counters.slUploadPixels += pixWidth * pixHeight;
+    };
+
+  // Vertex arrays
+  public:
+
+    virtual void SetVertexArray(void *pvtx, INDEX ctVtx) { gc_Counters.ctVertices += ctVtx; };
+
+    virtual void DrawElements(INDEX ctElem, INDEX *pidx) {
+      gc_Counters.ctDrawCalls++;
+      gc_Counters.ctTriangles += ctElem / 3;
+    };
+
+    virtual void SetConstantColor(COLOR col) { gc_Counters.ctStateChanges++; };
+    virtual void EnableColorArray(void) { gc_Counters.ctStateChanges++; };
+    virtual void DisableColorArray(void) { gc_Counters.ctStateChanges++; };
+};
+
+#endif // include-once check
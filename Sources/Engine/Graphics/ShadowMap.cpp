@@ -58,6 +58,7 @@ CShadowMap::CShadowMap()
   sm_ulProbeObject = NONE;
   sm_ulInternalFormat = NONE;
   sm_iRenderFrame = -1;
+  sm_iLastDrawnFrame = -1; // [Cecil]
   sm_ulFlags = NONE;
   Clear();
 }
@@ -128,7 +129,7 @@ void CShadowMap::Cache( INDEX iWantedMipLevel)
   if( !bCached || bWasFlat)
   {
     // allocate the memory
-    sm_pulCachedShadowMap = (ULONG*)AllocMemory(slSize);
+    sm_pulCachedShadowMap = (ULONG*)AllocMemoryTagged(slSize, MEM_SHADOWS);
     sm_slMemoryUsed = slSize;
     ASSERT( sm_slMemoryUsed>0 && sm_slMemoryUsed<=SHADOWMAXBYTES);
   }
@@ -136,7 +137,7 @@ void CShadowMap::Cache( INDEX iWantedMipLevel)
   else if( iWantedMipLevel<sm_iFirstCachedMipLevel)
   {
     // allocate new block
-    ULONG *pulNew = (ULONG*)AllocMemory(slSize);
+    ULONG *pulNew = (ULONG*)AllocMemoryTagged(slSize, MEM_SHADOWS);
     ASSERT( sm_slMemoryUsed>0 && sm_slMemoryUsed<=SHADOWMAXBYTES);
     if( slSize>sm_slMemoryUsed && !bWasFlat) {
       // copy old shadow map at the end of buffer
@@ -176,6 +177,8 @@ void CShadowMap::Cache( INDEX iWantedMipLevel)
 
   // add it to shadow list
   if( !sm_lnInGfx.IsLinked()) _pGfx->gl_lhCachedShadows.AddTail( sm_lnInGfx);
+  // [Cecil] Count caching as drawing, so shadow maps cached ahead of time aren't evicted before they're seen
+  if( sm_iLastDrawnFrame<0) sm_iLastDrawnFrame = _pGfx->gl_iFrameNumber;
   _pfGfxProfile.StopTimer( CGfxProfile::PTI_CACHESHADOW);
 }
 
@@ -205,7 +208,7 @@ ULONG CShadowMap::UpdateDynamicLayers(void)
   // allocate the memory if not yet allocated
   if( sm_pulDynamicShadowMap==NULL) {
     ASSERT( sm_slMemoryUsed>0 && sm_slMemoryUsed<=SHADOWMAXBYTES);
-    sm_pulDynamicShadowMap = (ULONG*)AllocMemory(sm_slMemoryUsed);
+    sm_pulDynamicShadowMap = (ULONG*)AllocMemoryTagged(sm_slMemoryUsed, MEM_SHADOWS);
   }
 
   // determine and clamp to max allowed dynamic shadow dimension
@@ -223,6 +226,7 @@ ULONG CShadowMap::UpdateDynamicLayers(void)
   _pfGfxProfile.StopTimer( CGfxProfile::PTI_CACHESHADOW);
 
   // skip if there was nothing to mix-in
+  // [Cecil] Deferred mixing leaves the flag cleared and corrects the upload level after mixing
   if( sm_ulFlags&SMF_DYNAMICBLACK) return 31;
   _bShadowsUpdated = TRUE;
   return iFinestMipLevel;
@@ -252,6 +256,7 @@ void CShadowMap::MarkDrawn(void)
   sm_lnInGfx.Remove();
   // set time stamp
   sm_tvLastDrawn = _pTimer->GetHighPrecisionTimer();
+  sm_iLastDrawnFrame = _pGfx->gl_iFrameNumber; // [Cecil]
   // put at the end of the list
   _pGfx->gl_lhCachedShadows.AddTail(sm_lnInGfx);
 }
@@ -290,6 +295,7 @@ SLONG CShadowMap::Uncache( void)
   sm_slMemoryUsed = 0;
   sm_tvLastDrawn = SQUAD(0);
   sm_iRenderFrame = -1;
+  sm_iLastDrawnFrame = -1; // [Cecil]
   sm_ulFlags = NONE;
   sm_tpLocal.Clear();
   // if added to list of all shadows,  remove from there
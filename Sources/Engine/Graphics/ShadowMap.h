@@ -57,6 +57,7 @@ public:
   CTexParams sm_tpLocal;        // local texture parameters
 
   INDEX sm_iRenderFrame; // frame number currently rendering (for profiling)
+  INDEX sm_iLastDrawnFrame; // [Cecil] Frame number when the shadow map has been drawn last time (for uncaching)
 
   // skip old shadows saved in stream
   void Read_old_t(CTStream *inFile); // throw char *
@@ -319,7 +319,7 @@ void CTextureData::Create_t( const CImageInfo *pII, MEX mexWanted, INDEX ctFineM
   td_slFrameSize = GetMipmapOffset( 15, pixSizeU, pixSizeV) *BYTES_PER_TEXEL;
 
   // allocate small ammount of memory just for Realloc sake
-  td_pulFrames = (ULONG*)AllocMemory(16);
+  td_pulFrames = (ULONG*)AllocMemoryTagged(16, MEM_TEXTURES);
   AddFrame_t( pII);
 }
 
@@ -385,8 +385,8 @@ static ULONG AllocEffectBuffers( CTextureData *pTD)
   // determine size of effect buffers 
   ULONG ulSize = GetEffectBufferSize( pTD);
   // allocate and reset buffers (memory walling!)
-  pTD->td_pubBuffer1 = (UBYTE*)AllocMemory( ulSize+8);
-  pTD->td_pubBuffer2 = (UBYTE*)AllocMemory( ulSize+8);
+  pTD->td_pubBuffer1 = (UBYTE*)AllocMemoryTagged(ulSize+8, MEM_TEXTURES);
+  pTD->td_pubBuffer2 = (UBYTE*)AllocMemoryTagged(ulSize+8, MEM_TEXTURES);
   memset( pTD->td_pubBuffer1, 0, ulSize);
   memset( pTD->td_pubBuffer2, 0, ulSize);
   return ulSize;
@@ -509,7 +509,7 @@ static void Convert( CTextureData *pTD)
   PIX pixMipSize   = pixWidth * pixHeight;
   PIX pixFrameSize = GetMipmapOffset( 15, pixWidth, pixHeight);
   // allocate memory for new texture
-  ULONG *pulFramesNew = (ULONG*)AllocMemory( pixFrameSize*pTD->td_ctFrames *BYTES_PER_TEXEL);
+  ULONG *pulFramesNew = (ULONG*)AllocMemoryTagged(pixFrameSize*pTD->td_ctFrames *BYTES_PER_TEXEL, MEM_TEXTURES);
   UWORD *puwFramesOld = (UWORD*)pTD->td_pulFrames;
   ASSERT( puwFramesOld!=NULL);
 
@@ -587,7 +587,7 @@ static void RemoveOversizedMipmaps( CTextureData *pTD)
   // determine memory size and allocate memory for rest mip-maps
   SLONG slRemovedMipsSize = GetMipmapOffset( ctSkipMips, pixSizeU, pixSizeV) *BYTES_PER_TEXEL;
   SLONG slNewFrameSize    = pTD->td_slFrameSize-slRemovedMipsSize;
-  ULONG *pulNewFrames = (ULONG*)AllocMemory( slNewFrameSize * pTD->td_ctFrames);
+  ULONG *pulNewFrames = (ULONG*)AllocMemoryTagged(slNewFrameSize * pTD->td_ctFrames, MEM_TEXTURES);
   ULONG *pulNewFrame  = pulNewFrames;
   ULONG *pulOldFrame  = pTD->td_pulFrames + (slRemovedMipsSize/BYTES_PER_TEXEL);
 
@@ -747,7 +747,7 @@ void CTextureData::Read_t( CTStream *inFile)
       }
       // calculate texture size for corresponding texture format and allocate memory
       SLONG slTexSize = td_slFrameSize * td_ctFrames;
-      td_pulFrames = (ULONG*)AllocMemory( slTexSize);
+      td_pulFrames = (ULONG*)AllocMemoryTagged(slTexSize, MEM_TEXTURES);
       // if older version
       if( iVersion==3) {
         // alloc memory block and read mip-maps
@@ -859,7 +859,7 @@ void CTextureData::Read_t( CTStream *inFile)
       }
       // allocate memory for effect frame buffer
       SLONG slFrameSize = GetMipmapOffset( 15, GetPixWidth(), GetPixHeight()) *BYTES_PER_TEXEL;
-      td_pulFrames = (ULONG*)AllocMemory( slFrameSize);
+      td_pulFrames = (ULONG*)AllocMemoryTagged(slFrameSize, MEM_TEXTURES);
       // remember once again new frame size just for the sake of old effect textures
       td_slFrameSize = slFrameSize;
       // mark that effect texture needs to be static
@@ -1227,7 +1227,7 @@ void CTextureData::SetAsCurrent( INDEX iFrameNo/*=0*/, BOOL bForceUpload/*=FALSE
     if( td_pulFrames==NULL || td_slFrameSize!=slFrameSize) {
       // (re)allocate the frame buffer
       if( td_pulFrames!=NULL) FreeMemory( td_pulFrames);
-      td_pulFrames = (ULONG*)AllocMemory( slFrameSize);
+      td_pulFrames = (ULONG*)AllocMemoryTagged(slFrameSize, MEM_TEXTURES);
       td_slFrameSize = slFrameSize;
       bNoDiscard = FALSE;
     }
@@ -1307,7 +1307,7 @@ void CTextureData::SetAsCurrent( INDEX iFrameNo/*=0*/, BOOL bForceUpload/*=FALSE
 
     if( td_ctFrames>1) {
       // animation textures
-      td_pulObjects = (ULONG*)AllocMemory( td_ctFrames *sizeof(td_ulProbeObject));
+      td_pulObjects = (ULONG*)AllocMemoryTagged(td_ctFrames *sizeof(td_ulProbeObject), MEM_TEXTURES);
       for (INDEX i = 0; i < td_ctFrames; i++) {
         _pGfx->GetInterface()->GenerateTexture(td_pulObjects[i]);
       }
@@ -25,6 +25,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/World/World.h>
 #include <Engine/Entities/Entity.h>
 #include <Engine/Templates/StaticArray.cpp>
+#include <Engine/Templates/StaticStackArray.cpp>
 #include <Engine/Graphics/GfxLibrary.h>
 #include <Engine/Math/Clipping.inl>
 
@@ -37,6 +38,22 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 INDEX _ctShadowLayers = 0;
 INDEX _ctShadowClusters = 0;
 
+// [Cecil] How many bytes of unfinished shadow masks can be kept before finishing them
+#define MAX_PENDING_MASK_BYTES (32 * 1024 * 1024)
+
+// [Cecil] Shadow mask of a layer that has been rendered but not finished yet
+struct PendingLayer_t {
+  CBrushShadowLayer *pbsl;
+  UBYTE *pubLayer; // byte-packed mask
+  struct MipmapTable mmtLayer;
+  PIX pixLayerMinU;
+  PIX pixLayerMinV;
+  PIX pixLayerSizeU;
+  PIX pixLayerSizeV;
+
+  inline void Clear(void) {};
+};
+
 
 // class used for making shadow layers (used only locally)
 class CLayerMaker {
@@ -85,6 +102,8 @@ public:
 
   CLightSource *lm_plsLight;    // current light
 
+  BOOL lm_bDeferFinishing; // [Cecil] Leave rendered shadow masks unfinished
+
   // remember general data
   void CalculateData(void);
 
@@ -102,6 +121,11 @@ public:
   /* Spread the shadow towards pixels inside of polygon. */
   void SpreadShadowMaskInwards(void);
 
+  // [Cecil] Spread the rendered shadow mask and pack it into the layer
+  void FinishShadowMask(CBrushShadowLayer *pbsl);
+  // [Cecil] Finish shadow masks of all pending layers of the polygon
+  void FinishPendingLayers(INDEX iFirstLayer, INDEX ctLayers);
+
 public:
 // interface:
   /* Constructor. */
@@ -318,6 +342,7 @@ inline BOOL TestPointInPolygon(CBrushPolygon &bpo, const FLOAT3D &v)
  */
 CLayerMaker::CLayerMaker(void)
 {
+  lm_bDeferFinishing = FALSE; // [Cecil]
 }
 
 /* Spread the shadow towards pixels outside of polygon. */
@@ -512,7 +537,7 @@ void CLayerMaker::SpreadShadowMaskInwards(void)
 void CLayerMaker::MakePolygonMask(void)
 {
   // allocate memory for the mask
-  lm_pubPolygonMask = (UBYTE *)AllocMemory(lm_mmtPolygonMask.mmt_slTotalSize+8);
+  lm_pubPolygonMask = (UBYTE *)AllocMemoryTagged(lm_mmtPolygonMask.mmt_slTotalSize+8, MEM_SHADOWS);
 
   // if there is packed polygon mask remembered in the shadow map
   if (lm_pbsmShadowMap->bsm_pubPolygonMask!=NULL) {
@@ -554,7 +579,7 @@ void CLayerMaker::MakePolygonMask(void)
 //      lm_mmtPolygonMask.mmt_slTotalSize);
 
     // convert it from byte-packed into bit-packed mask
-    lm_pbsmShadowMap->bsm_pubPolygonMask = (UBYTE *)AllocMemory((lm_mmtPolygonMask.mmt_slTotalSize+7)/8);
+    lm_pbsmShadowMap->bsm_pubPolygonMask = (UBYTE *)AllocMemoryTagged((lm_mmtPolygonMask.mmt_slTotalSize+7)/8, MEM_SHADOWS);
     ConvertBytesToBits(
       lm_pubPolygonMask,
       lm_pbsmShadowMap->bsm_pubPolygonMask,
@@ -587,6 +612,19 @@ void CLayerMaker::FlipShadowMask(INDEX iMip)
 }
 
 // make shadow mask for the light
+// [Cecil] Polygon with shadow masks that have been rendered but not finished yet
+struct PendingPolygon_t {
+  CLayerMaker lm;
+  INDEX iFirstLayer;
+  INDEX ctLayers;
+
+  inline void Clear(void) {};
+};
+
+static CStaticStackArray<PendingLayer_t> _aPendingLayers;
+static CStaticStackArray<PendingPolygon_t> _aPendingPolygons;
+static SLONG _slPendingBytes = 0;
+
 ULONG CLayerMaker::MakeShadowMask(CBrushShadowLayer *pbsl)
 {
   // if the light doesn't cast shadows, or the polygon does not receive them
@@ -631,7 +669,7 @@ ULONG CLayerMaker::MakeShadowMask(CBrushShadowLayer *pbsl)
   lm_pbslLayer->bsl_slSizeInPixels = lm_mmtLayer.mmt_slTotalSize;
 
   // allocate shadow mask for the light (+8 is safety wall for fast conversions)
-  lm_pubLayer = (UBYTE *)AllocMemory(lm_mmtLayer.mmt_slTotalSize+8);
+  lm_pubLayer = (UBYTE *)AllocMemoryTagged(lm_mmtLayer.mmt_slTotalSize+8, MEM_SHADOWS);
   const FLOAT fEpsilon = (1<<lm_iMipLevel)/1024.0f;
 
   ULONG ulLighted=BSLF_ALLLIGHT|BSLF_ALLDARK;
@@ -644,7 +682,24 @@ ULONG CLayerMaker::MakeShadowMask(CBrushShadowLayer *pbsl)
   } else {
     // make first mip-map of mask
     ulLighted&=MakeOneShadowMaskMip(0);
-    // make other shadow mask mips from the first one
+  }
+
+  // update statistics
+  _ctShadowLayers++;
+  _ctShadowClusters+=lm_mmtLayer.mmt_slTotalSize;
+
+  // [Cecil] Finish the mask later
+  if (lm_bDeferFinishing) return ulLighted;
+
+  FinishShadowMask(pbsl);
+  return ulLighted;
+}
+
+// [Cecil] Spread the rendered shadow mask and pack it into the layer
+void CLayerMaker::FinishShadowMask(CBrushShadowLayer *pbsl)
+{
+  // make other shadow mask mips from the first one
+  if (!(lm_pbpoPolygon->bpo_ulFlags & BPOF_ACCURATESHADOWS)) {
     MakeMipmapsForMask( lm_pubLayer, lm_mmtLayer.mmt_pixU, lm_mmtLayer.mmt_pixV,
                         lm_mmtLayer.mmt_slTotalSize);
   }
@@ -661,12 +716,30 @@ ULONG CLayerMaker::MakeShadowMask(CBrushShadowLayer *pbsl)
   ConvertBytesToBits(lm_pubLayer, lm_pubLayer, lm_mmtLayer.mmt_slTotalSize);
   ShrinkMemory((void **)&lm_pubLayer, (lm_mmtLayer.mmt_slTotalSize+7)/8);
   pbsl->bsl_pubLayer = lm_pubLayer;
+  pbsl->bsl_slPackedSize = 0; // [Cecil]
+  pbsl->PackLayer(); // [Cecil]
+}
 
-  // update statistics
-  _ctShadowLayers++;
-  _ctShadowClusters+=lm_mmtLayer.mmt_slTotalSize;
+// [Cecil] Finish shadow masks of all pending layers of the polygon
+void CLayerMaker::FinishPendingLayers(INDEX iFirstLayer, INDEX ctLayers)
+{
+  // make bit-packed mask of where the polygon is in the shadow map
+  MakePolygonMask();
+
+  for (INDEX iLayer = iFirstLayer; iLayer < iFirstLayer + ctLayers; iLayer++) {
+    PendingLayer_t &pl = _aPendingLayers[iLayer];
+    lm_pubLayer = pl.pubLayer;
+    lm_mmtLayer = pl.mmtLayer;
+    lm_pixLayerMinU = pl.pixLayerMinU;
+    lm_pixLayerMinV = pl.pixLayerMinV;
+    lm_pixLayerSizeU = pl.pixLayerSizeU;
+    lm_pixLayerSizeV = pl.pixLayerSizeV;
+
+    FinishShadowMask(pl.pbsl);
+  }
 
-  return ulLighted;
+  // free bit-packed polygon mask
+  FreeMemory(lm_pubPolygonMask);
 }
 
 ULONG CLayerMaker::MakeOneShadowMaskMip(INDEX iMip)
@@ -810,6 +883,7 @@ BOOL CLayerMaker::CreateLayers(CBrushPolygon &bpo, CWorld &woWorld, BOOL bDoDire
   BOOL bInitialized = FALSE;
   BOOL bCalculatedSome = FALSE;
   BOOL bSomeAreUncalculated = FALSE;
+  const INDEX iFirstPending = _aPendingLayers.Count(); // [Cecil]
 
   // remember the world
   lm_pwoWorld = &woWorld;
@@ -837,7 +911,8 @@ BOOL CLayerMaker::CreateLayers(CBrushPolygon &bpo, CWorld &woWorld, BOOL bDoDire
       // remember general data
       CalculateData();
       // make bit-packed mask of where the polygon is in the shadow map
-      MakePolygonMask();
+      // [Cecil] Only needed for finishing shadow masks
+      if (!lm_bDeferFinishing) MakePolygonMask();
       bInitialized = TRUE;
     }
 
@@ -845,22 +920,56 @@ BOOL CLayerMaker::CreateLayers(CBrushPolygon &bpo, CWorld &woWorld, BOOL bDoDire
     // mark the layer is calculated
     bsl.bsl_ulFlags |= BSLF_CALCULATED;
     // make shadow mask for the light
+    lm_pubLayer = NULL; // [Cecil]
     ULONG ulLighted=MakeShadowMask(itbsl);
     ASSERT((ulLighted==0) || (ulLighted==BSLF_ALLLIGHT) || (ulLighted==BSLF_ALLDARK));
     bsl.bsl_ulFlags &= ~(BSLF_ALLLIGHT|BSLF_ALLDARK);
     bsl.bsl_ulFlags |= ulLighted;
 
+    // [Cecil] Remember the rendered mask for finishing it later
+    if (lm_bDeferFinishing && lm_pubLayer != NULL) {
+      // unless it's not needed anyway
+      if (ulLighted & (BSLF_ALLLIGHT|BSLF_ALLDARK)) {
+        FreeMemory(lm_pubLayer);
+
+      } else {
+        PendingLayer_t &pl = _aPendingLayers.Push();
+        pl.pbsl = itbsl;
+        pl.pubLayer = lm_pubLayer;
+        pl.mmtLayer = lm_mmtLayer;
+        pl.pixLayerMinU = lm_pixLayerMinU;
+        pl.pixLayerMinV = lm_pixLayerMinV;
+        pl.pixLayerSizeU = lm_pixLayerSizeU;
+        pl.pixLayerSizeV = lm_pixLayerSizeV;
+        _slPendingBytes += lm_mmtLayer.mmt_slTotalSize;
+      }
+
+      lm_pubLayer = NULL;
+    }
+
     // if the layer is not needed
     if( ulLighted&(BSLF_ALLLIGHT|BSLF_ALLDARK)) {
       // free it
       if( bsl.bsl_pubLayer!=NULL) FreeMemory( bsl.bsl_pubLayer);
       bsl.bsl_pubLayer = NULL;
+      bsl.bsl_slPackedSize = 0; // [Cecil]
     }
     bCalculatedSome = TRUE;
   }
 
+  // [Cecil] Finish rendered shadow masks later
+  if (lm_bDeferFinishing) {
+    const INDEX ctPending = _aPendingLayers.Count() - iFirstPending;
+
+    if (ctPending > 0) {
+      PendingPolygon_t &pp = _aPendingPolygons.Push();
+      pp.lm = *this;
+      pp.iFirstLayer = iFirstPending;
+      pp.ctLayers = ctPending;
+    }
+
   // if was intialized
-  if( bInitialized) {
+  } else if( bInitialized) {
     // free bit-packed polygon mask
     FreeMemory( lm_pubPolygonMask);
   }
@@ -889,3 +998,74 @@ void CBrushPolygon::MakeShadowMap(CWorld *pwoWorld, BOOL bDoDirectionalLights)
   }
   _pfWorldEditingProfile.StopTimer(CWorldEditingProfile::PTI_MAKESHADOWMAP);
 }
+
+// [Cecil] Finish shadow masks of a range of pending polygons
+static void FinishPendingJob(void *pvData, INDEX iFirst, INDEX ct, INDEX iThread)
+{
+  for (INDEX i = iFirst; i < iFirst + ct; i++) {
+    PendingPolygon_t &pp = _aPendingPolygons[i];
+    pp.lm.FinishPendingLayers(pp.iFirstLayer, pp.ctLayers);
+  }
+}
+
+// [Cecil] Finish all pending shadow masks on job threads
+static void FinishPendingPolygons(void)
+{
+  IJobs::ParallelFor(_aPendingPolygons.Count(), 1, FinishPendingJob, NULL);
+
+  _aPendingPolygons.PopAll();
+  _aPendingLayers.PopAll();
+  _slPendingBytes = 0;
+}
+
+// [Cecil] Create shadow maps for polygons, reporting progress only while no masks are pending
+// (if the progress hook stops the calculation, all shadow maps made so far are complete and the rest stay queued)
+static void MakePolygonShadowMaps_t(CWorld *pwoWorld, CStaticStackArray<CBrushPolygon *> &apbpo, BOOL bDoDirectionalLights, BOOL bReportProgress) // throw char *
+{
+  const INDEX ctPolygons = apbpo.Count();
+
+  if (bReportProgress) CallProgressHook_t(0.0f);
+
+  // shadows are rendered one polygon at a time but their masks are finished on all job threads
+  for (INDEX ipo = 0; ipo < ctPolygons; ipo++) {
+    CBrushPolygon &bpo = *apbpo[ipo];
+
+    CLayerMaker lmMaker;
+    lmMaker.lm_bDeferFinishing = TRUE;
+    BOOL bSomeAreUncalculated = lmMaker.CreateLayers(bpo, *pwoWorld, bDoDirectionalLights);
+
+    // unqueue the shadow map
+    if (!bSomeAreUncalculated && bpo.bpo_smShadowMap.bsm_lnInUncalculatedShadowMaps.IsLinked()) {
+      bpo.bpo_smShadowMap.bsm_lnInUncalculatedShadowMaps.Remove();
+    }
+
+    // don't keep too many unfinished masks in memory
+    if (_slPendingBytes >= MAX_PENDING_MASK_BYTES) {
+      FinishPendingPolygons();
+      if (bReportProgress) CallProgressHook_t(FLOAT(ipo + 1) / ctPolygons);
+    }
+  }
+
+  FinishPendingPolygons();
+
+  if (bReportProgress) CallProgressHook_t(1.0f);
+}
+
+// [Cecil] Create shadow maps for many polygons at once
+void MakeShadowMaps(CWorld *pwoWorld, CStaticStackArray<CBrushPolygon *> &apbpo, BOOL bDoDirectionalLights, BOOL bReportProgress)
+{
+  if (apbpo.Count() == 0) return;
+
+  _pfWorldEditingProfile.StartTimer(CWorldEditingProfile::PTI_MAKESHADOWMAP);
+
+  // let the progress hook stop the calculation
+  try {
+    MakePolygonShadowMaps_t(pwoWorld, apbpo, bDoDirectionalLights, bReportProgress);
+
+  } catch (char *) {
+    _pfWorldEditingProfile.StopTimer(CWorldEditingProfile::PTI_MAKESHADOWMAP);
+    throw;
+  }
+
+  _pfWorldEditingProfile.StopTimer(CWorldEditingProfile::PTI_MAKESHADOWMAP);
+}
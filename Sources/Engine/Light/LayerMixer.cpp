@@ -33,8 +33,10 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include <Engine/Light/Shadows_internal.h>
 #include <Engine/World/WorldEditingProfile.h>
+#include <Engine/Network/Network.h>
 
 #include <Engine/Templates/StaticArray.cpp>
+#include <Engine/Templates/StaticStackArray.cpp>
 #include <Engine/Templates/DynamicArray.cpp>
 
 // [Cecil] For no ASM in CLayerMixer::AddAmbientPoint()
@@ -42,6 +44,23 @@ with this program; if not, write to the Free Software Foundation, Inc.,
   #include <xmmintrin.h>
 #endif
 
+// [Cecil] SSE2 and AVX2 light kernels for builds without inline assembly
+#if !SE1_USE_ASM && !SE1_OLD_COMPILER
+  #include <emmintrin.h>
+  #define SE1_MIXER_SSE2 1
+
+  // AVX2 intrinsics require a newer compiler
+  #if !SE1_INCOMPLETE_CPP11
+    #include <immintrin.h>
+    #define SE1_MIXER_AVX2 1
+  #else
+    #define SE1_MIXER_AVX2 0
+  #endif
+#else
+  #define SE1_MIXER_SSE2 0
+  #define SE1_MIXER_AVX2 0
+#endif
+
 // asm shortcuts
 #define O offset
 #define Q qword ptr
@@ -49,9 +68,47 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #define W  word ptr
 #define B  byte ptr
 
+// [Cecil] Set while the current thread is mixing shadow maps as a job
+static SE1_THREADLOCAL BOOL _bMixingInJob = FALSE;
+
+// [Cecil] Profiling timers aren't thread-safe, so they are only used outside of jobs
+static inline void StartMixerTimer(INDEX iTimer) {
+  if (!_bMixingInJob) _pfWorldEditingProfile.StartTimer(iTimer);
+};
+
+static inline void StopMixerTimer(INDEX iTimer) {
+  if (!_bMixingInJob) _pfWorldEditingProfile.StopTimer(iTimer);
+};
+
 extern INDEX shd_bFineQuality;
 extern INDEX shd_iFiltering;
 extern INDEX shd_iDithering;
+extern INDEX shd_iMixerSIMD; // [Cecil]
+
+// [Cecil] CPU features
+extern BOOL sys_bCPUHasSSE2;
+extern BOOL sys_bCPUHasAVX2;
+
+// [Cecil] Instruction sets for light kernels
+enum MixerSIMD_e {
+  MSIMD_NONE = 0,
+  MSIMD_SSE2 = 1,
+  MSIMD_AVX2 = 2,
+};
+
+// [Cecil] Get the best instruction set for light kernels that's supported and allowed
+static INDEX GetMixerSIMD(void) {
+  INDEX iSupported = MSIMD_NONE;
+
+#if SE1_MIXER_SSE2
+  if (sys_bCPUHasSSE2) iSupported = MSIMD_SSE2;
+#endif
+#if SE1_MIXER_AVX2
+  if (sys_bCPUHasSSE2 && sys_bCPUHasAVX2) iSupported = MSIMD_AVX2;
+#endif
+
+  return Clamp(shd_iMixerSIMD, (INDEX)MSIMD_NONE, iSupported);
+};
 
 extern const UBYTE *pubClipByte;
 extern UBYTE aubSqrt[  SQRTTABLESIZE];
@@ -88,9 +145,12 @@ public:
   // color components of current light
   COLOR lm_colLight;
   COLOR lm_colAmbient;
+  CStaticStackArray<UBYTE> lm_aubUnpacked; // [Cecil] Decoded mask of the current layer
 
   // constructor
   CLayerMixer( CBrushShadowMap *pbsm, INDEX iFirstMip, INDEX iLastMip, BOOL bDynamic);
+  // [Cecil] Constructor for filtering already mixed mip-maps
+  CLayerMixer(void) : lm_bDynamic(FALSE) {};
 
   // remember general data
   void CalculateData( CBrushShadowMap *pbsm, INDEX iMipmap);
@@ -98,6 +158,10 @@ public:
   void MixOneMipmap( CBrushShadowMap *pbsm, INDEX iMipmap);
   // mix dynamic lights
   void MixOneMipmapDynamic(CBrushShadowMap *pbsm, INDEX iMipmap);
+  // [Cecil] Filter and dither the current mip-map
+  void FilterMipmap(void);
+  // [Cecil] Filter and dither one mip-map that has been mixed as a job
+  void FilterOneMipmap(CBrushShadowMap *pbsm, INDEX iMipmap);
 
   // find start of a mip-map inside a layer
   void FindLayerMipmap( CBrushShadowLayer *pbsl, UBYTE *&pub, UBYTE &ubMask);
@@ -169,7 +233,7 @@ inline UBYTE LimitWordToByte(SLONG sl) {
 // remember general data
 void CLayerMixer::CalculateData( CBrushShadowMap *pbsm, INDEX iMipmap)
 {
-  _pfWorldEditingProfile.StartTimer(CWorldEditingProfile::PTI_CALCULATEDATA);
+  StartMixerTimer(CWorldEditingProfile::PTI_CALCULATEDATA);
 
   // cache class vars
   lm_pbsmShadowMap = pbsm;
@@ -229,7 +293,7 @@ void CLayerMixer::CalculateData( CBrushShadowMap *pbsm, INDEX iMipmap)
   lm_vStepV-= lm_vO;
 
   ASSERT( lm_pixPolygonSizeU>0 && lm_pixPolygonSizeV>0);
-  _pfWorldEditingProfile.StopTimer(CWorldEditingProfile::PTI_CALCULATEDATA);
+  StopMixerTimer(CWorldEditingProfile::PTI_CALCULATEDATA);
 }
 
 
@@ -242,7 +306,7 @@ void CLayerMixer::FindLayerMipmap( CBrushShadowLayer *pbsl, UBYTE *&pub, UBYTE &
   // get pixel offset of the mipmap
   SLONG slPixOffset = mmtLayer.mmt_aslOffsets[lm_iMipLevel-lm_iFirstLevel];
   // convert offset to bits
-  pub = pbsl->bsl_pubLayer + (slPixOffset>>3);
+  pub = pbsl->GetLayerMask(lm_aubUnpacked) + (slPixOffset>>3); // [Cecil] Decode if needed
   ubMask = 1<<(slPixOffset&7);
 }
 
@@ -251,15 +315,25 @@ void CLayerMixer::FindLayerMipmap( CBrushShadowLayer *pbsl, UBYTE *&pub, UBYTE &
 #define FTOX   0x10000000
 #define SHIFTX (28-SQRTTABLESIZELOG2)
 
+// [Cecil] Shadow maps can only be mixed on multiple threads if transfer variables are per thread
+// (inline assembly cannot access thread-local variables)
+#if SE1_USE_ASM
+  #define SE1_JOB_MIXING 0
+  #define MIXER_VAR static
+#else
+  #define SE1_JOB_MIXING 1
+  #define MIXER_VAR static SE1_THREADLOCAL
+#endif
+
 // static variables for easier transfers
-static const FLOAT3D *_vLight;
-static FLOAT _fMinLightDistance, _f1oFallOff;
-static INDEX _iPixCt, _iRowCt;
-static SLONG _slModulo;
-static ULONG _ulLightFlags, _ulPolyFlags;
-static SLONG _slL2Row, _slDDL2oDU, _slDDL2oDV, _slDDL2oDUoDV, _slDL2oDURow, _slDL2oDV;
-static SLONG _slLightMax, _slHotSpot, _slLightStep;
-static ULONG *_pulLayer;
+MIXER_VAR const FLOAT3D *_vLight;
+MIXER_VAR FLOAT _fMinLightDistance, _f1oFallOff;
+MIXER_VAR INDEX _iPixCt, _iRowCt;
+MIXER_VAR SLONG _slModulo;
+MIXER_VAR ULONG _ulLightFlags, _ulPolyFlags;
+MIXER_VAR SLONG _slL2Row, _slDDL2oDU, _slDDL2oDV, _slDDL2oDUoDV, _slDL2oDURow, _slDL2oDV;
+MIXER_VAR SLONG _slLightMax, _slHotSpot, _slLightStep;
+MIXER_VAR ULONG *_pulLayer;
 
 #if !SE1_USE_ASM
 
@@ -355,6 +429,339 @@ static __forceinline void MixPixelMMX(ULONG &ulPixel, const SLONG slIntensity, c
 
 #endif // !SE1_USE_ASM
 
+// [Cecil] SIMD versions of light kernels for builds without inline assembly
+#if SE1_MIXER_SSE2
+
+// Light intensities are 16-bit words, so only the lowest words of 32-bit lanes are used
+// and the highest ones are ignored when mixing pixels, just like with the MMX code
+
+// Prepare light color for multiplying with intensities (0x00AA00BB00GG00RR << 1 twice per register)
+static SE1_TARGET_SSE2 inline __m128i PrepareColorSSE2(const ULONG ulLightRGB) {
+  return _mm_slli_epi16(_mm_unpacklo_epi8(_mm_set1_epi32(ulLightRGB), _mm_setzero_si128()), 1);
+};
+
+// Mix four pixels with the light color using intensities of each pixel
+static SE1_TARGET_SSE2 inline __m128i MixPixelsSSE2(const __m128i mPixels, const __m128i mIntensity, const __m128i mColor) {
+  const __m128i mZero = _mm_setzero_si128();
+
+  // Spread intensity words of pixels over all of their channels
+  __m128i mI01 = _mm_unpacklo_epi32(mIntensity, mIntensity);
+  __m128i mI23 = _mm_unpackhi_epi32(mIntensity, mIntensity);
+  mI01 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(mI01, _MM_SHUFFLE(0, 0, 0, 0)), _MM_SHUFFLE(0, 0, 0, 0));
+  mI23 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(mI23, _MM_SHUFFLE(0, 0, 0, 0)), _MM_SHUFFLE(0, 0, 0, 0));
+
+  // Calculate RGB pixels to add (pmulhw)
+  mI01 = _mm_mulhi_epi16(mI01, mColor);
+  mI23 = _mm_mulhi_epi16(mI23, mColor);
+
+  // Add light pixels to underlying pixels (punpcklbw, paddw, packuswb)
+  const __m128i mLo = _mm_add_epi16(_mm_unpacklo_epi8(mPixels, mZero), mI01);
+  const __m128i mHi = _mm_add_epi16(_mm_unpackhi_epi8(mPixels, mZero), mI23);
+  return _mm_packus_epi16(mLo, mHi);
+};
+
+// Mix one pixel with the light color
+static SE1_TARGET_SSE2 inline void MixPixelSSE2(ULONG &ulPixel, const SLONG slIntensity, const __m128i mColor) {
+  const __m128i mPixel = _mm_cvtsi32_si128(ulPixel);
+  ulPixel = _mm_cvtsi128_si32(MixPixelsSSE2(mPixel, _mm_cvtsi32_si128(slIntensity), mColor));
+};
+
+// Point light parameters for SIMD kernels
+struct PointLightSIMD_t {
+  BOOL bDiffusion;   // Use inverse square root table instead of the square root one
+  SLONG slThreshold; // Hot spot (or maximum inverse distance for diffusion)
+  ULONG ulLightRGB;  // Light color in memory format
+};
+
+// Look up distances of four points in the square root tables
+static SE1_TARGET_SSE2 inline __m128i LookUpDistancesSSE2(const PointLightSIMD_t &pl, const __m128i mL2) {
+  // And is just for degenerate cases
+  SLONG aslIndex[4];
+  _mm_storeu_si128((__m128i *)aslIndex, _mm_and_si128(_mm_srai_epi32(mL2, SHIFTX), _mm_set1_epi32(SQRTTABLESIZE - 1)));
+
+  if (pl.bDiffusion) {
+    return _mm_set_epi32(auw1oSqrt[aslIndex[3]], auw1oSqrt[aslIndex[2]], auw1oSqrt[aslIndex[1]], auw1oSqrt[aslIndex[0]]);
+  }
+
+  return _mm_set_epi32(aubSqrt[aslIndex[3]], aubSqrt[aslIndex[2]], aubSqrt[aslIndex[1]], aubSqrt[aslIndex[0]]);
+};
+
+// Calculate intensities of four points from their squared distances (masked points get zero intensity)
+static SE1_TARGET_SSE2 inline __m128i PointIntensitiesSSE2(const PointLightSIMD_t &pl, const __m128i mL2) {
+  const __m128i mDist = LookUpDistancesSSE2(pl, mL2);
+  const __m128i mThreshold = _mm_set1_epi32(pl.slThreshold);
+  const __m128i mStep = _mm_set1_epi32(_slLightStep);
+  __m128i mOver, mValue;
+
+  // Only the lowest words of the products are needed
+  if (pl.bDiffusion) {
+    mOver = _mm_cmplt_epi32(mDist, mThreshold);
+    mValue = _mm_mullo_epi16(_mm_sub_epi32(mDist, _mm_set1_epi32(256)), mStep);
+
+  } else {
+    mOver = _mm_cmpgt_epi32(mDist, mThreshold);
+    mValue = _mm_mullo_epi16(_mm_sub_epi32(_mm_set1_epi32(255), mDist), mStep);
+  }
+
+  const __m128i mIntensity = _mm_or_si128(_mm_and_si128(mOver, mValue), _mm_andnot_si128(mOver, _mm_set1_epi32(_slLightMax)));
+  return _mm_and_si128(mIntensity, _mm_cmplt_epi32(mL2, _mm_set1_epi32(FTOX)));
+};
+
+// Add point light without a mask four pixels at a time
+static SE1_TARGET_SSE2 void AddPointSSE2(const PointLightSIMD_t &pl)
+{
+  const __m128i mColor = PrepareColorSSE2(pl.ulLightRGB);
+
+  // Quadratic interpolants advance by four pixels at a time
+  const __m128i mL2Step = _mm_set1_epi32(_slDDL2oDU * 6);
+  const __m128i mDL2Step = _mm_set1_epi32(_slDDL2oDU * 4);
+
+  SLONG slL2Row = _slL2Row;
+  SLONG slDL2oDURow = _slDL2oDURow;
+  SLONG slDL2oDV = _slDL2oDV;
+  UBYTE *pubLayer = (UBYTE *)_pulLayer;
+
+  for (INDEX iRow = 0; iRow < _iRowCt; iRow++) {
+    // Prepare interpolants of the first four pixels
+    SLONG aslL2[4], aslDL2[4];
+    SLONG slL2Point = slL2Row;
+    SLONG slDL2oDU = slDL2oDURow;
+
+    for (INDEX i = 0; i < 4; i++) {
+      aslL2[i] = slL2Point;
+      aslDL2[i] = slDL2oDU;
+      slL2Point += slDL2oDU;
+      slDL2oDU += _slDDL2oDU;
+    }
+
+    __m128i mL2 = _mm_loadu_si128((const __m128i *)aslL2);
+    __m128i mDL2 = _mm_loadu_si128((const __m128i *)aslDL2);
+
+    ULONG *pulPixel = (ULONG *)pubLayer;
+    INDEX ctPixels = _iPixCt;
+
+    for (; ctPixels >= 4; ctPixels -= 4, pulPixel += 4) {
+      const __m128i mPixels = _mm_loadu_si128((const __m128i *)pulPixel);
+      _mm_storeu_si128((__m128i *)pulPixel, MixPixelsSSE2(mPixels, PointIntensitiesSSE2(pl, mL2), mColor));
+
+      mL2 = _mm_add_epi32(mL2, _mm_add_epi32(_mm_slli_epi32(mDL2, 2), mL2Step));
+      mDL2 = _mm_add_epi32(mDL2, mDL2Step);
+    }
+
+    // Remaining pixels one by one
+    if (ctPixels > 0) {
+      SLONG aslIntensity[4];
+      _mm_storeu_si128((__m128i *)aslIntensity, PointIntensitiesSSE2(pl, mL2));
+
+      for (INDEX i = 0; i < ctPixels; i++) {
+        MixPixelSSE2(pulPixel[i], aslIntensity[i], mColor);
+      }
+    }
+
+    // Advance to the next row
+    pubLayer += _iPixCt * BYTES_PER_TEXEL + _slModulo;
+    slL2Row += slDL2oDV;
+    slDL2oDURow += _slDDL2oDUoDV;
+    slDL2oDV += _slDDL2oDV;
+  }
+};
+
+// Add constant color to all pixels of the layer with saturation
+static SE1_TARGET_SSE2 void AddDirectionalSSE2(const ULONG ulLightRGB)
+{
+  const __m128i mColor = _mm_set1_epi32(ulLightRGB);
+  UBYTE *pubLayer = (UBYTE *)_pulLayer;
+
+  for (INDEX iRow = 0; iRow < _iRowCt; iRow++) {
+    ULONG *pulPixel = (ULONG *)pubLayer;
+    INDEX ctPixels = _iPixCt;
+
+    for (; ctPixels >= 4; ctPixels -= 4, pulPixel += 4) {
+      const __m128i mPixels = _mm_loadu_si128((const __m128i *)pulPixel);
+      _mm_storeu_si128((__m128i *)pulPixel, _mm_adds_epu8(mPixels, mColor));
+    }
+
+    for (INDEX i = 0; i < ctPixels; i++) {
+      pulPixel[i] = _mm_cvtsi128_si32(_mm_adds_epu8(_mm_cvtsi32_si128(pulPixel[i]), mColor));
+    }
+
+    pubLayer += _iPixCt * BYTES_PER_TEXEL + _slModulo;
+  }
+};
+
+// Add signed RGB increments (four words per pixel) to pixels with saturation
+static SE1_TARGET_SSE2 void AddIncrementsSSE2(ULONG *pulPixels, const SWORD *pswAdd, INDEX ctPixels)
+{
+  const __m128i mZero = _mm_setzero_si128();
+
+  for (; ctPixels >= 4; ctPixels -= 4, pulPixels += 4, pswAdd += 16) {
+    const __m128i mPixels = _mm_loadu_si128((const __m128i *)pulPixels);
+    const __m128i mLo = _mm_add_epi16(_mm_unpacklo_epi8(mPixels, mZero), _mm_loadu_si128((const __m128i *)pswAdd));
+    const __m128i mHi = _mm_add_epi16(_mm_unpackhi_epi8(mPixels, mZero), _mm_loadu_si128((const __m128i *)(pswAdd + 8)));
+    _mm_storeu_si128((__m128i *)pulPixels, _mm_packus_epi16(mLo, mHi));
+  }
+
+  for (INDEX i = 0; i < ctPixels; i++, pswAdd += 4) {
+    const __m128i mPixel = _mm_unpacklo_epi8(_mm_cvtsi32_si128(pulPixels[i]), mZero);
+    const __m128i mAdd = _mm_loadl_epi64((const __m128i *)pswAdd);
+    pulPixels[i] = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_add_epi16(mPixel, mAdd), mZero));
+  }
+};
+
+#if SE1_MIXER_AVX2
+
+// Same as the SSE2 functions but with eight pixels at a time
+// (AVX2 unpacking works within 128-bit halves, so pixel order is preserved after packing)
+
+static SE1_TARGET_AVX2 inline __m256i MixPixelsAVX2(const __m256i mPixels, const __m256i mIntensity, const __m256i mColor) {
+  const __m256i mZero = _mm256_setzero_si256();
+
+  __m256i mILo = _mm256_unpacklo_epi32(mIntensity, mIntensity);
+  __m256i mIHi = _mm256_unpackhi_epi32(mIntensity, mIntensity);
+  mILo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(mILo, _MM_SHUFFLE(0, 0, 0, 0)), _MM_SHUFFLE(0, 0, 0, 0));
+  mIHi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(mIHi, _MM_SHUFFLE(0, 0, 0, 0)), _MM_SHUFFLE(0, 0, 0, 0));
+
+  mILo = _mm256_mulhi_epi16(mILo, mColor);
+  mIHi = _mm256_mulhi_epi16(mIHi, mColor);
+
+  const __m256i mLo = _mm256_add_epi16(_mm256_unpacklo_epi8(mPixels, mZero), mILo);
+  const __m256i mHi = _mm256_add_epi16(_mm256_unpackhi_epi8(mPixels, mZero), mIHi);
+  return _mm256_packus_epi16(mLo, mHi);
+};
+
+static SE1_TARGET_AVX2 inline __m256i PointIntensitiesAVX2(const PointLightSIMD_t &pl, const __m256i mL2) {
+  SLONG aslIndex[8];
+  _mm256_storeu_si256((__m256i *)aslIndex, _mm256_and_si256(_mm256_srai_epi32(mL2, SHIFTX), _mm256_set1_epi32(SQRTTABLESIZE - 1)));
+
+  const __m256i mThreshold = _mm256_set1_epi32(pl.slThreshold);
+  const __m256i mStep = _mm256_set1_epi32(_slLightStep);
+  __m256i mDist, mOver, mValue;
+
+  if (pl.bDiffusion) {
+    mDist = _mm256_set_epi32(auw1oSqrt[aslIndex[7]], auw1oSqrt[aslIndex[6]], auw1oSqrt[aslIndex[5]], auw1oSqrt[aslIndex[4]],
+                             auw1oSqrt[aslIndex[3]], auw1oSqrt[aslIndex[2]], auw1oSqrt[aslIndex[1]], auw1oSqrt[aslIndex[0]]);
+    mOver = _mm256_cmpgt_epi32(mThreshold, mDist);
+    mValue = _mm256_mullo_epi16(_mm256_sub_epi32(mDist, _mm256_set1_epi32(256)), mStep);
+
+  } else {
+    mDist = _mm256_set_epi32(aubSqrt[aslIndex[7]], aubSqrt[aslIndex[6]], aubSqrt[aslIndex[5]], aubSqrt[aslIndex[4]],
+                             aubSqrt[aslIndex[3]], aubSqrt[aslIndex[2]], aubSqrt[aslIndex[1]], aubSqrt[aslIndex[0]]);
+    mOver = _mm256_cmpgt_epi32(mDist, mThreshold);
+    mValue = _mm256_mullo_epi16(_mm256_sub_epi32(_mm256_set1_epi32(255), mDist), mStep);
+  }
+
+  const __m256i mIntensity = _mm256_blendv_epi8(_mm256_set1_epi32(_slLightMax), mValue, mOver);
+  return _mm256_and_si256(mIntensity, _mm256_cmpgt_epi32(_mm256_set1_epi32(FTOX), mL2));
+};
+
+static SE1_TARGET_AVX2 void AddPointAVX2(const PointLightSIMD_t &pl)
+{
+  const __m256i mColor = _mm256_slli_epi16(_mm256_unpacklo_epi8(_mm256_set1_epi32(pl.ulLightRGB), _mm256_setzero_si256()), 1);
+  const __m128i mColorSSE = _mm256_castsi256_si128(mColor);
+
+  const __m256i mL2Step = _mm256_set1_epi32(_slDDL2oDU * 28);
+  const __m256i mDL2Step = _mm256_set1_epi32(_slDDL2oDU * 8);
+
+  SLONG slL2Row = _slL2Row;
+  SLONG slDL2oDURow = _slDL2oDURow;
+  SLONG slDL2oDV = _slDL2oDV;
+  UBYTE *pubLayer = (UBYTE *)_pulLayer;
+
+  for (INDEX iRow = 0; iRow < _iRowCt; iRow++) {
+    SLONG aslL2[8], aslDL2[8];
+    SLONG slL2Point = slL2Row;
+    SLONG slDL2oDU = slDL2oDURow;
+
+    for (INDEX i = 0; i < 8; i++) {
+      aslL2[i] = slL2Point;
+      aslDL2[i] = slDL2oDU;
+      slL2Point += slDL2oDU;
+      slDL2oDU += _slDDL2oDU;
+    }
+
+    __m256i mL2 = _mm256_loadu_si256((const __m256i *)aslL2);
+    __m256i mDL2 = _mm256_loadu_si256((const __m256i *)aslDL2);
+
+    ULONG *pulPixel = (ULONG *)pubLayer;
+    INDEX ctPixels = _iPixCt;
+
+    for (; ctPixels >= 8; ctPixels -= 8, pulPixel += 8) {
+      const __m256i mPixels = _mm256_loadu_si256((const __m256i *)pulPixel);
+      _mm256_storeu_si256((__m256i *)pulPixel, MixPixelsAVX2(mPixels, PointIntensitiesAVX2(pl, mL2), mColor));
+
+      mL2 = _mm256_add_epi32(mL2, _mm256_add_epi32(_mm256_slli_epi32(mDL2, 3), mL2Step));
+      mDL2 = _mm256_add_epi32(mDL2, mDL2Step);
+    }
+
+    if (ctPixels > 0) {
+      SLONG aslIntensity[8];
+      _mm256_storeu_si256((__m256i *)aslIntensity, PointIntensitiesAVX2(pl, mL2));
+
+      for (INDEX i = 0; i < ctPixels; i++) {
+        MixPixelSSE2(pulPixel[i], aslIntensity[i], mColorSSE);
+      }
+    }
+
+    pubLayer += _iPixCt * BYTES_PER_TEXEL + _slModulo;
+    slL2Row += slDL2oDV;
+    slDL2oDURow += _slDDL2oDUoDV;
+    slDL2oDV += _slDDL2oDV;
+  }
+};
+
+static SE1_TARGET_AVX2 void AddDirectionalAVX2(const ULONG ulLightRGB)
+{
+  const __m256i mColor = _mm256_set1_epi32(ulLightRGB);
+  const __m128i mColorSSE = _mm256_castsi256_si128(mColor);
+  UBYTE *pubLayer = (UBYTE *)_pulLayer;
+
+  for (INDEX iRow = 0; iRow < _iRowCt; iRow++) {
+    ULONG *pulPixel = (ULONG *)pubLayer;
+    INDEX ctPixels = _iPixCt;
+
+    for (; ctPixels >= 8; ctPixels -= 8, pulPixel += 8) {
+      const __m256i mPixels = _mm256_loadu_si256((const __m256i *)pulPixel);
+      _mm256_storeu_si256((__m256i *)pulPixel, _mm256_adds_epu8(mPixels, mColor));
+    }
+
+    for (INDEX i = 0; i < ctPixels; i++) {
+      pulPixel[i] = _mm_cvtsi128_si32(_mm_adds_epu8(_mm_cvtsi32_si128(pulPixel[i]), mColorSSE));
+    }
+
+    pubLayer += _iPixCt * BYTES_PER_TEXEL + _slModulo;
+  }
+};
+
+#endif // SE1_MIXER_AVX2
+
+// Add point light using the best available instruction set
+static void AddPointSIMD(INDEX iSIMD, const PointLightSIMD_t &pl)
+{
+#if SE1_MIXER_AVX2
+  if (iSIMD >= MSIMD_AVX2) {
+    AddPointAVX2(pl);
+    return;
+  }
+#endif
+
+  AddPointSSE2(pl);
+};
+
+// Add directional light using the best available instruction set
+static void AddDirectionalSIMD(INDEX iSIMD, const ULONG ulLightRGB)
+{
+#if SE1_MIXER_AVX2
+  if (iSIMD >= MSIMD_AVX2) {
+    AddDirectionalAVX2(ulLightRGB);
+    return;
+  }
+#endif
+
+  AddDirectionalSSE2(ulLightRGB);
+};
+
+#endif // SE1_MIXER_SSE2
+
 // add one layer point light without diffusion and mask
 void CLayerMixer::AddAmbientPoint(void)
 {
@@ -446,6 +853,20 @@ skipPixel:
   }
 
 #else
+  // [Cecil] Use SIMD kernels if possible
+  #if SE1_MIXER_SSE2
+    const INDEX iSIMD = GetMixerSIMD();
+
+    if (iSIMD != MSIMD_NONE) {
+      PointLightSIMD_t pl;
+      pl.bDiffusion = FALSE;
+      pl.slThreshold = _slHotSpot;
+      pl.ulLightRGB = ulLightRGB;
+      AddPointSIMD(iSIMD, pl);
+      return;
+    }
+  #endif
+
   // prepare color
   __m64 tmp_mm7;
   PrepareColorMMX(tmp_mm7, ulLightRGB);
@@ -765,6 +1186,20 @@ skipPixel:
   }
 
 #else
+  // [Cecil] Use SIMD kernels if possible
+  #if SE1_MIXER_SSE2
+    const INDEX iSIMD = GetMixerSIMD();
+
+    if (iSIMD != MSIMD_NONE) {
+      PointLightSIMD_t pl;
+      pl.bDiffusion = TRUE;
+      pl.slThreshold = slMax1oL;
+      pl.ulLightRGB = ulLightRGB;
+      AddPointSIMD(iSIMD, pl);
+      return;
+    }
+  #endif
+
   // prepare color
   __m64 tmp_mm7;
   PrepareColorMMX(tmp_mm7, ulLightRGB);
@@ -1139,9 +1574,9 @@ BOOL CLayerMixer::PrepareOneLayerPoint( CBrushShadowLayer *pbsl, BOOL bNoMask)
 void CLayerMixer::AddOneLayerPoint( CBrushShadowLayer *pbsl, UBYTE *pubMask, UBYTE ubMask)
 {
   // try to prepare layer for this point light
-  _pfWorldEditingProfile.StartTimer( CWorldEditingProfile::PTI_ADDONELAYERPOINT);
+  StartMixerTimer(CWorldEditingProfile::PTI_ADDONELAYERPOINT);
   if( !PrepareOneLayerPoint( pbsl, pubMask==NULL)) {
-    _pfWorldEditingProfile.StopTimer( CWorldEditingProfile::PTI_ADDONELAYERPOINT);
+    StopMixerTimer(CWorldEditingProfile::PTI_ADDONELAYERPOINT);
     return;
   }
 
@@ -1168,7 +1603,7 @@ void CLayerMixer::AddOneLayerPoint( CBrushShadowLayer *pbsl, UBYTE *pubMask, UBY
   }
 
   // all done
-  _pfWorldEditingProfile.StopTimer(CWorldEditingProfile::PTI_ADDONELAYERPOINT);
+  StopMixerTimer(CWorldEditingProfile::PTI_ADDONELAYERPOINT);
 }
 
 
@@ -1335,6 +1770,14 @@ rowDone:
   PIX   pixOffset = 0;
   PIX   pixModulo = lm_pixCanvasSizeU-lm_pixPolygonSizeU;
 
+  // [Cecil] Increments are calculated one by one but added to pixels with SIMD in chunks
+  // (AVX2 wouldn't help much here because calculating increments takes most of the time)
+  #if SE1_MIXER_SSE2
+    #define GRADIENT_CHUNK 64
+    const BOOL bSIMD = (GetMixerSIMD() != MSIMD_NONE);
+    SWORD aswAdd[GRADIENT_CHUNK * 4];
+  #endif
+
   for (INDEX j = 0; j < lm_pixPolygonSizeV; j++)
   {
     // prepare row
@@ -1349,9 +1792,28 @@ rowDone:
       SLONG slR = Clamp(fixRcol >> 6, -255, +255);
       SLONG slG = Clamp(fixGcol >> 6, -255, +255);
       SLONG slB = Clamp(fixBcol >> 6, -255, +255);
-      IncrementByteWithClip( ((UBYTE*)&_pulLayer[pixOffset])[0], slR);
-      IncrementByteWithClip( ((UBYTE*)&_pulLayer[pixOffset])[1], slG);
-      IncrementByteWithClip( ((UBYTE*)&_pulLayer[pixOffset])[2], slB);
+
+    #if SE1_MIXER_SSE2
+      if (bSIMD) {
+        const INDEX iInChunk = i % GRADIENT_CHUNK;
+        SWORD *pswAdd = &aswAdd[iInChunk * 4];
+        pswAdd[0] = slR;
+        pswAdd[1] = slG;
+        pswAdd[2] = slB;
+        pswAdd[3] = 0;
+
+        // add the whole chunk at its last pixel
+        if (iInChunk == GRADIENT_CHUNK - 1 || i == lm_pixPolygonSizeU - 1) {
+          AddIncrementsSSE2(&_pulLayer[pixOffset - iInChunk], aswAdd, iInChunk + 1);
+        }
+
+      } else
+    #endif
+      {
+        IncrementByteWithClip( ((UBYTE*)&_pulLayer[pixOffset])[0], slR);
+        IncrementByteWithClip( ((UBYTE*)&_pulLayer[pixOffset])[1], slG);
+        IncrementByteWithClip( ((UBYTE*)&_pulLayer[pixOffset])[2], slB);
+      }
 
       // advance to next pixel
       fGrCol += fDGroDI;
@@ -1440,6 +1902,16 @@ rowNext:
   }
 
 #else
+  // [Cecil] Use SIMD kernels if possible (alpha channel is left as is)
+  #if SE1_MIXER_SSE2
+    const INDEX iSIMD = GetMixerSIMD();
+
+    if (iSIMD != MSIMD_NONE) {
+      AddDirectionalSIMD(iSIMD, ByteSwap32(lm_colLight) & 0x00FFFFFF);
+      return;
+    }
+  #endif
+
   UBYTE *pubLayer = (UBYTE *)_pulLayer; // remp carret
 
   // for each pixel in the shadow map
@@ -1530,7 +2002,7 @@ void CLayerMixer::AddOneLayerDirectional( CBrushShadowLayer *pbsl, UBYTE *pubMas
 {
   // only if there is color light (ambient is added at initial fill)
   if( !(lm_pbpoPolygon->bpo_ulFlags&BPOF_HASDIRECTIONALLIGHT)) return;
-  _pfWorldEditingProfile.StartTimer(CWorldEditingProfile::PTI_ADDONELAYERDIRECTIONAL);
+  StartMixerTimer(CWorldEditingProfile::PTI_ADDONELAYERDIRECTIONAL);
 
   // determine light influence dimensions
   _iPixCt = pbsl->bsl_pixSizeU >>lm_iMipShift;
@@ -1547,7 +2019,7 @@ void CLayerMixer::AddOneLayerDirectional( CBrushShadowLayer *pbsl, UBYTE *pubMas
   // if there is no influence, do nothing
   if( (pbsl->bsl_pixSizeU>>lm_iMipShift)==0 || (pbsl->bsl_pixSizeV>>lm_iMipShift)==0
     || _iPixCt<=0 || _iRowCt<=0) {
-    _pfWorldEditingProfile.StopTimer(CWorldEditingProfile::PTI_ADDONELAYERDIRECTIONAL);
+    StopMixerTimer(CWorldEditingProfile::PTI_ADDONELAYERDIRECTIONAL);
     return;
   }
 
@@ -1579,7 +2051,7 @@ void CLayerMixer::AddOneLayerDirectional( CBrushShadowLayer *pbsl, UBYTE *pubMas
   }
 
   // all done
-  _pfWorldEditingProfile.StopTimer(CWorldEditingProfile::PTI_ADDONELAYERDIRECTIONAL);
+  StopMixerTimer(CWorldEditingProfile::PTI_ADDONELAYERDIRECTIONAL);
 }
 
 
@@ -1602,7 +2074,7 @@ void CLayerMixer::MixOneMipmap(CBrushShadowMap *pbsm, INDEX iMipmap)
   const BOOL bDynamicOnly = lm_pbpoPolygon->bpo_ulFlags&BPOF_DYNAMICLIGHTSONLY;
 
   // fill with sector ambient
-  _pfWorldEditingProfile.StartTimer(CWorldEditingProfile::PTI_AMBIENTFILL);
+  StartMixerTimer(CWorldEditingProfile::PTI_AMBIENTFILL);
 
   // eventually add ambient component of all directional layers that might contribute
   COLOR colAmbient = 0x80808000UL; // overide ambient light color for dynamic lights only
@@ -1646,7 +2118,7 @@ void CLayerMixer::MixOneMipmap(CBrushShadowMap *pbsm, INDEX iMipmap)
   }
 #endif
 
-  _pfWorldEditingProfile.StopTimer(CWorldEditingProfile::PTI_AMBIENTFILL);
+  StopMixerTimer(CWorldEditingProfile::PTI_AMBIENTFILL);
 
   // find gradient layer
   CGradientParameters gpGradient;
@@ -1705,6 +2177,14 @@ void CLayerMixer::MixOneMipmap(CBrushShadowMap *pbsm, INDEX iMipmap)
   // if gradient is dark, substract gradient
   if( bHasGradient && gpGradient.gp_bDark) AddOneLayerGradient( gpGradient);
 
+  // [Cecil] Bitmap filters aren't thread-safe, so jobs leave filtering for later
+  if( !_bMixingInJob) FilterMipmap();
+}
+
+
+// [Cecil] Filter and dither the current mip-map
+void CLayerMixer::FilterMipmap(void)
+{
   // do eventual filtering of shadow layer
   shd_iFiltering = Clamp( shd_iFiltering, 0L, +6L);
   if( shd_iFiltering>0) {
@@ -1721,6 +2201,14 @@ void CLayerMixer::MixOneMipmap(CBrushShadowMap *pbsm, INDEX iMipmap)
 }
 
 
+// [Cecil] Filter and dither one mip-map that has been mixed as a job
+void CLayerMixer::FilterOneMipmap(CBrushShadowMap *pbsm, INDEX iMipmap)
+{
+  CalculateData( pbsm, iMipmap);
+  FilterMipmap();
+}
+
+
 
 // copy from static shadow map to dynamic layer
 __forceinline void CLayerMixer::CopyShadowLayer(void)
@@ -1830,9 +2318,109 @@ CLayerMixer::CLayerMixer( CBrushShadowMap *pbsm, INDEX iFirstMip, INDEX iLastMip
 }
 
 
+// [Cecil] Shadow map mixing that has been postponed until MixDeferredShadowMaps()
+struct DeferredMix_t {
+  CBrushShadowMap *pbsm;
+  INDEX iFirstMip;
+  INDEX iLastMip;
+  BOOL bDynamic;
+  INDEX iUploadIfBlack; // Mip level to upload from if dynamic layers turn out to be all black
+
+  inline void Clear(void) {};
+};
+
+static BOOL _bDeferMixing = FALSE;
+static CStaticStackArray<DeferredMix_t> _aDeferredStatic;
+static CStaticStackArray<DeferredMix_t> _aDeferredDynamic;
+
+// [Cecil] Postpone mixing of shadow maps
+void DeferShadowMapMixing(void)
+{
+  ASSERT(!_bDeferMixing);
+  _bDeferMixing = TRUE;
+}
+
+// [Cecil] Mix a range of postponed shadow maps
+static void MixDeferredJob(void *pvData, INDEX iFirst, INDEX ct, INDEX iThread)
+{
+  CStaticStackArray<DeferredMix_t> &aMixes = *(CStaticStackArray<DeferredMix_t> *)pvData;
+
+  _bMixingInJob = TRUE;
+
+  for (INDEX i = iFirst; i < iFirst + ct; i++) {
+    DeferredMix_t &mix = aMixes[i];
+    CLayerMixer lmMixer(mix.pbsm, mix.iFirstMip, mix.iLastMip, mix.bDynamic);
+  }
+
+  _bMixingInJob = FALSE;
+}
+
+// [Cecil] Mix all postponed shadow maps on job threads
+void MixDeferredShadowMaps(void)
+{
+  ASSERT(_bDeferMixing);
+  _bDeferMixing = FALSE;
+
+  _sfStats.StartTimer( CStatForm::STI_SHADOWUPDATE);
+  _pfWorldEditingProfile.StartTimer( CWorldEditingProfile::PTI_MIXLAYERS);
+
+#if SE1_JOB_MIXING
+  IJobs::ParallelFor(_aDeferredStatic.Count(), 1, MixDeferredJob, &_aDeferredStatic);
+#else
+  MixDeferredJob(&_aDeferredStatic, 0, _aDeferredStatic.Count(), 0);
+#endif
+
+  // filter static mip-maps before dynamic layers copy them
+  CLayerMixer lmFilter;
+
+  for (INDEX iMix = 0; iMix < _aDeferredStatic.Count(); iMix++) {
+    DeferredMix_t &mix = _aDeferredStatic[iMix];
+
+    for (INDEX iMipmap = mix.iFirstMip; iMipmap <= mix.iLastMip; iMipmap++) {
+      lmFilter.FilterOneMipmap(mix.pbsm, iMipmap);
+    }
+  }
+
+#if SE1_JOB_MIXING
+  IJobs::ParallelFor(_aDeferredDynamic.Count(), 1, MixDeferredJob, &_aDeferredDynamic);
+#else
+  MixDeferredJob(&_aDeferredDynamic, 0, _aDeferredDynamic.Count(), 0);
+#endif
+
+  // upload only static layers if dynamic ones turned out to be all black
+  for (INDEX iMix = 0; iMix < _aDeferredDynamic.Count(); iMix++) {
+    DeferredMix_t &mix = _aDeferredDynamic[iMix];
+
+    if (mix.pbsm->sm_ulFlags & SMF_DYNAMICBLACK) {
+      mix.pbsm->sm_iFirstUploadMipLevel = mix.iUploadIfBlack;
+    }
+  }
+
+  _aDeferredStatic.PopAll();
+  _aDeferredDynamic.PopAll();
+
+  _pfWorldEditingProfile.StopTimer( CWorldEditingProfile::PTI_MIXLAYERS);
+  _sfStats.StopTimer( CStatForm::STI_SHADOWUPDATE);
+}
+
+
 // mix all layers into cached shadow map
 void CBrushShadowMap::MixLayers( INDEX iFirstMip, INDEX iLastMip, BOOL bDynamic/*=FALSE*/)
 {
+  // [Cecil] Remember the shadow map for mixing it later
+  if (_bDeferMixing) {
+    DeferredMix_t &mix = (bDynamic ? _aDeferredDynamic : _aDeferredStatic).Push();
+    mix.pbsm = this;
+    mix.iFirstMip = iFirstMip;
+    mix.iLastMip = iLastMip;
+    mix.bDynamic = bDynamic;
+    mix.iUploadIfBlack = sm_iFirstUploadMipLevel;
+
+    // dynamic layers are assumed to be visible until they are mixed, which corrects the upload level
+    if (bDynamic) sm_ulFlags &= ~SMF_DYNAMICBLACK;
+    return;
+  }
+
   _sfStats.StartTimer( CStatForm::STI_SHADOWUPDATE);
   _pfWorldEditingProfile.StartTimer( CWorldEditingProfile::PTI_MIXLAYERS);
   // mix the layers with a shadow mixer
@@ -1840,3 +2428,145 @@ void CBrushShadowMap::MixLayers( INDEX iFirstMip, INDEX iLastMip, BOOL bDynamic/
   _pfWorldEditingProfile.StopTimer( CWorldEditingProfile::PTI_MIXLAYERS);
   _sfStats.StopTimer( CStatForm::STI_SHADOWUPDATE);
 }
+
+
+// [Cecil] Shadow map state that's changed by mixing its layers
+struct BenchmarkedShadowMap_t {
+  ULONG *pulCached;
+  ULONG *pulDynamic;
+  SLONG slMemoryUsed;
+  ULONG ulFlags;
+  CStaticStackArray<COLOR> acolLastAnim;
+
+  void Save(CBrushShadowMap &bsm) {
+    pulCached = bsm.sm_pulCachedShadowMap;
+    pulDynamic = bsm.sm_pulDynamicShadowMap;
+    slMemoryUsed = bsm.sm_slMemoryUsed;
+    ulFlags = bsm.sm_ulFlags;
+
+    acolLastAnim.PopAll();
+
+    FOREACHINLIST(CBrushShadowLayer, bsl_lnInShadowMap, bsm.bsm_lhLayers, itbsl) {
+      acolLastAnim.Push() = itbsl->bsl_colLastAnim;
+    }
+  };
+
+  void Restore(CBrushShadowMap &bsm) {
+    bsm.sm_pulCachedShadowMap = pulCached;
+    bsm.sm_pulDynamicShadowMap = pulDynamic;
+    bsm.sm_slMemoryUsed = slMemoryUsed;
+    bsm.sm_ulFlags = ulFlags;
+
+    INDEX iLayer = 0;
+
+    FOREACHINLIST(CBrushShadowLayer, bsl_lnInShadowMap, bsm.bsm_lhLayers, itbsl) {
+      itbsl->bsl_colLastAnim = acolLastAnim[iLayer++];
+    }
+  };
+};
+
+// [Cecil] Mix all shadow maps of the current world with each instruction set and compare results
+void BenchmarkShadowMixing(void *pArgs)
+{
+  const INDEX ctRepeats = Clamp(NEXTARGUMENT(INDEX), (INDEX)1, (INDEX)1000);
+
+  CWorld *pwo = _pNetwork->ga_pWorld;
+
+  if (pwo == NULL) {
+    CPrintF(TRANS("There is no world loaded!\n"));
+    return;
+  }
+
+  // gather shadow maps with layers
+  CStaticStackArray<CBrushShadowMap *> apbsm;
+
+  {FOREACHINDYNAMICARRAY(pwo->wo_baBrushes.ba_abrBrushes, CBrush3D, itbr) {
+    if (itbr->br_penEntity == NULL) continue;
+
+    FOREACHINLIST(CBrushMip, bm_lnInBrush, itbr->br_lhBrushMips, itbm) {
+      FOREACHINDYNAMICARRAY(itbm->bm_abscSectors, CBrushSector, itbsc) {
+        FOREACHINSTATICARRAY(itbsc->bsc_abpoPolygons, CBrushPolygon, itbpo) {
+          if (!itbpo->bpo_smShadowMap.bsm_lhLayers.IsEmpty()) apbsm.Push() = &itbpo->bpo_smShadowMap;
+        }
+      }
+    }
+  }}
+
+  const INDEX ctShadowMaps = apbsm.Count();
+
+  if (ctShadowMaps == 0) {
+    CPrintF(TRANS("There are no shadow maps in the current world!\n"));
+    return;
+  }
+
+  // find out which instruction sets can be tested
+  const INDEX iOldSIMD = shd_iMixerSIMD;
+  shd_iMixerSIMD = MSIMD_AVX2;
+  const INDEX iSupported = GetMixerSIMD();
+
+  DOUBLE adSeconds[MSIMD_AVX2 + 1] = { 0.0 };
+  INDEX actMismatches[MSIMD_AVX2 + 1] = { 0 };
+  SLONG slTexels = 0;
+
+  CStaticStackArray<ULONG> aulReference, aulMixed;
+  BenchmarkedShadowMap_t bsmSaved;
+
+  // mix without filtering and profiling, like in jobs
+  _bMixingInJob = TRUE;
+
+  for (INDEX iShadowMap = 0; iShadowMap < ctShadowMaps; iShadowMap++) {
+    CBrushShadowMap &bsm = *apbsm[iShadowMap];
+    const INDEX iFirstMip = bsm.sm_iFirstMipLevel;
+    const INDEX iLastMip = bsm.sm_iLastMipLevel;
+
+    // mix static and dynamic layers into separate buffers instead of the cached ones
+    const SLONG slSize = GetMipmapOffset(15, bsm.sm_mexWidth >> iFirstMip, bsm.sm_mexHeight >> iFirstMip);
+    slTexels += slSize;
+
+    aulMixed.PopAll();
+    ULONG *pulMixed = aulMixed.Push(slSize * 2);
+
+    bsmSaved.Save(bsm);
+    bsm.sm_pulCachedShadowMap = pulMixed;
+    bsm.sm_pulDynamicShadowMap = pulMixed + slSize;
+    bsm.sm_slMemoryUsed = slSize * BYTES_PER_TEXEL;
+
+    for (INDEX iSIMD = MSIMD_NONE; iSIMD <= iSupported; iSIMD++) {
+      shd_iMixerSIMD = iSIMD;
+
+      // dynamic layers might not be mixed at all
+      memset(pulMixed, 0, slSize * 2 * BYTES_PER_TEXEL);
+      CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+
+      for (INDEX iRepeat = 0; iRepeat < ctRepeats; iRepeat++) {
+        CLayerMixer lmStatic(&bsm, iFirstMip, iLastMip, FALSE);
+        CLayerMixer lmDynamic(&bsm, iFirstMip, iLastMip, TRUE);
+      }
+
+      adSeconds[iSIMD] += (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+
+      // compare with texels mixed without SIMD
+      if (iSIMD == MSIMD_NONE) {
+        aulReference.PopAll();
+        memcpy(aulReference.Push(slSize * 2), pulMixed, slSize * 2 * BYTES_PER_TEXEL);
+
+      } else if (memcmp(&aulReference[0], pulMixed, slSize * 2 * BYTES_PER_TEXEL) != 0) {
+        actMismatches[iSIMD]++;
+      }
+    }
+
+    bsmSaved.Restore(bsm);
+  }
+
+  _bMixingInJob = FALSE;
+  shd_iMixerSIMD = iOldSIMD;
+
+  static const char *astrSIMD[MSIMD_AVX2 + 1] = { "no SIMD", "SSE2", "AVX2" };
+
+  CPrintF(TRANS("Mixed %d shadow maps (%d texels) %d times:\n"), ctShadowMaps, slTexels, ctRepeats);
+
+  for (INDEX iSIMD = MSIMD_NONE; iSIMD <= iSupported; iSIMD++) {
+    CPrintF(TRANS("  %s: %.2f ms (%.2fx), mismatching shadow maps: %d\n"), astrSIMD[iSIMD],
+      adSeconds[iSIMD] * 1000.0, adSeconds[MSIMD_NONE] / ClampDn(adSeconds[iSIMD], 1e-9), actMismatches[iSIMD]);
+  }
+}
@@ -250,6 +250,7 @@ void CLightSource::AddLayer(CBrushPolygon &bpo)
 
   // initially it has no shadow
   bsl.bsl_pubLayer = NULL;
+  bsl.bsl_slPackedSize = 0; // [Cecil]
   bsl.bsl_ulFlags = 0;
 
   SetLayerParameters(bsl, bpo, lr);
@@ -33,4 +33,13 @@ public:
   FLOAT lr_fLightPlaneDistance;
 };
 
+// [Cecil] Postpone mixing of shadow map layers until MixDeferredShadowMaps() is called
+void DeferShadowMapMixing(void);
+
+// [Cecil] Mix all postponed shadow maps on job threads
+void MixDeferredShadowMaps(void);
+
+// [Cecil] Create shadow maps for many polygons at once, finishing their layers on job threads
+void MakeShadowMaps(CWorld *pwoWorld, CStaticStackArray<CBrushPolygon *> &apbpo, BOOL bDoDirectionalLights, BOOL bReportProgress);
+
 #endif // include-once check
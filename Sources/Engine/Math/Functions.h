@@ -177,6 +177,13 @@ inline SLONG DoubleToInt(DOUBLE f) {
   return SLONG(f + fAddToRound);
 };
 
+// [Cecil] Advance a seed of a simple pseudo-random generator and return it
+// For reproducible test data that mustn't touch the game's synchronized random seed
+inline ULONG NextRandomSeed(ULONG &ulSeed) {
+  ulSeed = ulSeed * 1103515245 + 12345;
+  return ulSeed;
+};
+
 // log base 2 of any float numero
 inline FLOAT Log2( FLOAT f) {
 // [Cecil] No log2f
@@ -50,6 +50,17 @@ extern const UBYTE *pubClipByte;
 extern const FLOAT *pfSinTable;
 extern const FLOAT *pfCosTable;
 
+// [Cecil] SSE2 kernels for unpacking model frames in builds without inline assembly
+#if !SE1_USE_ASM && !SE1_OLD_COMPILER
+  #include <emmintrin.h>
+  #define SE1_MODEL_SSE2 1
+#else
+  #define SE1_MODEL_SSE2 0
+#endif
+
+extern BOOL sys_bCPUHasSSE2; // [Cecil]
+extern INDEX mdl_bCacheFrames; // [Cecil]
+
 static GfxAPIType _eAPI;
 
 static BOOL  _bForceTranslucency;    // force translucency of opaque/transparent surfaces (for model fading)
@@ -1095,6 +1106,276 @@ static void AttenuateColor( const UBYTE *pshdMip, const INDEX ctVertices)
 
 
 // unpack vertices (and eventually normals) of one frame
+// [Cecil] Frame of one model mip unpacked in the current frame, for models that share the same animation
+struct UnpackedFrame_t {
+  const ModelMipInfo *uf_pmmi;
+  const void *uf_pvFrame0;
+  const void *uf_pvFrame1;
+  FLOAT uf_fRatio;
+  FLOAT3D uf_vStretch;
+  INDEX uf_iFrameNumber;
+  CStaticStackArray<GFXVertex3> uf_avtx;
+  CStaticStackArray<GFXNormal3> uf_anor;
+
+  UnpackedFrame_t() : uf_pmmi(NULL), uf_pvFrame0(NULL), uf_pvFrame1(NULL), uf_fRatio(0.0f), uf_iFrameNumber(-1) {};
+};
+
+// [Cecil] Amount of different frames that can be reused during one frame
+#define MAX_UNPACKED_FRAMES 32
+
+static UnpackedFrame_t _aufUnpacked[MAX_UNPACKED_FRAMES];
+static INDEX _iNextUnpacked = 0;
+
+// [Cecil] Forget all unpacked frames
+static void ClearUnpackedFrames(void)
+{
+  for( INDEX i=0; i<MAX_UNPACKED_FRAMES; i++) {
+    _aufUnpacked[i].uf_pmmi = NULL;
+    _aufUnpacked[i].uf_iFrameNumber = -1;
+  }
+  _iNextUnpacked = 0;
+}
+
+#if SE1_MODEL_SSE2
+
+// [Cecil] Can be disabled for comparing against the scalar code
+static BOOL _bUnpackSIMD = TRUE;
+
+// [Cecil] Normals for models that don't keep them
+static CStaticStackArray<GFXNormal3> _anorUnpacked;
+
+// [Cecil] Positions and normals of four vertices of one frame
+struct FrameLanes_t {
+  __m128 x, y, z;
+  __m128 nx, ny, nz;
+};
+
+SE1_TARGET_SSE2 static inline void LoadFrameLanes( const ModelFrameVertex16 *pFrame, const INDEX *aiMdlVx, FrameLanes_t &fl)
+{
+  const ModelFrameVertex16 &mfv0 = pFrame[aiMdlVx[0]];
+  const ModelFrameVertex16 &mfv1 = pFrame[aiMdlVx[1]];
+  const ModelFrameVertex16 &mfv2 = pFrame[aiMdlVx[2]];
+  const ModelFrameVertex16 &mfv3 = pFrame[aiMdlVx[3]];
+
+  fl.x = _mm_set_ps( mfv3.mfv_SWPoint(1), mfv2.mfv_SWPoint(1), mfv1.mfv_SWPoint(1), mfv0.mfv_SWPoint(1));
+  fl.y = _mm_set_ps( mfv3.mfv_SWPoint(2), mfv2.mfv_SWPoint(2), mfv1.mfv_SWPoint(2), mfv0.mfv_SWPoint(2));
+  fl.z = _mm_set_ps( mfv3.mfv_SWPoint(3), mfv2.mfv_SWPoint(3), mfv1.mfv_SWPoint(3), mfv0.mfv_SWPoint(3));
+
+  // normals from heading and pitch angles
+  const __m128 vSignMask = _mm_set1_ps( -0.0f);
+  const __m128 vSinH = _mm_set_ps( pfSinTable[mfv3.mfv_ubNormH], pfSinTable[mfv2.mfv_ubNormH], pfSinTable[mfv1.mfv_ubNormH], pfSinTable[mfv0.mfv_ubNormH]);
+  const __m128 vCosH = _mm_set_ps( pfCosTable[mfv3.mfv_ubNormH], pfCosTable[mfv2.mfv_ubNormH], pfCosTable[mfv1.mfv_ubNormH], pfCosTable[mfv0.mfv_ubNormH]);
+  const __m128 vSinP = _mm_set_ps( pfSinTable[mfv3.mfv_ubNormP], pfSinTable[mfv2.mfv_ubNormP], pfSinTable[mfv1.mfv_ubNormP], pfSinTable[mfv0.mfv_ubNormP]);
+  const __m128 vCosP = _mm_set_ps( pfCosTable[mfv3.mfv_ubNormP], pfCosTable[mfv2.mfv_ubNormP], pfCosTable[mfv1.mfv_ubNormP], pfCosTable[mfv0.mfv_ubNormP]);
+
+  fl.nx = _mm_mul_ps( _mm_xor_ps( vSinH, vSignMask), vCosP);
+  fl.ny = vSinP;
+  fl.nz = _mm_mul_ps( _mm_xor_ps( vCosH, vSignMask), vCosP);
+}
+
+SE1_TARGET_SSE2 static inline void LoadFrameLanes( const ModelFrameVertex8 *pFrame, const INDEX *aiMdlVx, FrameLanes_t &fl)
+{
+  const ModelFrameVertex8 &mfv0 = pFrame[aiMdlVx[0]];
+  const ModelFrameVertex8 &mfv1 = pFrame[aiMdlVx[1]];
+  const ModelFrameVertex8 &mfv2 = pFrame[aiMdlVx[2]];
+  const ModelFrameVertex8 &mfv3 = pFrame[aiMdlVx[3]];
+
+  fl.x = _mm_set_ps( mfv3.mfv_SBPoint(1), mfv2.mfv_SBPoint(1), mfv1.mfv_SBPoint(1), mfv0.mfv_SBPoint(1));
+  fl.y = _mm_set_ps( mfv3.mfv_SBPoint(2), mfv2.mfv_SBPoint(2), mfv1.mfv_SBPoint(2), mfv0.mfv_SBPoint(2));
+  fl.z = _mm_set_ps( mfv3.mfv_SBPoint(3), mfv2.mfv_SBPoint(3), mfv1.mfv_SBPoint(3), mfv0.mfv_SBPoint(3));
+
+  // normals from the table
+  const FLOAT3D &vNormal0 = avGouraudNormals[mfv0.mfv_NormIndex];
+  const FLOAT3D &vNormal1 = avGouraudNormals[mfv1.mfv_NormIndex];
+  const FLOAT3D &vNormal2 = avGouraudNormals[mfv2.mfv_NormIndex];
+  const FLOAT3D &vNormal3 = avGouraudNormals[mfv3.mfv_NormIndex];
+
+  fl.nx = _mm_set_ps( vNormal3(1), vNormal2(1), vNormal1(1), vNormal0(1));
+  fl.ny = _mm_set_ps( vNormal3(2), vNormal2(2), vNormal1(2), vNormal0(2));
+  fl.nz = _mm_set_ps( vNormal3(3), vNormal2(3), vNormal1(3), vNormal0(3));
+}
+
+// [Cecil] Same as Lerp() with ratios other than 0 and 1
+SE1_TARGET_SSE2 static inline __m128 LerpLanes( __m128 v0, __m128 v1, __m128 vRatio)
+{
+  return _mm_add_ps( v0, _mm_mul_ps( _mm_sub_ps( v1, v0), vRatio));
+}
+
+// [Cecil] Unpack positions and normals of mip vertices from one frame or lerp them between two frames
+// (gives the same results as the scalar code, so lerping by exactly 0 or 1 must be done with one frame)
+template<class FrameVertex> SE1_TARGET_SSE2
+static void UnpackVerticesSSE2( const FrameVertex *pFrame0, const FrameVertex *pFrame1, FLOAT fRatio,
+  const CRenderModel &rm, GFXVertex3 *pvtx, GFXNormal3 *pnor)
+{
+  const UWORD *puwMipToMdl = (const UWORD*)&rm.rm_pmmiMip->mmpi_auwMipToMdl[0];
+  const BOOL bLerp = (pFrame0!=pFrame1);
+
+  const __m128 vRatio    = _mm_set1_ps( fRatio);
+  const __m128 vOffsetX  = _mm_set1_ps( rm.rm_vOffset(1));
+  const __m128 vOffsetY  = _mm_set1_ps( rm.rm_vOffset(2));
+  const __m128 vOffsetZ  = _mm_set1_ps( rm.rm_vOffset(3));
+  const __m128 vStretchX = _mm_set1_ps( rm.rm_vStretch(1));
+  const __m128 vStretchY = _mm_set1_ps( rm.rm_vStretch(2));
+  const __m128 vStretchZ = _mm_set1_ps( rm.rm_vStretch(3));
+
+  FrameLanes_t fl0, fl1;
+  FLOAT afX[4], afY[4], afZ[4], afNX[4], afNY[4], afNZ[4];
+
+  for( INDEX iMipVx=0; iMipVx<_ctAllMipVx; iMipVx+=4)
+  {
+    // repeat the last vertex in unused lanes
+    const INDEX ctLanes = Min( _ctAllMipVx-iMipVx, (INDEX)4);
+    INDEX aiMdlVx[4];
+    for( INDEX iLane=0; iLane<4; iLane++) aiMdlVx[iLane] = puwMipToMdl[iMipVx + Min( iLane, ctLanes-1)];
+
+    LoadFrameLanes( pFrame0, aiMdlVx, fl0);
+
+    if( bLerp) {
+      LoadFrameLanes( pFrame1, aiMdlVx, fl1);
+      fl0.x  = LerpLanes( fl0.x,  fl1.x,  vRatio);
+      fl0.y  = LerpLanes( fl0.y,  fl1.y,  vRatio);
+      fl0.z  = LerpLanes( fl0.z,  fl1.z,  vRatio);
+      fl0.nx = LerpLanes( fl0.nx, fl1.nx, vRatio);
+      fl0.ny = LerpLanes( fl0.ny, fl1.ny, vRatio);
+      fl0.nz = LerpLanes( fl0.nz, fl1.nz, vRatio);
+    }
+
+    _mm_storeu_ps( afX, _mm_mul_ps( _mm_sub_ps( fl0.x, vOffsetX), vStretchX));
+    _mm_storeu_ps( afY, _mm_mul_ps( _mm_sub_ps( fl0.y, vOffsetY), vStretchY));
+    _mm_storeu_ps( afZ, _mm_mul_ps( _mm_sub_ps( fl0.z, vOffsetZ), vStretchZ));
+    _mm_storeu_ps( afNX, fl0.nx);
+    _mm_storeu_ps( afNY, fl0.ny);
+    _mm_storeu_ps( afNZ, fl0.nz);
+
+    for( INDEX iLane=0; iLane<ctLanes; iLane++) {
+      GFXVertex3 &vtx = pvtx[iMipVx+iLane];
+      vtx.x = afX[iLane];
+      vtx.y = afY[iLane];
+      vtx.z = afZ[iLane];
+      GFXNormal3 &nor = pnor[iMipVx+iLane];
+      nor.nx = afNX[iLane];
+      nor.ny = afNY[iLane];
+      nor.nz = afNZ[iLane];
+    }
+  }
+}
+
+// [Cecil] Calculate vertex shades from unpacked normals
+SE1_TARGET_SSE2 static void ShadeVerticesSSE2( const CRenderModel &rm, const GFXNormal3 *pnor, SWORD *pswMipCol)
+{
+  const __m128 vLightX = _mm_set1_ps( rm.rm_vLightObj(1) * -255.0f);
+  const __m128 vLightY = _mm_set1_ps( rm.rm_vLightObj(2) * -255.0f);
+  const __m128 vLightZ = _mm_set1_ps( rm.rm_vLightObj(3) * -255.0f);
+  const __m128 vSignMask = _mm_set1_ps( -0.0f);
+  const __m128 vHalf = _mm_set1_ps( 0.5f);
+  SLONG aslShades[4];
+
+  for( INDEX iMipVx=0; iMipVx<_ctAllMipVx; iMipVx+=4)
+  {
+    const INDEX ctLanes = Min( _ctAllMipVx-iMipVx, (INDEX)4);
+    const GFXNormal3 &nor0 = pnor[iMipVx];
+    const GFXNormal3 &nor1 = pnor[iMipVx + Min( (INDEX)1, ctLanes-1)];
+    const GFXNormal3 &nor2 = pnor[iMipVx + Min( (INDEX)2, ctLanes-1)];
+    const GFXNormal3 &nor3 = pnor[iMipVx + Min( (INDEX)3, ctLanes-1)];
+
+    const __m128 vNX = _mm_set_ps( nor3.nx, nor2.nx, nor1.nx, nor0.nx);
+    const __m128 vNY = _mm_set_ps( nor3.ny, nor2.ny, nor1.ny, nor0.ny);
+    const __m128 vNZ = _mm_set_ps( nor3.nz, nor2.nz, nor1.nz, nor0.nz);
+
+    const __m128 vShade = _mm_add_ps( _mm_add_ps( _mm_mul_ps( vNX, vLightX), _mm_mul_ps( vNY, vLightY)), _mm_mul_ps( vNZ, vLightZ));
+
+    // round away from zero like FloatToInt()
+    const __m128 vRound = _mm_or_ps( _mm_and_ps( vShade, vSignMask), vHalf);
+    _mm_storeu_si128( (__m128i *)aslShades, _mm_cvttps_epi32( _mm_add_ps( vShade, vRound)));
+
+    for( INDEX iLane=0; iLane<ctLanes; iLane++) pswMipCol[iMipVx+iLane] = aslShades[iLane];
+  }
+}
+
+// [Cecil] Unpack current frame with SIMD and reuse frames that have already been unpacked for other models
+SE1_TARGET_SSE2 static void UnpackFrameSSE2( CRenderModel &rm, BOOL bKeepNormals, SWORD *pswMipCol)
+{
+  const BOOL b16Bit = rm.rm_pmdModelData->md_Flags & MF_COMPRESSED_16BIT;
+  const void *pvFrame0 = b16Bit ? (const void *)rm.rm_pFrame16_0 : (const void *)rm.rm_pFrame8_0;
+  const void *pvFrame1 = b16Bit ? (const void *)rm.rm_pFrame16_1 : (const void *)rm.rm_pFrame8_1;
+  FLOAT fRatio = rm.rm_fRatio;
+
+  // lerping by 0 or 1 results in one of the frames
+  if( fRatio==0.0f) pvFrame1 = pvFrame0;
+  else if( fRatio==1.0f) pvFrame0 = pvFrame1;
+  if( pvFrame0==pvFrame1) fRatio = 0.0f;
+
+  const INDEX iFrameNumber = _pGfx->GetFrameNumber();
+  UnpackedFrame_t *puf = NULL;
+
+  if( mdl_bCacheFrames) {
+    for( INDEX i=0; i<MAX_UNPACKED_FRAMES; i++) {
+      UnpackedFrame_t &uf = _aufUnpacked[i];
+      if( uf.uf_iFrameNumber==iFrameNumber && uf.uf_pmmi==rm.rm_pmmiMip
+       && uf.uf_pvFrame0==pvFrame0 && uf.uf_pvFrame1==pvFrame1
+       && uf.uf_fRatio==fRatio && uf.uf_vStretch==rm.rm_vStretch) {
+        puf = &uf;
+        break;
+      }
+    }
+  }
+
+  const GFXNormal3 *pnorUnpacked;
+
+  // reuse the same frame
+  if( puf!=NULL) {
+    _sfStats.IncrementCounter( CStatForm::SCI_MDLFRAMEHITS);
+    memcpy( pvtxMipBase, &puf->uf_avtx[0], _ctAllMipVx*sizeof(GFXVertex3));
+    pnorUnpacked = &puf->uf_anor[0];
+
+  } else {
+    _sfStats.IncrementCounter( CStatForm::SCI_MDLFRAMEMISSES);
+    GFXVertex3 *pvtx = pvtxMipBase;
+    GFXNormal3 *pnor;
+
+    // unpack into the oldest cached frame
+    if( mdl_bCacheFrames) {
+      puf = &_aufUnpacked[_iNextUnpacked];
+      _iNextUnpacked = (_iNextUnpacked+1) % MAX_UNPACKED_FRAMES;
+
+      puf->uf_pmmi = rm.rm_pmmiMip;
+      puf->uf_pvFrame0 = pvFrame0;
+      puf->uf_pvFrame1 = pvFrame1;
+      puf->uf_fRatio = fRatio;
+      puf->uf_vStretch = rm.rm_vStretch;
+      puf->uf_iFrameNumber = iFrameNumber;
+      puf->uf_avtx.PopAll();
+      puf->uf_anor.PopAll();
+      pvtx = puf->uf_avtx.Push(_ctAllMipVx);
+      pnor = puf->uf_anor.Push(_ctAllMipVx);
+
+    } else if( bKeepNormals) {
+      pnor = pnorMipBase;
+
+    } else {
+      _anorUnpacked.PopAll();
+      pnor = _anorUnpacked.Push(_ctAllMipVx);
+    }
+
+    if( b16Bit) {
+      UnpackVerticesSSE2( (const ModelFrameVertex16 *)pvFrame0, (const ModelFrameVertex16 *)pvFrame1, fRatio, rm, pvtx, pnor);
+    } else {
+      UnpackVerticesSSE2( (const ModelFrameVertex8 *)pvFrame0, (const ModelFrameVertex8 *)pvFrame1, fRatio, rm, pvtx, pnor);
+    }
+
+    if( pvtx!=pvtxMipBase) memcpy( pvtxMipBase, pvtx, _ctAllMipVx*sizeof(GFXVertex3));
+    pnorUnpacked = pnor;
+  }
+
+  if( bKeepNormals && pnorUnpacked!=pnorMipBase) {
+    memcpy( pnorMipBase, pnorUnpacked, _ctAllMipVx*sizeof(GFXNormal3));
+  }
+
+  ShadeVerticesSSE2( rm, pnorUnpacked, pswMipCol);
+}
+
+#endif // SE1_MODEL_SSE2
+
 static void UnpackFrame( CRenderModel &rm, BOOL bKeepNormals)
 {
   _pfModelProfile.StartTimer( CModelProfile::PTI_VIEW_INIT_UNPACK);
@@ -1114,6 +1395,12 @@ static void UnpackFrame( CRenderModel &rm, BOOL bKeepNormals)
   const UWORD *puwMipToMdl = (const UWORD*)&rm.rm_pmmiMip->mmpi_auwMipToMdl[0];
         SWORD *pswMipCol   = (SWORD*)&pcolMipBase[_ctAllMipVx>>1];
 
+#if SE1_MODEL_SSE2
+  // [Cecil] unpack with SIMD kernels
+  if( sys_bCPUHasSSE2 && _bUnpackSIMD) {
+    UnpackFrameSSE2( rm, bKeepNormals, pswMipCol);
+  } else
+#endif
   // if 16 bit compression
   if( rm.rm_pmdModelData->md_Flags & MF_COMPRESSED_16BIT)
   {
@@ -1764,7 +2051,7 @@ void CModelObject::RenderModel_View( CRenderModel &rm)
   _eAPI = _pGfx->GetCurrentAPI();
   _pGfx->CheckAPI();
 
-  if( _eAPI==GAT_NONE) return;  // must have API
+  if( !_pGfx->GetInterface()->CanRender()) return;  // must have API (or something that counts calls to it)
 
 #if SE1_TRUFORM
   // adjust Truform usage
@@ -3508,6 +3795,138 @@ void RenderBatchedSimpleShadows_View(void)
 }
 
 
+// [Cecil] Unpack frames of some model many times with and without SIMD and compare the results
+// (only the unpacking stage is measured, so it works without any graphics API)
+void BenchmarkModelUnpack(void *pArgs)
+{
+  const CTString strModel = *NEXTARGUMENT(CTString *);
+  const INDEX ctInstances = Clamp(NEXTARGUMENT(INDEX), (INDEX)1, (INDEX)100000);
+
+#if SE1_MODEL_SSE2
+  if (!sys_bCPUHasSSE2) {
+    CPrintF(TRANS("SSE2 is not supported by this CPU!\n"));
+    return;
+  }
+
+  CModelObject mo;
+
+  try {
+    mo.SetData_t(strModel);
+  } catch (char *strError) {
+    CPrintF(TRANS("Cannot load model: %s\n"), strError);
+    return;
+  }
 
+  CModelData &md = *(CModelData *)mo.GetData();
+  PrepareModelForRendering(md);
 
+  // setup the highest mip with some light from above
+  CRenderModel rm;
+  rm.rm_pmdModelData = &md;
+  rm.rm_iMipLevel = 0;
+  rm.rm_pmmiMip = &md.md_MipInfos[0];
+  rm.rm_vStretch = md.md_Stretch;
+  rm.rm_vOffset = md.md_vCompressedCenter;
+  rm.rm_vLightObj = FLOAT3D(0.3f, -0.9f, 0.3f).Normalize();
 
+  _ctAllMipVx = rm.rm_pmmiMip->mmpi_ctMipVx;
+
+  if (_ctAllMipVx <= 0) {
+    CPrintF(TRANS("Model has no vertices!\n"));
+    return;
+  }
+
+  ResetVertexArrays();
+  _avtxMipBase.Push(_ctAllMipVx);
+  _acolMipBase.Push(_ctAllMipVx);
+  _anorMipBase.Push(_ctAllMipVx);
+  pvtxMipBase = &_avtxMipBase[0];
+  pcolMipBase = &_acolMipBase[0];
+  pnorMipBase = &_anorMipBase[0];
+
+  const BOOL b16Bit = md.md_Flags & MF_COMPRESSED_16BIT;
+  const INDEX ctFrames = Min(md.md_FramesCt, (INDEX)16);
+  const INDEX bOldCache = mdl_bCacheFrames;
+
+  CStaticStackArray<GFXVertex3> avtxReference;
+  CStaticStackArray<GFXNormal3> anorReference;
+  CStaticStackArray<SWORD> aswReference;
+  avtxReference.Push(_ctAllMipVx * ctFrames);
+  anorReference.Push(_ctAllMipVx * ctFrames);
+  aswReference.Push(_ctAllMipVx * ctFrames);
+
+  const SWORD *pswMipCol = (const SWORD *)&pcolMipBase[_ctAllMipVx >> 1];
+  DOUBLE adTime[3] = { 0.0, 0.0, 0.0 };
+  INDEX actMismatches[3] = { 0, 0, 0 };
+
+  // scalar code, SIMD code and SIMD code with reused frames
+  for (INDEX iPass = 0; iPass < 3; iPass++) {
+    _bUnpackSIMD = (iPass > 0);
+    mdl_bCacheFrames = (iPass == 2);
+
+    for (INDEX iFrame = 0; iFrame < ctFrames; iFrame++) {
+      // lerp halfway to the next frame
+      const INDEX iFrame1 = (iFrame + 1) % md.md_FramesCt;
+      rm.rm_iFrame0 = iFrame;
+      rm.rm_iFrame1 = iFrame1;
+      rm.rm_fRatio = 0.5f;
+
+      if (b16Bit) {
+        rm.rm_pFrame16_0 = &md.md_FrameVertices16[iFrame  * md.md_VerticesCt];
+        rm.rm_pFrame16_1 = &md.md_FrameVertices16[iFrame1 * md.md_VerticesCt];
+      } else {
+        rm.rm_pFrame8_0 = &md.md_FrameVertices8[iFrame  * md.md_VerticesCt];
+        rm.rm_pFrame8_1 = &md.md_FrameVertices8[iFrame1 * md.md_VerticesCt];
+      }
+
+      ClearUnpackedFrames();
+      CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+
+      for (INDEX i = 0; i < ctInstances; i++) {
+        UnpackFrame(rm, TRUE);
+      }
+
+      adTime[iPass] += (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+
+      // remember reference results
+      GFXVertex3 *pvtxReference = &avtxReference[_ctAllMipVx * iFrame];
+      GFXNormal3 *pnorReference = &anorReference[_ctAllMipVx * iFrame];
+      SWORD *pswReference = &aswReference[_ctAllMipVx * iFrame];
+
+      if (iPass == 0) {
+        memcpy(pvtxReference, pvtxMipBase, _ctAllMipVx * sizeof(GFXVertex3));
+        memcpy(pnorReference, pnorMipBase, _ctAllMipVx * sizeof(GFXNormal3));
+        memcpy(pswReference, pswMipCol, _ctAllMipVx * sizeof(SWORD));
+        continue;
+      }
+
+      // compare coordinates bit by bit
+      for (INDEX iVtx = 0; iVtx < _ctAllMipVx; iVtx++) {
+        if (memcmp(&pvtxReference[iVtx], &pvtxMipBase[iVtx], sizeof(GFXVertex3)) != 0
+         || memcmp(&pnorReference[iVtx], &pnorMipBase[iVtx], sizeof(GFXNormal3)) != 0
+         || pswReference[iVtx] != pswMipCol[iVtx]) {
+          actMismatches[iPass]++;
+        }
+      }
+    }
+  }
+
+  _bUnpackSIMD = TRUE;
+  mdl_bCacheFrames = bOldCache;
+  ClearUnpackedFrames();
+  ResetVertexArrays();
+
+  const INDEX ctUnpacks = ctInstances * ctFrames;
+
+  CPrintF(TRANS("Unpacked %d frames of '%s' (%d vertices each) %d times:\n"),
+    ctFrames, strModel.ConstData(), _ctAllMipVx, ctInstances);
+  CPrintF(TRANS("  reference:    %.2f ms (%.2f us per frame)\n"), adTime[0] * 1000.0, adTime[0] * 1e6 / ctUnpacks);
+  CPrintF(TRANS("  SSE2:         %.2f ms (%.2f us per frame), mismatching vertices: %d\n"),
+    adTime[1] * 1000.0, adTime[1] * 1e6 / ctUnpacks, actMismatches[1]);
+  CPrintF(TRANS("  SSE2 + cache: %.2f ms (%.2f us per frame), mismatching vertices: %d\n"),
+    adTime[2] * 1000.0, adTime[2] * 1e6 / ctUnpacks, actMismatches[2]);
+
+#else
+  CPrintF(TRANS("SIMD frame unpacking is not available in this build!\n"));
+#endif
+}
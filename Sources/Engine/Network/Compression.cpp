@@ -35,7 +35,7 @@ void CCompressor::UnpackStream_t(CTMemoryStream &strmSrc, CTStream &strmDst) //
   // get the buffer of source stream
   UBYTE *pubSrc = strmSrc.mstrm_pubBuffer + strmSrc.mstrm_slLocation;
   // allocate buffer for decompression
-  UBYTE *pubDst = (UBYTE*)AllocMemory(slSizeDst);
+  UBYTE *pubDst = (UBYTE*)AllocMemoryTagged(slSizeDst, MEM_NETWORK);
   // compress there
   BOOL bOk = Unpack(pubSrc, slSizeSrc, pubDst, slSizeDst);
   // if failed
@@ -58,7 +58,7 @@ void CCompressor::PackStream_t(CTMemoryStream &strmSrc, CTStream &strmDst) // th
   SLONG slSizeSrc = strmSrc.GetStreamSize();
   // allocate buffer for compression
   SLONG slSizeDst = NeededDestinationSize(slSizeSrc);
-  UBYTE *pubDst = (UBYTE*)AllocMemory(slSizeDst);
+  UBYTE *pubDst = (UBYTE*)AllocMemoryTagged(slSizeDst, MEM_NETWORK);
   // compress there
   BOOL bOk = Pack(pubSrc, slSizeSrc, pubDst, slSizeDst);
   // if failed
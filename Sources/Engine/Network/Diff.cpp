@@ -307,11 +307,11 @@ void DIFF_Diff_t(CTStream *pstrmOld, CTStream *pstrmNew, CTStream *pstrmDiff)
     CTimerValue tv0 = _pTimer->GetHighPrecisionTimer();
 
     _slSizeOld = pstrmOld->GetStreamSize()-pstrmOld->GetPos_t();
-    _pubOld = (UBYTE*)AllocMemory(_slSizeOld);
+    _pubOld = (UBYTE*)AllocMemoryTagged(_slSizeOld, MEM_NETWORK);
     pstrmOld->Read_t(_pubOld, _slSizeOld);
 
     _slSizeNew = pstrmNew->GetStreamSize()-pstrmNew->GetPos_t();
-    _pubNew = (UBYTE*)AllocMemory(_slSizeNew);
+    _pubNew = (UBYTE*)AllocMemoryTagged(_slSizeNew, MEM_NETWORK);
     pstrmNew->Read_t(_pubNew, _slSizeNew);
 
     CRC_Start(_ulCRC);
@@ -340,11 +340,11 @@ void DIFF_Undiff_t(CTStream *pstrmOld, CTStream *pstrmDiff, CTStream *pstrmNew)
     CTimerValue tv0 = _pTimer->GetHighPrecisionTimer();
 
     _slSizeOld = pstrmOld->GetStreamSize()-pstrmOld->GetPos_t();
-    _pubOld = (UBYTE*)AllocMemory(_slSizeOld);
+    _pubOld = (UBYTE*)AllocMemoryTagged(_slSizeOld, MEM_NETWORK);
     pstrmOld->Read_t(_pubOld, _slSizeOld);
 
     _slSizeNew = pstrmDiff->GetStreamSize()-pstrmDiff->GetPos_t();
-    _pubNew = (UBYTE*)AllocMemory(_slSizeNew);
+    _pubNew = (UBYTE*)AllocMemoryTagged(_slSizeNew, MEM_NETWORK);
     pstrmDiff->Read_t(_pubNew, _slSizeNew);
 
     _pstrmOut = pstrmNew;
@@ -20,6 +20,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Network/MessageDispatcher.h>
 #include <Engine/Network/Network.h>
 #include <Engine/Network/NetworkProfile.h>
+#include <Engine/Network/Telemetry.h> // [Cecil]
 #include <Engine/Network/NetworkMessage.h>
 #include <Engine/Network/CommunicationInterface.h>
 #include <Engine/Base/ErrorTable.h>
@@ -56,7 +57,7 @@ void CMessageBuffer::Allocate(void)
     ASSERT(mb_pvMessageBuffer == NULL);
     // allocate message buffer
     mb_ulMessageBufferSize = 16000;
-    mb_pvMessageBuffer = AllocMemory(mb_ulMessageBufferSize);
+    mb_pvMessageBuffer = AllocMemoryTagged(mb_ulMessageBufferSize, MEM_NETWORK);
   }
 }
 
@@ -270,6 +271,7 @@ void CMessageDispatcher::SendToClient(INDEX iClient, const CNetworkMessage &nmMe
   _cmiComm.Server_Send_Unreliable(iClient, (void*)nmMessage.nm_pubMessage, nmMessage.nm_slSize);
 	
   UpdateSentMessageStats(nmMessage);
+  IServerTelemetry::CountClientTraffic(iClient, 0, nmMessage.nm_slSize); // [Cecil]
   _pfNetworkProfile.StopTimer(CNetworkProfile::PTI_SENDMESSAGE);
 }
 void CMessageDispatcher::SendToClientReliable(INDEX iClient, const CNetworkMessage &nmMessage)
@@ -279,6 +281,7 @@ void CMessageDispatcher::SendToClientReliable(INDEX iClient, const CNetworkMessa
   // send the message
   _cmiComm.Server_Send_Reliable(iClient, (void*)nmMessage.nm_pubMessage, nmMessage.nm_slSize);
   UpdateSentMessageStats(nmMessage);
+  IServerTelemetry::CountClientTraffic(iClient, 0, nmMessage.nm_slSize); // [Cecil]
   _pfNetworkProfile.StopTimer(CNetworkProfile::PTI_SENDMESSAGE);
 }
 void CMessageDispatcher::SendToClientReliable(INDEX iClient, CTMemoryStream &strmMessage)
@@ -293,6 +296,7 @@ void CMessageDispatcher::SendToClientReliable(INDEX iClient, CTMemoryStream &str
   _cmiComm.Server_Send_Reliable(iClient, pvBuffer, slSize);
   strmMessage.UnlockBuffer();
   UpdateSentStreamStats(slSize);
+  IServerTelemetry::CountClientTraffic(iClient, 0, slSize); // [Cecil]
   _pfNetworkProfile.StopTimer(CNetworkProfile::PTI_SENDMESSAGE);
 }
 
@@ -398,6 +402,7 @@ BOOL CMessageDispatcher::ReceiveFromClient(INDEX iClient, CNetworkMessage &nmMes
     nmMessage.nm_mtType = (MESSAGETYPE)ubType;
 
     UpdateReceivedMessageStats(nmMessage);
+    IServerTelemetry::CountClientTraffic(iClient, nmMessage.nm_slSize, 0); // [Cecil]
   }
   _pfNetworkProfile.StopTimer(CNetworkProfile::PTI_RECEIVEMESSAGE);
   return bReceived;
@@ -421,6 +426,7 @@ BOOL CMessageDispatcher::ReceiveFromClientReliable(INDEX iClient, CNetworkMessag
     nmMessage.nm_mtType = (MESSAGETYPE)ubType;
 
     UpdateReceivedMessageStats(nmMessage);
+    IServerTelemetry::CountClientTraffic(iClient, nmMessage.nm_slSize, 0); // [Cecil]
   }
 //  _pfNetworkProfile.StopTimer(CNetworkProfile::PTI_RECEIVEMESSAGE);
   return bReceived;
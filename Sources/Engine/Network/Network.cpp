@@ -40,6 +40,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include <Engine/Rendering/RenderProfile.h>
 #include <Engine/Network/NetworkProfile.h>
+#include <Engine/Network/Telemetry.h> // [Cecil]
 #include <Engine/Network/LevelChange.h>
 #include <Engine/Brushes/BrushArchive.h>
 #include <Engine/Entities/Entity.h>
@@ -228,6 +229,23 @@ INDEX inp_iMouseMovePressThreshold = 5;
 extern void RendererInfo(void);
 extern void ClearRenderer(void);
 
+// [Cecil] Ray casting through polygon trees
+extern INDEX wld_bRayCastTrees;
+extern void BenchmarkRayCasts(INDEX ctRays);
+extern void BenchmarkCRC(INDEX ctKilobytes);
+extern INDEX wld_bEntityCache;
+extern void BenchmarkEntityRange(INDEX ctQueries);
+extern void BenchmarkSkinning(void *pArgs);
+extern void BenchmarkShadowMixing(void *pArgs); // [Cecil]
+extern void CheckShadowPacking(void); // [Cecil]
+extern void BenchmarkTerrainRegen(INDEX ctFrames); // [Cecil]
+extern void BenchmarkModelUnpack(void *pArgs); // [Cecil]
+extern void BenchmarkRenderView(void *pArgs); // [Cecil]
+extern void DumpProfileTimeline(INDEX ctFrames); // [Cecil]
+extern void ListEntityClassTimes(INDEX ctTop); // [Cecil]
+extern void ResetEntityClassTimes(void); // [Cecil]
+extern void MemoryInfo(void); // [Cecil]
+
 
 // cache all shadowmaps now
 extern void CacheShadows(void)
@@ -245,6 +263,49 @@ extern void CacheShadows(void)
   _bNeedPretouch = TRUE;
 }
 
+// [Cecil] Calculate potentially visible sets of sectors in the current world
+static void CalculatePVS(void)
+{
+  CWorld *pwo = _pwoCurrentWorld;
+
+  if (pwo==NULL) {
+    CPrintF(TRANS("No world is loaded\n"));
+    return;
+  }
+
+  CBrushArchive &ba = pwo->wo_baBrushes;
+
+  // sets are made from portal-sector links
+  if (!pwo->wo_bPortalLinksUpToDate) {
+    CSetFPUPrecision FPUPrecision(FPT_53BIT);
+    ba.LinkPortalsAndSectors();
+    pwo->wo_bPortalLinksUpToDate = TRUE;
+  }
+
+  CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+  ba.CalculatePVS();
+  CTimerValue tvStop = _pTimer->GetHighPrecisionTimer();
+
+  if (!ba.HasPVS()) {
+    CPrintF(TRANS("There are no static zoning sectors\n"));
+    return;
+  }
+
+  // count all potentially visible sectors
+  const INDEX ctSectors = ba.ba_aiPVSRows.Count();
+  const INDEX ctRows = ba.ba_aulPVS.Count() / ba.ba_ctPVSRowLength;
+  INDEX ctVisible = 0;
+
+  for (INDEX iBit = 0; iBit < ctRows * ba.ba_ctPVSRowLength * 32; iBit++) {
+    if (ba.ba_aulPVS[iBit >> 5] & (1UL << (iBit & 31))) ctVisible++;
+  }
+
+  CPrintF(TRANS("Potentially visible sets of %d/%d sectors calculated in %.2fs\n"),
+    ctRows, ctSectors, (tvStop - tvStart).GetSeconds());
+  CPrintF(TRANS("Each set has %.1f sectors on average; save the world to keep them\n"),
+    FLOAT(ctVisible) / FLOAT(ctRows));
+}
+
 // check if a name or IP matches a mask
 extern BOOL MatchesBanMask(const CTString &strString, const CTString &strMask)
 {
@@ -763,6 +824,24 @@ void CNetworkLibrary::Init(void)
   _pShell->DeclareSymbol("user void RendererInfo(void);", &RendererInfo);
   _pShell->DeclareSymbol("user void ClearRenderer(void);",   &ClearRenderer);
   _pShell->DeclareSymbol("user void CacheShadows(void);",    &CacheShadows);
+  _pShell->DeclareSymbol("user void CalculatePVS(void);", &CalculatePVS); // [Cecil]
+  _pShell->DeclareSymbol("user INDEX wld_bRayCastTrees;", &wld_bRayCastTrees); // [Cecil]
+  _pShell->DeclareSymbol("user void BenchmarkRayCasts(INDEX);", &BenchmarkRayCasts); // [Cecil]
+  _pShell->DeclareSymbol("user void BenchmarkCRC(INDEX);", &BenchmarkCRC); // [Cecil]
+  _pShell->DeclareSymbol("user INDEX wld_bEntityCache;", &wld_bEntityCache); // [Cecil]
+  _pShell->DeclareSymbol("user void BenchmarkEntityRange(INDEX);", &BenchmarkEntityRange); // [Cecil]
+  _pShell->DeclareSymbol("user void BenchmarkSkinning(CTString, INDEX);", &BenchmarkSkinning); // [Cecil]
+  _pShell->DeclareSymbol("user void BenchmarkShadowMixing(INDEX);", &BenchmarkShadowMixing); // [Cecil]
+  _pShell->DeclareSymbol("user void CheckShadowPacking(void);", &CheckShadowPacking); // [Cecil]
+  _pShell->DeclareSymbol("user void BenchmarkTerrainRegen(INDEX);", &BenchmarkTerrainRegen); // [Cecil]
+  _pShell->DeclareSymbol("user void BenchmarkModelUnpack(CTString, INDEX);", &BenchmarkModelUnpack); // [Cecil]
+  _pShell->DeclareSymbol("user void BenchmarkRenderView(CTString, INDEX);", &BenchmarkRenderView); // [Cecil]
+  _pShell->DeclareSymbol("user INDEX prf_bTimeline;", &prf_bTimeline); // [Cecil]
+  _pShell->DeclareSymbol("user void DumpProfileTimeline(INDEX);", &DumpProfileTimeline); // [Cecil]
+  _pShell->DeclareSymbol("user INDEX ent_bProfileClasses;", &ent_bProfileClasses); // [Cecil]
+  _pShell->DeclareSymbol("user void ListEntityClassTimes(INDEX);", &ListEntityClassTimes); // [Cecil]
+  _pShell->DeclareSymbol("user void ResetEntityClassTimes(void);", &ResetEntityClassTimes); // [Cecil]
+  _pShell->DeclareSymbol("user void MemoryInfo(void);", &MemoryInfo); // [Cecil]
   _pShell->DeclareSymbol("user void KickClient(INDEX, CTString);", &KickClientCfunc);
   _pShell->DeclareSymbol("user void KickByName(CTString, CTString);", &KickByNameCfunc);
   _pShell->DeclareSymbol("user void ListPlayers(void);", &ListPlayers);
@@ -845,6 +924,13 @@ void CNetworkLibrary::Init(void)
   _pShell->DeclareSymbol("persistent user INDEX ser_bInverseBanning;", &ser_bInverseBanning);
   _pShell->DeclareSymbol("persistent user CTString ser_strMOTD;", &ser_strMOTD);
 
+  // [Cecil] Server telemetry log
+  extern INDEX ser_iTelemetryFileSize;
+  extern INDEX ser_iTelemetryFiles;
+  _pShell->DeclareSymbol("persistent user INDEX ser_iTelemetry;", &ser_iTelemetry);
+  _pShell->DeclareSymbol("persistent user INDEX ser_iTelemetryFileSize;", &ser_iTelemetryFileSize);
+  _pShell->DeclareSymbol("persistent user INDEX ser_iTelemetryFiles;", &ser_iTelemetryFiles);
+
   _pShell->DeclareSymbol("persistent user INDEX cli_bAutoAdjustSettings;",   &cli_bAutoAdjustSettings);
   _pShell->DeclareSymbol("persistent user FLOAT cli_tmAutoAdjustThreshold;", &cli_tmAutoAdjustThreshold);
   _pShell->DeclareSymbol("persistent user INDEX cli_bPrediction;",           &cli_bPrediction);
@@ -1834,6 +1920,11 @@ static void SendAdminResponse(ULONG ulAdr, UWORD uwPort, ULONG ulCode, const CTS
  */
 void CNetworkLibrary::MainLoop(void)
 {
+  // [Cecil] Each call starts a new frame on the profiling timeline
+  IProfileTimeline::MarkFrame();
+  MarkMemoryFrame(); // [Cecil] Count allocations per frame
+  PRF_ZONE("MainLoop");
+
   // synchronize access to network
   CTSingleLock slNetwork(&ga_csNetwork, TRUE);
 
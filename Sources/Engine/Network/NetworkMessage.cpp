@@ -61,7 +61,7 @@ CNetworkMessage::CNetworkMessage(void)
 {
   // allocate message buffer
   nm_slMaxSize = MAX_NETWORKMESSAGE_SIZE;
-  nm_pubMessage = (UBYTE*) AllocMemory(nm_slMaxSize);
+  nm_pubMessage = (UBYTE*) AllocMemoryTagged(nm_slMaxSize, MEM_NETWORK);
 
   // mangle pointer and size so that it could not be accidentally read/written
   nm_pubPointer = NULL;
@@ -89,7 +89,7 @@ CNetworkMessage::CNetworkMessage(MESSAGETYPE mtType)
 {
   // allocate message buffer
   nm_slMaxSize = MAX_NETWORKMESSAGE_SIZE;
-  nm_pubMessage = (UBYTE*) AllocMemory(nm_slMaxSize);
+  nm_pubMessage = (UBYTE*) AllocMemoryTagged(nm_slMaxSize, MEM_NETWORK);
 
   // init read/write pointer and size
   nm_pubPointer = nm_pubMessage;
@@ -107,7 +107,7 @@ CNetworkMessage::CNetworkMessage(const CNetworkMessage &nmOriginal)
 {
   // allocate message buffer
   nm_slMaxSize = nmOriginal.nm_slMaxSize;
-  nm_pubMessage = (UBYTE*) AllocMemory(nm_slMaxSize);
+  nm_pubMessage = (UBYTE*) AllocMemoryTagged(nm_slMaxSize, MEM_NETWORK);
 
   // init read/write pointer and size
   nm_pubPointer = nm_pubMessage + (nmOriginal.nm_pubPointer-nmOriginal.nm_pubMessage);
@@ -130,7 +130,7 @@ void CNetworkMessage::operator=(const CNetworkMessage &nmOriginal)
 
     // allocate message buffer
     nm_slMaxSize = nmOriginal.nm_slMaxSize;
-    nm_pubMessage = (UBYTE*) AllocMemory(nm_slMaxSize);
+    nm_pubMessage = (UBYTE*) AllocMemoryTagged(nm_slMaxSize, MEM_NETWORK);
   }
 
   // init read/write pointer and size
@@ -22,6 +22,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Network/PlayerBuffer.h>
 #include <Engine/Network/PlayerTarget.h>
 #include <Engine/Network/NetworkProfile.h>
+#include <Engine/Network/Telemetry.h> // [Cecil]
 #include <Engine/Network/ClientInterface.h>
 #include <Engine/Network/CommunicationInterface.h>
 #include <Engine/Network/Compression.h>
@@ -206,6 +207,9 @@ CServer::~CServer()
  */
 void CServer::Stop(void)
 {
+  // [Cecil] Finish the telemetry log
+  IServerTelemetry::Close();
+
   // [Cecil] Stop master server if needed
   if (ser_bEnumeration) {
     IMasterServer::OnServerEnd();
@@ -413,6 +417,7 @@ void CServer::SendGameStreamBlocks(INDEX iClient)
   // repeat for max 100 sequences
   INDEX iBlocksOk = 0;
   INDEX iMaxSent = -1;
+  SLONG slRawSize = 0; // [Cecil] Size of blocks in the last valid pack
   for(INDEX i=0; i<100; i++) {
     if (iStep<0 && iBlocksOk>=3) {
 //      break;
@@ -471,6 +476,7 @@ void CServer::SendGameStreamBlocks(INDEX iClient)
     // use new pack
 //    CPrintF("added ");
     nmPackedBlocks = nmPackedBlocksNew;
+    slRawSize = nmGameStreamBlocks.nm_slSize;
     iMaxSent = Max(iMaxSent, iSequence);
     iSequence+= iStep;
     iBlocksOk++;
@@ -494,6 +500,7 @@ void CServer::SendGameStreamBlocks(INDEX iClient)
   // send the message to the client
 //  CPrintF("sent: %d=%dB\n", iBlocksOk, nmPackedBlocks.nm_slSize);
   _pNetwork->SendToClient(iClient, nmPackedBlocks);
+  IServerTelemetry::CountGameStream(slRawSize, nmPackedBlocks.nm_slSize); // [Cecil]
   sso.sso_iLastSentSequence = Max(sso.sso_iLastSentSequence, iMaxSent);
   sso.sso_tvLastMessageSent = _pTimer->GetHighPrecisionTimer();
 
@@ -539,6 +546,7 @@ void CServer::ResendGameStreamBlocks(INDEX iClient, INDEX iSequence0, INDEX ctSe
   // create a package message
   CNetworkMessage nmGameStreamBlocks(MSG_GAMESTREAMBLOCKS);
   CNetworkMessage nmPackedBlocks(MSG_GAMESTREAMBLOCKS);
+  SLONG slRawSize = 0; // [Cecil] Size of blocks in the last valid pack
 
   // for each sequence
   INDEX iSequence = iSequence0;
@@ -564,11 +572,16 @@ void CServer::ResendGameStreamBlocks(INDEX iClient, INDEX iSequence0, INDEX ctSe
     }
     // use new pack
     nmPackedBlocks = nmPackedBlocksNew;
+    slRawSize = nmGameStreamBlocks.nm_slSize;
   }
 
   // send the last batch of valid size
   _pfNetworkProfile.IncrementCounter(CNetworkProfile::PCI_GAMESTREAMRESENDS);
   _pNetwork->SendToClient(iClient, nmPackedBlocks);
+
+  // [Cecil] Count the resent batch
+  IServerTelemetry::CountResend();
+  IServerTelemetry::CountGameStream(slRawSize, nmPackedBlocks.nm_slSize);
   extern INDEX net_bReportMiscErrors;
   if (net_bReportMiscErrors) {
     CPrintF(TRANS(" sent %d-%d(%d - %db)\n"), 
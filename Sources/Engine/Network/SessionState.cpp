@@ -30,6 +30,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Math/Float.h>
 #include <Engine/Network/PlayerTarget.h>
 #include <Engine/Network/NetworkProfile.h>
+#include <Engine/Network/Telemetry.h> // [Cecil]
 #include <Engine/World/PhysicsProfile.h>
 #include <Engine/Network/CommunicationInterface.h>
 #include <Engine/Network/Compression.h>
@@ -610,6 +611,7 @@ void CSessionState::HandleMovers(void)
   // for each active mover
   {FORDELETELIST(CMovableEntity, en_lnInMovers, lhActiveMovers, itenMover) {
     // let it calculate its wanted parameters for this tick
+    CEntityClassTimer ect(itenMover, ECW_PREMOVING); // [Cecil]
     itenMover->PreMoving();
   }}
 
@@ -642,7 +644,10 @@ void CSessionState::HandleMovers(void)
 */
 
     // let it do its own physics
-    penMoving->DoMoving();
+    {
+      CEntityClassTimer ect(penMoving, ECW_DOMOVING); // [Cecil]
+      penMoving->DoMoving();
+    }
 //    CPrintF("\n");
 
     // if any mover is re-added, put it to the end of active list
@@ -657,6 +662,7 @@ void CSessionState::HandleMovers(void)
       continue;
     }
     // let it calculate its parameters after all movement has been resolved
+    CEntityClassTimer ect(itenMover, ECW_POSTMOVING); // [Cecil]
     itenMover->PostMoving();
   }}
 
@@ -696,26 +702,10 @@ void CSessionState::HandleTimers(TICK tckCurrentTick)
 
   _pfPhysicsProfile.StartTimer(CPhysicsProfile::PTI_HANDLETIMERS);
   // repeat
-  CListHead &lhTimers = _pNetwork->ga_pWorld->wo_lhTimers;
+  CWorld &wo = *_pNetwork->ga_pWorld;
   FOREVER {
-    // no entity found initially
-    CRationalEntity *penTimer = NULL;
-    // for each entity in list of timers
-    FOREACHINLIST(CRationalEntity, en_lnInTimers, lhTimers, iten) {
-      // if due after current time
-      if(iten->en_tckTimer > tckCurrentTick) {
-        // stop searching
-        break;
-      }
-      // if now predicting and it is not a predictor
-      if (ses_bPredicting && !iten->IsPredictor()) {
-        // skip it
-        continue;
-      }
-      // remember found entity, and stop searching
-      penTimer = iten;
-      break;
-    }
+    // [Cecil] Get the first due timer (skip non-predictors if now predicting)
+    CRationalEntity *penTimer = wo.GetDueTimer(tckCurrentTick, ses_bPredicting);
 
     // if no entity is found
     if (penTimer==NULL) {
@@ -730,7 +720,7 @@ void CSessionState::HandleTimers(TICK tckCurrentTick)
 
     // remove the timer from the list
     penTimer->en_tckTimer = THINKTIME_NEVER;
-    penTimer->en_lnInTimers.Remove();
+    wo.RemoveTimer(penTimer);
     // send timer event to the entity
     penTimer->SendEvent(ETimer());
   }
@@ -901,8 +891,18 @@ void ClearDumpStream(void)
 extern INDEX cli_bEmulateDesync;
 void CSessionState::ProcessGameTick(CNetworkMessage &nmMessage, TICK tckCurrentTick)
 {
+  PRF_ZONE("GameTick"); // [Cecil]
+  CMemoryTagScope mtsEntities(MEM_ENTITIES); // [Cecil] Count memory allocated by entity logic
   ses_tckLastPredictionProcessed = -1;
 
+  // [Cecil] Measure the tick for the telemetry log
+  const BOOL bTelemetry = _pNetwork->IsServer() && IServerTelemetry::IsEnabled();
+  CTimerValue tvTickStart;
+
+  if (bTelemetry) {
+    tvTickStart = _pTimer->GetHighPrecisionTimer();
+  }
+
   _pfPhysicsProfile.StartTimer(CPhysicsProfile::PTI_PROCESSGAMETICK);
 
 #if DEBUG_SYNCSTREAMDUMPING
@@ -961,6 +961,10 @@ void CSessionState::ProcessGameTick(CNetworkMessage &nmMessage, TICK tckCurrentT
 
   // do thinking
   HandleTimers(tckCurrentTick);
+
+  // [Cecil] Count movers before they get processed
+  const INDEX ctMovers = (bTelemetry ? _pNetwork->ga_pWorld->wo_lhMovers.Count() : 0);
+
   // do physics
   HandleMovers();
 
@@ -1008,6 +1012,13 @@ void CSessionState::ProcessGameTick(CNetworkMessage &nmMessage, TICK tckCurrentT
 
   _pfPhysicsProfile.StopTimer(CPhysicsProfile::PTI_PROCESSGAMETICK);
 
+  // [Cecil] Record the processed tick
+  if (bTelemetry) {
+    CTimerValue tvTickEnd = _pTimer->GetHighPrecisionTimer();
+    IServerTelemetry::WriteTick(tckCurrentTick, (tvTickEnd - tvTickStart).GetSeconds(),
+      _pNetwork->ga_pWorld->wo_cenEntities.Count(), ctMovers);
+  }
+
   // assure that FPU precision was low all the rendering time
   ASSERT( GetFPUPrecision()==FPT_24BIT);
 
@@ -1023,6 +1034,7 @@ void CSessionState::ProcessGameTick(CNetworkMessage &nmMessage, TICK tckCurrentT
 /* Process a predicted game tick. */
 void CSessionState::ProcessPredictedGameTick(INDEX iPredictionStep, FLOAT fFactor, TICK tckCurrentTick)
 {
+  CMemoryTagScope mtsEntities(MEM_ENTITIES); // [Cecil] Count memory allocated by entity logic
   _pfPhysicsProfile.StartTimer(CPhysicsProfile::PTI_PROCESSGAMETICK);
 
   //CPrintF("predicted: %" SDL_PRIs64 "\n", tckCurrentTick);
@@ -1654,13 +1666,13 @@ void CSessionState::ReadWorldAndState_t(CTStream *pstr)   // throw char *
   // read world situation
   _pNetwork->ga_pWorld->ReadState_t(pstr);
 
-  // create an empty list for relinking timers
-  CListHead lhNewTimers;
+  // [Cecil] Create an empty array for reordering timers
+  CStaticStackArray<CRationalEntity *> apenNewTimers;
   // read number of entities in timer list
   pstr->ExpectID_t("TMRS");   // timers
   INDEX ctTimers;
   *pstr>>ctTimers;
-//  ASSERT(ctTimers == _pNetwork->ga_pWorld->wo_lhTimers.Count());
+//  ASSERT(ctTimers == _pNetwork->ga_pWorld->wo_apenTimers.Count());
   // for each entity in the timer list
   {for(INDEX ienTimer=0; ienTimer<ctTimers; ienTimer++) {
     // read its index in container of all entities
@@ -1668,15 +1680,13 @@ void CSessionState::ReadWorldAndState_t(CTStream *pstr)   // throw char *
     *pstr>>ien;
     // get the entity
     CRationalEntity *pen = (CRationalEntity*)_pNetwork->ga_pWorld->EntityFromID(ien);
-    // remove it from the timer list and add it at the end of the new timer list
-    if (pen->en_lnInTimers.IsLinked()) {
-      pen->en_lnInTimers.Remove();
-      lhNewTimers.AddTail(pen->en_lnInTimers);
-    }
+    // add it at the end of the new timer order
+    apenNewTimers.Push() = pen;
   }}
-  // use the new timer list instead the old one
-  ASSERT(_pNetwork->ga_pWorld->wo_lhTimers.IsEmpty());
-  _pNetwork->ga_pWorld->wo_lhTimers.MoveList(lhNewTimers);
+  // [Cecil] Use the new timer order instead of the old one
+  if (ctTimers > 0) {
+    _pNetwork->ga_pWorld->PrioritizeTimers(&apenNewTimers[0], ctTimers);
+  }
 
   // create an empty list for relinking movers
   CListHead lhNewMovers;
@@ -1784,12 +1794,14 @@ void CSessionState::WriteWorldAndState_t(CTStream *pstr)   // throw char *
 
   // write number of entities in timer list
   pstr->WriteID_t("TMRS");   // timers
-  CListHead &lhTimers = _pNetwork->ga_pWorld->wo_lhTimers;
-  *pstr<<lhTimers.Count();
+  // [Cecil] Get timers in order of handling
+  CStaticStackArray<CRationalEntity *> apenTimers;
+  _pNetwork->ga_pWorld->GetTimersInOrder(apenTimers);
+  *pstr<<apenTimers.Count();
   // for each entity in the timer list
-  {FOREACHINLIST(CRationalEntity, en_lnInTimers, lhTimers, iten) {
+  {for (INDEX iTimer = 0; iTimer < apenTimers.Count(); iTimer++) {
     // save its index in container
-    *pstr<<iten->en_ulID;
+    *pstr<<apenTimers[iTimer]->en_ulID;
   }}
 
   // write number of entities in mover list
@@ -0,0 +1,222 @@
+/* Copyright (c) 2026 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "StdH.h"
+
+#include <Engine/Network/Telemetry.h>
+#include <Engine/Network/CommunicationInterface.h>
+#include <Engine/Entities/EntityClass.h>
+#include <Engine/Base/Console.h>
+#include <Engine/Base/GameDir.h>
+#include <Engine/Base/Stream.h>
+#include <Engine/OS/FileSystem.h>
+
+#include <time.h>
+
+// Telemetry log format (0 - disabled; 1 - CSV; 2 - JSON lines)
+INDEX ser_iTelemetry = 0;
+
+// Size of one log file in kilobytes before it gets rotated (0 - never rotate)
+INDEX ser_iTelemetryFileSize = 4096;
+
+// Amount of rotated log files to keep
+INDEX ser_iTelemetryFiles = 4;
+
+// Log file that's currently being written into
+static FILE *_fTelemetry = NULL;
+static INDEX _iTelemetryFormat = 0;
+
+// Counters since the last record
+static SLONG _aslReceived[SERVER_CLIENTS] = { 0 };
+static SLONG _aslSent[SERVER_CLIENTS] = { 0 };
+static SLONG _slStreamRaw = 0;
+static SLONG _slStreamPacked = 0;
+static INDEX _ctResends = 0;
+
+// Get full path to a log file of some format (0 - current one; 1+ - rotated ones)
+static CTString LogFile(INDEX iFormat, INDEX iRotated) {
+  CTString strFile = "Telemetry";
+
+  if (iRotated > 0) {
+    strFile.PrintF("Telemetry.%d", iRotated);
+  }
+
+  strFile += (iFormat == 1 ? ".csv" : ".jsonl");
+
+  CTString strPath = ExpandPath::ToUser("Telemetry\\" + strFile);
+
+#if !SE1_WIN
+  strPath.ReplaceChar('\\', '/'); // For remove() and rename()
+#endif
+
+  return strPath;
+};
+
+// Shift all rotated files by one and make room for a new log file
+static void RotateFiles(INDEX iFormat) {
+  const INDEX ctRotated = ClampDn(ser_iTelemetryFiles, (INDEX)0);
+
+  // Oldest file (or the current one, if there are no rotated files) is discarded
+  remove(LogFile(iFormat, ctRotated).ConstData());
+
+  for (INDEX i = ctRotated; i > 0; i--) {
+    rename(LogFile(iFormat, i - 1).ConstData(), LogFile(iFormat, i).ConstData());
+  }
+};
+
+// Get log format from the current setting
+static inline INDEX LogFormat(void) {
+  return Clamp(ser_iTelemetry, (INDEX)1, (INDEX)2);
+};
+
+// Open log file of the current format for appending records
+static BOOL OpenLog(void) {
+  const INDEX iFormat = LogFormat();
+  const CTString strFile = LogFile(iFormat, 0);
+
+  CreateAllDirectories(strFile);
+  _fTelemetry = FileSystem::Open(strFile, "at");
+
+  if (_fTelemetry == NULL) {
+    CPrintF(TRANS("Cannot open telemetry log '%s' for writing: %s\n"), strFile.ConstData(), strerror(errno));
+
+    // Don't try again on each tick
+    ser_iTelemetry = 0;
+    return FALSE;
+  }
+
+  _iTelemetryFormat = iFormat;
+
+  // Begin new CSV files with a header
+  fseek(_fTelemetry, 0, SEEK_END);
+
+  if (iFormat == 1 && ftell(_fTelemetry) == 0) {
+    fprintf(_fTelemetry, "timestamp,tick,tick_ms,entities,movers,resends,stream_raw,stream_packed,compression,slowest_class,slowest_ms,clients\n");
+  }
+
+  return TRUE;
+};
+
+namespace IServerTelemetry {
+
+void CountClientTraffic(INDEX iClient, SLONG slReceived, SLONG slSent) {
+  if (!IsEnabled() || iClient < 0 || iClient >= SERVER_CLIENTS) return;
+
+  _aslReceived[iClient] += slReceived;
+  _aslSent[iClient] += slSent;
+};
+
+void CountGameStream(SLONG slRaw, SLONG slPacked) {
+  if (!IsEnabled()) return;
+
+  _slStreamRaw += slRaw;
+  _slStreamPacked += slPacked;
+};
+
+void CountResend(void) {
+  if (!IsEnabled()) return;
+
+  _ctResends++;
+};
+
+void WriteTick(TICK tckTick, DOUBLE dTickTime, INDEX ctEntities, INDEX ctMovers) {
+  // Reopen the log if the format has been changed
+  if (_fTelemetry != NULL && _iTelemetryFormat != LogFormat()) {
+    Close();
+  }
+
+  if (_fTelemetry == NULL && !OpenLog()) return;
+
+  const SQUAD llTimestamp = (SQUAD)time(NULL);
+  const DOUBLE dTickMs = dTickTime * 1000.0;
+
+  // Packed size relative to the original size
+  const DOUBLE dCompression = (_slStreamRaw > 0 ? (DOUBLE)_slStreamPacked / (DOUBLE)_slStreamRaw : 1.0);
+
+  // Slowest entity class can only be determined while classes are being measured
+  const char *strSlowest = "";
+  DOUBLE dSlowestMs = 0.0;
+
+  if (ent_bProfileClasses) {
+    SQUAD llSlowest;
+    CEntityClass *pecSlowest = TakeSlowestEntityClass(llSlowest);
+
+    if (pecSlowest != NULL && pecSlowest->ec_pdecDLLClass != NULL) {
+      strSlowest = pecSlowest->ec_pdecDLLClass->dec_strName;
+      dSlowestMs = llSlowest * 1000.0 / (DOUBLE)_llTimerValueSecondLen;
+    }
+  }
+
+  if (_iTelemetryFormat == 1) {
+    fprintf(_fTelemetry, "%" SDL_PRIs64 ",%" SDL_PRIs64 ",%.3f,%d,%d,%d,%d,%d,%.3f,%s,%.3f,",
+      llTimestamp, tckTick, dTickMs, ctEntities, ctMovers, _ctResends, (INDEX)_slStreamRaw, (INDEX)_slStreamPacked, dCompression,
+      strSlowest, dSlowestMs);
+
+  } else {
+    fprintf(_fTelemetry, "{\"timestamp\":%" SDL_PRIs64 ",\"tick\":%" SDL_PRIs64 ",\"tick_ms\":%.3f,\"entities\":%d,\"movers\":%d,"
+      "\"resends\":%d,\"stream_raw\":%d,\"stream_packed\":%d,\"compression\":%.3f,\"slowest_class\":\"%s\",\"slowest_ms\":%.3f,\"clients\":[",
+      llTimestamp, tckTick, dTickMs, ctEntities, ctMovers, _ctResends, (INDEX)_slStreamRaw, (INDEX)_slStreamPacked, dCompression,
+      strSlowest, dSlowestMs);
+  }
+
+  // Traffic of each connected client
+  BOOL bFirst = TRUE;
+
+  for (INDEX iClient = 0; iClient < SERVER_CLIENTS; iClient++) {
+    if (!_cmiComm.Server_IsClientUsed(iClient)) continue;
+
+    const INDEX iReceived = _aslReceived[iClient];
+    const INDEX iSent = _aslSent[iClient];
+
+    // CSV field with space-separated "client:in/out" pairs
+    if (_iTelemetryFormat == 1) {
+      fprintf(_fTelemetry, (bFirst ? "%d:%d/%d" : " %d:%d/%d"), iClient, iReceived, iSent);
+
+    } else {
+      fprintf(_fTelemetry, (bFirst ? "{\"id\":%d,\"in\":%d,\"out\":%d}" : ",{\"id\":%d,\"in\":%d,\"out\":%d}"),
+        iClient, iReceived, iSent);
+    }
+
+    bFirst = FALSE;
+  }
+
+  fprintf(_fTelemetry, (_iTelemetryFormat == 1 ? "\n" : "]}\n"));
+  fflush(_fTelemetry);
+
+  // Start counting for the next tick
+  memset(_aslReceived, 0, sizeof(_aslReceived));
+  memset(_aslSent, 0, sizeof(_aslSent));
+  _slStreamRaw = 0;
+  _slStreamPacked = 0;
+  _ctResends = 0;
+
+  // Rotate the log if it's too big
+  if (ser_iTelemetryFileSize > 0 && ftell(_fTelemetry) >= ser_iTelemetryFileSize * 1024) {
+    const INDEX iFormat = _iTelemetryFormat;
+    Close();
+    RotateFiles(iFormat);
+  }
+};
+
+void Close(void) {
+  if (_fTelemetry != NULL) {
+    fclose(_fTelemetry);
+    _fTelemetry = NULL;
+  }
+
+  _iTelemetryFormat = 0;
+};
+
+}; // namespace
@@ -0,0 +1,52 @@
+/* Copyright (c) 2026 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef SE_INCL_TELEMETRY_H
+#define SE_INCL_TELEMETRY_H
+
+#ifdef PRAGMA_ONCE
+  #pragma once
+#endif
+
+// Telemetry log format (0 - disabled; 1 - CSV; 2 - JSON lines)
+ENGINE_API extern INDEX ser_iTelemetry;
+
+// Rotating log of server load that's written after each processed game tick
+// Traffic and stream counters are accumulated between ticks and reset after each record
+namespace IServerTelemetry {
+
+// Check if the telemetry is being recorded
+inline BOOL IsEnabled(void) {
+  return ser_iTelemetry > 0;
+};
+
+// Count bytes received from and sent to some client
+void CountClientTraffic(INDEX iClient, SLONG slReceived, SLONG slSent);
+
+// Count game stream blocks before and after packing them for a client
+void CountGameStream(SLONG slRaw, SLONG slPacked);
+
+// Count one resent batch of game stream blocks
+void CountResend(void);
+
+// Write a record about a processed game tick
+void WriteTick(TICK tckTick, DOUBLE dTickTime, INDEX ctEntities, INDEX ctMovers);
+
+// Close the current log file
+void Close(void);
+
+}; // namespace
+
+#endif // include-once check
@@ -40,6 +40,15 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 // Formatting function attribute (NOTE: add 1 to argument numbers if using this on class methods to skip 'this' argument)
 #define SE1_FORMAT_FUNC(_FormatArg, _VariadicArgs) __attribute__((format(printf, _FormatArg, _VariadicArgs)))
 
+// Functions with intrinsics of other instruction sets (GCC and Clang only compile them within functions that target them)
+#if defined(__GNUC__)
+  #define SE1_TARGET_SSE2 __attribute__((target("sse2")))
+  #define SE1_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+  #define SE1_TARGET_SSE2
+  #define SE1_TARGET_AVX2
+#endif
+
 // Windows-specific
 #if SE1_WIN
 
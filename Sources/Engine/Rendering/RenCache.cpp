@@ -42,6 +42,8 @@ static FLOAT fooFarRatioI,  fooFarRatioJ;
 
 static CRenderer *_preThis;
 
+extern INDEX wld_bCachePolygonSetup; // [Cecil]
+
 // check if a sector is inside view frustum
 __forceinline INDEX CRenderer::IsSectorVisible(CBrush3D &br, CBrushSector &bsc)
 {
@@ -509,11 +511,120 @@ void CRenderer::AddScreenEdges(void)
   _pfRenderProfile.StopTimer(CRenderProfile::PTI_ADDSCREENEDGES);
 }
 
+// [Cecil] Get cached setup of a brush polygon in the world (NULL if it can't be cached)
+static PolygonSetup_t *GetPolygonSetup(CWorld *pwo, CBrushPolygon &bpo)
+{
+  if (!wld_bCachePolygonSetup) return NULL;
+
+  // start over for another world or after its brushes have been changed
+  CBrushArchive &ba = pwo->wo_baBrushes;
+  const INDEX ctPolygons = ba.ba_apbpo.Count();
+
+  if (_pwoPolygonSetups!=pwo || _aiPolygonSetups.Count()!=ctPolygons) {
+    ClearPolygonSetups();
+    _pwoPolygonSetups = pwo;
+
+    if (ctPolygons>0) {
+      _aiPolygonSetups.New(ctPolygons);
+      memset(&_aiPolygonSetups[0], 0xFF, ctPolygons*sizeof(INDEX));
+    }
+  }
+
+  // polygon isn't indexed in the world (e.g. while it's being edited)
+  const INDEX ibpo = bpo.bpo_iInWorld;
+  if (ibpo<0 || ibpo>=ctPolygons || ba.ba_apbpo[ibpo]!=&bpo) return NULL;
+
+  INDEX &iSetup = _aiPolygonSetups[ibpo];
+
+  if (iSetup<0) {
+    iSetup = _apsPolygonSetups.Count();
+    PolygonSetup_t &ps = _apsPolygonSetups.Push();
+
+    // nothing has been set up yet
+    memset(&ps, 0, sizeof(ps));
+    ps.ps_pbpo = &bpo;
+  }
+
+  PolygonSetup_t &ps = _apsPolygonSetups[iSetup];
+
+  // polygons have been recreated with the same count, so start over for this one
+  if (ps.ps_pbpo!=&bpo) {
+    memset(&ps, 0, sizeof(ps));
+    ps.ps_pbpo = &bpo;
+  }
+
+  return &ps;
+}
+
+// [Cecil] Check if the setup of a layer has been made from the same properties
+static inline BOOL IsLayerSetupValid(const LayerSetup_t &ls, const CBrushPolygonTexture &bpt,
+  CTextureData *ptd, const CTextureBlending &tb)
+{
+  return ls.ls_ptd==ptd && ls.ls_mexWidth==ptd->GetWidth() && ls.ls_mexHeight==ptd->GetHeight()
+      && ls.ls_ubBlendingType==tb.tb_ubBlendingType && ls.ls_colMultiply==tb.tb_colMultiply
+      && memcmp(ls.ls_aubProperties, bpt.bpt_auProperties, sizeof(ls.ls_aubProperties))==0
+      && memcmp(&ls.ls_mdMapping, &bpt.bpt_mdMapping, sizeof(CMappingDefinition))==0;
+}
+
+// [Cecil] Set up everything about a layer that doesn't depend on the view
+static void MakeLayerSetup(LayerSetup_t &ls, const CBrushPolygonTexture &bpt,
+  CTextureData *ptd, const CTextureBlending &tb)
+{
+  ls.ls_ptd = ptd;
+  ls.ls_mexWidth  = ptd->GetWidth();
+  ls.ls_mexHeight = ptd->GetHeight();
+  memcpy(ls.ls_aubProperties, bpt.bpt_auProperties, sizeof(ls.ls_aubProperties));
+  ls.ls_mdMapping = bpt.bpt_mdMapping;
+  ls.ls_ubBlendingType = tb.tb_ubBlendingType;
+  ls.ls_colMultiply = tb.tb_colMultiply;
+
+  // set texture blending flags
+  ASSERT( BPTF_CLAMPU==STXF_CLAMPU && BPTF_CLAMPV==STXF_CLAMPV && BPTF_AFTERSHADOW==STXF_AFTERSHADOW);
+  ls.ls_ubFlags = (bpt.s.bpt_ubFlags & (BPTF_CLAMPU|BPTF_CLAMPV|BPTF_AFTERSHADOW))
+                | (tb.tb_ubBlendingType);
+  if( bpt.s.bpt_ubFlags & BPTF_REFLECTION) ls.ls_ubFlags |= STXF_REFLECTION;
+
+  // set texture blending color
+  ls.ls_colColor = MulColors( bpt.s.bpt_colColor, tb.tb_colMultiply);
+
+  // if texture is wrapped on both axes
+  const CMappingDefinition &md = bpt.bpt_mdMapping;
+
+  if( (bpt.s.bpt_ubFlags&(BPTF_CLAMPU|BPTF_CLAMPV))==0) {
+    // wrap offsets around the texture size
+    const MEX mexMaskU = ls.ls_mexWidth  -1;
+    const MEX mexMaskV = ls.ls_mexHeight -1;
+    ls.ls_fUOffset = (FloatToInt(md.md_fUOffset*1024.0f) & mexMaskU) /1024.0f;
+    ls.ls_fVOffset = (FloatToInt(md.md_fVOffset*1024.0f) & mexMaskV) /1024.0f;
+  } else {
+    ls.ls_fUOffset = md.md_fUOffset;
+    ls.ls_fVOffset = md.md_fVOffset;
+  }
+
+  // invert the mapping (same as in CMappingDefinition::MakeMappingVectors())
+  const FLOAT ood = 1.0f / (md.md_fUoS*md.md_fVoT - md.md_fUoT*md.md_fVoS);
+  ls.ls_fSoU = +md.md_fVoT*ood;  ls.ls_fSoV = -md.md_fUoT*ood;
+  ls.ls_fToV = +md.md_fUoS*ood;  ls.ls_fToU = -md.md_fVoS*ood;
+}
+
+// [Cecil] Make texture mapping vectors of a layer with specific offsets from default vectors of the plane
+static inline void MakeLayerMappingVectors(const LayerSetup_t &ls, FLOAT fUOffset, FLOAT fVOffset,
+  const CMappingVectors &mvSrc, CMappingVectors &mvDst)
+{
+  const CMappingDefinition &md = ls.ls_mdMapping;
+  mvDst.mv_vO = mvSrc.mv_vO
+              + mvSrc.mv_vU * (fUOffset*ls.ls_fSoU + fVOffset*ls.ls_fSoV)
+              + mvSrc.mv_vV * (fUOffset*ls.ls_fToU + fVOffset*ls.ls_fToV);
+  mvDst.mv_vU = mvSrc.mv_vU*md.md_fUoS + mvSrc.mv_vV*md.md_fUoT;
+  mvDst.mv_vV = mvSrc.mv_vU*md.md_fVoS + mvSrc.mv_vV*md.md_fVoT;
+}
+
 // set scene rendering parameters for one polygon texture
-void CRenderer::SetOneTextureParameters(CBrushPolygon &bpo, ScenePolygon &spo, INDEX iLayer)
+void CRenderer::SetOneTextureParameters(CBrushPolygon &bpo, ScenePolygon &spo, INDEX iLayer, LayerSetup_t *pls)
 {
   spo.spo_aptoTextures[iLayer] = NULL;
-  CTextureData *ptd = (CTextureData *)bpo.bpo_abptTextures[iLayer].bpt_toTexture.GetData();
+  CBrushPolygonTexture &bpt = bpo.bpo_abptTextures[iLayer];
+  CTextureData *ptd = (CTextureData *)bpt.bpt_toTexture.GetData();
 
   // if there is no texture or it should not be shown
   if (ptd==NULL || !_wrpWorldRenderPrefs.wrp_abTextureLayers[iLayer]) {
@@ -523,56 +634,58 @@ void CRenderer::SetOneTextureParameters(CBrushPolygon &bpo, ScenePolygon &spo, I
 
   CWorkingPlane &wpl  = *bpo.bpo_pbplPlane->bpl_pwplWorking;
   // set texture and its parameters
-  spo.spo_aptoTextures[iLayer] = &bpo.bpo_abptTextures[iLayer].bpt_toTexture;
+  spo.spo_aptoTextures[iLayer] = &bpt.bpt_toTexture;
 
   // get texture blending type
-  CTextureBlending &tb = re_pwoWorld->wo_atbTextureBlendings[bpo.bpo_abptTextures[iLayer].s.bpt_ubBlend];
+  CTextureBlending &tb = re_pwoWorld->wo_atbTextureBlendings[bpt.s.bpt_ubBlend];
 
-  // set texture blending flags
-  ASSERT( BPTF_CLAMPU==STXF_CLAMPU && BPTF_CLAMPV==STXF_CLAMPV && BPTF_AFTERSHADOW==STXF_AFTERSHADOW);
-  spo.spo_aubTextureFlags[iLayer] = 
-     (bpo.bpo_abptTextures[iLayer].s.bpt_ubFlags & (BPTF_CLAMPU|BPTF_CLAMPV|BPTF_AFTERSHADOW))
-   | (tb.tb_ubBlendingType);
-  if( bpo.bpo_abptTextures[iLayer].s.bpt_ubFlags & BPTF_REFLECTION) spo.spo_aubTextureFlags[iLayer] |= STXF_REFLECTION;
+  // [Cecil] Reuse view-independent setup of the layer from previous frames, unless it has been changed
+  LayerSetup_t lsTmp;
+  LayerSetup_t &ls = (pls!=NULL) ? *pls : lsTmp;
 
-  // set texture blending color
-  spo.spo_acolColors[iLayer] = MulColors( bpo.bpo_abptTextures[iLayer].s.bpt_colColor, tb.tb_colMultiply);
+  if (pls!=NULL && IsLayerSetupValid(ls, bpt, ptd, tb)) {
+    _sfStats.IncrementCounter(CStatForm::SCI_POLYSETUPHITS);
+  } else {
+    MakeLayerSetup(ls, bpt, ptd, tb);
+    if (pls!=NULL) _sfStats.IncrementCounter(CStatForm::SCI_POLYSETUPMISSES);
+  }
+
+  // set texture blending flags and color
+  spo.spo_aubTextureFlags[iLayer] = ls.ls_ubFlags;
+  spo.spo_acolColors[iLayer] = ls.ls_colColor;
 
   // if texture should be not transformed
-  INDEX iTransformation = bpo.bpo_abptTextures[iLayer].s.bpt_ubScroll;
+  const CMappingDefinition &md = ls.ls_mdMapping;
+  INDEX iTransformation = bpt.s.bpt_ubScroll;
   if( iTransformation==0)
   {
     // if texture is wrapped on both axes
-    if( (bpo.bpo_abptTextures[iLayer].s.bpt_ubFlags&(BPTF_CLAMPU|BPTF_CLAMPV))==0)
+    if( (bpt.s.bpt_ubFlags&(BPTF_CLAMPU|BPTF_CLAMPV))==0)
     { // make a mapping adjusted for texture wrapping
-      const MEX mexMaskU = ptd->GetWidth()  -1;
-      const MEX mexMaskV = ptd->GetHeight() -1;
-      CMappingDefinition mdTmp = bpo.bpo_abptTextures[iLayer].bpt_mdMapping;
-      mdTmp.md_fUOffset = (FloatToInt(mdTmp.md_fUOffset*1024.0f) & mexMaskU) /1024.0f;
-      mdTmp.md_fVOffset = (FloatToInt(mdTmp.md_fVOffset*1024.0f) & mexMaskV) /1024.0f;
+      const MEX mexMaskU = ls.ls_mexWidth  -1;
+      const MEX mexMaskV = ls.ls_mexHeight -1;
       const FLOAT3D vOffset = wpl.wpl_plView.ReferencePoint() - wpl.wpl_mvView.mv_vO;
       const FLOAT fS = vOffset % wpl.wpl_mvView.mv_vU;
       const FLOAT fT = vOffset % wpl.wpl_mvView.mv_vV;
-      const FLOAT fU = fS*mdTmp.md_fUoS + fT*mdTmp.md_fUoT + mdTmp.md_fUOffset;
-      const FLOAT fV = fS*mdTmp.md_fVoS + fT*mdTmp.md_fVoT + mdTmp.md_fVOffset;
-      mdTmp.md_fUOffset += (FloatToInt(fU*1024.0f) & ~mexMaskU) /1024.0f;
-      mdTmp.md_fVOffset += (FloatToInt(fV*1024.0f) & ~mexMaskV) /1024.0f;
+      const FLOAT fU = fS*md.md_fUoS + fT*md.md_fUoT + ls.ls_fUOffset;
+      const FLOAT fV = fS*md.md_fVoS + fT*md.md_fVoT + ls.ls_fVOffset;
+      const FLOAT fUOffset = ls.ls_fUOffset + (FloatToInt(fU*1024.0f) & ~mexMaskU) /1024.0f;
+      const FLOAT fVOffset = ls.ls_fVOffset + (FloatToInt(fV*1024.0f) & ~mexMaskV) /1024.0f;
       // make texture mapping vectors from default vectors of the plane
-      mdTmp.MakeMappingVectors( wpl.wpl_mvView, spo.spo_amvMapping[iLayer]);
+      MakeLayerMappingVectors( ls, fUOffset, fVOffset, wpl.wpl_mvView, spo.spo_amvMapping[iLayer]);
     }
     // if texture is clamped
     else {
       // just make texture mapping vectors from default vectors of the plane
-      bpo.bpo_abptTextures[iLayer].bpt_mdMapping.MakeMappingVectors( wpl.wpl_mvView, spo.spo_amvMapping[iLayer]);
+      MakeLayerMappingVectors( ls, md.md_fUOffset, md.md_fVOffset, wpl.wpl_mvView, spo.spo_amvMapping[iLayer]);
     }
   }
   // if texture should be transformed
   else {
     // make mapping vectors as normal and then transform them
-    CMappingDefinition &mdBase = bpo.bpo_abptTextures[iLayer].bpt_mdMapping;
     CMappingDefinition &mdScroll = re_pwoWorld->wo_attTextureTransformations[iTransformation].tt_mdTransformation;
     CMappingVectors mvTmp;
-    mdBase.MakeMappingVectors( wpl.wpl_mvView, mvTmp);
+    MakeLayerMappingVectors( ls, md.md_fUOffset, md.md_fVOffset, wpl.wpl_mvView, mvTmp);
     mdScroll.TransformMappingVectors( mvTmp, spo.spo_amvMapping[iLayer]);
   }
 }
@@ -627,24 +740,45 @@ CScreenPolygon *CRenderer::MakeScreenPolygon(CBrushPolygon &bpo)
   }
 
   // make texture mapping vectors from default vectors of the plane
-  CMappingDefinition mdShadow;
-  mdShadow.md_fUoS = 1;
-  mdShadow.md_fUoT = 0;
-  mdShadow.md_fVoS = 0;
-  mdShadow.md_fVoT = 1;
-  mdShadow.md_fUOffset = -bpo.bpo_smShadowMap.sm_mexOffsetX/1024.0f;
-  mdShadow.md_fVOffset = -bpo.bpo_smShadowMap.sm_mexOffsetY/1024.0f;
-  mdShadow.MakeMappingVectors(wpl.wpl_mvView, sppo.spo_amvMapping[3]);
+  // [Cecil] Shadow mapping is never rotated or stretched, so only the offsets need to be applied
+  CMappingVectors &mvShadow = sppo.spo_amvMapping[3];
+  const FLOAT fShadowU = -bpo.bpo_smShadowMap.sm_mexOffsetX/1024.0f;
+  const FLOAT fShadowV = -bpo.bpo_smShadowMap.sm_mexOffsetY/1024.0f;
+  mvShadow.mv_vO = wpl.wpl_mvView.mv_vO + wpl.wpl_mvView.mv_vU*fShadowU + wpl.wpl_mvView.mv_vV*fShadowV;
+  mvShadow.mv_vU = wpl.wpl_mvView.mv_vU;
+  mvShadow.mv_vV = wpl.wpl_mvView.mv_vV;
+
+  // [Cecil] Get cached setup of the polygon
+  PolygonSetup_t *pps = GetPolygonSetup(re_pwoWorld, bpo);
+
   // adjust shadow blending type
   CTextureBlending &tbShadow = re_pwoWorld->wo_atbTextureBlendings[bpo.bpo_bppProperties.bpp_ubShadowBlend];
-  sppo.spo_aubTextureFlags[3] = STXF_CLAMPU|STXF_CLAMPV|tbShadow.tb_ubBlendingType;
-  // set shadow blending color
-  sppo.spo_acolColors[3] = MulColors(bpo.bpo_colShadow, tbShadow.tb_colMultiply);
+
+  // [Cecil] Reuse shadow parameters if they are still the same
+  if (pps!=NULL && pps->ps_bShadowSet && pps->ps_colShadow==bpo.bpo_colShadow
+   && pps->ps_ubShadowBlendingType==tbShadow.tb_ubBlendingType && pps->ps_colShadowMultiply==tbShadow.tb_colMultiply) {
+    sppo.spo_aubTextureFlags[3] = pps->ps_ubShadowFlags;
+    sppo.spo_acolColors[3] = pps->ps_colShadowColor;
+
+  } else {
+    sppo.spo_aubTextureFlags[3] = STXF_CLAMPU|STXF_CLAMPV|tbShadow.tb_ubBlendingType;
+    // set shadow blending color
+    sppo.spo_acolColors[3] = MulColors(bpo.bpo_colShadow, tbShadow.tb_colMultiply);
+
+    if (pps!=NULL) {
+      pps->ps_bShadowSet = TRUE;
+      pps->ps_colShadow = bpo.bpo_colShadow;
+      pps->ps_ubShadowBlendingType = tbShadow.tb_ubBlendingType;
+      pps->ps_colShadowMultiply = tbShadow.tb_colMultiply;
+      pps->ps_ubShadowFlags = sppo.spo_aubTextureFlags[3];
+      pps->ps_colShadowColor = sppo.spo_acolColors[3];
+    }
+  }
 
   // set textures for the polygon 
-  SetOneTextureParameters( bpo, sppo, 0);
-  SetOneTextureParameters( bpo, sppo, 1);
-  SetOneTextureParameters( bpo, sppo, 2);
+  SetOneTextureParameters( bpo, sppo, 0, (pps!=NULL) ? &pps->ps_alsLayers[0] : NULL);
+  SetOneTextureParameters( bpo, sppo, 1, (pps!=NULL) ? &pps->ps_alsLayers[1] : NULL);
+  SetOneTextureParameters( bpo, sppo, 2, (pps!=NULL) ? &pps->ps_alsLayers[2] : NULL);
 
   // clear polygon flags
   sppo.spo_ulFlags = 0;
@@ -141,6 +141,26 @@ nextpolygon:;
   }
 }
 
+// [Cecil] Check if anything behind a portal may be seen from initial sectors
+BOOL CRenderer::IsPortalInPVS(CBrushPolygon &bpo) const
+{
+  const CBrushArchive &ba = re_pwoWorld->wo_baBrushes;
+  BOOL bAnySector = FALSE;
+
+  {FOREACHDSTOFSRC(bpo.bpo_rsOtherSideSectors, CBrushSector, bsc_rdOtherSidePortals, pbsc)
+    // Unknown sectors may be seen from anywhere
+    if (ba.GetPVSRow(pbsc)==NULL) return TRUE;
+
+    const INDEX iSector = pbsc->bsc_iInWorld;
+    if (re_aulPVS[iSector >> 5] & (1UL << (iSector & 31))) return TRUE;
+
+    bAnySector = TRUE;
+  ENDFOR}
+
+  // Portals that don't lead anywhere aren't culled
+  return !bAnySector;
+}
+
 // make screen polygons for nondetail polygons in current sector
 void CRenderer::MakeNonDetailScreenPolygons(void)
 {
@@ -164,6 +184,12 @@ void CRenderer::MakeNonDetailScreenPolygons(void)
     // no screen polygon by default
     bpo.bpo_pspoScreenPolygon = NULL;
 
+    // [Cecil] skip portals that only lead into sectors that cannot be seen from initial sectors
+    if (re_aulPVS.Count()>0 && (bpo.bpo_ulFlags&BPOF_RENDERASPORTAL) && !IsPortalInPVS(bpo)) {
+      _sfStats.IncrementCounter(CStatForm::SCI_PVSCULLED);
+      continue;
+    }
+
     // skip if the polygon is not visible
     ASSERT( !IsPolygonCulled(bpo));  // cannot be culled yet!
     const ULONG ulVisible = GetPolygonVisibility(bpo);
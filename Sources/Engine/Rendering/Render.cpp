@@ -82,6 +82,7 @@ static BOOL _bMirrorDrawn = FALSE;
 extern INDEX wld_bAlwaysAddAll;
 extern INDEX wld_bRenderEmptyBrushes;
 extern INDEX wld_bRenderDetailPolygons;
+extern INDEX wld_bUsePVS; // [Cecil]
 extern INDEX gfx_bRenderParticles;
 extern INDEX gfx_bRenderModels;
 extern INDEX gfx_bRenderFog;
@@ -161,6 +162,19 @@ struct ModelLight {
 };
 static CDynamicStackArray<struct ModelLight> _amlLights;
 
+// [Cecil] Cached setups of brush polygons in the last rendered world
+static CStaticStackArray<PolygonSetup_t> _apsPolygonSetups;
+static CStaticArray<INDEX> _aiPolygonSetups; // Setup index for each polygon in the world (-1 if none)
+static CWorld *_pwoPolygonSetups = NULL;
+
+// [Cecil] Forget all cached polygon setups
+static void ClearPolygonSetups(void)
+{
+  _apsPolygonSetups.Clear();
+  _aiPolygonSetups.Clear();
+  _pwoPolygonSetups = NULL;
+}
+
 static INDEX _ctMaxAddEdges=0;
 static INDEX _ctMaxActiveEdges=0;
 
@@ -198,6 +212,10 @@ void RendererInfo(void)
     slMem += re.re_aiEdgeVxMain.sa_Count*sizeof(INDEX);
   }
 
+  // [Cecil] Polygon setups
+  slMem += _apsPolygonSetups.sa_Count*sizeof(PolygonSetup_t);
+  slMem += _aiPolygonSetups.sa_Count*sizeof(INDEX);
+
   CPrintF("Temporary memory used: %dk\n", slMem/1024);
 }
 
@@ -230,6 +248,8 @@ void ClearRenderer(void)
     re.re_aiEdgeVxMain.Clear();
   }
 
+  ClearPolygonSetups(); // [Cecil]
+
   CPrintF("Renderer buffers cleared.\n");
 }
 
@@ -328,6 +348,8 @@ void CRenderer::AddInitialSectors(void)
   re_bViewerInHaze = FALSE;
   re_ulVisExclude = 0;
   re_ulVisInclude = 0;
+  // [Cecil] Nothing is culled by potentially visible sets until all initial sectors are added
+  re_aulPVS.PopAll();
 
   // if showing vis tweaks
   if (_wrpWorldRenderPrefs.wrp_bShowVisTweaksOn && _pselbscVisTweaks!=NULL) {
@@ -437,8 +459,41 @@ void CRenderer::AddInitialSectors(void)
       re_penBackgroundViewer->GetPlacement().pl_PositionVector);
   }
 
+  // [Cecil] Portals of sectors added after this can be culled
+  PreparePVS();
+
   _pfRenderProfile.StopTimer(CRenderProfile::PTI_ADDINITIAL);
 }
+
+// [Cecil] Gather sectors that may be seen from initial sectors
+void CRenderer::PreparePVS(void)
+{
+  re_aulPVS.PopAll();
+
+  // Only views from an entity can rely on being inside initial sectors
+  if (!wld_bUsePVS || re_bRenderingShadows || re_penViewer==NULL || re_lhActiveSectors.IsEmpty()) return;
+
+  const CBrushArchive &ba = re_pwoWorld->wo_baBrushes;
+  if (!ba.HasPVS()) return;
+
+  const INDEX ctLength = ba.ba_ctPVSRowLength;
+  ULONG *pulPVS = re_aulPVS.Push(ctLength);
+  memset(pulPVS, 0, ctLength * sizeof(ULONG));
+
+  FOREACHINLIST(CBrushSector, bsc_lnInActiveSectors, re_lhActiveSectors, itbsc) {
+    const ULONG *pulRow = ba.GetPVSRow(itbsc);
+
+    // Anything may be seen from this sector
+    if (pulRow==NULL) {
+      re_aulPVS.PopAll();
+      return;
+    }
+
+    for (INDEX i = 0; i < ctLength; i++) {
+      pulPVS[i] |= pulRow[i];
+    }
+  }
+}
 // scan through portals for other sectors
 void CRenderer::ScanForOtherSectors(void)
 {
@@ -946,6 +1001,8 @@ void CRenderer::InitClippingRectangle(PIX pixMinI, PIX pixMinJ, PIX pixSizeI, PI
 void RenderView(CWorld &woWorld, CEntity &enViewer,
   CAnyProjection3D &prProjection, CDrawPort &dpDrawport)
 {
+  PRF_ZONE("RenderView"); // [Cecil]
+
   // let the worldbase execute its render function
   if (woWorld.wo_pecWorldBaseClass!=NULL
     &&woWorld.wo_pecWorldBaseClass->ec_pdecDLLClass!=NULL
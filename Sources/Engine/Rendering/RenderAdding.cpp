@@ -573,8 +573,36 @@ void CRenderer::AddEntitiesInBox(const FLOATaabbox3D &boxNear)
 {
   _pfRenderProfile.StartTimer(CRenderProfile::PTI_ADDENTITIESINBOX);
 
+  // [Cecil] Check render types and flags in the entity cache to avoid touching every entity
+  CEntityCache &ec = re_pwoWorld->wo_ecCache;
+  const BOOL bUseCache = ec.Validate();
+  const BOOL bFieldBrushes = _wrpWorldRenderPrefs.IsFieldBrushesOn();
+
   // for all entities in world
   FOREACHINDYNAMICCONTAINER(re_pwoWorld->wo_cenEntities, CEntity, iten) {
+    // [Cecil] Skip entities that can't be added using the cache
+    if (bUseCache) {
+      const INDEX iEntity = iten.GetIndex();
+
+      switch (ec.ec_aubRenderTypes[iEntity]) {
+        case CEntity::RT_FIELDBRUSH:
+          if (!bFieldBrushes) continue;
+          // fall through
+
+        case CEntity::RT_BRUSH:
+          if (ec.ec_aulFlags[iEntity] & ENF_ZONING) continue;
+          if (ec.IsOutsideBox(iEntity, boxNear)) continue;
+          break;
+
+        case CEntity::RT_MODEL: case CEntity::RT_EDITORMODEL:
+        case CEntity::RT_SKAMODEL: case CEntity::RT_SKAEDITORMODEL:
+        case CEntity::RT_TERRAIN:
+          break;
+
+        default: continue;
+      }
+    }
+
     // if it is brush
     if (iten->en_RenderType==CEntity::RT_BRUSH
      ||(iten->en_RenderType==CEntity::RT_FIELDBRUSH 
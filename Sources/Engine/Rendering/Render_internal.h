@@ -268,6 +268,39 @@ public:
   void FinishAdding(void);
 };
 
+// [Cecil] View-independent setup of one texture layer on a brush polygon
+struct LayerSetup_t {
+  // Properties that the setup has been made from
+  CTextureData *ls_ptd;
+  MEX ls_mexWidth, ls_mexHeight;
+  UBYTE ls_aubProperties[8];
+  CMappingDefinition ls_mdMapping;
+  UBYTE ls_ubBlendingType;
+  COLOR ls_colMultiply;
+
+  // Scene polygon parameters
+  UBYTE ls_ubFlags;
+  COLOR ls_colColor;
+  FLOAT ls_fUOffset, ls_fVOffset; // Offsets wrapped around the texture size
+  FLOAT ls_fSoU, ls_fSoV, ls_fToU, ls_fToV; // Inverse of the mapping for applying offsets
+};
+
+// [Cecil] View-independent setup of a brush polygon that's reused between frames
+struct PolygonSetup_t {
+  CBrushPolygon *ps_pbpo;
+  LayerSetup_t ps_alsLayers[3];
+
+  // Shadow layer
+  BOOL ps_bShadowSet;
+  COLOR ps_colShadow;
+  UBYTE ps_ubShadowBlendingType;
+  COLOR ps_colShadowMultiply;
+  UBYTE ps_ubShadowFlags;
+  COLOR ps_colShadowColor;
+
+  inline void Clear(void) {};
+};
+
 /*
  * Object that performs rendering of a scene as seen by an entity.
  */
@@ -317,6 +350,7 @@ public:
   BOOL re_bViewerInHaze;          // set if viewer is viewing from a hazed sector
   ULONG re_ulVisExclude;    // for visibility tweaking
   ULONG re_ulVisInclude;
+  CStaticStackArray<ULONG> re_aulPVS; // [Cecil] Sectors that may be seen from initial sectors (empty if unknown)
 
   INDEX re_iViewVx0; // first view vertex for current sector
   FLOATplane3D re_plClip;         // current clip plane
@@ -390,7 +424,8 @@ public:
   /* Make a screen edge from two vertices. */
   inline void MakeScreenEdge(CScreenEdge &sed, FLOAT fI0, FLOAT fJ0, FLOAT fI1, FLOAT fJ1);
   // set scene rendering parameters for one polygon texture
-  inline void SetOneTextureParameters(CBrushPolygon &bpo, ScenePolygon &spo, INDEX iTexture);
+  // [Cecil] Cached setup of the layer is used and updated, if there's any
+  inline void SetOneTextureParameters(CBrushPolygon &bpo, ScenePolygon &spo, INDEX iTexture, LayerSetup_t *pls);
   /* Make a screen polygon for a brush polygon */
   CScreenPolygon *MakeScreenPolygon(CBrushPolygon &bpo);
   /* Add a polygon to scene rendering. */
@@ -412,6 +447,8 @@ public:
   void MakeInitialPolygonEdges(CBrushPolygon &bpo, CScreenPolygon &spo, BOOL bInverted);
   // find which portals should be rendered as portals or as pretenders
   void FindPretenders(void);
+  // [Cecil] Check if anything behind a portal may be seen from initial sectors
+  BOOL IsPortalInPVS(CBrushPolygon &bpo) const;
   // make screen polygons for nondetail polygons in current sector
   void MakeNonDetailScreenPolygons(void);
   // make screen polygons for detail polygons in current sector
@@ -555,6 +592,8 @@ public:
   void Initialize(void);
   // add initial sectors to active lists
   void AddInitialSectors(void);
+  // [Cecil] Gather sectors that may be seen from initial sectors
+  void PreparePVS(void);
   // scan through portals for other sectors
   void ScanForOtherSectors(void);
   // cleanup after scanning
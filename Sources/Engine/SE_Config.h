@@ -108,6 +108,9 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #ifndef SE1_USE_SDL
 #define SE1_USE_SDL       0 // Prefer SDL over Windows API (0 - No; 1 - Yes)
 #endif
+#ifndef SE1_MEMORY_TRACKING
+#define SE1_MEMORY_TRACKING 1 // Count memory allocated via AllocMemory() per subsystem (0 - No; 1 - Yes)
+#endif
 
 // Sound API switches specifically for Windows platforms
 
@@ -446,6 +446,7 @@ void CAnimSet::Write_t(CTStream *ostrFile)
 // read from stream
 void CAnimSet::Read_t(CTStream *istrFile)
 {
+  CMemoryTagScope mtsSka(MEM_SKA); // [Cecil] Count memory allocated while loading SKA data
   INDEX iFileVersion;
   // read chunk id
   istrFile->ExpectID_t(CChunkID(ANIMSET_ID));
@@ -675,6 +675,7 @@ void CMesh::Write_t(CTStream *ostrFile)
 //read from stream
 void CMesh::Read_t(CTStream *istrFile)
 {
+  CMemoryTagScope mtsSka(MEM_SKA); // [Cecil] Count memory allocated while loading SKA data
   INDEX ctmlods;
   INDEX iFileVersion;
   // read chunk id
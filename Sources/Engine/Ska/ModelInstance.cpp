@@ -1134,6 +1134,9 @@ void CModelInstance::Clear(void)
   mi_cbAABox.Clear();
   // clear anim list
   mi_aqAnims.aq_Lists.Clear();
+
+  // [Cecil] Forget the last poses
+  mi_mpcPose.Clear();
 }
 
 // Count used memory
@@ -1149,6 +1152,10 @@ SLONG CModelInstance::GetUsedMemory(void)
   slMemoryUsed += mi_aMeshInst.Count() * sizeof(MeshInstance);
   // Count bounding boxes
   slMemoryUsed += mi_cbAABox.Count() * sizeof(ColisionBox);
+  // [Cecil] Count cached poses
+  for (INDEX ipose = 0; ipose < MAX_CACHED_POSES; ipose++) {
+    slMemoryUsed += mi_mpcPose.mpc_aPoses[ipose].GetUsedMemory();
+  }
   // Cound child model instances
   INDEX ctcmi = mi_cmiChildren.Count();
   for(INDEX icmi=0;icmi<ctcmi;icmi++) {
@@ -144,6 +144,48 @@ struct PlayedAnim
   INDEX pa_GroupID;    // Group ID
 };
 
+// [Cecil] Animated pose of a model instance that has been matched for a certain state of animations
+struct ModelPose
+{
+  CStaticArray<UBYTE> mp_aubKey; // State of animations that the pose has been matched for (empty if none)
+  CStaticArray<AnimPos> mp_aapBones; // Positions of renbones
+  CStaticArray<AnimRot> mp_aarBones; // Rotations of renbones
+  CStaticArray<FLOAT> mp_afMorphs; // Factors of renmorphs
+
+  inline void Clear(void) {
+    mp_aubKey.Clear();
+    mp_aapBones.Clear();
+    mp_aarBones.Clear();
+    mp_afMorphs.Clear();
+  };
+
+  inline SLONG GetUsedMemory(void) const {
+    return mp_aubKey.Count() * sizeof(UBYTE)
+         + mp_aapBones.Count() * sizeof(AnimPos)
+         + mp_aarBones.Count() * sizeof(AnimRot)
+         + mp_afMorphs.Count() * sizeof(FLOAT);
+  };
+};
+
+// [Cecil] Poses of a model instance that were matched the last times it has been rendered
+// (more than one, since the same model may be rendered at different lods within one frame, e.g. in a mirror or a shadow)
+#define MAX_CACHED_POSES 2
+
+struct ModelPoseCache
+{
+  ModelPose mpc_aPoses[MAX_CACHED_POSES];
+  INDEX mpc_iLastUsed; // Pose that has been matched or reused the last
+
+  ModelPoseCache() : mpc_iLastUsed(0) {};
+
+  inline void Clear(void) {
+    for (INDEX i = 0; i < MAX_CACHED_POSES; i++) {
+      mpc_aPoses[i].Clear();
+    }
+    mpc_iLastUsed = 0;
+  };
+};
+
 class ENGINE_API CModelInstance
 {
 public:
@@ -289,6 +331,7 @@ public:
   FLOAT3D mi_vStretch;    // stretch of this model instance
   ColisionBox mi_cbAllFramesBBox; // all frames colision box
   CTFileName mi_fnSourceFile;     // source file name of this model instance (used only for ska studio)
+  ModelPoseCache mi_mpcPose;      // [Cecil] last matched animation poses (never copied)
 
 private:
   INDEX mi_iModelID;      // ID of this model instance (this is ID for mi_strName)
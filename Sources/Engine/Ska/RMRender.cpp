@@ -22,6 +22,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Math/Geometry.inl>
 #include <Engine/Math/Clipping.inl>
 #include <Engine/Ska/ModelInstance.h>
+#include <Engine/Ska/ModelConfig.h>
 #include <Engine/Ska/Render.h>
 #include <Engine/Ska/Mesh.h>
 #include <Engine/Ska/Skeleton.h>
@@ -32,6 +33,14 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Graphics/Fog_internal.h>
 #include <Engine/Base/Statistics_internal.h>
 
+// [Cecil] SSE intrinsics for skinning
+#if !SE1_OLD_COMPILER
+  #include <xmmintrin.h>
+  #define SE1_SKA_SIMD 1
+#else
+  #define SE1_SKA_SIMD 0
+#endif
+
 static CAnyProjection3D _aprProjection;
 static CDrawPort *_pdp = NULL;
 static enum FPUPrecisionType _fpuOldPrecision;
@@ -53,6 +62,8 @@ static FLOAT _fCustomMlodDistance=-1; // custom distance for mesh lods
 static FLOAT _fCustomSlodDistance=-1; // custom distance for skeleton lods
 extern FLOAT ska_fLODMul;
 extern FLOAT ska_fLODAdd;
+extern INDEX ska_bFastSkinning; // [Cecil]
+extern INDEX ska_bCachePoses; // [Cecil]
 
 // mask shader (for rendering models' shadows to shadowmaps)
 static CShader _shMaskShader;
@@ -87,6 +98,7 @@ static void *_pAdjustShaderData = NULL;
 static BOOL FindRenBone(RenModel &rm,int iBoneID,INDEX *piBoneIndex);
 static void PrepareMeshForRendering(RenMesh &rmsh, INDEX iSkeletonlod);
 static void CalculateRenderingData(CModelInstance &mi);
+static void SkinAllMeshes(BOOL bTransformBoneless); // [Cecil]
 static void ClearRenArrays();
 
 // load our 3x4 matrix from old-fashioned matrix+vector combination
@@ -412,6 +424,7 @@ void RM_GetModelVertices( CModelInstance &mi, CStaticStackArray<FLOAT3D> &avVert
   MakeIdentityMatrix(_mAbsToViewer);
   RM_SetCurrentDistance(fDistance);
   CalculateRenderingData(mi);
+  SkinAllMeshes(TRUE); // [Cecil]
 
   // for each ren model
   INDEX ctrmsh = _aRenModels.Count();
@@ -463,6 +476,7 @@ FLOAT RM_TestRayCastHit(CModelInstance &mi, FLOATmatrix3D &mRotation, const FLOA
   // allways use the first LOD
   RM_SetCurrentDistance(0);
 	CalculateRenderingData(mi);
+  SkinAllMeshes(TRUE); // [Cecil]
 	// for each ren model
 	INDEX ctrmsh = _aRenModels.Count();
 	for(int irmsh=1;irmsh<ctrmsh;irmsh++) {
@@ -899,7 +913,7 @@ static void RenderNormals()
   if( _iRenderingType!=1) return;
 
   _pGfx->GetInterface()->DisableTexture();
-  INDEX ctNormals = _aFinalNormals.Count();
+  INDEX ctNormals = _ctFinalVertices; // [Cecil] Final normals may be elsewhere
   for(INDEX ivx=0;ivx<ctNormals;ivx++)
   {
     FLOAT3D vNormal = FLOAT3D(_panFinalNormals[ivx].nx,_panFinalNormals[ivx].ny,_panFinalNormals[ivx].nz);
@@ -2162,44 +2176,43 @@ static void RenderMesh(RenMesh &rmsh,RenModel &rm)
   }
 }
 
-// Prepare ren mesh for rendering
-static void PrepareMeshForRendering(RenMesh &rmsh, INDEX iSkeletonlod)
+// [Cecil] How vertices of a ren mesh are prepared for rendering
+enum EMeshSkinning {
+  MSK_OBJECTSPACE = 0, // Original vertices are left in object space
+  MSK_BONELESS,        // Morphed vertices are transformed into view space by the model transformation
+  MSK_BONES,           // Morphed vertices are skinned into view space by bone transformations
+};
+
+// [Cecil] Determine how vertices of a ren mesh should be prepared
+static EMeshSkinning GetMeshSkinning(const RenMesh &rmsh, INDEX iSkeletonlod, BOOL bTransformBoneless)
 {
-  // set curent mesh lod
-  MeshLOD &mlod = rmsh.rmsh_pMeshInst->mi_pMesh->msh_aMeshLODs[rmsh.rmsh_iMeshLODIndex];
-  // clear vertices array
-  _aMorphedVtxs.PopAll();
-  _aMorphedNormals.PopAll();
-  _aFinalVtxs.PopAll();
-  _aFinalNormals.PopAll();
-  _pavFinalVertices = NULL;
-  _panFinalNormals  = NULL;
+  INDEX ctrw = rmsh.rmsh_iFirstWeight + rmsh.rmsh_ctWeights;
+  INDEX ctbones = 0;
+  CSkeleton *pskl = _aRenModels[rmsh.rmsh_iRenModelIndex].rm_pmiModel->mi_psklSkeleton;
+  // if skeleton for this model exists and its currently visible
+  if((pskl!=NULL) && (iSkeletonlod > -1)) {
+    // count bones in skeleton
+    ctbones = pskl->skl_aSkeletonLODs[iSkeletonlod].slod_aBones.Count();
+  }
 
-  FLOATmatrix3D mAbsToLight;
-  FLOAT3D vDummy;
-  Matrix12ToMatrixVector(mAbsToLight, vDummy, _mObjectToAbs);
+  // if there is skeleton attached to this mesh transfrom all vertices
+  if(ctbones > 0 && ctrw>0) return MSK_BONES;
 
-  // Reset light direction
-  // [Cecil] And orient it relative to the object rotation
-  _vLightDirInView = _vLightDir * !mAbsToLight;
+  // if flag is set to transform all vertices to view space
+  if(bTransformBoneless) return MSK_BONELESS;
 
-  // Get vertices count
+  return MSK_OBJECTSPACE;
+}
+
+// [Cecil] Copy original vertices of a ren mesh and blend its morphs into them
+static void MorphVertices(const RenMesh &rmsh, MeshVertex *pavMorphed, MeshNormal *panMorphed)
+{
+  MeshLOD &mlod = rmsh.rmsh_pMeshInst->mi_pMesh->msh_aMeshLODs[rmsh.rmsh_iMeshLODIndex];
   INDEX ctVertices = mlod.mlod_aVertices.Count();
-  // Allocate memory for vertices
-  _aMorphedVtxs.Push(ctVertices);
-  _aMorphedNormals.Push(ctVertices);
-  _aFinalVtxs.Push(ctVertices);
-  _aFinalNormals.Push(ctVertices);
-  // Remember final vertex count
-  _ctFinalVertices = ctVertices;
-  
-  // Copy original vertices and normals to _aMorphedVtxs
-  memcpy(&_aMorphedVtxs[0],&mlod.mlod_aVertices[0],sizeof(mlod.mlod_aVertices[0]) * ctVertices);
-  memcpy(&_aMorphedNormals[0],&mlod.mlod_aNormals[0],sizeof(mlod.mlod_aNormals[0]) * ctVertices);
-  // Set final vertices and normals to 0
-  memset(&_aFinalVtxs[0],0,sizeof(_aFinalVtxs[0])*ctVertices);
-  memset(&_aFinalNormals[0],0,sizeof(_aFinalNormals[0])*ctVertices);
-  
+
+  // Copy original vertices and normals
+  memcpy(pavMorphed,&mlod.mlod_aVertices[0],sizeof(mlod.mlod_aVertices[0]) * ctVertices);
+  memcpy(panMorphed,&mlod.mlod_aNormals[0],sizeof(mlod.mlod_aNormals[0]) * ctVertices);
 
   INDEX ctmm = rmsh.rmsh_iFirstMorph + rmsh.rmsh_ctMorphs;
   // blend vertices and normals for each RenMorph 
@@ -2218,151 +2231,527 @@ static void PrepareMeshForRendering(RenMesh &rmsh, INDEX iSkeletonlod)
           MeshNormal &mnSrc = mlod.mlod_aNormals[vtx];
           MeshVertexMorph &mvmDst = rm.rmp_pmmmMorphMap->mmp_aMorphMap[ivx];
           // blend vertices
-          _aMorphedVtxs[vtx].x += rm.rmp_fFactor*(mvmDst.mwm_x - mvSrc.x);
-          _aMorphedVtxs[vtx].y += rm.rmp_fFactor*(mvmDst.mwm_y - mvSrc.y);
-          _aMorphedVtxs[vtx].z += rm.rmp_fFactor*(mvmDst.mwm_z - mvSrc.z);
+          pavMorphed[vtx].x += rm.rmp_fFactor*(mvmDst.mwm_x - mvSrc.x);
+          pavMorphed[vtx].y += rm.rmp_fFactor*(mvmDst.mwm_y - mvSrc.y);
+          pavMorphed[vtx].z += rm.rmp_fFactor*(mvmDst.mwm_z - mvSrc.z);
           // blend normals
-          _aMorphedNormals[vtx].nx += rm.rmp_fFactor*(mvmDst.mwm_nx - mnSrc.nx);
-          _aMorphedNormals[vtx].ny += rm.rmp_fFactor*(mvmDst.mwm_ny - mnSrc.ny);
-          _aMorphedNormals[vtx].nz += rm.rmp_fFactor*(mvmDst.mwm_nz - mnSrc.nz);
+          panMorphed[vtx].nx += rm.rmp_fFactor*(mvmDst.mwm_nx - mnSrc.nx);
+          panMorphed[vtx].ny += rm.rmp_fFactor*(mvmDst.mwm_ny - mnSrc.ny);
+          panMorphed[vtx].nz += rm.rmp_fFactor*(mvmDst.mwm_nz - mnSrc.nz);
         } else {
           // blend absolute (1-f)*cur + f*dst
           INDEX vtx = rm.rmp_pmmmMorphMap->mmp_aMorphMap[ivx].mwm_iVxIndex;
-          MeshVertex &mvSrc = mlod.mlod_aVertices[vtx];
           MeshVertexMorph &mvmDst = rm.rmp_pmmmMorphMap->mmp_aMorphMap[ivx];
           // blend vertices
-          _aMorphedVtxs[vtx].x = (1.0f-rm.rmp_fFactor) * _aMorphedVtxs[vtx].x + rm.rmp_fFactor*mvmDst.mwm_x;
-          _aMorphedVtxs[vtx].y = (1.0f-rm.rmp_fFactor) * _aMorphedVtxs[vtx].y + rm.rmp_fFactor*mvmDst.mwm_y;
-          _aMorphedVtxs[vtx].z = (1.0f-rm.rmp_fFactor) * _aMorphedVtxs[vtx].z + rm.rmp_fFactor*mvmDst.mwm_z;
+          pavMorphed[vtx].x = (1.0f-rm.rmp_fFactor) * pavMorphed[vtx].x + rm.rmp_fFactor*mvmDst.mwm_x;
+          pavMorphed[vtx].y = (1.0f-rm.rmp_fFactor) * pavMorphed[vtx].y + rm.rmp_fFactor*mvmDst.mwm_y;
+          pavMorphed[vtx].z = (1.0f-rm.rmp_fFactor) * pavMorphed[vtx].z + rm.rmp_fFactor*mvmDst.mwm_z;
           // blend normals
-          _aMorphedNormals[vtx].nx = (1.0f-rm.rmp_fFactor) * _aMorphedNormals[vtx].nx + rm.rmp_fFactor*mvmDst.mwm_nx;
-          _aMorphedNormals[vtx].ny = (1.0f-rm.rmp_fFactor) * _aMorphedNormals[vtx].ny + rm.rmp_fFactor*mvmDst.mwm_ny;
-          _aMorphedNormals[vtx].nz = (1.0f-rm.rmp_fFactor) * _aMorphedNormals[vtx].nz + rm.rmp_fFactor*mvmDst.mwm_nz;
+          panMorphed[vtx].nx = (1.0f-rm.rmp_fFactor) * panMorphed[vtx].nx + rm.rmp_fFactor*mvmDst.mwm_nx;
+          panMorphed[vtx].ny = (1.0f-rm.rmp_fFactor) * panMorphed[vtx].ny + rm.rmp_fFactor*mvmDst.mwm_ny;
+          panMorphed[vtx].nz = (1.0f-rm.rmp_fFactor) * panMorphed[vtx].nz + rm.rmp_fFactor*mvmDst.mwm_nz;
         }
       }
     }
   }
+}
 
-  INDEX ctrw = rmsh.rmsh_iFirstWeight + rmsh.rmsh_ctWeights;
-  INDEX ctbones = 0;
-  CSkeleton *pskl = _aRenModels[rmsh.rmsh_iRenModelIndex].rm_pmiModel->mi_psklSkeleton;
-  // if skeleton for this model exists and its currently visible
-  if((pskl!=NULL) && (iSkeletonlod > -1)) {
-    // count bones in skeleton
-    ctbones = pskl->skl_aSkeletonLODs[iSkeletonlod].slod_aBones.Count();
+#if SE1_SKA_SIMD
+
+// [Cecil] Columns of a 3x4 matrix for transforming vectors with SSE
+struct MatrixColumns_t {
+  __m128 v1, v2, v3, v4;
+
+  inline MatrixColumns_t(const Matrix12 &m) {
+    v1 = _mm_setr_ps(m[0], m[4], m[ 8], 0.0f);
+    v2 = _mm_setr_ps(m[1], m[5], m[ 9], 0.0f);
+    v3 = _mm_setr_ps(m[2], m[6], m[10], 0.0f);
+    v4 = _mm_setr_ps(m[3], m[7], m[11], 0.0f);
+  };
+
+  // Same operation order as in RotateVector(), so the results are identical
+  inline __m128 Rotate(const __m128 v) const {
+    const __m128 vX = _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0));
+    const __m128 vY = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
+    const __m128 vZ = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2));
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(v1, vX), _mm_mul_ps(v2, vY)), _mm_mul_ps(v3, vZ));
+  };
+
+  // Same operation order as in TransformVector()
+  inline __m128 Transform(const __m128 v) const {
+    return _mm_add_ps(Rotate(v), v4);
+  };
+};
+
+#endif // SE1_SKA_SIMD
+
+// [Cecil] Get transformation matrices of a ren weight of a ren mesh
+static inline void GetWeightTransforms(const RenMesh &rmsh, const MeshLOD &mlod, const RenWeight &rw, Matrix12 &mTransform, Matrix12 &mStrTransform)
+{
+  // if no bone for this weight 
+  if(rw.rw_iBoneIndex == (-1)) {
+    // transform vertex using default model transform matrix (for boneless models)
+    MatrixCopy(mStrTransform, _aRenModels[rmsh.rmsh_iRenModelIndex].rm_mStrTransform);
+    MatrixCopy(mTransform,    _aRenModels[rmsh.rmsh_iRenModelIndex].rm_mTransform);
+  } else {
+    // use bone transform matrix
+    MatrixCopy(mStrTransform, _aRenBones[rw.rw_iBoneIndex].rb_mStrTransform);
+    MatrixCopy(mTransform,    _aRenBones[rw.rw_iBoneIndex].rb_mTransform);
   }
 
-  // if there is skeleton attached to this mesh transfrom all vertices
-  if(ctbones > 0 && ctrw>0) {
+  // if this is front face mesh remove rotation from transfrom matrix
+  if(mlod.mlod_ulFlags & ML_FULL_FACE_FORWARD) {
+    RemoveRotationFromMatrix(mStrTransform);
+  }
+}
+
+// [Cecil] Add one vertex transformed by a weight to final vertices
+static inline void AddWeightedVertex(const MeshVertexWeight &vw, const Matrix12 &mStrTransform, const Matrix12 &mTransform,
+                                     const MeshVertex *pavMorphed, const MeshNormal *panMorphed, MeshVertex *pavFinal, MeshNormal *panFinal)
+{
+  const INDEX ivx = vw.mww_iVertex;
+  MeshVertex mv = pavMorphed[ivx];
+  MeshNormal mn = panMorphed[ivx];
+  
+  // transform vertex and normal with this weight transform matrix
+  TransformVector((FLOAT3&)mv,mStrTransform);
+  RotateVector((FLOAT3&)mn,mTransform); // Don't stretch normals
+
+  // Add new values to final vertices
+  pavFinal[ivx].x += mv.x * vw.mww_fWeight;
+  pavFinal[ivx].y += mv.y * vw.mww_fWeight;
+  pavFinal[ivx].z += mv.z * vw.mww_fWeight;
+  panFinal[ivx].nx += mn.nx * vw.mww_fWeight;
+  panFinal[ivx].ny += mn.ny * vw.mww_fWeight;
+  panFinal[ivx].nz += mn.nz * vw.mww_fWeight;
+}
+
+#if SE1_SKA_SIMD
+
+// [Cecil] Add one vertex transformed by a weight to final vertices with SSE
+static inline void AddWeightedVertexSIMD(const MeshVertexWeight &vw, const MatrixColumns_t &mcStrTransform, const MatrixColumns_t &mcTransform,
+                                         const MeshVertex *pavMorphed, const MeshNormal *panMorphed, MeshVertex *pavFinal, MeshNormal *panFinal)
+{
+  const INDEX ivx = vw.mww_iVertex;
+
+  // transform vertex and normal with this weight transform matrix (don't stretch normals)
+  const __m128 vWeight = _mm_set1_ps(vw.mww_fWeight);
+  const __m128 vVtx = mcStrTransform.Transform(_mm_loadu_ps(&pavMorphed[ivx].x));
+  const __m128 vNor = mcTransform.Rotate(_mm_loadu_ps(&panMorphed[ivx].nx));
+
+  // add new values to final vertices (padding is overwritten as well)
+  _mm_storeu_ps(&pavFinal[ivx].x,  _mm_add_ps(_mm_loadu_ps(&pavFinal[ivx].x),  _mm_mul_ps(vVtx, vWeight)));
+  _mm_storeu_ps(&panFinal[ivx].nx, _mm_add_ps(_mm_loadu_ps(&panFinal[ivx].nx), _mm_mul_ps(vNor, vWeight)));
+}
+
+#endif // SE1_SKA_SIMD
+
+// [Cecil] Transform a range of morphed vertices of a ren mesh into view space
+// Only vertices within the range are written, so different ranges can be processed at the same time
+static void SkinVertices(const RenMesh &rmsh, EMeshSkinning eSkinning, const MeshVertex *pavMorphed, const MeshNormal *panMorphed,
+                         MeshVertex *pavFinal, MeshNormal *panFinal, INDEX iFirstVertex, INDEX ctVertices, BOOL bSIMD)
+{
+  ASSERT(eSkinning != MSK_OBJECTSPACE);
+  MeshLOD &mlod = rmsh.rmsh_pMeshInst->mi_pMesh->msh_aMeshLODs[rmsh.rmsh_iMeshLODIndex];
+  const INDEX iLastVertex = iFirstVertex + ctVertices;
+
+  #if !SE1_SKA_SIMD
+    bSIMD = FALSE;
+  #endif
+
+  if (eSkinning == MSK_BONES) {
+    // Set final vertices and normals to 0
+    memset(&pavFinal[iFirstVertex],0,sizeof(pavFinal[0])*ctVertices);
+    memset(&panFinal[iFirstVertex],0,sizeof(panFinal[0])*ctVertices);
+
+    INDEX ctrw = rmsh.rmsh_iFirstWeight + rmsh.rmsh_ctWeights;
     // for each renweight
     for(int irw=rmsh.rmsh_iFirstWeight; irw<ctrw; irw++) {
       RenWeight &rw = _aRenWeights[irw];
       Matrix12 mTransform;
       Matrix12 mStrTransform;
-      // if no bone for this weight 
-      if(rw.rw_iBoneIndex == (-1)) {
-        // transform vertex using default model transform matrix (for boneless models)
-        MatrixCopy(mStrTransform, _aRenModels[rmsh.rmsh_iRenModelIndex].rm_mStrTransform);
-        MatrixCopy(mTransform,    _aRenModels[rmsh.rmsh_iRenModelIndex].rm_mTransform);
-      } else {
-        // use bone transform matrix
-        MatrixCopy(mStrTransform, _aRenBones[rw.rw_iBoneIndex].rb_mStrTransform);
-        MatrixCopy(mTransform,    _aRenBones[rw.rw_iBoneIndex].rb_mTransform);
-      }
+      GetWeightTransforms(rmsh, mlod, rw, mTransform, mStrTransform);
 
-      // if this is front face mesh remove rotation from transfrom matrix
-      if(mlod.mlod_ulFlags & ML_FULL_FACE_FORWARD) {
-        RemoveRotationFromMatrix(mStrTransform);
+      INDEX ctvw = rw.rw_pwmWeightMap->mwm_aVertexWeight.Count();
+      const MeshVertexWeight *pvw = &rw.rw_pwmWeightMap->mwm_aVertexWeight[0];
+
+    #if SE1_SKA_SIMD
+      if (bSIMD) {
+        const MatrixColumns_t mcStrTransform(mStrTransform);
+        const MatrixColumns_t mcTransform(mTransform);
+
+        // for each vertex in this weight
+        for(int ivw=0; ivw<ctvw; ivw++) {
+          const INDEX ivx = pvw[ivw].mww_iVertex;
+          if (ivx < iFirstVertex || ivx >= iLastVertex) continue;
+
+          AddWeightedVertexSIMD(pvw[ivw], mcStrTransform, mcTransform, pavMorphed, panMorphed, pavFinal, panFinal);
+        }
+        continue;
       }
+    #endif // SE1_SKA_SIMD
 
       // for each vertex in this weight
-      INDEX ctvw = rw.rw_pwmWeightMap->mwm_aVertexWeight.Count();
       for(int ivw=0; ivw<ctvw; ivw++) {
-        MeshVertexWeight &vw = rw.rw_pwmWeightMap->mwm_aVertexWeight[ivw];
-        INDEX ivx = vw.mww_iVertex;
-        MeshVertex mv = _aMorphedVtxs[ivx];
-        MeshNormal mn = _aMorphedNormals[ivx];
-        
-        // transform vertex and normal with this weight transform matrix
-        TransformVector((FLOAT3&)mv,mStrTransform);
-        RotateVector((FLOAT3&)mn,mTransform); // Don't stretch normals
-
-        // Add new values to final vertices
-        _aFinalVtxs[ivx].x += mv.x * vw.mww_fWeight;
-        _aFinalVtxs[ivx].y += mv.y * vw.mww_fWeight;
-        _aFinalVtxs[ivx].z += mv.z * vw.mww_fWeight;
-        _aFinalNormals[ivx].nx += mn.nx * vw.mww_fWeight;
-        _aFinalNormals[ivx].ny += mn.ny * vw.mww_fWeight;
-        _aFinalNormals[ivx].nz += mn.nz * vw.mww_fWeight;
+        const INDEX ivx = pvw[ivw].mww_iVertex;
+        if (ivx < iFirstVertex || ivx >= iLastVertex) continue;
+
+        AddWeightedVertex(pvw[ivw], mStrTransform, mTransform, pavMorphed, panMorphed, pavFinal, panFinal);
       }
     }
+    return;
+  }
+
+  // transform every vertex using default model transform matrix (for boneless models)
+  Matrix12 mTransform;
+  Matrix12 mStrTransform;
+  MatrixCopy(mTransform,    _aRenModels[rmsh.rmsh_iRenModelIndex].rm_mTransform);
+  MatrixCopy(mStrTransform, _aRenModels[rmsh.rmsh_iRenModelIndex].rm_mStrTransform);
+
+  // if this is front face mesh remove rotation from transfrom matrix
+  if(mlod.mlod_ulFlags & ML_FULL_FACE_FORWARD) {
+    RemoveRotationFromMatrix(mStrTransform);
+  }
+
+  // for each vertex
+  for(int ivx=iFirstVertex;ivx<iLastVertex;ivx++) {
+    MeshVertex mv = pavMorphed[ivx];
+    MeshNormal mn = panMorphed[ivx];
+    // Transform vertex
+    TransformVector((FLOAT3&)mv,mStrTransform);
+    // Rotate normal
+    RotateVector((FLOAT3&)mn,mTransform);
+    pavFinal[ivx].x = mv.x;
+    pavFinal[ivx].y = mv.y;
+    pavFinal[ivx].z = mv.z;
+    panFinal[ivx].nx = mn.nx;
+    panFinal[ivx].ny = mn.ny;
+    panFinal[ivx].nz = mn.nz;
+  }
+}
+
+// [Cecil] Maximum amount of vertices skinned by one job
+#define SKIN_JOB_VERTICES 1024
+
+// [Cecil] Vertices of a ren mesh that have been prepared beforehand
+struct SkinnedMesh_t {
+  EMeshSkinning eSkinning; // How vertices have been prepared
+  INDEX iFirstVertex; // First vertex in arrays of skinned vertices
+  INDEX ctVertices; // Amount of skinned vertices (0 if left in object space)
+  INDEX iFirstJob; // First skinning job of this mesh
+  INDEX ctJobs; // Amount of skinning jobs
+  INDEX iFirstWeight; // First vertex weight of this mesh in the weight buckets
+  INDEX ctWeights; // Amount of vertex weights (0 if not skinned with bones)
+
+  inline void Clear(void) {};
+};
+
+// [Cecil] Range of vertices of one mesh for a skinning job
+struct SkinJob_t {
+  INDEX iRenMesh;
+  INDEX iFirstVertex;
+  INDEX ctVertices;
+  INDEX iFirstWeight; // Vertex weights within the range in the weight buckets
+  INDEX ctWeights;
+
+  inline void Clear(void) {};
+};
+
+// [Cecil] Vertex weight bucketed for a skinning job
+struct SkinWeight_t {
+  INDEX iRenWeight; // Ren weight with the transformation
+  MeshVertexWeight vw;
+
+  inline void Clear(void) {};
+};
+
+static CStaticStackArray<SkinnedMesh_t> _aSkinnedMeshes; // One for each ren mesh (or none if nothing has been prepared)
+static CStaticStackArray<SkinJob_t> _aSkinJobs;
+static CStaticStackArray<SkinWeight_t> _aSkinWeights; // Vertex weights of each skinning job in their original order
+static CStaticStackArray<struct MeshVertex> _aSkinnedMorphedVtxs;
+static CStaticStackArray<struct MeshNormal> _aSkinnedMorphedNormals;
+static CStaticStackArray<struct MeshVertex> _aSkinnedVtxs;
+static CStaticStackArray<struct MeshNormal> _aSkinnedNormals;
+
+// [Cecil] Sort vertex weights of a mesh into buckets of its skinning jobs
+// Weights keep their original order within each bucket, so vertices are summed up in the same order
+static void BucketMeshWeights(const RenMesh &rmsh, const SkinnedMesh_t &sm)
+{
+  SkinJob_t *psjJobs = &_aSkinJobs[sm.iFirstJob];
+
+  for (INDEX iJob = 0; iJob < sm.ctJobs; iJob++) {
+    psjJobs[iJob].ctWeights = 0;
+  }
+
+  const INDEX ctrw = rmsh.rmsh_iFirstWeight + rmsh.rmsh_ctWeights;
+
+  // Count weights in each job range
+  for (INDEX irw = rmsh.rmsh_iFirstWeight; irw < ctrw; irw++) {
+    const CStaticArray<MeshVertexWeight> &avw = _aRenWeights[irw].rw_pwmWeightMap->mwm_aVertexWeight;
+    const INDEX ctvw = avw.Count();
+
+    for (INDEX ivw = 0; ivw < ctvw; ivw++) {
+      const INDEX ivx = avw[ivw].mww_iVertex;
+      if (ivx < 0 || ivx >= sm.ctVertices) continue;
+
+      psjJobs[ivx / SKIN_JOB_VERTICES].ctWeights++;
+    }
+  }
+
+  // Place buckets one after another
+  INDEX iWeight = sm.iFirstWeight;
+
+  for (INDEX iJob = 0; iJob < sm.ctJobs; iJob++) {
+    psjJobs[iJob].iFirstWeight = iWeight;
+    iWeight += psjJobs[iJob].ctWeights;
+    psjJobs[iJob].ctWeights = 0;
+  }
+
+  ASSERT(iWeight <= sm.iFirstWeight + sm.ctWeights);
+
+  // Fill the buckets
+  for (INDEX irw = rmsh.rmsh_iFirstWeight; irw < ctrw; irw++) {
+    const CStaticArray<MeshVertexWeight> &avw = _aRenWeights[irw].rw_pwmWeightMap->mwm_aVertexWeight;
+    const INDEX ctvw = avw.Count();
+
+    for (INDEX ivw = 0; ivw < ctvw; ivw++) {
+      const INDEX ivx = avw[ivw].mww_iVertex;
+      if (ivx < 0 || ivx >= sm.ctVertices) continue;
+
+      SkinJob_t &sj = psjJobs[ivx / SKIN_JOB_VERTICES];
+      SkinWeight_t &sw = _aSkinWeights[sj.iFirstWeight + sj.ctWeights++];
+      sw.iRenWeight = irw;
+      sw.vw = avw[ivw];
+    }
+  }
+}
+
+// [Cecil] Morph vertices of a range of ren meshes and bucket their weights for skinning jobs
+static void MorphMeshesJob(void *pvData, INDEX iFirst, INDEX ctItems, INDEX iThread)
+{
+  for (INDEX i = iFirst; i < iFirst + ctItems; i++) {
+    const SkinnedMesh_t &sm = _aSkinnedMeshes[i];
+    if (sm.ctVertices == 0) continue;
+
+    MorphVertices(_aRenMesh[i], &_aSkinnedMorphedVtxs[sm.iFirstVertex], &_aSkinnedMorphedNormals[sm.iFirstVertex]);
+
+    if (sm.eSkinning == MSK_BONES) {
+      BucketMeshWeights(_aRenMesh[i], sm);
+    }
+  }
+}
+
+// [Cecil] Skin vertices of one job from its bucket of vertex weights
+static void SkinJobWeights(const SkinJob_t &sj, const MeshVertex *pavMorphed, const MeshNormal *panMorphed, MeshVertex *pavFinal, MeshNormal *panFinal)
+{
+  const RenMesh &rmsh = _aRenMesh[sj.iRenMesh];
+  MeshLOD &mlod = rmsh.rmsh_pMeshInst->mi_pMesh->msh_aMeshLODs[rmsh.rmsh_iMeshLODIndex];
+
+  // Set final vertices and normals to 0
+  memset(&pavFinal[sj.iFirstVertex],0,sizeof(pavFinal[0])*sj.ctVertices);
+  memset(&panFinal[sj.iFirstVertex],0,sizeof(panFinal[0])*sj.ctVertices);
+
+  if (sj.ctWeights == 0) return;
+
+  const SkinWeight_t *psw = &_aSkinWeights[0] + sj.iFirstWeight;
+  const SkinWeight_t *pswEnd = psw + sj.ctWeights;
+
+  // Weights of the same ren weight follow each other
+  while (psw < pswEnd) {
+    const INDEX irw = psw->iRenWeight;
+
+    Matrix12 mTransform;
+    Matrix12 mStrTransform;
+    GetWeightTransforms(rmsh, mlod, _aRenWeights[irw], mTransform, mStrTransform);
+
+  #if SE1_SKA_SIMD
+    const MatrixColumns_t mcStrTransform(mStrTransform);
+    const MatrixColumns_t mcTransform(mTransform);
+
+    for (; psw < pswEnd && psw->iRenWeight == irw; psw++) {
+      AddWeightedVertexSIMD(psw->vw, mcStrTransform, mcTransform, pavMorphed, panMorphed, pavFinal, panFinal);
+    }
+  #else
+    for (; psw < pswEnd && psw->iRenWeight == irw; psw++) {
+      AddWeightedVertex(psw->vw, mStrTransform, mTransform, pavMorphed, panMorphed, pavFinal, panFinal);
+    }
+  #endif
+  }
+}
+
+// [Cecil] Skin vertices of a range of skinning jobs
+static void SkinMeshesJob(void *pvData, INDEX iFirst, INDEX ctItems, INDEX iThread)
+{
+  for (INDEX i = iFirst; i < iFirst + ctItems; i++) {
+    const SkinJob_t &sj = _aSkinJobs[i];
+    const SkinnedMesh_t &sm = _aSkinnedMeshes[sj.iRenMesh];
+
+    MeshVertex *pavMorphed = &_aSkinnedMorphedVtxs[sm.iFirstVertex];
+    MeshNormal *panMorphed = &_aSkinnedMorphedNormals[sm.iFirstVertex];
+    MeshVertex *pavFinal = &_aSkinnedVtxs[sm.iFirstVertex];
+    MeshNormal *panFinal = &_aSkinnedNormals[sm.iFirstVertex];
+
+    if (sm.eSkinning == MSK_BONES) {
+      SkinJobWeights(sj, pavMorphed, panMorphed, pavFinal, panFinal);
+    } else {
+      SkinVertices(_aRenMesh[sj.iRenMesh], sm.eSkinning, pavMorphed, panMorphed, pavFinal, panFinal, sj.iFirstVertex, sj.ctVertices, TRUE);
+    }
+  }
+}
+
+// [Cecil] Prepare vertices of all ren meshes at once using all job threads
+static void SkinAllMeshes(BOOL bTransformBoneless)
+{
+  _aSkinnedMeshes.PopAll();
+  _aSkinJobs.PopAll();
+
+  const INDEX ctMeshes = _aRenMesh.Count();
+  if (!ska_bFastSkinning || ctMeshes == 0) return;
+
+  SkinnedMesh_t *psmMeshes = _aSkinnedMeshes.Push(ctMeshes);
+  INDEX ctTotalVertices = 0;
+  INDEX ctTotalWeights = 0;
+
+  // Gather vertices of all meshes and split them into jobs
+  for (INDEX imsh = 0; imsh < ctMeshes; imsh++) {
+    const RenMesh &rmsh = _aRenMesh[imsh];
+    SkinnedMesh_t &sm = psmMeshes[imsh];
+
+    sm.eSkinning = GetMeshSkinning(rmsh, _aRenModels[rmsh.rmsh_iRenModelIndex].rm_iSkeletonLODIndex, bTransformBoneless);
+    sm.iFirstVertex = ctTotalVertices;
+    sm.ctVertices = 0;
+    sm.iFirstJob = _aSkinJobs.Count();
+    sm.ctJobs = 0;
+    sm.iFirstWeight = ctTotalWeights;
+    sm.ctWeights = 0;
+
+    if (sm.eSkinning == MSK_OBJECTSPACE) continue;
+
+    MeshLOD &mlod = rmsh.rmsh_pMeshInst->mi_pMesh->msh_aMeshLODs[rmsh.rmsh_iMeshLODIndex];
+    sm.ctVertices = mlod.mlod_aVertices.Count();
+
+    for (INDEX iVtx = 0; iVtx < sm.ctVertices; iVtx += SKIN_JOB_VERTICES) {
+      SkinJob_t &sj = _aSkinJobs.Push();
+      sj.iRenMesh = imsh;
+      sj.iFirstVertex = iVtx;
+      sj.ctVertices = Min(sm.ctVertices - iVtx, (INDEX)SKIN_JOB_VERTICES);
+      sj.iFirstWeight = 0;
+      sj.ctWeights = 0;
+      sm.ctJobs++;
+    }
+
+    // Reserve room for all vertex weights of the mesh
+    if (sm.eSkinning == MSK_BONES) {
+      const INDEX ctrw = rmsh.rmsh_iFirstWeight + rmsh.rmsh_ctWeights;
+
+      for (INDEX irw = rmsh.rmsh_iFirstWeight; irw < ctrw; irw++) {
+        sm.ctWeights += _aRenWeights[irw].rw_pwmWeightMap->mwm_aVertexWeight.Count();
+      }
+    }
+
+    ctTotalVertices += sm.ctVertices;
+    ctTotalWeights += sm.ctWeights;
+  }
+
+  if (ctTotalVertices == 0) return;
+
+  _aSkinnedMorphedVtxs.PopAll();
+  _aSkinnedMorphedNormals.PopAll();
+  _aSkinnedVtxs.PopAll();
+  _aSkinnedNormals.PopAll();
+  _aSkinWeights.PopAll();
+  _aSkinnedMorphedVtxs.Push(ctTotalVertices);
+  _aSkinnedMorphedNormals.Push(ctTotalVertices);
+  _aSkinnedVtxs.Push(ctTotalVertices);
+  _aSkinnedNormals.Push(ctTotalVertices);
+  if (ctTotalWeights > 0) _aSkinWeights.Push(ctTotalWeights);
+
+  // Morphing must be finished for the whole mesh before any of its vertices can be skinned
+  IJobs::ParallelFor(ctMeshes, 1, MorphMeshesJob, NULL);
+  IJobs::ParallelFor(_aSkinJobs.Count(), 1, SkinMeshesJob, NULL);
+}
+
+// Prepare ren mesh for rendering
+static void PrepareMeshForRendering(RenMesh &rmsh, INDEX iSkeletonlod)
+{
+  // set curent mesh lod
+  MeshLOD &mlod = rmsh.rmsh_pMeshInst->mi_pMesh->msh_aMeshLODs[rmsh.rmsh_iMeshLODIndex];
+  // clear vertices array
+  _aMorphedVtxs.PopAll();
+  _aMorphedNormals.PopAll();
+  _aFinalVtxs.PopAll();
+  _aFinalNormals.PopAll();
+  _pavFinalVertices = NULL;
+  _panFinalNormals  = NULL;
+
+  FLOATmatrix3D mAbsToLight;
+  FLOAT3D vDummy;
+  Matrix12ToMatrixVector(mAbsToLight, vDummy, _mObjectToAbs);
+
+  // Reset light direction
+  // [Cecil] And orient it relative to the object rotation
+  _vLightDirInView = _vLightDir * !mAbsToLight;
+
+  // Get vertices count
+  INDEX ctVertices = mlod.mlod_aVertices.Count();
+  // Remember final vertex count
+  _ctFinalVertices = ctVertices;
+
+  // [Cecil] Determine how vertices should be prepared
+  const EMeshSkinning eSkinning = GetMeshSkinning(rmsh, iSkeletonlod, _bTransformBonelessModelToViewSpace);
+  const INDEX iRenMesh = INDEX(&rmsh - &_aRenMesh[0]);
+
+  // [Cecil] Use vertices that have been prepared beforehand
+  if (eSkinning != MSK_OBJECTSPACE && iRenMesh < _aSkinnedMeshes.Count()
+   && _aSkinnedMeshes[iRenMesh].eSkinning == eSkinning && _aSkinnedMeshes[iRenMesh].ctVertices == ctVertices) {
+    const SkinnedMesh_t &sm = _aSkinnedMeshes[iRenMesh];
+    _pavFinalVertices = &_aSkinnedVtxs[sm.iFirstVertex];
+    _panFinalNormals  = &_aSkinnedNormals[sm.iFirstVertex];
+
+  // [Cecil] Prepare vertices of this mesh right now
+  } else if (eSkinning != MSK_OBJECTSPACE) {
+    // Allocate memory for vertices
+    _aMorphedVtxs.Push(ctVertices);
+    _aMorphedNormals.Push(ctVertices);
+    _aFinalVtxs.Push(ctVertices);
+    _aFinalNormals.Push(ctVertices);
+
+    MorphVertices(rmsh, &_aMorphedVtxs[0], &_aMorphedNormals[0]);
+    SkinVertices(rmsh, eSkinning, &_aMorphedVtxs[0], &_aMorphedNormals[0], &_aFinalVtxs[0], &_aFinalNormals[0], 0, ctVertices, ska_bFastSkinning);
+
     _pavFinalVertices = &_aFinalVtxs[0];
     _panFinalNormals  = &_aFinalNormals[0];
+  }
+
+  // if mesh has been transformed
+  if (eSkinning != MSK_OBJECTSPACE) {
     // mesh is in view space so transform light to view space
     RotateVector(_vLightDirInView.vector,_mObjToView);
     // set flag that mesh is in view space
     rmsh.rmsh_bTransToViewSpace = TRUE;
     // reset view matrix bacause model is allready transformed in view space
     _pGfx->GetInterface()->SetViewMatrix(NULL);
-  // if no skeleton
-  } else {
-    // if flag is set to transform all vertices to view space
-    if(_bTransformBonelessModelToViewSpace) {
-      // transform every vertex using default model transform matrix (for boneless models)
-      Matrix12 mTransform;
-      Matrix12 mStrTransform;
-      MatrixCopy(mTransform,    _aRenModels[rmsh.rmsh_iRenModelIndex].rm_mTransform);
-      MatrixCopy(mStrTransform, _aRenModels[rmsh.rmsh_iRenModelIndex].rm_mStrTransform);
 
-      // if this is front face mesh remove rotation from transfrom matrix
-      if(mlod.mlod_ulFlags & ML_FULL_FACE_FORWARD) {
-        RemoveRotationFromMatrix(mStrTransform);
-      }
-      
-      // for each vertex
-      for(int ivx=0;ivx<ctVertices;ivx++) {
-        MeshVertex &mv = _aMorphedVtxs[ivx];
-        MeshNormal &mn = _aMorphedNormals[ivx];
-        // Transform vertex
-        TransformVector((FLOAT3&)mv,mStrTransform);
-        // Rotate normal
-        RotateVector((FLOAT3&)mn,mTransform);
-        _aFinalVtxs[ivx].x = mv.x;
-        _aFinalVtxs[ivx].y = mv.y;
-        _aFinalVtxs[ivx].z = mv.z;
-        _aFinalNormals[ivx].nx = mn.nx;
-        _aFinalNormals[ivx].ny = mn.ny;
-        _aFinalNormals[ivx].nz = mn.nz;
-      }
-      _pavFinalVertices = &_aFinalVtxs[0];
-      _panFinalNormals  = &_aFinalNormals[0];
-      // mesh is in view space so transform light to view space
-      RotateVector(_vLightDirInView.vector,_mObjToView);
-      // set flag that mesh is in view space
-      rmsh.rmsh_bTransToViewSpace = TRUE;
-      // reset view matrix bacause model is allready transformed in view space
-      _pGfx->GetInterface()->SetViewMatrix(NULL);
-    // leave vertices in obj space
-    } else {
-      Matrix12 &m12 = _aRenModels[rmsh.rmsh_iRenModelIndex].rm_mStrTransform;
-      FLOAT gfxm[16];
-      #pragma message(">> Fix face forward meshes, when objects are left in object space")
-
-      // set view matrix to gfx
-      gfxm[ 0] = m12[ 0];  gfxm[ 1] = m12[ 4];  gfxm[ 2] = m12[ 8];  gfxm[ 3] = 0;
-      gfxm[ 4] = m12[ 1];  gfxm[ 5] = m12[ 5];  gfxm[ 6] = m12[ 9];  gfxm[ 7] = 0;
-      gfxm[ 8] = m12[ 2];  gfxm[ 9] = m12[ 6];  gfxm[10] = m12[10];  gfxm[11] = 0;
-      gfxm[12] = m12[ 3];  gfxm[13] = m12[ 7];  gfxm[14] = m12[11];  gfxm[15] = 1;
-      _pGfx->GetInterface()->SetViewMatrix(gfxm);
-
-      RenModel &rm = _aRenModels[rmsh.rmsh_iRenModelIndex];
-      RenBone &rb = _aRenBones[rm.rm_iParentBoneIndex];
-      RotateVector(_vLightDirInView.vector,rb.rb_mBonePlacement);
-      _pavFinalVertices = &mlod.mlod_aVertices[0];
-      _panFinalNormals  = &mlod.mlod_aNormals[0];
-      // mark this mesh as in object space
-      rmsh.rmsh_bTransToViewSpace = FALSE;
-    }
+  // leave vertices in obj space
+  } else {
+    Matrix12 &m12 = _aRenModels[rmsh.rmsh_iRenModelIndex].rm_mStrTransform;
+    FLOAT gfxm[16];
+    #pragma message(">> Fix face forward meshes, when objects are left in object space")
+
+    // set view matrix to gfx
+    gfxm[ 0] = m12[ 0];  gfxm[ 1] = m12[ 4];  gfxm[ 2] = m12[ 8];  gfxm[ 3] = 0;
+    gfxm[ 4] = m12[ 1];  gfxm[ 5] = m12[ 5];  gfxm[ 6] = m12[ 9];  gfxm[ 7] = 0;
+    gfxm[ 8] = m12[ 2];  gfxm[ 9] = m12[ 6];  gfxm[10] = m12[10];  gfxm[11] = 0;
+    gfxm[12] = m12[ 3];  gfxm[13] = m12[ 7];  gfxm[14] = m12[11];  gfxm[15] = 1;
+    _pGfx->GetInterface()->SetViewMatrix(gfxm);
+
+    RenModel &rm = _aRenModels[rmsh.rmsh_iRenModelIndex];
+    RenBone &rb = _aRenBones[rm.rm_iParentBoneIndex];
+    RotateVector(_vLightDirInView.vector,rb.rb_mBonePlacement);
+    _pavFinalVertices = &mlod.mlod_aVertices[0];
+    _panFinalNormals  = &mlod.mlod_aNormals[0];
+    // mark this mesh as in object space
+    rmsh.rmsh_bTransToViewSpace = FALSE;
   }
 }
 
@@ -2456,6 +2845,175 @@ BOOL RM_GetBoneAbsPosition(CModelInstance &mi,INDEX iBoneID, FLOAT3D &vStartPoin
   return FALSE;
 }
 
+// [Cecil] Current state of animations of a renmodel
+static CStaticStackArray<UBYTE> _aubPoseKey;
+
+template<class Type> static inline
+void AddToPoseKey(const Type &val) {
+  memcpy(_aubPoseKey.Push(sizeof(Type)), &val, sizeof(Type));
+};
+
+// [Cecil] Gather everything that determines the animated pose of a renmodel
+static void MakePoseKey(const RenModel &rm)
+{
+  _aubPoseKey.PopAll();
+  CModelInstance &mi = *rm.rm_pmiModel;
+
+  // Default pose of the skeleton lod
+  AddToPoseKey(mi.mi_psklSkeleton);
+  AddToPoseKey(rm.rm_iSkeletonLODIndex);
+  AddToPoseKey(rm.rm_ctBones);
+
+  // Morph maps of mesh lods
+  AddToPoseKey(rm.rm_ctMeshes);
+
+  for (INDEX irmsh = rm.rm_iFirstMesh; irmsh < rm.rm_iFirstMesh + rm.rm_ctMeshes; irmsh++) {
+    const RenMesh &rmsh = _aRenMesh[irmsh];
+    AddToPoseKey(rmsh.rmsh_pMeshInst->mi_pMesh);
+    AddToPoseKey(rmsh.rmsh_iMeshLODIndex);
+    AddToPoseKey(rmsh.rmsh_ctMorphs);
+  }
+
+  // Available animations
+  const INDEX ctas = mi.mi_aAnimSet.Count();
+  AddToPoseKey(ctas);
+
+  for (INDEX ias = 0; ias < ctas; ias++) {
+    AddToPoseKey(mi.mi_aAnimSet.Pointer(ias));
+  }
+
+  // Time of the frame
+  AddToPoseKey(_pTimer->GetLerpedCurrentSec());
+
+  // Animation queue
+  const INDEX ctal = mi.mi_aqAnims.aq_Lists.Count();
+  AddToPoseKey(ctal);
+
+  for (INDEX ial = 0; ial < ctal; ial++) {
+    AnimList &al = mi.mi_aqAnims.aq_Lists[ial];
+    AddToPoseKey(al.al_tmStartTime);
+    AddToPoseKey(al.al_tmFadeTime);
+
+    const INDEX ctpa = al.al_PlayedAnims.Count();
+    AddToPoseKey(ctpa);
+
+    for (INDEX ipa = 0; ipa < ctpa; ipa++) {
+      const PlayedAnim &pa = al.al_PlayedAnims[ipa];
+      AddToPoseKey(pa.pa_tmStartTime);
+      AddToPoseKey(pa.pa_tmSpeedMul);
+      AddToPoseKey(pa.pa_iAnimID);
+      AddToPoseKey(pa.pa_ulFlags);
+      AddToPoseKey(pa.pa_Strength);
+    }
+  }
+};
+
+// [Cecil] Reuse one of the last matched poses of a renmodel if its animation state hasn't changed
+static BOOL RestorePose(RenModel &rm)
+{
+  ModelPoseCache &mpc = rm.rm_pmiModel->mi_mpcPose;
+  const INDEX ctKey = _aubPoseKey.Count();
+
+  // Lods are a part of the key, so each lod that the model is rendered at finds its own pose
+  INDEX ipose = 0;
+
+  for (; ipose < MAX_CACHED_POSES; ipose++) {
+    const ModelPose &mp = mpc.mpc_aPoses[ipose];
+    if (mp.mp_aubKey.Count() == ctKey && memcmp(&mp.mp_aubKey[0], &_aubPoseKey[0], ctKey) == 0) break;
+  }
+
+  if (ipose >= MAX_CACHED_POSES) return FALSE;
+
+  mpc.mpc_iLastUsed = ipose;
+  const ModelPose &mp = mpc.mpc_aPoses[ipose];
+
+  // Amounts of bones and morphs are a part of the key
+  for (INDEX irb = 0; irb < rm.rm_ctBones; irb++) {
+    RenBone &rb = _aRenBones[rm.rm_iFirstBone + irb];
+    rb.rb_apPos = mp.mp_aapBones[irb];
+    rb.rb_arRot = mp.mp_aarBones[irb];
+  }
+
+  INDEX iFactor = 0;
+
+  for (INDEX irmsh = rm.rm_iFirstMesh; irmsh < rm.rm_iFirstMesh + rm.rm_ctMeshes; irmsh++) {
+    const RenMesh &rmsh = _aRenMesh[irmsh];
+
+    for (INDEX irmp = rmsh.rmsh_iFirstMorph; irmp < rmsh.rmsh_iFirstMorph + rmsh.rmsh_ctMorphs; irmp++) {
+      _aRenMorph[irmp].rmp_fFactor = mp.mp_afMorphs[iFactor++];
+    }
+  }
+
+  return TRUE;
+};
+
+template<class Type> static inline
+void ResizePoseArray(CStaticArray<Type> &a, INDEX ct) {
+  if (a.Count() == ct) return;
+
+  a.Clear();
+  a.New(ct);
+};
+
+// [Cecil] Remember the pose that has just been matched for a renmodel in place of the one that has been used the least recently
+static void StorePose(RenModel &rm)
+{
+  ModelPoseCache &mpc = rm.rm_pmiModel->mi_mpcPose;
+  mpc.mpc_iLastUsed = (mpc.mpc_iLastUsed + 1) % MAX_CACHED_POSES;
+  ModelPose &mp = mpc.mpc_aPoses[mpc.mpc_iLastUsed];
+
+  INDEX ctMorphs = 0;
+
+  for (INDEX irmsh = rm.rm_iFirstMesh; irmsh < rm.rm_iFirstMesh + rm.rm_ctMeshes; irmsh++) {
+    ctMorphs += _aRenMesh[irmsh].rmsh_ctMorphs;
+  }
+
+  ResizePoseArray(mp.mp_aubKey, _aubPoseKey.Count());
+  ResizePoseArray(mp.mp_aapBones, rm.rm_ctBones);
+  ResizePoseArray(mp.mp_aarBones, rm.rm_ctBones);
+  ResizePoseArray(mp.mp_afMorphs, ctMorphs);
+
+  memcpy(&mp.mp_aubKey[0], &_aubPoseKey[0], _aubPoseKey.Count());
+
+  for (INDEX irb = 0; irb < rm.rm_ctBones; irb++) {
+    const RenBone &rb = _aRenBones[rm.rm_iFirstBone + irb];
+    mp.mp_aapBones[irb] = rb.rb_apPos;
+    mp.mp_aarBones[irb] = rb.rb_arRot;
+  }
+
+  INDEX iFactor = 0;
+
+  for (INDEX irmsh = rm.rm_iFirstMesh; irmsh < rm.rm_iFirstMesh + rm.rm_ctMeshes; irmsh++) {
+    const RenMesh &rmsh = _aRenMesh[irmsh];
+
+    for (INDEX irmp = rmsh.rmsh_iFirstMorph; irmp < rmsh.rmsh_iFirstMorph + rmsh.rmsh_ctMorphs; irmp++) {
+      mp.mp_afMorphs[iFactor++] = _aRenMorph[irmp].rmp_fFactor;
+    }
+  }
+};
+
+// [Cecil] Match animations of a renmodel or reuse one of its last poses
+// (only the animated pose is cached; bone transforms are still calculated from it every time)
+static void MatchCachedAnims(RenModel &rm)
+{
+  if (!ska_bCachePoses) {
+    MatchAnims(rm);
+    return;
+  }
+
+  MakePoseKey(rm);
+
+  if (RestorePose(rm)) {
+    _sfStats.IncrementCounter(CStatForm::SCI_SKAPOSEHITS);
+    return;
+  }
+
+  _sfStats.IncrementCounter(CStatForm::SCI_SKAPOSEMISSES);
+
+  MatchAnims(rm);
+  StorePose(rm);
+};
+
 // Calculate complete rendering data for model instance
 static void CalculateRenderingData(CModelInstance &mi)
 {
@@ -2463,6 +3021,9 @@ static void CalculateRenderingData(CModelInstance &mi)
   // distance to model is z param in objtoview matrix 
   _fDistanceFactor = -_mObjToView[11];
 
+  // [Cecil] Vertices prepared for the previous hierarchy are no longer valid
+  _aSkinnedMeshes.PopAll();
+
   // create first dummy model that serves as parent for the entire hierarchy
   MakeRootModel();
   // build entire hierarchy with children
@@ -2472,7 +3033,7 @@ static void CalculateRenderingData(CModelInstance &mi)
   // for each renmodel 
   for(int irm=1;irm<ctrm;irm++) {
     // match model animations
-    MatchAnims(_aRenModels[irm]);
+    MatchCachedAnims(_aRenModels[irm]); // [Cecil]
   }
   // Calculate transformations for all bones on already built hierarchy
   CalculateBoneTransforms();
@@ -2481,11 +3042,15 @@ static void CalculateRenderingData(CModelInstance &mi)
 // Render one SKA model with its children
 void RM_RenderSKA(CModelInstance &mi)
 {
+  CMemoryTagScope mtsSka(MEM_SKA); // [Cecil] Count memory allocated while rendering SKA data
   // Calculate all rendering data for this model instance
   //if( _iRenderingType==2) CalculateRenderingData( mi, 0);
   //else 
   CalculateRenderingData(mi);
 
+  // [Cecil] Prepare vertices of all meshes at once (shadow masks always transform boneless models)
+  SkinAllMeshes(_iRenderingType == 2 ? TRUE : _bTransformBonelessModelToViewSpace);
+
   // for each renmodel
   INDEX ctrmsh = _aRenModels.Count();
   for(int irmsh=1;irmsh<ctrmsh;irmsh++) {
@@ -2576,7 +3141,113 @@ static void ClearRenArrays()
   _aRenMesh.PopAll();
   _aRenWeights.PopAll();
   _aRenMorph.PopAll();
+  _aSkinnedMeshes.PopAll(); // [Cecil]
   _fCustomMlodDistance = -1;
   _fCustomSlodDistance = -1;
 }
 
+
+// [Cecil] Prepare all meshes of the currently calculated hierarchy and gather their final vertices
+static void PrepareAllMeshes(CStaticStackArray<MeshVertex> &avVertices, CStaticStackArray<MeshNormal> &anNormals)
+{
+  avVertices.PopAll();
+  anNormals.PopAll();
+
+  INDEX ctrmsh = _aRenModels.Count();
+  for(int irmsh=1;irmsh<ctrmsh;irmsh++) {
+    RenModel &rm = _aRenModels[irmsh];
+    INDEX ctmsh = rm.rm_iFirstMesh + rm.rm_ctMeshes;
+
+    for(int imsh=rm.rm_iFirstMesh;imsh<ctmsh;imsh++) {
+      PrepareMeshForRendering(_aRenMesh[imsh], rm.rm_iSkeletonLODIndex);
+
+      if (_ctFinalVertices > 0) {
+        memcpy(avVertices.Push(_ctFinalVertices), _pavFinalVertices, _ctFinalVertices * sizeof(MeshVertex));
+        memcpy(anNormals.Push(_ctFinalVertices), _panFinalNormals, _ctFinalVertices * sizeof(MeshNormal));
+      }
+    }
+  }
+}
+
+// [Cecil] Skin some SKA model many times with and without fast skinning and compare the results
+void BenchmarkSkinning(void *pArgs)
+{
+  const CTString strModel = *NEXTARGUMENT(CTString *);
+  const INDEX ctInstances = Clamp(NEXTARGUMENT(INDEX), (INDEX)1, (INDEX)100000);
+
+  CModelInstance *pmi = NULL;
+
+  try {
+    pmi = ObtainModelInstance_t(strModel);
+  } catch (char *strError) {
+    CPrintF(TRANS("Cannot load model: %s\n"), strError);
+    return;
+  }
+
+  // play the first animation to move the bones
+  if (pmi->mi_aAnimSet.Count() > 0 && pmi->mi_aAnimSet[0].as_Anims.Count() > 0) {
+    pmi->AddAnimation(pmi->mi_aAnimSet[0].as_Anims[0].an_iID, AN_LOOPING, 1.0f, 0);
+  }
+
+  const BOOL bOldTransform = _bTransformBonelessModelToViewSpace;
+  const INDEX bOldFast = ska_bFastSkinning;
+  _bTransformBonelessModelToViewSpace = TRUE;
+
+  // prepare the model in the highest quality in front of the viewer
+  RM_SetObjectPlacement(CPlacement3D(FLOAT3D(0.0f, 0.0f, -5.0f), ANGLE3D(0.0f, 0.0f, 0.0f)));
+  MakeIdentityMatrix(_mAbsToViewer);
+  RM_SetCurrentDistance(0);
+  CalculateRenderingData(*pmi);
+
+  CStaticStackArray<MeshVertex> avReference, avFast;
+  CStaticStackArray<MeshNormal> anReference, anFast;
+
+  // skin meshes one by one without SIMD
+  ska_bFastSkinning = FALSE;
+  CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+
+  for (INDEX i = 0; i < ctInstances; i++) {
+    PrepareAllMeshes(avReference, anReference);
+  }
+
+  const DOUBLE dReference = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+
+  // skin all meshes at once using job threads
+  ska_bFastSkinning = TRUE;
+  tvStart = _pTimer->GetHighPrecisionTimer();
+
+  for (INDEX i = 0; i < ctInstances; i++) {
+    SkinAllMeshes(TRUE);
+    PrepareAllMeshes(avFast, anFast);
+  }
+
+  const DOUBLE dFast = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+
+  // compare coordinates bit by bit
+  const INDEX ctVertices = avReference.Count();
+  INDEX ctMismatches = 0;
+
+  if (avFast.Count() != ctVertices) {
+    ctMismatches = ctVertices;
+
+  } else {
+    for (INDEX iVtx = 0; iVtx < ctVertices; iVtx++) {
+      if (memcmp(&avReference[iVtx].x, &avFast[iVtx].x, sizeof(FLOAT) * 3) != 0
+       || memcmp(&anReference[iVtx].nx, &anFast[iVtx].nx, sizeof(FLOAT) * 3) != 0) {
+        ctMismatches++;
+      }
+    }
+  }
+
+  ClearRenArrays();
+  ska_bFastSkinning = bOldFast;
+  _bTransformBonelessModelToViewSpace = bOldTransform;
+
+  DeleteModelInstance(pmi);
+
+  CPrintF(TRANS("Skinned %d instances of '%s' (%d vertices each) on %d threads:\n"),
+    ctInstances, strModel.ConstData(), ctVertices, IJobs::GetThreadCount());
+  CPrintF(TRANS("  reference:     %.2f ms (%.2f us per instance)\n"), dReference * 1000.0, dReference * 1e6 / ctInstances);
+  CPrintF(TRANS("  fast skinning: %.2f ms (%.2f us per instance)\n"), dFast * 1000.0, dFast * 1e6 / ctInstances);
+  CPrintF(TRANS("  mismatching vertices: %d\n"), ctMismatches);
+}
@@ -206,6 +206,7 @@ void CSkeleton::Write_t(CTStream *ostrFile)
 // read from stream
 void CSkeleton::Read_t(CTStream *istrFile)
 {
+  CMemoryTagScope mtsSka(MEM_SKA); // [Cecil] Count memory allocated while loading SKA data
   INDEX iFileVersion;
   INDEX ctslods;
   // read chunk id
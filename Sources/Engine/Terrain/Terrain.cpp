@@ -25,14 +25,23 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Terrain/TerrainRender.h>
 #include <Engine/Terrain/TerrainEditing.h>
 #include <Engine/Terrain/TerrainMisc.h>
+#include <Engine/Terrain/TerrainRayCasting.h>
 #include <Engine/Templates/Stock_CTextureData.h>
 #include <Engine/Entities/Entity.h>
 #include <Engine/Entities/ShadingInfo.h>
 #include <Engine/Graphics/Font.h>
 #include <Engine/Base/Console.h>
+#include <Engine/Base/Jobs.h>
+#include <Engine/Network/Network.h>
+#include <Engine/World/World.h>
 #include <Engine/Rendering/Render.h>
 
 extern CTerrain *_ptrTerrain;
+extern FLOAT3D _vViewerAbs;
+extern INDEX ter_bParallelRegen; // [Cecil]
+
+// [Cecil] Tiles that are being regenerated
+static CStaticStackArray<INDEX> _aiRegenTiles;
 
 static INDEX _iTerrainVersion = 9;   // Current terrain version
 static INDEX ctGeneratedTopMaps = 0; // TEMP
@@ -300,6 +309,8 @@ void CTerrain::ReBuildTerrain(BOOL bDelayTileRegen/*=FALSE*/)
   BuildTerrainData();
   // Build terrain quadtree
   BuildQuadTree();
+  // [Cecil] Build height bounds for ray casting
+  BuildTerrainHeightBounds(this);
   // Generate global top map
   GenerateTerrainTopMap();
   // Clear current regen list
@@ -957,6 +968,69 @@ static void AddTileLayerToTopMap(CTerrain *ptrTerrain, INDEX iTileIndex, INDEX i
   }
 }
 
+// [Cecil] Layer that's being blended into a top map
+struct TopMapLayer_t {
+  ULONG *pulTexDst;        // First texel in destination texture
+  PIX pixWidth;            // Width of destination texture
+  ULONG *pulFirstInMipSrc; // First texel in source texture mipmap
+  INDEX iSrcMipWidth;
+  UBYTE *ubFirstInMask;    // First byte in layer mask
+  UBYTE *ubFirstInEdgeMap; // First byte in edge map
+  INDEX iMaskWidth;
+  SLONG xHMaskStep;
+  SLONG xVMaskStep;
+};
+
+// [Cecil] Blend a range of top map rows with a layer
+static void BlendTopMapRows(void *pvLayer, INDEX iFirst, INDEX ct, INDEX iThread)
+{
+  const TopMapLayer_t &tml = *(const TopMapLayer_t *)pvLayer;
+  const INDEX iMaskWidth = tml.iMaskWidth;
+  const INDEX iSrcMipWidth = tml.iSrcMipWidth;
+
+  // for each row
+  for(UINT ir=iFirst;ir<UINT(iFirst+ct);ir++)
+  {
+    // position in mask is advanced by the same step for each row
+    SLONG xMaskVPos = tml.xVMaskStep * (SLONG)ir;
+    ULONG *pulTexDst = tml.pulTexDst + ir * tml.pixWidth;
+
+    // get first byte for src mip texture in this row
+    ULONG *pulSrcRow = &tml.pulFirstInMipSrc[(ir&(iSrcMipWidth-1))*iSrcMipWidth];//%
+    INDEX iMaskVPos = (INDEX)(xMaskVPos>>16) * (iMaskWidth);
+    UBYTE *pubMaskRow = &tml.ubFirstInMask[iMaskVPos];
+    UBYTE *pubEdgeMaskRow = &tml.ubFirstInEdgeMap[iMaskVPos];
+    SLONG xMaskHPos = 0;
+    // for each column
+    for(UINT ic=0;ic<(UINT)tml.pixWidth;ic++)
+    {
+      ULONG *ulSrc = &pulSrcRow[ic&(iSrcMipWidth-1)];
+      INDEX iMask = (INDEX)(xMaskHPos>>16);
+
+      SLONG x1 = (SLONG)(pubMaskRow[iMask+0]) <<0; //NormByteToFixInt(pubMaskRow[iMask]);
+      SLONG x2 = (SLONG)(pubMaskRow[iMask+1]) <<0; //NormByteToFixInt(pubMaskRow[iMask+1]);
+      SLONG x3 = (SLONG)(pubMaskRow[iMask+iMaskWidth+0]) <<0;//NormByteToFixInt(pubMaskRow[iMask+iMaskWidth+0]);
+      SLONG x4 = (SLONG)(pubMaskRow[iMask+iMaskWidth+1]) <<0;//NormByteToFixInt(pubMaskRow[iMask+iMaskWidth+1]);
+      SLONG xFactH = xMaskHPos - (xMaskHPos&0xFFFF0000);
+      SLONG xFactV = xMaskVPos - (xMaskVPos&0xFFFF0000);
+      
+      SLONG xStrengthX1 = (x1<<7) + (SLONG)(((x2-x1)*xFactH)>>9); //Lerp(fi1,fi2,fiFactH);
+      SLONG xStrengthX2 = (x3<<7) + (SLONG)(((x4-x3)*xFactH)>>9); //Lerp(fi3,fi4,fiFactH);
+      SLONG xStrength   = (xStrengthX1<<1) + (SLONG)((((xStrengthX2>>0)-(xStrengthX1>>0))*xFactV)>>15);   //Lerp(fiStrengthX1,fiStrengthX2,fiFactV);
+      
+      GFXColor *pcolSrc = (GFXColor*)pulTexDst;
+      GFXColor *pcolDst = (GFXColor*)ulSrc;
+      pcolSrc->r = (UBYTE)( (ULONG)pcolSrc->r + ((((ULONG)pcolDst->r - (ULONG)pcolSrc->r) * xStrength)>>16));
+      pcolSrc->g = (UBYTE)( (ULONG)pcolSrc->g + ((((ULONG)pcolDst->g - (ULONG)pcolSrc->g) * xStrength)>>16));
+      pcolSrc->b = (UBYTE)( (ULONG)pcolSrc->b + ((((ULONG)pcolDst->b - (ULONG)pcolSrc->b) * xStrength)>>16));
+      pcolSrc->a = pubEdgeMaskRow[iMask];
+      
+      pulTexDst++;
+      xMaskHPos += tml.xHMaskStep;
+    }
+  }
+}
+
 void CTerrain::UpdateTopMap(INDEX iTileIndex, Rect *prcDest/*=NULL*/)
 {
   //ReGenerateTopMap(this, iTileIndex);
@@ -1051,53 +1125,19 @@ void CTerrain::UpdateTopMap(INDEX iTileIndex, Rect *prcDest/*=NULL*/)
     FIX16_16 fiHMaskStep = FIX16_16(iMaskWidth-1) / FIX16_16(ptdDest->GetWidth()-1) / fiMaskDiv;
     FIX16_16 fiVMaskStep = FIX16_16(iMaskWidth-1) / FIX16_16(ptdDest->GetWidth()-1) / fiMaskDiv;
 
-    SLONG xHMaskStep = fiHMaskStep.slHolder;
-    SLONG xVMaskStep = fiVMaskStep.slHolder;
-    SLONG xMaskVPos=0;
-    
-    // get first byte in destination texture
-    ULONG *pulTexDst = (ULONG*)&ptdDest->td_pulFrames[0];
-    // get first byte in source texture
-    ULONG *pulFirstInMipSrc = (ULONG*)&ptdSrc->td_pulFrames[iMipAdr];
-  
-    // for each row
-    for(UINT ir=0;ir<ptdDest->GetPixHeight();ir++)
-    {
-      // get first byte for src mip texture in this row
-      ULONG *pulSrcRow = &pulFirstInMipSrc[(ir&(iSrcMipWidth-1))*iSrcMipWidth];//%
-      INDEX iMaskVPos = (INDEX)(xMaskVPos>>16) * (iMaskWidth);
-      UBYTE *pubMaskRow = &ubFirstInMask[iMaskVPos];
-      UBYTE *pubEdgeMaskRow = &ubFirstInEdgeMap[iMaskVPos];
-      SLONG xMaskHPos = 0;
-      // for each column
-      for(UINT ic=0;ic<ptdDest->GetPixWidth();ic++)
-      {
-        ULONG *ulSrc = &pulSrcRow[ic&(iSrcMipWidth-1)];
-        INDEX iMask = (INDEX)(xMaskHPos>>16);
+    // [Cecil] Blend rows of the layer in parallel
+    TopMapLayer_t tml;
+    tml.pulTexDst = (ULONG*)&ptdDest->td_pulFrames[0];
+    tml.pixWidth = ptdDest->GetPixWidth();
+    tml.pulFirstInMipSrc = (ULONG*)&ptdSrc->td_pulFrames[iMipAdr];
+    tml.iSrcMipWidth = iSrcMipWidth;
+    tml.ubFirstInMask = ubFirstInMask;
+    tml.ubFirstInEdgeMap = ubFirstInEdgeMap;
+    tml.iMaskWidth = iMaskWidth;
+    tml.xHMaskStep = fiHMaskStep.slHolder;
+    tml.xVMaskStep = fiVMaskStep.slHolder;
 
-        SLONG x1 = (SLONG)(pubMaskRow[iMask+0]) <<0; //NormByteToFixInt(pubMaskRow[iMask]);
-        SLONG x2 = (SLONG)(pubMaskRow[iMask+1]) <<0; //NormByteToFixInt(pubMaskRow[iMask+1]);
-        SLONG x3 = (SLONG)(pubMaskRow[iMask+iMaskWidth+0]) <<0;//NormByteToFixInt(pubMaskRow[iMask+iMaskWidth+0]);
-        SLONG x4 = (SLONG)(pubMaskRow[iMask+iMaskWidth+1]) <<0;//NormByteToFixInt(pubMaskRow[iMask+iMaskWidth+1]);
-        SLONG xFactH = xMaskHPos - (xMaskHPos&0xFFFF0000);
-        SLONG xFactV = xMaskVPos - (xMaskVPos&0xFFFF0000);
-        
-        SLONG xStrengthX1 = (x1<<7) + (SLONG)(((x2-x1)*xFactH)>>9); //Lerp(fi1,fi2,fiFactH);
-        SLONG xStrengthX2 = (x3<<7) + (SLONG)(((x4-x3)*xFactH)>>9); //Lerp(fi3,fi4,fiFactH);
-        SLONG xStrength   = (xStrengthX1<<1) + (SLONG)((((xStrengthX2>>0)-(xStrengthX1>>0))*xFactV)>>15);   //Lerp(fiStrengthX1,fiStrengthX2,fiFactV);
-        
-        GFXColor *pcolSrc = (GFXColor*)pulTexDst;
-        GFXColor *pcolDst = (GFXColor*)ulSrc;
-        pcolSrc->r = (UBYTE)( (ULONG)pcolSrc->r + ((((ULONG)pcolDst->r - (ULONG)pcolSrc->r) * xStrength)>>16));
-        pcolSrc->g = (UBYTE)( (ULONG)pcolSrc->g + ((((ULONG)pcolDst->g - (ULONG)pcolSrc->g) * xStrength)>>16));
-        pcolSrc->b = (UBYTE)( (ULONG)pcolSrc->b + ((((ULONG)pcolDst->b - (ULONG)pcolSrc->b) * xStrength)>>16));
-        pcolSrc->a = pubEdgeMaskRow[iMask];
-        
-        pulTexDst++;
-        xMaskHPos += xHMaskStep;
-      }
-      xMaskVPos += xVMaskStep;
-    }
+    IJobs::ParallelFor(ptdDest->GetPixHeight(), 16, BlendTopMapRows, &tml);
   }
   // make mipmaps
   INDEX ctMipMaps = GetNoOfMipmaps(ptdDest->GetPixWidth(),ptdDest->GetPixHeight());
@@ -1636,6 +1676,16 @@ void CTerrain::UpdateQuadTree()
  * Generation
  */ 
 
+// [Cecil] Generate geometry of a range of tiles that are being regenerated
+static void ReGenerateGeometryJob(void *pvTerrain, INDEX iFirst, INDEX ct, INDEX iThread)
+{
+  CTerrain *ptr = (CTerrain *)pvTerrain;
+
+  for(INDEX i=iFirst;i<iFirst+ct;i++) {
+    ptr->tr_attTiles[_aiRegenTiles[i]].ReGenerateGeometry();
+  }
+}
+
 void CTerrain::ReGenerate(void)
 {
   // for each tile in terrain
@@ -1655,23 +1705,118 @@ void CTerrain::ReGenerate(void)
     tt.AddFlag(TT_REGENERATE);
   }
 
-  // for each tile that is waiting in regen queue
+  // [Cecil] Gather each tile from the queue once and prepare its arrays
+  _aiRegenTiles.PopAll();
+
   for(irt=0;irt<ctrt;irt++) {
     INDEX iTileIndex = tr_auiRegenList[irt];
     CTerrainTile &tt = tr_attTiles[iTileIndex];
     // if tile needs to be regenerated
     if(tt.GetFlags() & TT_REGENERATE) {
-      // Regenerate it now
-      ReGenerateTile(tt.tt_iIndex);
+      tt.PrepareReGenerate();
       // remove flag for regeneration
       tt.RemoveFlag(TT_REGENERATE);
+      _aiRegenTiles.Push() = iTileIndex;
+    }
+  }
+
+  // [Cecil] Generate geometry of all tiles at once
+  const INDEX ctRegen = _aiRegenTiles.Count();
+
+  if(ctRegen>0) {
+    if(ter_bParallelRegen) {
+      IJobs::ParallelFor(ctRegen, 1, ReGenerateGeometryJob, this);
+    } else {
+      ReGenerateGeometryJob(this, 0, ctRegen, 0);
     }
   }
 
+  // [Cecil] Update shared data in queue order
+  for(INDEX irg=0;irg<ctRegen;irg++) {
+    tr_attTiles[_aiRegenTiles[irg]].FinishReGenerate();
+  }
+
   // clear regenration list
   ClearRegenList();
 }
 
+// [Cecil] Measure time of regenerating tiles while flying across terrains of the current world
+void BenchmarkTerrainRegen(INDEX ctFrames)
+{
+  CWorld *pwo = _pwoCurrentWorld;
+
+  if (pwo == NULL) {
+    CPrintF(TRANS("No world is currently loaded!\n"));
+    return;
+  }
+
+  ctFrames = Clamp(ctFrames, (INDEX)2, (INDEX)100000);
+
+  CDynamicContainer<CTerrain> cTerrains;
+
+  {FOREACHINDYNAMICCONTAINER(pwo->wo_cenEntities, CEntity, iten) {
+    if (iten->GetRenderType() == CEntity::RT_TERRAIN && iten->GetTerrain() != NULL) {
+      cTerrains.Add(iten->GetTerrain());
+    }
+  }}
+
+  if (cTerrains.Count() == 0) {
+    CPrintF(TRANS("No terrains in the world!\n"));
+    return;
+  }
+
+  CSetFPUPrecision FPUPrecision(FPT_24BIT);
+
+  CTerrain *ptrOld = _ptrTerrain;
+  const FLOAT3D vOldViewer = _vViewerAbs;
+  const INDEX bOldParallel = ter_bParallelRegen;
+
+  CPrintF(TRANS("Regenerating tiles of %d terrains over %d frames using %d threads...\n"),
+    cTerrains.Count(), ctFrames, IJobs::GetThreadCount());
+
+  for (INDEX iPass = 0; iPass < 2; iPass++) {
+    ter_bParallelRegen = (iPass == 1);
+
+    DOUBLE dTotal = 0.0;
+    DOUBLE dPeak = 0.0;
+    INDEX ctTiles = 0;
+
+    FOREACHINDYNAMICCONTAINER(cTerrains, CTerrain, ittr) {
+      CTerrain &tr = *ittr;
+      _ptrTerrain = &tr;
+
+      // start from the highest lod everywhere
+      tr.AddAllTilesToRegenQueue();
+      _vViewerAbs = FLOAT3D(0.0f, tr.tr_vTerrainSize(2), 0.0f);
+      tr.ReGenerate();
+
+      // fly diagonally across the terrain
+      for (INDEX iFrame = 0; iFrame < ctFrames; iFrame++) {
+        const FLOAT fRatio = FLOAT(iFrame) / FLOAT(ctFrames - 1);
+        _vViewerAbs = FLOAT3D(tr.tr_vTerrainSize(1) * fRatio, tr.tr_vTerrainSize(2), tr.tr_vTerrainSize(3) * fRatio);
+
+        CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+        tr.ReGenerate();
+        const DOUBLE dFrame = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds() * 1000.0;
+
+        dTotal += dFrame;
+        dPeak = Max(dPeak, dFrame);
+        ctTiles += _aiRegenTiles.Count();
+      }
+
+      // lods are recalculated with the real viewer on the next render
+      tr.AddFlag(TR_REGENERATE);
+    }
+
+    CPrintF(TRANS("  %s: %.3f ms per frame (peak %.3f ms), %.1f tiles per frame\n"),
+      (iPass == 1) ? "Parallel" : "Serial  ", dTotal / ctFrames, dPeak, FLOAT(ctTiles) / ctFrames);
+  }
+
+  ter_bParallelRegen = bOldParallel;
+  _vViewerAbs = vOldViewer;
+  _ptrTerrain = ptrOld;
+}
+
 extern CStaticStackArray<GFXVertex4> _avLerpedVerices;
 static void ShowTerrainInfo(CAnyProjection3D &apr, CDrawPort *pdp, CTerrain *ptrTerrain)
 {
@@ -1996,6 +2141,9 @@ void CTerrain::ClearHeightMap(void)
     FreeMemory(tr_auwHeightMap);
     tr_auwHeightMap = NULL;
   }
+
+  // [Cecil] Height bounds are invalid without the height map
+  tr_auwHeightBounds.Clear();
 }
 
 // Clear shadow map
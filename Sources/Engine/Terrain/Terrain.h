@@ -268,6 +268,7 @@ public:
   CStaticStackArray<class CTerrainLayer> tr_atlLayers;          // Array of terrain layers
   CDynamicContainer<class CTextureData>  tr_atdTopMaps;         // Array of top maps for each tile array (used by ArrayHolder)
   CStaticStackArray<INDEX>               tr_auiRegenList;       // List of tiles that need to be regenerated
+  CStaticStackArray<UWORD>               tr_auwHeightBounds;    // [Cecil] Min and max heights of quad blocks for ray casting
 
   /* Do not change any of this params directly */
   UWORD  *tr_auwHeightMap;        // Terrain height map
@@ -18,6 +18,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Terrain/TerrainRender.h>
 #include <Engine/Terrain/TerrainEditing.h>
 #include <Engine/Terrain/TerrainMisc.h>
+#include <Engine/Terrain/TerrainRayCasting.h>
 #include <Engine/Entities/Entity.h>
 
 extern FLOAT3D   _vViewerAbs; // Viewer pos 
@@ -259,6 +260,8 @@ static void UpdateEditedTerrainTiles(CTerrain *ptrTerrain, Rect &rcExtract, Buff
   if(btBufferType == BT_HEIGHT_MAP) {
     AddFlagsToTilesInRect(ptrTerrain, rcExtract, TT_NO_LODING|TT_QUADTREENODE_REGEN, TRUE);
     UpdateShadowMapRect(ptrTerrain, rcExtract);
+    // [Cecil] Update height bounds for ray casting
+    UpdateTerrainHeightBounds(ptrTerrain, rcExtract);
 
   } else if(btBufferType == BT_LAYER_MASK) {
     AddFlagsToTilesInRect(ptrTerrain, rcExtract, TT_NO_LODING|TT_FORCE_TOPMAP_REGEN, TRUE);
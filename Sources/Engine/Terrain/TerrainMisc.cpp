@@ -27,6 +27,18 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Light/LightSource.h>
 #include <Engine/Rendering/Render.h>
 #include <Engine/Terrain/TerrainRayCasting.h>
+#include <Engine/Base/Jobs.h>
+#include <Engine/Templates/StaticStackArray.cpp>
+
+// [Cecil] SSE2 lighting kernel for builds without inline assembly
+#if !SE1_USE_ASM && !SE1_OLD_COMPILER
+  #include <emmintrin.h>
+  #define SE1_TERRAIN_SSE2 1
+#else
+  #define SE1_TERRAIN_SSE2 0
+#endif
+
+extern BOOL sys_bCPUHasSSE2; // [Cecil]
 
 /*
  * Terrain raycasting and colision 
@@ -572,7 +584,7 @@ void CreateTexture(CTextureData &tdTopMap, PIX pixWidth, PIX pixHeight,ULONG ulF
   // Allocate memory for top map
   INDEX ctMipMaps = GetNoOfMipmaps(pixWidth,pixHeight);
   SLONG slSize = GetMipmapOffset(ctMipMaps,pixWidth,pixHeight)*BYTES_PER_TEXEL;
-  tdTopMap.td_pulFrames = (ULONG*)AllocMemory(slSize);
+  tdTopMap.td_pulFrames = (ULONG*)AllocMemoryTagged(slSize, MEM_TEXTURES);
   tdTopMap.td_slFrameSize = slSize;
   tdTopMap.td_ctFrames = 1;
   tdTopMap.td_iFirstMipLevel = 0;
@@ -614,7 +626,7 @@ void PrepareSharedTopMapMemory(CTextureData *ptdTopMap, INDEX iTileIndex)
     // else
     } else {
       // Allocate new memory for global top map
-      ptdTopMap->td_pulFrames = (ULONG*)AllocMemory(slSize);
+      ptdTopMap->td_pulFrames = (ULONG*)AllocMemoryTagged(slSize, MEM_TEXTURES);
     }
   // else this is normal top map
   } else {
@@ -627,7 +639,7 @@ void PrepareSharedTopMapMemory(CTextureData *ptdTopMap, INDEX iTileIndex)
         _pulSharedTopMap = NULL;
       }
       // allocate new shared memory for top maps
-      _pulSharedTopMap = (ULONG*)AllocMemory(slSize);
+      _pulSharedTopMap = (ULONG*)AllocMemoryTagged(slSize, MEM_TEXTURES);
       // remember new memory size
       _slSharedTopMapSize = slSize;
     }
@@ -706,154 +718,285 @@ static FLOAT3D CalculateNormalFromPoint(FLOAT fPosX, FLOAT fPosZ, FLOAT3D *pvStr
   return vNormal;
 }
 
-static void CalcPointLight(CPlacement3D &plLight, CLightSource *plsLight, Rect &rcUpdate)
+// [Cecil] Light that affects the shadow map that's being updated
+struct ShadowLight_t {
+  Rect sl_rcUpdate;      // Affected part of the shadow map
+  BOOL sl_bDirectional;
+  FLOAT3D sl_vPosition;  // Position of a point light in terrain space
+  FLOAT sl_fHotSpot;
+  FLOAT sl_fFallOff;
+  FLOAT3D sl_vLightNormal; // Direction towards a directional light
+  GFXColor sl_colLight;
+  SLONG sl_slar, sl_slag, sl_slab; // Ambient of a directional light
+  UBYTE sl_ubColShift;
+
+  inline void Clear(void) {};
+};
+
+static CStaticStackArray<ShadowLight_t> _aslShadowLights;
+
+// [Cecil] Normals and positions of texels in one row of the shadow map per job thread
+static CStaticStackArray<FLOAT> _afShadowTexels[JOB_MAX_THREADS];
+
+// [Cecil] Components of texel normals and positions in a row
+enum ShadowTexel_e {
+  STX_NORMALX = 0, STX_NORMALY, STX_NORMALZ,
+  STX_POSX, STX_POSY, STX_POSZ,
+  STX_COUNT,
+};
+
+static void AddPointLight(const ShadowLight_t &sl, GFXColor *pacolRow, const FLOAT *pfTexels, PIX pixWidth, PIX pixFirst, PIX pixLast)
 {
-  FLOAT fSHDiffX = (FLOAT)_ptrTerrain->tr_pixHeightMapWidth  / _ptrTerrain->GetShadowMapWidth();
-  FLOAT fSHDiffZ = (FLOAT)_ptrTerrain->tr_pixHeightMapHeight / _ptrTerrain->GetShadowMapHeight();
+  const FLOAT *pfNX = pfTexels + STX_NORMALX * pixWidth;
+  const FLOAT *pfNY = pfTexels + STX_NORMALY * pixWidth;
+  const FLOAT *pfNZ = pfTexels + STX_NORMALZ * pixWidth;
+  const FLOAT *pfPX = pfTexels + STX_POSX * pixWidth;
+  const FLOAT *pfPY = pfTexels + STX_POSY * pixWidth;
+  const FLOAT *pfPZ = pfTexels + STX_POSZ * pixWidth;
+
+  for(PIX pix=pixFirst;pix<pixLast;pix++) {
+    FLOAT3D vNormal(pfNX[pix], pfNY[pix], pfNZ[pix]);
+    FLOAT3D vPosStr(pfPX[pix], pfPY[pix], pfPZ[pix]);
+
+    // Calculate normal from light position
+    FLOAT3D vDistance = vPosStr - sl.sl_vPosition;
+    FLOAT   fDistance = vDistance.Length();
+    FLOAT3D vLightNormal = -vDistance.Normalize();
+    GFXColor colLight = sl.sl_colLight;
+
+    // Calculate light intensity
+    FLOAT fIntensity = 1.0f;
+    if(fDistance>sl.sl_fFallOff) {
+      fIntensity = 0;
+    } else if(fDistance>sl.sl_fHotSpot) {
+      fIntensity = CalculateRatio(fDistance, sl.sl_fHotSpot, sl.sl_fFallOff, 0.0f, 1.0f);
+    }
+    ULONG ulIntensity = NormFloatToByte(fIntensity);
+    ulIntensity = (ulIntensity<<CT_RSHIFT)|(ulIntensity<<CT_GSHIFT)|(ulIntensity<<CT_BSHIFT);
+    colLight = MulColors(ByteSwap32(colLight.abgr), ulIntensity);
+
+    FLOAT fDot = vNormal%vLightNormal;
+    fDot = Clamp(fDot,0.0f,1.0f);
+    SLONG slDot = NormFloatToByte(fDot);
+
+    GFXColor *pacolData = pacolRow + pix;
+    pacolData->r = ClampUp(pacolData->r + ((colLight.r*slDot)>>8),255L);
+    pacolData->g = ClampUp(pacolData->g + ((colLight.g*slDot)>>8),255L);
+    pacolData->b = ClampUp(pacolData->b + ((colLight.b*slDot)>>8),255L);
+    pacolData->a = 255;
+  }
+}
 
-  PIX pixLeft   = rcUpdate.rc_iLeft;
-  PIX pixRight  = rcUpdate.rc_iRight;
-  PIX pixTop    = rcUpdate.rc_iTop;
-  PIX pixBottom = rcUpdate.rc_iBottom;
-  PIX pixWidth  = pixRight - pixLeft;
-  PIX pixStepX  = _ptrTerrain->GetShadowMapWidth()  - pixWidth;
-
-  // Get color pointer in shadow map
-  PIX       pixFirst   = pixLeft + pixTop*_ptrTerrain->GetShadowMapWidth();
-  GFXColor *pacolData  = (GFXColor*)&_ptrTerrain->tr_tdShadowMap.td_pulFrames[pixFirst];
-
-  // for each row in shadow map
-  for(PIX pixY=pixTop;pixY<pixBottom;pixY++) {
-    // for each in column
-    for(PIX pixX=pixLeft;pixX<pixRight;pixX++) {
-      FLOAT fPosX = (FLOAT)(pixX*fSHDiffX);
-      FLOAT fPosZ = (FLOAT)(pixY*fSHDiffZ);
+#if SE1_TERRAIN_SSE2
 
-      FLOAT3D vPosStr;
-      FLOAT3D vNormal = CalculateNormalFromPoint(fPosX,fPosZ,&vPosStr);
-      
-      // Calculate normal from light position
-      FLOAT3D vDistance = vPosStr - plLight.pl_PositionVector;
-      FLOAT   fDistance = vDistance.Length();
-      FLOAT3D vLightNormal = -vDistance.Normalize();
-      GFXColor colLight   = plsLight->GetLightColor();
-
-      // Calculate light intensity
-      FLOAT fIntensity = 1.0f;
-      FLOAT fFallOff   = plsLight->ls_rFallOff;
-      FLOAT fHotSpot   = plsLight->ls_rHotSpot;
-      if(fDistance>fFallOff) {
-        fIntensity = 0;
-      } else if(fDistance>fHotSpot) {
-        fIntensity = CalculateRatio(fDistance, fHotSpot, fFallOff, 0.0f, 1.0f);
-      }
-      ULONG ulIntensity = NormFloatToByte(fIntensity);
-      ulIntensity = (ulIntensity<<CT_RSHIFT)|(ulIntensity<<CT_GSHIFT)|(ulIntensity<<CT_BSHIFT);
-      colLight = MulColors(ByteSwap32(colLight.abgr), ulIntensity);
+// [Cecil] Add directional light to four texels at a time and return the first texel that's left
+static SE1_TARGET_SSE2 PIX AddDirectionalLightSSE2(const ShadowLight_t &sl, GFXColor *pacolRow, const FLOAT *pfTexels, PIX pixWidth, PIX pixFirst, PIX pixLast)
+{
+  const FLOAT *pfNX = pfTexels + STX_NORMALX * pixWidth;
+  const FLOAT *pfNY = pfTexels + STX_NORMALY * pixWidth;
+  const FLOAT *pfNZ = pfTexels + STX_NORMALZ * pixWidth;
+
+  const __m128 mLightX = _mm_set1_ps(sl.sl_vLightNormal(1));
+  const __m128 mLightY = _mm_set1_ps(sl.sl_vLightNormal(2));
+  const __m128 mLightZ = _mm_set1_ps(sl.sl_vLightNormal(3));
+  const __m128 m0 = _mm_setzero_ps();
+  const __m128 m1 = _mm_set1_ps(1.0f);
+  const __m128 m255 = _mm_set1_ps(255.0f);
+
+  const GFXColor &col = sl.sl_colLight;
+  const __m128i mColor = _mm_setr_epi16(col.r, col.g, col.b, 0, col.r, col.g, col.b, 0);
+  const __m128i mAmbient = _mm_setr_epi16(sl.sl_slar, sl.sl_slag, sl.sl_slab, 0, sl.sl_slar, sl.sl_slag, sl.sl_slab, 0);
+  const __m128i mShift = _mm_cvtsi32_si128(sl.sl_ubColShift);
+  const __m128i mAlpha = _mm_set1_epi32(0xFF000000);
+  const __m128i mZero = _mm_setzero_si128();
+
+  PIX pix = pixFirst;
+
+  for(; pix+4<=pixLast; pix+=4) {
+    // Same operation order as FLOAT3D::operator%
+    __m128 mDot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(pfNX + pix), mLightX),
+                                        _mm_mul_ps(_mm_loadu_ps(pfNY + pix), mLightY)),
+                                        _mm_mul_ps(_mm_loadu_ps(pfNZ + pix), mLightZ));
+    mDot = _mm_min_ps(_mm_max_ps(mDot, m0), m1);
+    const __m128i mDots = _mm_cvttps_epi32(_mm_mul_ps(mDot, m255));
+
+    // Spread each dot product over color channels of its texel
+    __m128i mDots16 = _mm_packs_epi32(mDots, mDots);
+    mDots16 = _mm_unpacklo_epi16(mDots16, mDots16);
+    const __m128i mDotsLo = _mm_unpacklo_epi32(mDots16, mDots16);
+    const __m128i mDotsHi = _mm_unpackhi_epi32(mDots16, mDots16);
+
+    __m128i *pmPixels = (__m128i *)(pacolRow + pix);
+    const __m128i mPixels = _mm_loadu_si128(pmPixels);
+    __m128i mLo = _mm_unpacklo_epi8(mPixels, mZero);
+    __m128i mHi = _mm_unpackhi_epi8(mPixels, mZero);
+
+    // Products fit into unsigned words and sums stay below the signed limit
+    mLo = _mm_add_epi16(mLo, _mm_add_epi16(mAmbient, _mm_srl_epi16(_mm_mullo_epi16(mColor, mDotsLo), mShift)));
+    mHi = _mm_add_epi16(mHi, _mm_add_epi16(mAmbient, _mm_srl_epi16(_mm_mullo_epi16(mColor, mDotsHi), mShift)));
+
+    _mm_storeu_si128(pmPixels, _mm_or_si128(_mm_packus_epi16(mLo, mHi), mAlpha));
+  }
 
+  return pix;
+}
 
-      FLOAT fDot = vNormal%vLightNormal;
-      fDot = Clamp(fDot,0.0f,1.0f);
-      SLONG slDot = NormFloatToByte(fDot);
+#endif // SE1_TERRAIN_SSE2
 
-      pacolData->r = ClampUp(pacolData->r + ((colLight.r*slDot)>>8),255L);
-      pacolData->g = ClampUp(pacolData->g + ((colLight.g*slDot)>>8),255L);
-      pacolData->b = ClampUp(pacolData->b + ((colLight.b*slDot)>>8),255L);
-      pacolData->a = 255;
-      pacolData++;
-    }
-    pacolData+=pixStepX;
+static void AddDirectionalLight(const ShadowLight_t &sl, GFXColor *pacolRow, const FLOAT *pfTexels, PIX pixWidth, PIX pixFirst, PIX pixLast)
+{
+#if SE1_TERRAIN_SSE2
+  if(sys_bCPUHasSSE2) {
+    pixFirst = AddDirectionalLightSSE2(sl, pacolRow, pfTexels, pixWidth, pixFirst, pixLast);
+  }
+#endif
+
+  const FLOAT *pfNX = pfTexels + STX_NORMALX * pixWidth;
+  const FLOAT *pfNY = pfTexels + STX_NORMALY * pixWidth;
+  const FLOAT *pfNZ = pfTexels + STX_NORMALZ * pixWidth;
+
+  for(PIX pix=pixFirst;pix<pixLast;pix++) {
+    FLOAT3D vNormal(pfNX[pix], pfNY[pix], pfNZ[pix]);
+
+    FLOAT fDot = vNormal%sl.sl_vLightNormal;
+    fDot = Clamp(fDot,0.0f,1.0f);
+    SLONG slDot = NormFloatToByte(fDot);
+
+    GFXColor *pacolData = pacolRow + pix;
+    pacolData->r = ClampUp(pacolData->r + sl.sl_slar + ((sl.sl_colLight.r*slDot)>>sl.sl_ubColShift),255L);
+    pacolData->g = ClampUp(pacolData->g + sl.sl_slag + ((sl.sl_colLight.g*slDot)>>sl.sl_ubColShift),255L);
+    pacolData->b = ClampUp(pacolData->b + sl.sl_slab + ((sl.sl_colLight.b*slDot)>>sl.sl_ubColShift),255L);
+    pacolData->a = 255;
   }
 }
 
-static void CalcDirectionalLight(CPlacement3D &plLight, CLightSource *plsLight, Rect &rcUpdate)
+// [Cecil] Clear and relight rows of the updated part of the shadow map
+static void UpdateShadowMapRows(void *pvRect, INDEX iFirst, INDEX ct, INDEX iThread)
 {
+  const Rect &rcUpdate = *(const Rect *)pvRect;
+
   FLOAT fSHDiffX = (FLOAT)_ptrTerrain->tr_pixHeightMapWidth  / _ptrTerrain->GetShadowMapWidth();
   FLOAT fSHDiffZ = (FLOAT)_ptrTerrain->tr_pixHeightMapHeight / _ptrTerrain->GetShadowMapHeight();
 
-  PIX pixLeft   = rcUpdate.rc_iLeft;
-  PIX pixRight  = rcUpdate.rc_iRight;
-  PIX pixTop    = rcUpdate.rc_iTop;
-  PIX pixBottom = rcUpdate.rc_iBottom;
-  PIX pixWidth  = pixRight - pixLeft;
-  PIX pixStepX  = _ptrTerrain->GetShadowMapWidth()  - pixWidth;
+  const PIX pixLeft  = rcUpdate.rc_iLeft;
+  const PIX pixRight = rcUpdate.rc_iRight;
+  const PIX pixWidth = pixRight - pixLeft;
 
-  // Get color pointer in shadow map
-  PIX       pixFirst   = pixLeft + pixTop*_ptrTerrain->GetShadowMapWidth();
-  GFXColor *pacolData  = (GFXColor*)&_ptrTerrain->tr_tdShadowMap.td_pulFrames[pixFirst];
+  CStaticStackArray<FLOAT> &afTexels = _afShadowTexels[iThread];
+  afTexels.PopAll();
+  FLOAT *pfTexels = afTexels.Push(pixWidth * STX_COUNT);
 
-  FLOAT3D vLightNormal;
-  GFXColor colLight   = plsLight->GetLightColor();
-  GFXColor colAmbient = plsLight->GetLightAmbient();
+  const INDEX ctLights = _aslShadowLights.Count();
 
-  UBYTE ubColShift = 8;
-  SLONG slar = colAmbient.r;
-  SLONG slag = colAmbient.g;
-  SLONG slab = colAmbient.b;
+  for(INDEX iRow=iFirst;iRow<iFirst+ct;iRow++) {
+    const PIX pixY = rcUpdate.rc_iTop + iRow;
 
-  extern INDEX mdl_bAllowOverbright;
-  BOOL bOverBrightning = mdl_bAllowOverbright && _pGfx->gl_ctTextureUnits>1;
+    // Get color pointer in shadow map
+    PIX       pixFirst = pixLeft + pixY*_ptrTerrain->GetShadowMapWidth();
+    GFXColor *pacolRow = (GFXColor*)&_ptrTerrain->tr_tdShadowMap.td_pulFrames[pixFirst];
 
-  // is overbrightning enabled
-  if(bOverBrightning) {
-    slar = ClampUp(slar,127L);
-    slag = ClampUp(slag,127L);
-    slab = ClampUp(slab,127L);
-    ubColShift = 8;
-  } else {
-    slar*=2;
-    slag*=2;
-    slab*=2;
-    ubColShift = 7;
-  }
+    // Clear part of shadow map that will be updated
+    memset(pacolRow, 0, pixWidth * sizeof(GFXColor));
 
-  // Calculate light normal
-  AnglesToDirectionVector(plLight.pl_OrientationAngle,vLightNormal);
-  vLightNormal *= !_ptrTerrain->tr_penEntity->en_mRotation;
-  vLightNormal = -vLightNormal.Normalize();
-
-  // for each row in shadow map
-  for(PIX pixY=pixTop;pixY<pixBottom;pixY++) {
-    // for each in column
-    for(PIX pixX=pixLeft;pixX<pixRight;pixX++) {
-      FLOAT fPosX = (FLOAT)(pixX*fSHDiffX);
+    // Calculate normals once for all lights
+    for(PIX pix=0;pix<pixWidth;pix++) {
+      FLOAT fPosX = (FLOAT)((pixLeft+pix)*fSHDiffX);
       FLOAT fPosZ = (FLOAT)(pixY*fSHDiffZ);
-      FLOAT3D vNormal = CalculateNormalFromPoint(fPosX,fPosZ);
 
-      FLOAT fDot = vNormal%vLightNormal;
-      fDot = Clamp(fDot,0.0f,1.0f);
-      SLONG slDot = NormFloatToByte(fDot);
+      FLOAT3D vPosStr;
+      FLOAT3D vNormal = CalculateNormalFromPoint(fPosX,fPosZ,&vPosStr);
+
+      pfTexels[STX_NORMALX*pixWidth + pix] = vNormal(1);
+      pfTexels[STX_NORMALY*pixWidth + pix] = vNormal(2);
+      pfTexels[STX_NORMALZ*pixWidth + pix] = vNormal(3);
+      pfTexels[STX_POSX*pixWidth + pix] = vPosStr(1);
+      pfTexels[STX_POSY*pixWidth + pix] = vPosStr(2);
+      pfTexels[STX_POSZ*pixWidth + pix] = vPosStr(3);
+    }
+
+    // Add lights in the same order as they are in the world
+    for(INDEX iLight=0;iLight<ctLights;iLight++) {
+      const ShadowLight_t &sl = _aslShadowLights[iLight];
+      const Rect &rcLight = sl.sl_rcUpdate;
+
+      if(pixY<rcLight.rc_iTop || pixY>=rcLight.rc_iBottom) continue;
 
-      pacolData->r = ClampUp(pacolData->r + slar + ((colLight.r*slDot)>>ubColShift),255L);
-      pacolData->g = ClampUp(pacolData->g + slag + ((colLight.g*slDot)>>ubColShift),255L);
-      pacolData->b = ClampUp(pacolData->b + slab + ((colLight.b*slDot)>>ubColShift),255L);
-      pacolData->a = 255;
-      pacolData++;
+      const PIX pixLightFirst = Max(rcLight.rc_iLeft,  pixLeft)  - pixLeft;
+      const PIX pixLightLast  = Min(rcLight.rc_iRight, pixRight) - pixLeft;
+      if(pixLightFirst>=pixLightLast) continue;
+
+      if(sl.sl_bDirectional) {
+        AddDirectionalLight(sl, pacolRow, pfTexels, pixWidth, pixLightFirst, pixLightLast);
+      } else {
+        AddPointLight(sl, pacolRow, pfTexels, pixWidth, pixLightFirst, pixLightLast);
+      }
     }
-    pacolData+=pixStepX;
   }
 }
 
-static void ClearPartOfShadowMap(CTerrain *ptrTerrain, Rect &rcUpdate)
+// [Cecil] Convert changed part of shadow map mip into shading map
+static void UpdateShadingMapRect(CTerrain *ptrTerrain, const ULONG *pulMip, const Rect &rcMip)
 {
-  PIX pixLeft   = rcUpdate.rc_iLeft;
-  PIX pixRight  = rcUpdate.rc_iRight;
-  PIX pixTop    = rcUpdate.rc_iTop;
-  PIX pixBottom = rcUpdate.rc_iBottom;
-  PIX pixWidth  = pixRight - pixLeft;
-  PIX pixStepX  = _ptrTerrain->GetShadowMapWidth() - pixWidth;
-
-  // Get color pointer in shadow map
-  PIX pixFirst = rcUpdate.rc_iLeft + rcUpdate.rc_iTop * ptrTerrain->GetShadowMapWidth();
-  GFXColor *pacolData  = (GFXColor*)&_ptrTerrain->tr_tdShadowMap.td_pulFrames[pixFirst];
-  // for each row in shadow map
-  for(PIX pixY=pixTop;pixY<pixBottom;pixY++) {
-    // for each in column
-    for(PIX pixX=pixLeft;pixX<pixRight;pixX++) {
-      *pacolData = 0x00000000;
-      pacolData++;
+  const PIX pixWidth = ptrTerrain->GetShadingMapWidth();
+
+  for(PIX pixY=rcMip.rc_iTop;pixY<rcMip.rc_iBottom;pixY++) {
+    const ULONG *ppixShadowMip = pulMip + pixY*pixWidth;
+    UWORD *puwShade = &ptrTerrain->tr_auwShadingMap[pixY*pixWidth];
+
+    for(PIX pixX=rcMip.rc_iLeft;pixX<rcMip.rc_iRight;pixX++) {
+      ULONG ulPixel = ByteSwap32(ppixShadowMip[pixX]);
+      puwShade[pixX] = (((ulPixel>>27)&0x001F)<<10) | 
+                       (((ulPixel>>19)&0x001F)<< 5) | 
+                       (((ulPixel>>11)&0x001F)<< 0);
+    }
+  }
+}
+
+// [Cecil] Remake bilinear mipmaps and shading map only where the shadow map has changed
+// (same filtering as MakeMipmaps() and both of its implementations)
+static void UpdateShadowMapMipmaps(CTerrain *ptrTerrain, Rect rcMip)
+{
+  CTextureData &tdShadowMap = ptrTerrain->tr_tdShadowMap;
+  PIX pixWidth  = tdShadowMap.td_mexWidth;
+  PIX pixHeight = tdShadowMap.td_mexHeight;
+  ULONG *pulSrc = tdShadowMap.td_pulFrames;
+  INDEX iMip = 0;
+
+  if(iMip==ptrTerrain->tr_iShadingMapSizeAspect) {
+    UpdateShadingMapRect(ptrTerrain, pulSrc, rcMip);
+  }
+
+  while(pixWidth>1 && pixHeight>1) {
+    ULONG *pulDst = pulSrc + pixWidth*pixHeight;
+    const PIX pixDstWidth  = pixWidth >>1;
+    const PIX pixDstHeight = pixHeight>>1;
+
+    // Area of the next mipmap that's affected by the changed area
+    rcMip.rc_iLeft   = rcMip.rc_iLeft>>1;
+    rcMip.rc_iTop    = rcMip.rc_iTop >>1;
+    rcMip.rc_iRight  = ClampUp((rcMip.rc_iRight +1)>>1, pixDstWidth);
+    rcMip.rc_iBottom = ClampUp((rcMip.rc_iBottom+1)>>1, pixDstHeight);
+
+    for(PIX pixY=rcMip.rc_iTop;pixY<rcMip.rc_iBottom;pixY++) {
+      for(PIX pixX=rcMip.rc_iLeft;pixX<rcMip.rc_iRight;pixX++) {
+        const UBYTE *pubUp   = (const UBYTE *)&pulSrc[(pixY*2)*pixWidth + pixX*2];
+        const UBYTE *pubDown = pubUp + pixWidth*BYTES_PER_TEXEL;
+        UBYTE *pubDst = (UBYTE *)&pulDst[pixY*pixDstWidth + pixX];
+
+        for(INDEX iChannel=0;iChannel<4;iChannel++) {
+          pubDst[iChannel] = UBYTE((pubUp[iChannel] + pubUp[iChannel+4] + pubDown[iChannel] + pubDown[iChannel+4] + 2) / 4);
+        }
+      }
+    }
+
+    pulSrc = pulDst;
+    pixWidth  = pixDstWidth;
+    pixHeight = pixDstHeight;
+    iMip++;
+
+    if(iMip==ptrTerrain->tr_iShadingMapSizeAspect) {
+      UpdateShadingMapRect(ptrTerrain, pulSrc, rcMip);
     }
-    pacolData+=pixStepX;
   }
 }
 
@@ -944,8 +1087,18 @@ void UpdateTerrainShadowMap(CTerrain *ptrTerrain, FLOATaabbox3D *pboxUpdate/*=NU
   ASSERT(tdShadowMap.td_pulFrames!=NULL);
 
   Rect rcUpdate = GetUpdateRectFromBox(ptrTerrain, boxUpdate);
-  // Clear part of shadow map that will be updated
-  ClearPartOfShadowMap(ptrTerrain,rcUpdate);
+
+  // [Cecil] Keep the update inside the shadow map
+  rcUpdate.rc_iLeft   = Clamp(rcUpdate.rc_iLeft,   (INDEX)0, (INDEX)pixWidth);
+  rcUpdate.rc_iRight  = Clamp(rcUpdate.rc_iRight,  (INDEX)0, (INDEX)pixWidth);
+  rcUpdate.rc_iTop    = Clamp(rcUpdate.rc_iTop,    (INDEX)0, (INDEX)pixHeight);
+  rcUpdate.rc_iBottom = Clamp(rcUpdate.rc_iBottom, (INDEX)0, (INDEX)pixHeight);
+
+  extern INDEX mdl_bAllowOverbright;
+  BOOL bOverBrightning = mdl_bAllowOverbright && _pGfx->gl_ctTextureUnits>1;
+
+  // [Cecil] Gather lights that affect the updated part first
+  _aslShadowLights.PopAll();
 
   // for each entity in the world
   FOREACHINDYNAMICCONTAINER(pwldWorld->wo_cenEntities, CEntity, iten) {
@@ -962,8 +1115,35 @@ void UpdateTerrainShadowMap(CTerrain *ptrTerrain, FLOATaabbox3D *pboxUpdate/*=NU
       FLOATaabbox3D boxLight(plLight.pl_PositionVector, pls->ls_rFallOff);
       // if light is directional
       if(pls->ls_ulFlags &LSF_DIRECTIONAL) {
-        // Calculate lightning
-        CalcDirectionalLight(plLight,pls,rcUpdate);
+        ShadowLight_t &sl = _aslShadowLights.Push();
+        sl.sl_rcUpdate = rcUpdate;
+        sl.sl_bDirectional = TRUE;
+        sl.sl_colLight = pls->GetLightColor();
+
+        GFXColor colAmbient = pls->GetLightAmbient();
+        sl.sl_slar = colAmbient.r;
+        sl.sl_slag = colAmbient.g;
+        sl.sl_slab = colAmbient.b;
+
+        // is overbrightning enabled
+        if(bOverBrightning) {
+          sl.sl_slar = ClampUp(sl.sl_slar,127L);
+          sl.sl_slag = ClampUp(sl.sl_slag,127L);
+          sl.sl_slab = ClampUp(sl.sl_slab,127L);
+          sl.sl_ubColShift = 8;
+        } else {
+          sl.sl_slar*=2;
+          sl.sl_slag*=2;
+          sl.sl_slab*=2;
+          sl.sl_ubColShift = 7;
+        }
+
+        // Calculate light normal
+        FLOAT3D vLightNormal;
+        AnglesToDirectionVector(plLight.pl_OrientationAngle,vLightNormal);
+        vLightNormal *= !ptrTerrain->tr_penEntity->en_mRotation;
+        sl.sl_vLightNormal = -vLightNormal.Normalize();
+
       // if it is point light
       } else {
         _bboxDrawOne = boxLight;
@@ -972,41 +1152,34 @@ void UpdateTerrainShadowMap(CTerrain *ptrTerrain, FLOATaabbox3D *pboxUpdate/*=NU
         if(boxLight.HasContactWith(boxUpdate)) {
           _ctShadowMapUpdates++;
 
+          ShadowLight_t &sl = _aslShadowLights.Push();
+          sl.sl_bDirectional = FALSE;
+          sl.sl_vPosition = plLight.pl_PositionVector;
+          sl.sl_fHotSpot = pls->ls_rHotSpot;
+          sl.sl_fFallOff = pls->ls_rFallOff;
+          sl.sl_colLight = pls->GetLightColor();
+
           // if light box is inside update box
           if(boxLight.minvect(1)>=boxUpdate.minvect(1) && boxLight.minvect(3)>boxUpdate.minvect(3) && 
             boxLight.maxvect(1)<=boxUpdate.maxvect(1) && boxLight.maxvect(3)<=boxUpdate.maxvect(3)) {
             // Recalculate only light box
-            Rect rcLightUpdate = GetUpdateRectFromBox(ptrTerrain,boxLight);
-            CalcPointLight(plLight,pls,rcLightUpdate);
+            sl.sl_rcUpdate = GetUpdateRectFromBox(ptrTerrain,boxLight);
           // else 
           } else {
             // Recalculate update box
-            CalcPointLight(plLight,pls,rcUpdate);
+            sl.sl_rcUpdate = rcUpdate;
           }
         }
       }
     }
   }
 
-  // Create shadow map mipmaps 
-  INDEX ctMipMaps = GetNoOfMipmaps(tdShadowMap.td_mexWidth,tdShadowMap.td_mexHeight);
-  MakeMipmaps(ctMipMaps, tdShadowMap.td_pulFrames, tdShadowMap.td_mexWidth, tdShadowMap.td_mexHeight);
-
-
-  // Update shading map from one mip of shadow map
-  INDEX iMipOffset = GetMipmapOffset(ptrTerrain->tr_iShadingMapSizeAspect,ptrTerrain->GetShadowMapWidth(),ptrTerrain->GetShadowMapHeight());
-  UWORD *puwShade = &ptrTerrain->tr_auwShadingMap[0];
-  ULONG *ppixShadowMip = &ptrTerrain->tr_tdShadowMap.td_pulFrames[iMipOffset];
-
-  INDEX ctpixs = ptrTerrain->GetShadingMapWidth()*ptrTerrain->GetShadingMapHeight();
-  for(PIX ipix=0;ipix<ctpixs;ipix++) {
-    ULONG ulPixel = ByteSwap32(*ppixShadowMip);
-    // ULONG ulPixel = ulTemp;
-    *puwShade = (((ulPixel>>27)&0x001F)<<10) | 
-                (((ulPixel>>19)&0x001F)<< 5) | 
-                (((ulPixel>>11)&0x001F)<< 0);
-    puwShade++;
-    ppixShadowMip++;
+  // [Cecil] Clear and relight rows of the updated part in parallel
+  if(rcUpdate.rc_iRight>rcUpdate.rc_iLeft && rcUpdate.rc_iBottom>rcUpdate.rc_iTop) {
+    IJobs::ParallelFor(rcUpdate.rc_iBottom - rcUpdate.rc_iTop, 8, UpdateShadowMapRows, &rcUpdate);
+
+    // Update shadow map mipmaps and shading map from one of them
+    UpdateShadowMapMipmaps(ptrTerrain, rcUpdate);
   }
 
   // discard cached model info
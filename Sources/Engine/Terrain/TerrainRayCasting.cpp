@@ -311,125 +311,316 @@ static BOOL HitAABBox(const FLOAT3D &vOrigin, const FLOAT3D &vTarget, FLOAT3D &v
   return TRUE;
 }
 
-// Test all quads in ray direction and return exact hit location
-static FLOAT GetExactHitLocation(CTerrain *ptrTerrain, const FLOAT3D &vHitBegin, const FLOAT3D &vHitEnd,
-                                 const FLOAT fOldDistance)
+// [Cecil] Maximum amount of levels in the height pyramid (enough for any height map size)
+#define MAX_BOUNDS_LEVELS 32
+
+// [Cecil] How much to expand node bounds to account for the precision of hit points
+#define BOUNDS_EPSILON 0.05f
+
+// [Cecil] One level of the min/max height pyramid
+// Each node stores min and max height of up to 2x2 nodes of the previous level, and nodes of the
+// lowest level store min and max height of each quad; the highest level is one node for the entire terrain
+struct BoundsLevel_t {
+  INDEX iFirst;  // First node of this level in the array
+  PIX pixWidth;  // Nodes in one row
+  PIX pixHeight; // Nodes in one column
+};
+
+// [Cecil] Get layout of the height pyramid for the current height map size and return amount of levels
+static INDEX GetBoundsLevels(const CTerrain *ptrTerrain, BoundsLevel_t *ablLevels)
 {
-  // set global vars
-  _ptrTerrain = ptrTerrain;
-  _vOrigin    = vHitBegin;
-  _vTarget    = vHitEnd;
+  PIX pixWidth  = ptrTerrain->tr_pixHeightMapWidth  - 1;
+  PIX pixHeight = ptrTerrain->tr_pixHeightMapHeight - 1;
+  if (pixWidth <= 0 || pixHeight <= 0) return 0;
 
-  // TEMP
-  _avRCVertices.PopAll();
-  _aiRCIndices.PopAll();
+  INDEX ctLevels = 0;
+  INDEX iFirst = 0;
 
-  const FLOAT fX0 = vHitBegin(1) / ptrTerrain->tr_vStretch(1);
-  const FLOAT fY0 = vHitBegin(3) / ptrTerrain->tr_vStretch(3);
-  const FLOAT fH0 = vHitBegin(2);// / ptrTerrain->tr_vStretch(2);
-  const FLOAT fX1 = vHitEnd(1)   / ptrTerrain->tr_vStretch(1);
-  const FLOAT fY1 = vHitEnd(3)   / ptrTerrain->tr_vStretch(3);
-  const FLOAT fH1 = vHitEnd(2);//   / ptrTerrain->tr_vStretch(2);
+  for (;;) {
+    BoundsLevel_t &bl = ablLevels[ctLevels++];
+    bl.iFirst = iFirst;
+    bl.pixWidth = pixWidth;
+    bl.pixHeight = pixHeight;
+    iFirst += pixWidth * pixHeight;
 
-  FLOAT fDeltaX = Abs(fX1-fX0);
-  FLOAT fDeltaY = Abs(fY1-fY0);
-  FLOAT fIterator;
+    if ((pixWidth == 1 && pixHeight == 1) || ctLevels >= MAX_BOUNDS_LEVELS) break;
 
-  if(fDeltaX>fDeltaY) {
-    fIterator = fDeltaX;
-  } else {
-    fIterator = fDeltaY;
+    pixWidth  = (pixWidth  + 1) / 2;
+    pixHeight = (pixHeight + 1) / 2;
   }
-  if(fIterator==0) {
-    fIterator = 0.01f;
+
+  return ctLevels;
+};
+
+// [Cecil] Check if the height pyramid has been built for the current height map
+static BOOL AreHeightBoundsValid(const CTerrain *ptrTerrain, const BoundsLevel_t *ablLevels, INDEX ctLevels)
+{
+  if (ctLevels == 0 || ptrTerrain->tr_auwHeightMap == NULL) return FALSE;
+
+  const BoundsLevel_t &blTop = ablLevels[ctLevels - 1];
+  return ptrTerrain->tr_auwHeightBounds.Count() == (blTop.iFirst + blTop.pixWidth * blTop.pixHeight) * 2;
+};
+
+// [Cecil] Recalculate bounds of a rect of quads and all nodes above them
+static void UpdateBoundsRect(CTerrain *ptrTerrain, const BoundsLevel_t *ablLevels, INDEX ctLevels,
+  PIX pixX0, PIX pixZ0, PIX pixX1, PIX pixZ1)
+{
+  const PIX pixMapWidth = ptrTerrain->tr_pixHeightMapWidth;
+  const UWORD *puwHeightMap = ptrTerrain->tr_auwHeightMap;
+  UWORD *puwBounds = &ptrTerrain->tr_auwHeightBounds[0];
+
+  // Min and max height of each quad
+  const BoundsLevel_t &blQuads = ablLevels[0];
+  pixX0 = Max(pixX0, (PIX)0);
+  pixZ0 = Max(pixZ0, (PIX)0);
+  pixX1 = Min(pixX1, blQuads.pixWidth);
+  pixZ1 = Min(pixZ1, blQuads.pixHeight);
+  if (pixX0 >= pixX1 || pixZ0 >= pixZ1) return;
+
+  for (PIX pixZ = pixZ0; pixZ < pixZ1; pixZ++) {
+    const UWORD *puwHeight = &puwHeightMap[pixX0 + pixZ * pixMapWidth];
+    UWORD *puwNode = &puwBounds[(blQuads.iFirst + pixX0 + pixZ * blQuads.pixWidth) * 2];
+
+    for (PIX pixX = pixX0; pixX < pixX1; pixX++, puwHeight++, puwNode += 2) {
+      const UWORD uw0 = puwHeight[0];
+      const UWORD uw1 = puwHeight[1];
+      const UWORD uw2 = puwHeight[pixMapWidth];
+      const UWORD uw3 = puwHeight[pixMapWidth + 1];
+      puwNode[0] = Min(Min(uw0, uw1), Min(uw2, uw3));
+      puwNode[1] = Max(Max(uw0, uw1), Max(uw2, uw3));
+    }
   }
 
-  const FLOAT fStepX = (fX1-fX0) / fIterator;
-  const FLOAT fStepY = (fY1-fY0) / fIterator;
-  const FLOAT fStepH = (fH1-fH0) / fIterator;
-  const FLOAT fEpsilonH = Abs(fStepH);
-
-  FLOAT fX;
-  FLOAT fY;
-  FLOAT fH;
-  // calculate prestep
-  if(fDeltaX>fDeltaY) {
-    if(fX0<fX1) {
-      fX = ceil(fX0);
-      fY = fY0 + (fX-fX0)*fStepY;
-      fH = fH0 + (fX-fX0)*fStepH;
-    } else {
-      fX = floor(fX0);
-      fY = fY0 + (fX0-fX)*fStepY;
-      fH = fH0 + (fX0-fX)*fStepH;
+  // Merge changed nodes into the levels above
+  for (INDEX iLevel = 1; iLevel < ctLevels; iLevel++) {
+    const BoundsLevel_t &blChild = ablLevels[iLevel - 1];
+    const BoundsLevel_t &bl = ablLevels[iLevel];
+
+    pixX0 = pixX0 / 2;
+    pixZ0 = pixZ0 / 2;
+    pixX1 = (pixX1 + 1) / 2;
+    pixZ1 = (pixZ1 + 1) / 2;
+
+    for (PIX pixZ = pixZ0; pixZ < pixZ1; pixZ++) {
+      for (PIX pixX = pixX0; pixX < pixX1; pixX++) {
+        UWORD uwMin = 0xFFFF;
+        UWORD uwMax = 0;
+
+        const PIX pixChildX1 = Min(pixX * 2 + 2, blChild.pixWidth);
+        const PIX pixChildZ1 = Min(pixZ * 2 + 2, blChild.pixHeight);
+
+        for (PIX pixChildZ = pixZ * 2; pixChildZ < pixChildZ1; pixChildZ++) {
+          for (PIX pixChildX = pixX * 2; pixChildX < pixChildX1; pixChildX++) {
+            const UWORD *puwChild = &puwBounds[(blChild.iFirst + pixChildX + pixChildZ * blChild.pixWidth) * 2];
+            uwMin = Min(uwMin, puwChild[0]);
+            uwMax = Max(uwMax, puwChild[1]);
+          }
+        }
+
+        UWORD *puwNode = &puwBounds[(bl.iFirst + pixX + pixZ * bl.pixWidth) * 2];
+        puwNode[0] = uwMin;
+        puwNode[1] = uwMax;
+      }
     }
-  } else {
-    if(fY0<fY1) {
-      fY = ceil(fY0);
-      fX = fX0 + (fY-fY0)*fStepX;
-      fH = fH0 + (fY-fY0)*fStepH;
-    } else {
-      fY = floor(fY0);
-      fX = fX0 + (fY0-fY)*fStepX;
-      fH = fH0 + (fY0-fY)*fStepH;
+  }
+};
+
+// [Cecil] Build min/max height pyramid that lets rays skip empty parts of the terrain
+void BuildTerrainHeightBounds(CTerrain *ptrTerrain)
+{
+  ptrTerrain->tr_auwHeightBounds.Clear();
+  if (ptrTerrain->tr_auwHeightMap == NULL) return;
+
+  BoundsLevel_t ablLevels[MAX_BOUNDS_LEVELS];
+  const INDEX ctLevels = GetBoundsLevels(ptrTerrain, ablLevels);
+  if (ctLevels == 0) return;
+
+  const BoundsLevel_t &blTop = ablLevels[ctLevels - 1];
+  ptrTerrain->tr_auwHeightBounds.Push((blTop.iFirst + blTop.pixWidth * blTop.pixHeight) * 2);
+
+  UpdateBoundsRect(ptrTerrain, ablLevels, ctLevels, 0, 0, ablLevels[0].pixWidth, ablLevels[0].pixHeight);
+};
+
+// [Cecil] Update height pyramid after changing a rect of height map vertices
+void UpdateTerrainHeightBounds(CTerrain *ptrTerrain, const Rect &rcHeightMap)
+{
+  BoundsLevel_t ablLevels[MAX_BOUNDS_LEVELS];
+  const INDEX ctLevels = GetBoundsLevels(ptrTerrain, ablLevels);
+
+  // Rebuild everything if the height map has changed in some other way
+  if (!AreHeightBoundsValid(ptrTerrain, ablLevels, ctLevels)) {
+    BuildTerrainHeightBounds(ptrTerrain);
+    return;
+  }
+
+  // Quads on both sides of each changed vertex
+  UpdateBoundsRect(ptrTerrain, ablLevels, ctLevels, rcHeightMap.rc_iLeft - 1, rcHeightMap.rc_iTop - 1,
+    rcHeightMap.rc_iRight, rcHeightMap.rc_iBottom);
+};
+
+// [Cecil] Ray segment that's being tested against the height pyramid
+static BoundsLevel_t _ablRayLevels[MAX_BOUNDS_LEVELS];
+static FLOAT3D _vRayDir;     // From the beginning to the end of the segment
+static FLOAT   _fRayLength;  // Length of the segment
+static FLOAT   _fClosestHit; // Closest hit distance so far
+
+// [Cecil] Clip ray segment to a rect of quads and get its fractions where it enters and exits the rect
+static BOOL ClipRayToQuads(PIX pixX0, PIX pixZ0, PIX pixX1, PIX pixZ1, FLOAT &tNear, FLOAT &tFar)
+{
+  const FLOAT3D &vStretch = _ptrTerrain->tr_vStretch;
+  const FLOAT afMin[2] = { pixX0 * vStretch(1) - BOUNDS_EPSILON, pixZ0 * vStretch(3) - BOUNDS_EPSILON };
+  const FLOAT afMax[2] = { pixX1 * vStretch(1) + BOUNDS_EPSILON, pixZ1 * vStretch(3) + BOUNDS_EPSILON };
+  const INDEX aiAxes[2] = { 1, 3 };
+
+  tNear = 0.0f;
+  tFar = 1.0f;
+
+  for (INDEX i = 0; i < 2; i++) {
+    const INDEX iAxis = aiAxes[i];
+    const FLOAT fOrigin = _vOrigin(iAxis);
+    const FLOAT fDir = _vRayDir(iAxis);
+
+    // Parallel to the rect side
+    if (Abs(fDir) < 1e-9f) {
+      if (fOrigin < afMin[i] || fOrigin > afMax[i]) return FALSE;
+      continue;
     }
+
+    FLOAT t0 = (afMin[i] - fOrigin) / fDir;
+    FLOAT t1 = (afMax[i] - fOrigin) / fDir;
+    if (t0 > t1) Swap(t0, t1);
+
+    if (t0 > tNear) tNear = t0;
+    if (t1 < tFar) tFar = t1;
+    if (tNear > tFar) return FALSE;
   }
 
+  return TRUE;
+};
+
+// [Cecil] Test ray against quads of one pyramid node, from the closest child node to the farthest
+static void HitCheckNode(INDEX iLevel, PIX pixX, PIX pixZ, FLOAT tNear, FLOAT tFar)
+{
+  const BoundsLevel_t &bl = _ablRayLevels[iLevel];
+  const UWORD *puwNode = &_ptrTerrain->tr_auwHeightBounds[(bl.iFirst + pixX + pixZ * bl.pixWidth) * 2];
+
+  // Skip the node if the ray passes entirely above or below it
+  const FLOAT fH0 = _vOrigin(2) + _vRayDir(2) * tNear;
+  const FLOAT fH1 = _vOrigin(2) + _vRayDir(2) * tFar;
+  const FLOAT fRayMin = Min(fH0, fH1);
+  const FLOAT fRayMax = Max(fH0, fH1);
 
-  // Chech quad where ray starts
-  _fMinHeight = vHitBegin(2)-fEpsilonH;
-  _fMaxHeight = vHitBegin(2)+fEpsilonH;
-  FLOAT fDistanceStart = HitCheckQuad(floor(fX0),floor(fY0));
-  if(fDistanceStart<fOldDistance) {
-    return fDistanceStart;
+  const FLOAT fStretchH = _ptrTerrain->tr_vStretch(2);
+
+  if (fRayMax < puwNode[0] * fStretchH - BOUNDS_EPSILON || fRayMin > puwNode[1] * fStretchH + BOUNDS_EPSILON) {
+    return;
   }
 
-  // for each iteration
-  INDEX ctit = ceil(fIterator);
-  for(INDEX iit=0;iit<ctit;iit++) {
-    PIX pixX = floor(fX);
-    PIX pixY = floor(fY);
-
-    FLOAT fDistance0;
-    FLOAT fDistance1;
-
-    // Check first quad
-    _fMinHeight = fH-fEpsilonH;
-    _fMaxHeight = fH+fEpsilonH;
-    fDistance0 = HitCheckQuad(pixX,pixY);
-    // if iterating by x
-    if(fDeltaX>fDeltaY) {
-      // check left quad
-      fDistance1 = HitCheckQuad(pixX-1,pixY);
-    // else 
+  // Test triangles of a single quad
+  if (iLevel == 0) {
+    _fMinHeight = fRayMin - BOUNDS_EPSILON;
+    _fMaxHeight = fRayMax + BOUNDS_EPSILON;
+
+    // Keep the closest hit if this quad is hit farther away
+    const FLOAT3D vLastHit = _vHitExact;
+    const FLOATplane3D plLastHit = _plHitPlane;
+    const FLOAT fDistance = HitCheckQuad(pixX, pixZ);
+
+    if (fDistance < _fClosestHit) {
+      _fClosestHit = fDistance;
     } else {
-      // check upper quad
-      fDistance1 = HitCheckQuad(pixX,pixY-1);
+      _vHitExact = vLastHit;
+      _plHitPlane = plLastHit;
     }
+    return;
+  }
 
-    // find closer of two quads
-    if(fDistance1<fDistance0) {
-      fDistance0 = fDistance1;
-    }
-    // if distance is closer than old distance
-    if(fDistance0<fOldDistance) {
-      // return distance
-      return fDistance0;
+  // Gather child nodes that are touched by the ray
+  const BoundsLevel_t &blChild = _ablRayLevels[iLevel - 1];
+  const INDEX iChildShift = iLevel - 1;
+  const PIX pixQuadsX = _ablRayLevels[0].pixWidth;
+  const PIX pixQuadsZ = _ablRayLevels[0].pixHeight;
+
+  struct ChildNode_t {
+    PIX pixX, pixZ;
+    FLOAT tNear, tFar;
+  } acnChildren[4];
+
+  INDEX ctChildren = 0;
+
+  for (PIX pixChildZ = pixZ * 2; pixChildZ < Min(pixZ * 2 + 2, blChild.pixHeight); pixChildZ++) {
+    for (PIX pixChildX = pixX * 2; pixChildX < Min(pixX * 2 + 2, blChild.pixWidth); pixChildX++) {
+      ChildNode_t &cn = acnChildren[ctChildren];
+
+      const PIX pixQuadX0 = pixChildX << iChildShift;
+      const PIX pixQuadZ0 = pixChildZ << iChildShift;
+      const PIX pixQuadX1 = Min((pixChildX + 1) << iChildShift, pixQuadsX);
+      const PIX pixQuadZ1 = Min((pixChildZ + 1) << iChildShift, pixQuadsZ);
+
+      if (!ClipRayToQuads(pixQuadX0, pixQuadZ0, pixQuadX1, pixQuadZ1, cn.tNear, cn.tFar)) continue;
+
+      cn.pixX = pixChildX;
+      cn.pixZ = pixChildZ;
+
+      // Sort by where the ray enters them
+      for (INDEX i = ctChildren; i > 0 && acnChildren[i - 1].tNear > acnChildren[i].tNear; i--) {
+        Swap(acnChildren[i - 1], acnChildren[i]);
+      }
+      ctChildren++;
     }
+  }
+
+  for (INDEX i = 0; i < ctChildren; i++) {
+    const ChildNode_t &cn = acnChildren[i];
+
+    // Nothing can be closer than the hit that's already been found
+    if (cn.tNear * _fRayLength >= _fClosestHit) break;
 
-    fX+=fStepX;
-    fY+=fStepY;
-    fH+=fStepH;
+    HitCheckNode(iLevel - 1, cn.pixX, cn.pixZ, cn.tNear, cn.tFar);
   }
+};
 
-  // Chech quad where ray ends
-  _fMinHeight = vHitEnd(2)-fEpsilonH;
-  _fMaxHeight = vHitEnd(2)+fEpsilonH;
-  FLOAT fDistanceEnd = HitCheckQuad(floor(fX1),floor(fY1));
-  if(fDistanceEnd<fOldDistance) {
-    return fDistanceEnd;
+// Test all quads in ray direction and return exact hit location
+// [Cecil] Descends the height pyramid instead of stepping through every quad along the ray
+static FLOAT GetExactHitLocation(CTerrain *ptrTerrain, const FLOAT3D &vHitBegin, const FLOAT3D &vHitEnd,
+                                 const FLOAT fOldDistance)
+{
+  // set global vars
+  _ptrTerrain = ptrTerrain;
+  _vOrigin    = vHitBegin;
+  _vTarget    = vHitEnd;
+
+  // TEMP
+  _avRCVertices.PopAll();
+  _aiRCIndices.PopAll();
+
+  // Make sure the height pyramid matches the height map
+  const INDEX ctLevels = GetBoundsLevels(ptrTerrain, _ablRayLevels);
+
+  if (!AreHeightBoundsValid(ptrTerrain, _ablRayLevels, ctLevels)) {
+    BuildTerrainHeightBounds(ptrTerrain);
+
+    if (!AreHeightBoundsValid(ptrTerrain, _ablRayLevels, ctLevels)) {
+      return UpperLimit(0.0f);
+    }
+  }
+
+  _vRayDir = vHitEnd - vHitBegin;
+  _fRayLength = _vRayDir.Length();
+
+  // Only hits closer than the old distance are of interest
+  _fClosestHit = fOldDistance;
+
+  // Start from the node that covers the entire terrain
+  FLOAT tNear, tFar;
+
+  if (ClipRayToQuads(0, 0, _ablRayLevels[0].pixWidth, _ablRayLevels[0].pixHeight, tNear, tFar)) {
+    HitCheckNode(ctLevels - 1, 0, 0, tNear, tFar);
   }
 
+  if (_fClosestHit < fOldDistance) {
+    return _fClosestHit;
+  }
 
   // no hit
   return UpperLimit(0.0f);
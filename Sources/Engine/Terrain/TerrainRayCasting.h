@@ -26,4 +26,10 @@ FLOAT TestRayCastHit(CTerrain *ptrTerrain, const FLOATmatrix3D &mRotation, const
 FLOAT TestRayCastHit(CTerrain *ptrTerrain, const FLOATmatrix3D &mRotation, const FLOAT3D &vPosition, 
                      const FLOAT3D &vOrigin, const FLOAT3D &vTarget,const FLOAT fOldDistance, 
                      const BOOL bHitInvisibleTris, FLOATplane3D &plHitPlane, FLOAT3D &vHitPoint);
+
+// [Cecil] Build min/max height pyramid that lets rays skip empty parts of the terrain
+void BuildTerrainHeightBounds(CTerrain *ptrTerrain);
+
+// [Cecil] Update height pyramid after changing a rect of height map vertices
+void UpdateTerrainHeightBounds(CTerrain *ptrTerrain, const Rect &rcHeightMap);
 #endif
@@ -32,6 +32,7 @@ CTerrainTile::CTerrainTile()
   tt_iArrayIndex = -1;
   tt_iLod = -1;
   tt_iRequestedLod = 0;
+  tt_iLodBeforeRegen = -1; // [Cecil]
   tt_ulTileFlags   = 0;
 }
 
@@ -399,12 +400,24 @@ void CTerrainTile::ReGenerateTileLayer(INDEX iTileLayer)
 
 // Regenerate tile
 void CTerrainTile::ReGenerate()
+{
+  PrepareReGenerate();
+  ReGenerateGeometry();
+  FinishReGenerate();
+}
+
+// [Cecil] Allocate arrays for requested lod (array holders are shared between tiles)
+void CTerrainTile::PrepareReGenerate(void)
 {
   // remember lod before regen
-  INDEX iOldLod = tt_iLod;
+  tt_iLodBeforeRegen = tt_iLod;
   // Allocate arrays for requested lod
   tt_iLod = ChangeTileArrays(tt_iRequestedLod);
+}
 
+// [Cecil] Fill arrays of this tile (only reads terrain data and lods of neighbours)
+void CTerrainTile::ReGenerateGeometry(void)
+{
   // for each vertex in row
   INDEX iStep = 1<<tt_iLod;
   INDEX ir=0;
@@ -456,7 +469,11 @@ void CTerrainTile::ReGenerate()
       }
     }
   }
+}
 
+// [Cecil] Update top map and quad tree node of the tile (they are shared with the rest of the terrain)
+void CTerrainTile::FinishReGenerate(void)
+{
   BOOL bAllowTopMapRegen = !(GetFlags()&TT_NO_TOPMAP_REGEN);
   // if top map is allowed to be regenerated
   if(bAllowTopMapRegen) {
@@ -464,7 +481,7 @@ void CTerrainTile::ReGenerate()
     if(tt_iLod>0 && tt_iLod<_ptrTerrain->tr_iMaxTileLod) {
       // if top map regen is forced or tile has changed lod
       BOOL bForceTopMapRegen = (GetFlags()&TT_FORCE_TOPMAP_REGEN);
-      if(bForceTopMapRegen || iOldLod!=tt_iLod) {
+      if(bForceTopMapRegen || tt_iLodBeforeRegen!=tt_iLod) {
         // Update tile top map
         _ptrTerrain->UpdateTopMap(tt_iIndex);
         // remove flag that forced top map regen
@@ -44,6 +44,10 @@ public:
   void Render(void);
   // Regenerate tile
   void ReGenerate(void);
+  // [Cecil] Regenerate tile in steps, where only geometry of different tiles can be generated in parallel
+  void PrepareReGenerate(void);
+  void ReGenerateGeometry(void);
+  void FinishReGenerate(void);
   // Regenerate tile layer 
   void ReGenerateTileLayer(INDEX iTileLayer);
   // Release tile
@@ -100,6 +104,7 @@ public:
   INDEX tt_iIndex;    // Index of this tile 
   INDEX tt_iLod;      // Current lod of tile
   INDEX tt_iRequestedLod;   // Requested lod for tile
+  INDEX tt_iLodBeforeRegen; // [Cecil] Lod before the current regeneration
   INDEX tt_iArrayIndex;     // Index of array holder this tile uses
   INDEX tt_aiNeighbours[4]; // Array of tile neighbours
 
@@ -35,8 +35,10 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Templates/DynamicArray.cpp>
 #include <Engine/Brushes/Brush.h>
 #include <Engine/Light/LightSource.h>
+#include <Engine/Light/Shadows_internal.h>
 #include <Engine/Base/ProgressHook.h>
 #include <Engine/Templates/StaticArray.cpp>
+#include <Engine/Templates/StaticStackArray.cpp>
 #include <Engine/Templates/Selection.cpp>
 #include <Engine/Terrain/Terrain.h>
 
@@ -88,6 +90,7 @@ CWorld::CWorld(void)
 {
   wo_baBrushes.ba_pwoWorld = this;
   wo_taTerrains.ta_pwoWorld = this;
+  wo_ecCache.ec_pwoWorld = this;
 
   // create empty texture movements
   wo_attTextureTransformations.New(256);
@@ -110,6 +113,7 @@ CWorld::CWorld(void)
   wo_fRtL = wo_fRtH = 1.0f; wo_fRtCZ = wo_fRtCY = 0.0f;
 
   wo_ulNextEntityID = 1;
+  wo_llNextTimerOrder = 0;
 
   // set default placement
   wo_plFocus = CPlacement3D( FLOAT3D(3.0f, 4.0f, 10.0f),
@@ -167,13 +171,20 @@ void CWorld::Clear(void)
     ASSERT(wo_cenEntities.Count()==0);
     ASSERT(wo_cenAllEntities.Count()==0);
     wo_cenEntities.Clear();
+    wo_ecCache.Clear();
     wo_cenAllEntities.Clear();
     cenToDestroy.Clear();
     wo_ulNextEntityID = 1;
+
+    // [Cecil] All timers must be gone with the entities
+    ASSERT(wo_apenTimers.Count()==0);
+    wo_apenTimers.Clear();
+    wo_llNextTimerOrder = 0;
   }
 
   // clear brushes
   wo_baBrushes.ba_abrBrushes.Clear();
+  wo_baBrushes.ClearPVS(); // [Cecil]
   // clear terrains
   wo_taTerrains.ta_atrTerrains.Clear();
 
@@ -221,6 +232,8 @@ CEntity *CWorld::CreateEntity(const CPlacement3D &plPlacement, CEntityClass *pec
   penEntity->en_plPlacement = plPlacement;
   // calculate rotation matrix
   MakeRotationMatrixFast(penEntity->en_mRotation, penEntity->en_plPlacement.pl_OrientationAngle);
+  // [Cecil] Add it to the entity cache after the container
+  wo_ecCache.AddEntity(penEntity);
 
   // if now predicting
   if (_pNetwork->IsPredicting()) {
@@ -354,6 +367,71 @@ CPlayerEntity *CWorld::FindEntityWithCharacter(CPlayerCharacter &pcCharacter)
   return NULL;
 }
 
+// [Cecil] Check if one timer should be handled before another one
+static inline BOOL IsTimerBefore(const CRationalEntity *pen0, const CRationalEntity *pen1)
+{
+  if (pen0->en_tckTimer != pen1->en_tckTimer) {
+    return pen0->en_tckTimer < pen1->en_tckTimer;
+  }
+  return pen0->en_llTimerOrder < pen1->en_llTimerOrder;
+}
+
+// [Cecil] Move timer up the heap until its parent goes before it
+static void MoveTimerUp(CStaticStackArray<CRationalEntity *> &apenTimers, INDEX i)
+{
+  CRationalEntity *pen = apenTimers[i];
+
+  while (i > 0) {
+    const INDEX iParent = (i - 1) / 2;
+    CRationalEntity *penParent = apenTimers[iParent];
+    if (!IsTimerBefore(pen, penParent)) break;
+
+    apenTimers[i] = penParent;
+    penParent->en_iInTimers = i;
+    i = iParent;
+  }
+
+  apenTimers[i] = pen;
+  pen->en_iInTimers = i;
+}
+
+// [Cecil] Move timer down the heap until its children go after it
+static void MoveTimerDown(CStaticStackArray<CRationalEntity *> &apenTimers, INDEX i)
+{
+  const INDEX ct = apenTimers.Count();
+  CRationalEntity *pen = apenTimers[i];
+
+  FOREVER {
+    INDEX iChild = i * 2 + 1;
+    if (iChild >= ct) break;
+
+    // pick the earlier child
+    if (iChild + 1 < ct && IsTimerBefore(apenTimers[iChild + 1], apenTimers[iChild])) {
+      iChild++;
+    }
+
+    CRationalEntity *penChild = apenTimers[iChild];
+    if (!IsTimerBefore(penChild, pen)) break;
+
+    apenTimers[i] = penChild;
+    penChild->en_iInTimers = i;
+    i = iChild;
+  }
+
+  apenTimers[i] = pen;
+  pen->en_iInTimers = i;
+}
+
+// [Cecil] Add timer to the heap with its current order
+static void PushTimer(CStaticStackArray<CRationalEntity *> &apenTimers, CRationalEntity *pen)
+{
+  ASSERT(!pen->IsWaitingForTimer());
+  const INDEX i = apenTimers.Count();
+  apenTimers.Push() = pen;
+  pen->en_iInTimers = i;
+  MoveTimerUp(apenTimers, i);
+}
+
 /*
  * Add an entity to list of thinkers.
  */
@@ -363,20 +441,134 @@ void CWorld::AddTimer(CRationalEntity *penThinker)
   ASSERT(GetFPUPrecision()==FPT_24BIT);
 
   // if the entity is already in the list
-  if (penThinker->en_lnInTimers.IsLinked()) {
+  if (penThinker->IsWaitingForTimer()) {
     // remove it
-    penThinker->en_lnInTimers.Remove();
+    RemoveTimer(penThinker);
+  }
+
+  // [Cecil] Add it before all timers with the same think time, like it used to be inserted into a sorted list
+  penThinker->en_llTimerOrder = --wo_llNextTimerOrder;
+  PushTimer(wo_apenTimers, penThinker);
+}
+
+// [Cecil] Remove an entity from the list of timers
+void CWorld::RemoveTimer(CRationalEntity *penTimer)
+{
+  const INDEX i = penTimer->en_iInTimers;
+  ASSERT(i >= 0 && i < wo_apenTimers.Count() && wo_apenTimers[i] == penTimer);
+
+  penTimer->en_iInTimers = -1;
+
+  // replace it with the last timer
+  const INDEX iLast = wo_apenTimers.Count() - 1;
+  CRationalEntity *penLast = wo_apenTimers[iLast];
+  wo_apenTimers.PopUntil(iLast - 1);
+
+  if (i == iLast) return;
+
+  wo_apenTimers[i] = penLast;
+  penLast->en_iInTimers = i;
+
+  // and put it in the right place
+  if (i > 0 && IsTimerBefore(penLast, wo_apenTimers[(i - 1) / 2])) {
+    MoveTimerUp(wo_apenTimers, i);
+  } else {
+    MoveTimerDown(wo_apenTimers, i);
+  }
+}
+
+// [Cecil] Sort a timer into its place after its tick has been changed, keeping its order
+void CWorld::UpdateTimer(CRationalEntity *penTimer)
+{
+  const INDEX i = penTimer->en_iInTimers;
+  ASSERT(i >= 0 && i < wo_apenTimers.Count() && wo_apenTimers[i] == penTimer);
+
+  if (i > 0 && IsTimerBefore(penTimer, wo_apenTimers[(i - 1) / 2])) {
+    MoveTimerUp(wo_apenTimers, i);
+  } else {
+    MoveTimerDown(wo_apenTimers, i);
   }
-  // for each entity in the thinker list
-  FOREACHINLISTKEEP(CRationalEntity, en_lnInTimers, wo_lhTimers, iten) {
-    // if the entity in list has greater or same think time than the one to add
-    if (iten->en_tckTimer >= penThinker->en_tckTimer) {
-      // stop searching
-      break;
+}
+
+// [Cecil] Find the earliest due predictor under some timer in the heap
+static void FindDuePredictor(CStaticStackArray<CRationalEntity *> &apenTimers, INDEX i, TICK tckCurrentTime, CRationalEntity *&penBest)
+{
+  if (i >= apenTimers.Count()) return;
+
+  // children are never due before their parent
+  CRationalEntity *pen = apenTimers[i];
+  if (pen->en_tckTimer > tckCurrentTime) return;
+  if (penBest != NULL && IsTimerBefore(penBest, pen)) return;
+
+  if (pen->IsPredictor()) {
+    penBest = pen;
+    return;
+  }
+
+  FindDuePredictor(apenTimers, i * 2 + 1, tckCurrentTime, penBest);
+  FindDuePredictor(apenTimers, i * 2 + 2, tckCurrentTime, penBest);
+}
+
+// [Cecil] Get the first timer that is due at a given tick (optionally only among predictors)
+CRationalEntity *CWorld::GetDueTimer(TICK tckCurrentTime, BOOL bOnlyPredictors)
+{
+  if (wo_apenTimers.Count() == 0) return NULL;
+
+  // the first one in the heap
+  if (!bOnlyPredictors) {
+    CRationalEntity *pen = wo_apenTimers[0];
+    return (pen->en_tckTimer <= tckCurrentTime) ? pen : NULL;
+  }
+
+  // search through all due timers
+  CRationalEntity *penBest = NULL;
+  FindDuePredictor(wo_apenTimers, 0, tckCurrentTime, penBest);
+  return penBest;
+}
+
+static int qsort_CompareTimers(const void *ppen0, const void *ppen1)
+{
+  const CRationalEntity *pen0 = *(const CRationalEntity **)ppen0;
+  const CRationalEntity *pen1 = *(const CRationalEntity **)ppen1;
+
+  if (IsTimerBefore(pen0, pen1)) return -1;
+  if (IsTimerBefore(pen1, pen0)) return +1;
+  return 0;
+}
+
+// [Cecil] Get all timers in order of handling
+void CWorld::GetTimersInOrder(CStaticStackArray<CRationalEntity *> &apenTimers)
+{
+  apenTimers.PopAll();
+
+  const INDEX ct = wo_apenTimers.Count();
+  if (ct == 0) return;
+
+  CRationalEntity **apen = apenTimers.Push(ct);
+
+  for (INDEX i = 0; i < ct; i++) {
+    apen[i] = wo_apenTimers[i];
+  }
+
+  qsort(apen, ct, sizeof(CRationalEntity *), qsort_CompareTimers);
+}
+
+// [Cecil] Put given timers in front of other timers with the same tick, keeping their order
+void CWorld::PrioritizeTimers(CRationalEntity **apenTimers, INDEX ctTimers)
+{
+  // give them the newest order from the end
+  for (INDEX iTimer = ctTimers - 1; iTimer >= 0; iTimer--) {
+    CRationalEntity *pen = apenTimers[iTimer];
+
+    if (pen->IsWaitingForTimer()) {
+      pen->en_llTimerOrder = --wo_llNextTimerOrder;
     }
   }
-  // add the new entity before current one
-  iten.InsertBeforeCurrent(penThinker->en_lnInTimers);
+
+  // rebuild the heap
+  for (INDEX i = wo_apenTimers.Count() / 2 - 1; i >= 0; i--) {
+    MoveTimerDown(wo_apenTimers, i);
+  }
 }
 
 // set overdue timers to be due in current time
@@ -385,14 +577,21 @@ void CWorld::AdjustLateTimers(TICK tckCurrentTime)
   // must be in 24bit mode when managing entities
   CSetFPUPrecision FPUPrecision(FPT_24BIT);
 
-  // for each entity in the thinker list
-  FOREACHINLIST(CRationalEntity, en_lnInTimers, wo_lhTimers, iten) {
-    CRationalEntity &en = *iten;
-    // if the entity in list is overdue
-    if (en.en_tckTimer < tckCurrentTime) {
-      // set it to current time
-      en.en_tckTimer = tckCurrentTime;
-    }
+  // [Cecil] Take all overdue timers out in order
+  CStaticStackArray<CRationalEntity *> apenLate;
+
+  while (wo_apenTimers.Count() > 0 && wo_apenTimers[0]->en_tckTimer < tckCurrentTime) {
+    CRationalEntity *pen = wo_apenTimers[0];
+    RemoveTimer(pen);
+    apenLate.Push() = pen;
+  }
+
+  // set them to current time and put them back in front of timers that were already due at this time
+  for (INDEX iLate = apenLate.Count() - 1; iLate >= 0; iLate--) {
+    CRationalEntity *pen = apenLate[iLate];
+    pen->en_tckTimer = tckCurrentTime;
+    pen->en_llTimerOrder = --wo_llNextTimerOrder;
+    PushTimer(wo_apenTimers, pen);
   }
 }
 
@@ -500,13 +699,17 @@ void CWorld::CalculateDirectionalShadows(void)
   _ctShadowLayers=0;
   _ctShadowClusters=0;
 
-  // for each shadow map that is queued for calculation
-  FORDELETELIST(CBrushShadowMap, bsm_lnInUncalculatedShadowMaps,
+  // [Cecil] Gather polygons of all shadow maps that are queued for calculation
+  CStaticStackArray<CBrushPolygon *> apbpo;
+  FOREACHINLIST(CBrushShadowMap, bsm_lnInUncalculatedShadowMaps,
     wo_baBrushes.ba_lhUncalculatedShadowMaps, itbsm) {
-    // calculate shadows on it
-    itbsm->GetBrushPolygon()->MakeShadowMap(this, TRUE);
+    apbpo.Push() = itbsm->GetBrushPolygon();
   }
 
+  // [Cecil] Calculate shadows on all of them at once
+  SetProgressDescription(TRANS("calculating shadows"));
+  MakeShadowMaps(this, apbpo, TRUE, TRUE);
+
   // report shadow rendering stats
   CTimerValue tvStop = _pTimer->GetHighPrecisionTimer();
   CPrintF("Shadow calculation: total %d clusters in %d layers, %fs\n",
@@ -517,12 +720,19 @@ void CWorld::CalculateDirectionalShadows(void)
 
 void CWorld::CalculateNonDirectionalShadows(void)
 {
-  // for each shadow map that is queued for calculation
-  FORDELETELIST(CBrushShadowMap, bsm_lnInUncalculatedShadowMaps,
+  // [Cecil] Nothing to calculate
+  if (wo_baBrushes.ba_lhUncalculatedShadowMaps.IsEmpty()) return;
+
+  // [Cecil] Gather polygons of all shadow maps that are queued for calculation
+  CStaticStackArray<CBrushPolygon *> apbpo;
+  FOREACHINLIST(CBrushShadowMap, bsm_lnInUncalculatedShadowMaps,
     wo_baBrushes.ba_lhUncalculatedShadowMaps, itbsm) {
-    // calculate shadows on it
-    itbsm->GetBrushPolygon()->MakeShadowMap(this, FALSE);
+    apbpo.Push() = itbsm->GetBrushPolygon();
   }
+
+  // [Cecil] Calculate shadows on all of them at once without reporting progress
+  // (this is called while rendering)
+  MakeShadowMaps(this, apbpo, FALSE, FALSE);
 }
 
 
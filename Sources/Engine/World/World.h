@@ -26,7 +26,9 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Entities/Entity.h>
 #include <Engine/Math/Placement.h>
 #include <Engine/Templates/StaticArray.h>
+#include <Engine/Templates/StaticStackArray.h>
 #include <Engine/Templates/DynamicContainer.h>
+#include <Engine/World/WorldEntityCache.h>
 
 class CTextureTransformation;
 class CTextureBlending;
@@ -94,7 +96,10 @@ public:
   CTString wo_strDescription; // description of the level (intro, mission, etc.)
 
   ULONG wo_ulNextEntityID;    // next free ID for entities
-  CListHead wo_lhTimers;      // timer scheduled entities
+  CEntityCache wo_ecCache;    // [Cecil] Cached data of existing entities
+  // [Cecil] Timer scheduled entities in a binary heap ordered by the timer tick and then by order of adding
+  CStaticStackArray<CRationalEntity *> wo_apenTimers;
+  SQUAD wo_llNextTimerOrder;  // order for the next added timer (decreases, so newer timers go first)
   CListHead wo_lhMovers;        // entities that want to/have to move
   BOOL wo_bPortalLinksUpToDate; // set if portal-sector links are up to date
 
@@ -123,6 +128,16 @@ public:
 
   /* Add an entity to list of timers. */
   void AddTimer(CRationalEntity *penTimer);
+  // [Cecil] Remove an entity from the list of timers
+  void RemoveTimer(CRationalEntity *penTimer);
+  // [Cecil] Sort a timer into its place after its tick has been changed, keeping its order
+  void UpdateTimer(CRationalEntity *penTimer);
+  // [Cecil] Get the first timer that is due at a given tick (optionally only among predictors)
+  CRationalEntity *GetDueTimer(TICK tckCurrentTime, BOOL bOnlyPredictors);
+  // [Cecil] Get all timers in order of handling
+  void GetTimersInOrder(CStaticStackArray<CRationalEntity *> &apenTimers);
+  // [Cecil] Put given timers in front of other timers with the same tick, keeping their order
+  void PrioritizeTimers(CRationalEntity **apenTimers, INDEX ctTimers);
   // set overdue timers to be due in current time
   void AdjustLateTimers(TICK tckCurrentTime);
 
@@ -223,6 +238,9 @@ public:
 
   /* Cast a ray and see what it hits. */
   void CastRay(CCastRay &crRay);
+  // [Cecil] Cast multiple rays at once (each result is identical to casting the ray alone)
+  // NOTE: Rays cast this way cannot be continued using ContinueCast()
+  void CastRays(CCastRay **apcrRays, INDEX ctRays);
   /* Continue to cast already cast ray */
   void ContinueCast(CCastRay &crRay);
   /* Test if a movement is clipped by something and where. */
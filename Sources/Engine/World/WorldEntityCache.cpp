@@ -0,0 +1,214 @@
+/* Copyright (c) 2026 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "StdH.h"
+
+#include <Engine/World/World.h>
+#include <Engine/World/WorldEntityCache.h>
+#include <Engine/Entities/Entity.h>
+#include <Engine/Brushes/Brush.h>
+#include <Engine/Templates/StaticStackArray.cpp>
+#include <Engine/Templates/DynamicContainer.cpp>
+
+// Use cached entity data in loops over all entities
+INDEX wld_bEntityCache = TRUE;
+
+CEntityCache::CEntityCache(void) : ec_pwoWorld(NULL), ec_bValid(TRUE)
+{
+  ec_avPositions.SetAllocationStep(256);
+  ec_afRadii.SetAllocationStep(256);
+  ec_aubRenderTypes.SetAllocationStep(256);
+  ec_aulFlags.SetAllocationStep(256);
+};
+
+// Get radius of a sphere around the entity position that contains the first mip of its brush
+// (spatial classification radius can't be used, since it only covers corners of the box on its main diagonal)
+static FLOAT GetBrushRadius(CEntity *pen) {
+  if (pen->en_RenderType != CEntity::RT_BRUSH && pen->en_RenderType != CEntity::RT_FIELDBRUSH) return -1.0f;
+  if (pen->en_pbrBrush == NULL || pen->en_pbrBrush->br_lhBrushMips.IsEmpty()) return -1.0f;
+
+  // Distance to the farthest corner of the box
+  const FLOATaabbox3D &box = pen->en_pbrBrush->GetFirstMip()->bm_boxRelative;
+  FLOAT3D vFarthest;
+
+  for (INDEX i = 1; i <= 3; i++) {
+    vFarthest(i) = Max(Abs(box.Min()(i)), Abs(box.Max()(i)));
+  }
+
+  // Leave some room for precision errors of the absolute box
+  return vFarthest.Length() * 1.001f + 0.01f;
+};
+
+void CEntityCache::SetEntry(INDEX iEntry, CEntity *pen) {
+  ec_avPositions[iEntry] = pen->en_plPlacement.pl_PositionVector;
+  ec_afRadii[iEntry] = GetBrushRadius(pen);
+  ec_aubRenderTypes[iEntry] = (UBYTE)pen->en_RenderType;
+  ec_aulFlags[iEntry] = pen->en_ulFlags;
+};
+
+void CEntityCache::Clear(void) {
+  ec_avPositions.PopAll();
+  ec_afRadii.PopAll();
+  ec_aubRenderTypes.PopAll();
+  ec_aulFlags.PopAll();
+  ec_bValid = TRUE;
+};
+
+void CEntityCache::Invalidate(void) {
+  ec_bValid = FALSE;
+};
+
+BOOL CEntityCache::Validate(void) {
+  if (!wld_bEntityCache) return FALSE;
+  if (ec_bValid) return TRUE;
+
+  // Rebuild all entries
+  CDynamicContainer<CEntity> &cen = ec_pwoWorld->wo_cenEntities;
+  const INDEX ct = cen.Count();
+
+  ec_avPositions.PopAll();
+  ec_afRadii.PopAll();
+  ec_aubRenderTypes.PopAll();
+  ec_aulFlags.PopAll();
+
+  if (ct > 0) {
+    ec_avPositions.Push(ct);
+    ec_afRadii.Push(ct);
+    ec_aubRenderTypes.Push(ct);
+    ec_aulFlags.Push(ct);
+  }
+
+  for (INDEX i = 0; i < ct; i++) {
+    CEntity *pen = cen.Pointer(i);
+    pen->en_iInCache = i;
+    SetEntry(i, pen);
+  }
+
+  ec_bValid = TRUE;
+  return TRUE;
+};
+
+void CEntityCache::AddEntity(CEntity *pen) {
+  pen->en_iInCache = -1;
+  if (!ec_bValid) return;
+
+  const INDEX i = ec_aubRenderTypes.Count();
+  ASSERT(ec_pwoWorld->wo_cenEntities.Count() == i + 1 && ec_pwoWorld->wo_cenEntities.Pointer(i) == pen);
+
+  ec_avPositions.Push();
+  ec_afRadii.Push();
+  ec_aubRenderTypes.Push();
+  ec_aulFlags.Push();
+
+  pen->en_iInCache = i;
+  SetEntry(i, pen);
+};
+
+void CEntityCache::RemoveEntity(CEntity *pen) {
+  const INDEX i = pen->en_iInCache;
+  pen->en_iInCache = -1;
+
+  if (!ec_bValid) return;
+
+  // Container moves its last entity in place of the removed one
+  const INDEX iLast = ec_aubRenderTypes.Count() - 1;
+  ASSERT(i >= 0 && i <= iLast);
+
+  if (i != iLast) {
+    CEntity *penMoved = ec_pwoWorld->wo_cenEntities.Pointer(i);
+    ASSERT(penMoved->en_iInCache == iLast);
+
+    penMoved->en_iInCache = i;
+    ec_avPositions[i] = ec_avPositions[iLast];
+    ec_afRadii[i] = ec_afRadii[iLast];
+    ec_aubRenderTypes[i] = ec_aubRenderTypes[iLast];
+    ec_aulFlags[i] = ec_aulFlags[iLast];
+  }
+
+  ec_avPositions.Pop();
+  ec_afRadii.Pop();
+  ec_aubRenderTypes.Pop();
+  ec_aulFlags.Pop();
+};
+
+void CEntityCache::UpdateEntity(CEntity *pen) {
+  if (!ec_bValid || pen->en_iInCache < 0) return;
+
+  ASSERT(ec_pwoWorld->wo_cenEntities.Pointer(pen->en_iInCache) == pen);
+  SetEntry(pen->en_iInCache, pen);
+};
+
+// Measure time of finding entities in range with and without the entity cache
+void BenchmarkEntityRange(INDEX ctQueries)
+{
+  CWorld *pwo = _pwoCurrentWorld;
+
+  if (pwo == NULL) {
+    CPrintF(TRANS("No world is currently loaded!\n"));
+    return;
+  }
+
+  ctQueries = Clamp(ctQueries, (INDEX)1, (INDEX)1000000);
+
+  // gather entities inside sectors to search around
+  CDynamicContainer<CEntity> cenOrigins;
+
+  {FOREACHINDYNAMICCONTAINER(pwo->wo_cenEntities, CEntity, iten) {
+    if (!iten->en_rdSectors.IsEmpty()) {
+      cenOrigins.Add(iten);
+    }
+  }}
+
+  if (cenOrigins.Count() == 0) {
+    CPrintF(TRANS("No entities to search around!\n"));
+    return;
+  }
+
+  // must be in 24bit mode when managing entities
+  CSetFPUPrecision FPUPrecision(FPT_24BIT);
+
+  const INDEX bOldCache = wld_bEntityCache;
+  DOUBLE adTime[2];
+  INDEX actFound[2];
+
+  for (INDEX iPass = 0; iPass < 2; iPass++) {
+    wld_bEntityCache = (iPass == 1);
+    pwo->wo_ecCache.Validate();
+
+    CDynamicContainer<CEntity> cenFound;
+    ULONG ulSeed = 0x5EED;
+    actFound[iPass] = 0;
+
+    CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+
+    for (INDEX iQuery = 0; iQuery < ctQueries; iQuery++) {
+      CEntity *pen = cenOrigins.Pointer((NextRandomSeed(ulSeed) >> 8) % cenOrigins.Count());
+
+      const FLOAT fRange = 5.0f + ((NextRandomSeed(ulSeed) >> 8) & 0xFF) / 255.0f * 45.0f;
+
+      cenFound.Clear();
+      pen->FindEntitiesInRange(FLOATaabbox3D(pen->en_plPlacement.pl_PositionVector, fRange), cenFound, FALSE);
+      actFound[iPass] += cenFound.Count();
+    }
+
+    adTime[iPass] = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+  }
+
+  wld_bEntityCache = bOldCache;
+
+  CPrintF(TRANS("%d range queries among %d entities:\n"), ctQueries, pwo->wo_cenEntities.Count());
+  CPrintF(TRANS("  without entity cache: %.2f ms (%d found)\n"), adTime[0] * 1000.0, actFound[0]);
+  CPrintF(TRANS("  with entity cache:    %.2f ms (%d found)\n"), adTime[1] * 1000.0, actFound[1]);
+};
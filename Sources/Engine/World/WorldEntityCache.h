@@ -0,0 +1,71 @@
+/* Copyright (c) 2026 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef SE_INCL_WORLDENTITYCACHE_H
+#define SE_INCL_WORLDENTITYCACHE_H
+
+#ifdef PRAGMA_ONCE
+  #pragma once
+#endif
+
+#include <Engine/Math/AABBox.h>
+#include <Engine/Templates/StaticStackArray.h>
+
+// Contiguous copies of entity data that is checked in loops over all existing entities in the world
+// Entries are kept in the same order as entities in CWorld::wo_cenEntities
+class ENGINE_API CEntityCache {
+  public:
+    CWorld *ec_pwoWorld; // World that the entities are in
+    BOOL ec_bValid; // Whether the entries match the container of entities
+
+    CStaticStackArray<FLOAT3D> ec_avPositions; // Positions
+    CStaticStackArray<FLOAT> ec_afRadii; // Radii of spheres around positions that contain first mips of brushes (negative for other entities)
+    CStaticStackArray<UBYTE> ec_aubRenderTypes; // Render types
+    CStaticStackArray<ULONG> ec_aulFlags; // Entity flags (only reliable for ones changed by SetFlags())
+
+  private:
+    // Copy entity data into some entry
+    void SetEntry(INDEX iEntry, CEntity *pen);
+
+  public:
+    // Constructor
+    CEntityCache(void);
+
+    // Remove all entries
+    void Clear(void);
+
+    // Mark entries as outdated after changing the container of entities directly
+    void Invalidate(void);
+
+    // Rebuild entries if they are outdated and check if the cache can be used
+    BOOL Validate(void);
+
+    // Add an entity that has just been added to the end of the container
+    void AddEntity(CEntity *pen);
+
+    // Remove an entity that has just been removed from the container
+    void RemoveEntity(CEntity *pen);
+
+    // Update entry of an entity after it has changed
+    void UpdateEntity(CEntity *pen);
+
+    // Check if the first brush mip of some entry is surely outside a box
+    inline BOOL IsOutsideBox(INDEX iEntry, const FLOATaabbox3D &box) const {
+      const FLOAT fRadius = ec_afRadii[iEntry];
+      return fRadius >= 0.0f && !box.HasContactWith(FLOATaabbox3D(ec_avPositions[iEntry], fRadius));
+    };
+};
+
+#endif // include-once check
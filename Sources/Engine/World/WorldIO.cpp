@@ -203,6 +203,9 @@ void CWorld::ReadBrushes_t( CTStream *istrm)// throw char *
     CallProgressHook_t(1.0f);
   }
 
+  // [Cecil] Read potentially visible sets of sectors if they have been calculated
+  wo_baBrushes.ReadPVS_t(*istrm);
+
   istrm->DictionaryReadEnd_t();
   _pwoCurrentLoading = NULL;
   _pfWorldEditingProfile.StopTimer(CWorldEditingProfile::PTI_READBRUSHES);
@@ -219,6 +222,12 @@ void CWorld::WriteBrushes_t( CTStream *ostrm) // throw char *
   ostrm->DictionaryWriteBegin_t(CTString(""), 0);
   wo_baBrushes.Write_t(ostrm);
   wo_taTerrains.Write_t(ostrm);
+
+  // [Cecil] Potentially visible sets are only valid with up-to-date portal links
+  if (wo_baBrushes.HasPVS() && wo_bPortalLinksUpToDate) {
+    wo_baBrushes.WritePVS_t(*ostrm);
+  }
+
   ostrm->DictionaryWriteEnd_t();
 }
 
@@ -402,6 +411,9 @@ void CWorld::ReadState_veryold_t( CTStream *istr) // throw char *
     SetBackgroundViewer(wo_cenAllEntities.Pointer(ienBackgroundViewer));
   }
 
+  // [Cecil] Entities are read directly and removed from the container
+  wo_ecCache.Invalidate();
+
   // for each entity
   {for(INDEX iEntity=0; iEntity<ctEntities; iEntity++) {
     CEntity &en = wo_cenAllEntities[iEntity];
@@ -516,6 +528,9 @@ void CWorld::ReadState_old_t( CTStream *istr) // throw char *
     SetBackgroundViewer(wo_cenAllEntities.Pointer(ienBackgroundViewer));
   }
 
+  // [Cecil] Entities are read directly and removed from the container
+  wo_ecCache.Invalidate();
+
   // for each entity
   {for(INDEX iEntity=0; iEntity<ctEntities; iEntity++) {
     CEntity &en = wo_cenAllEntities[iEntity];
@@ -652,6 +667,9 @@ void CWorld::ReadState_new_t( CTStream *istr) // throw char *
   }
 
   wo_cenEntities.Unlock();
+  // [Cecil] Entities are read directly and removed from the container
+  wo_ecCache.Invalidate();
+
   // for each entity
   {for(INDEX iEntity=0; iEntity<ctEntities; iEntity++) {
     CEntity &en = wo_cenAllEntities[iEntity];
@@ -23,6 +23,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Templates/DynamicContainer.cpp>
 #include <Engine/Templates/DynamicArray.cpp>
 #include <Engine/Brushes/Brush.h>
+#include <Engine/Brushes/BrushRayTree.h>
 #include <Engine/Templates/StaticArray.cpp>
 #include <Engine/Models/ModelObject.h>
 #include <Engine/Math/Clipping.inl>
@@ -47,6 +48,25 @@ public:
 static CStaticStackArray<CActiveSector> _aas;
 CListHead _lhTestedTerrains; // list of tested terrains
 
+// [Cecil] Polygons of a sector that are near the ray
+static CStaticStackArray<INDEX> _aiRayPolygons;
+
+// [Cecil] Use polygon trees for testing rays against big sectors
+INDEX wld_bRayCastTrees = TRUE;
+
+// [Cecil] Rays that are being cast through the whole world at once
+static CStaticStackArray<CCastRay *> _apcrWholeWorld;
+
+// [Cecil] Rays with an origin entity that are waiting to be cast in packets
+static CStaticStackArray<CCastRay *> _apcrPending;
+
+// [Cecil] Maximum amount of rays in one packet (one bit per ray in sector masks)
+#define CASTRAY_PACKET 32
+
+// [Cecil] Active sectors and tested terrains of each ray in the packet being cast
+static CStaticStackArray<CBrushSector *> _aapbscPacketSectors[CASTRAY_PACKET];
+static CStaticStackArray<CTerrain *> _aaptrPacketTerrains[CASTRAY_PACKET];
+
 // calculate origin position from ray placement
 static inline FLOAT3D CalculateRayOrigin(const CPlacement3D &plRay)
 {
@@ -75,6 +95,7 @@ void CCastRay::Init(CEntity *penOrigin, const FLOAT3D &vOrigin, const FLOAT3D &v
   cr_bAllowOverHit = FALSE;
   cr_pbpoIgnore = NULL;
   cr_penIgnore = NULL;
+  cr_iPacketRay = -1; // [Cecil]
 
   cr_bHitPortals = FALSE;
   cr_bHitTranslucentPortals = TRUE;
@@ -460,121 +481,163 @@ void CCastRay::TestTerrain(CEntity *penTerrain)
 }
 
 /*
- * Test against a brush sector.
+ * Test against a brush polygon.
  */
-void CCastRay::TestBrushSector(CBrushSector *pbscSector)
+void CCastRay::TestBrushPolygon(CBrushSector *pbscSector, CBrushPolygon &bpoPolygon)
 {
-  // if entity is hidden
-  if(pbscSector->bsc_pbmBrushMip->bm_pbrBrush->br_penEntity->en_ulFlags&ENF_HIDDEN)
-  {
-    // don't cast ray
+  if (&bpoPolygon==cr_pbpoIgnore) {
     return;
   }
-  // for each polygon in the sector
-  FOREACHINSTATICARRAY(pbscSector->bsc_abpoPolygons, CBrushPolygon, itpoPolygon) {
-    CBrushPolygon &bpoPolygon = itpoPolygon.Current();
 
-    if (&bpoPolygon==cr_pbpoIgnore) {
-      continue;
-    }
-
-    ULONG ulFlags = bpoPolygon.bpo_ulFlags;
-    // if not testing recursively
-    if (cr_penOrigin==NULL) {
-      // if the polygon is portal
-      if (ulFlags&BPOF_PORTAL) {
-        // if it is translucent or selected
-        if (ulFlags&(BPOF_TRANSLUCENT|BPOF_TRANSPARENT|BPOF_SELECTED)) {
-          // if translucent portals should be passed through
-          if (!cr_bHitTranslucentPortals) {
-            // skip this polygon
-            continue;
-          }
-        // if it is not translucent
-        } else {
-           // if portals should be passed through
-          if (!cr_bHitPortals) {
-            // skip this polygon
-            continue;
-          }
+  ULONG ulFlags = bpoPolygon.bpo_ulFlags;
+  // if not testing recursively
+  if (cr_penOrigin==NULL) {
+    // if the polygon is portal
+    if (ulFlags&BPOF_PORTAL) {
+      // if it is translucent or selected
+      if (ulFlags&(BPOF_TRANSLUCENT|BPOF_TRANSPARENT|BPOF_SELECTED)) {
+        // if translucent portals should be passed through
+        if (!cr_bHitTranslucentPortals) {
+          // skip this polygon
+          return;
+        }
+      // if it is not translucent
+      } else {
+         // if portals should be passed through
+        if (!cr_bHitPortals) {
+          // skip this polygon
+          return;
         }
-      }
-      // if polygon is detail, and detail polygons are off
-      extern INDEX wld_bRenderDetailPolygons;
-      if ((ulFlags&BPOF_DETAILPOLYGON) && !wld_bRenderDetailPolygons) {
-        // skip this polygon
-        continue;
       }
     }
-    // get distances of ray points from the polygon plane
-    FLOAT fDistance0 = bpoPolygon.bpo_pbplPlane->bpl_plAbsolute.PointDistance(cr_vOrigin);
-    FLOAT fDistance1 = bpoPolygon.bpo_pbplPlane->bpl_plAbsolute.PointDistance(cr_vTarget);
-
-    // if the ray hits the polygon plane
-    if (fDistance0>=0 && fDistance0>=fDistance1) {
-      // calculate fraction of line before intersection
-      FLOAT fFraction = fDistance0/((fDistance0-fDistance1) + 0.0000001f/*correction*/);
-      // calculate intersection coordinate
-      FLOAT3D vHitPoint = cr_vOrigin+(cr_vTarget-cr_vOrigin)*fFraction;
-      // calculate intersection distance
-      FLOAT fHitDistance = (vHitPoint-cr_vOrigin).Length();
-      // if the hit point can not be new closest candidate
-      if (fHitDistance>cr_fHitDistance) {
-        // skip this polygon
-        continue;
-      }
+    // if polygon is detail, and detail polygons are off
+    extern INDEX wld_bRenderDetailPolygons;
+    if ((ulFlags&BPOF_DETAILPOLYGON) && !wld_bRenderDetailPolygons) {
+      // skip this polygon
+      return;
+    }
+  }
+  // get distances of ray points from the polygon plane
+  FLOAT fDistance0 = bpoPolygon.bpo_pbplPlane->bpl_plAbsolute.PointDistance(cr_vOrigin);
+  FLOAT fDistance1 = bpoPolygon.bpo_pbplPlane->bpl_plAbsolute.PointDistance(cr_vTarget);
+
+  // if the ray hits the polygon plane
+  if (fDistance0>=0 && fDistance0>=fDistance1) {
+    // calculate fraction of line before intersection
+    FLOAT fFraction = fDistance0/((fDistance0-fDistance1) + 0.0000001f/*correction*/);
+    // calculate intersection coordinate
+    FLOAT3D vHitPoint = cr_vOrigin+(cr_vTarget-cr_vOrigin)*fFraction;
+    // calculate intersection distance
+    FLOAT fHitDistance = (vHitPoint-cr_vOrigin).Length();
+    // if the hit point can not be new closest candidate
+    if (fHitDistance>cr_fHitDistance) {
+      // skip this polygon
+      return;
+    }
 
-      // find major axes of the polygon plane
-      INDEX iMajorAxis1, iMajorAxis2;
-      GetMajorAxesForPlane(itpoPolygon->bpo_pbplPlane->bpl_plAbsolute, iMajorAxis1, iMajorAxis2);
-
-      // create an intersector
-      CIntersector isIntersector(vHitPoint(iMajorAxis1), vHitPoint(iMajorAxis2));
-      // for all edges in the polygon
-      FOREACHINSTATICARRAY(bpoPolygon.bpo_abpePolygonEdges, CBrushPolygonEdge,
-        itbpePolygonEdge) {
-        // get edge vertices (edge direction is irrelevant here!)
-        const FLOAT3D &vVertex0 = itbpePolygonEdge->bpe_pbedEdge->bed_pbvxVertex0->bvx_vAbsolute;
-        const FLOAT3D &vVertex1 = itbpePolygonEdge->bpe_pbedEdge->bed_pbvxVertex1->bvx_vAbsolute;
-        // pass the edge to the intersector
-        isIntersector.AddEdge(
-          vVertex0(iMajorAxis1), vVertex0(iMajorAxis2),
-          vVertex1(iMajorAxis1), vVertex1(iMajorAxis2));
-      }
-      // if the polygon is intersected by the ray
-      if (isIntersector.IsIntersecting()) {
-        // if it is portal and testing recusively
-        if ((ulFlags&cr_ulPassablePolygons) && (cr_penOrigin!=NULL)) {
-          // for each sector on the other side
-          {FOREACHDSTOFSRC(bpoPolygon.bpo_rsOtherSideSectors, CBrushSector, bsc_rdOtherSidePortals, pbsc)
-            // add the sector
-            AddSector(pbsc);
-          ENDFOR}
-
-          if( cr_bHitPortals && ulFlags&(BPOF_TRANSLUCENT|BPOF_TRANSPARENT) && !cr_bPhysical)
-          {
-            // remember hit coordinates
-            cr_fHitDistance=fHitDistance;
-            cr_penHit = pbscSector->bsc_pbmBrushMip->bm_pbrBrush->br_penEntity;
-            cr_pbscBrushSector = pbscSector;
-            cr_pbpoBrushPolygon = &bpoPolygon;
-          }
-        // if the ray just plainly hit it
-        } else {
+    // find major axes of the polygon plane
+    INDEX iMajorAxis1, iMajorAxis2;
+    GetMajorAxesForPlane(bpoPolygon.bpo_pbplPlane->bpl_plAbsolute, iMajorAxis1, iMajorAxis2);
+
+    // create an intersector
+    CIntersector isIntersector(vHitPoint(iMajorAxis1), vHitPoint(iMajorAxis2));
+    // for all edges in the polygon
+    FOREACHINSTATICARRAY(bpoPolygon.bpo_abpePolygonEdges, CBrushPolygonEdge,
+      itbpePolygonEdge) {
+      // get edge vertices (edge direction is irrelevant here!)
+      const FLOAT3D &vVertex0 = itbpePolygonEdge->bpe_pbedEdge->bed_pbvxVertex0->bvx_vAbsolute;
+      const FLOAT3D &vVertex1 = itbpePolygonEdge->bpe_pbedEdge->bed_pbvxVertex1->bvx_vAbsolute;
+      // pass the edge to the intersector
+      isIntersector.AddEdge(
+        vVertex0(iMajorAxis1), vVertex0(iMajorAxis2),
+        vVertex1(iMajorAxis1), vVertex1(iMajorAxis2));
+    }
+    // if the polygon is intersected by the ray
+    if (isIntersector.IsIntersecting()) {
+      // if it is portal and testing recusively
+      if ((ulFlags&cr_ulPassablePolygons) && (cr_penOrigin!=NULL)) {
+        // for each sector on the other side
+        {FOREACHDSTOFSRC(bpoPolygon.bpo_rsOtherSideSectors, CBrushSector, bsc_rdOtherSidePortals, pbsc)
+          // add the sector
+          AddSector(pbsc);
+        ENDFOR}
+
+        if( cr_bHitPortals && ulFlags&(BPOF_TRANSLUCENT|BPOF_TRANSPARENT) && !cr_bPhysical)
+        {
           // remember hit coordinates
           cr_fHitDistance=fHitDistance;
           cr_penHit = pbscSector->bsc_pbmBrushMip->bm_pbrBrush->br_penEntity;
           cr_pbscBrushSector = pbscSector;
           cr_pbpoBrushPolygon = &bpoPolygon;
         }
+      // if the ray just plainly hit it
+      } else {
+        // remember hit coordinates
+        cr_fHitDistance=fHitDistance;
+        cr_penHit = pbscSector->bsc_pbmBrushMip->bm_pbrBrush->br_penEntity;
+        cr_pbscBrushSector = pbscSector;
+        cr_pbpoBrushPolygon = &bpoPolygon;
       }
     }
   }
 }
 
+/*
+ * Test against a brush sector.
+ */
+void CCastRay::TestBrushSector(CBrushSector *pbscSector)
+{
+  // if entity is hidden
+  CEntity *penBrush = pbscSector->bsc_pbmBrushMip->bm_pbrBrush->br_penEntity;
+  if(penBrush->en_ulFlags&ENF_HIDDEN)
+  {
+    // don't cast ray
+    return;
+  }
+
+  // [Cecil] if the sector has a polygon tree
+  CBrushRayTree *prtTree = (wld_bRayCastTrees ? pbscSector->GetRayTree() : NULL);
+  FLOAT3D vDirection = cr_vTarget-cr_vOrigin;
+  const FLOAT fLength = vDirection.Length();
+
+  if (prtTree!=NULL && fLength>0.0001f) {
+    vDirection/=fLength;
+
+    // transform the ray into brush space where the tree is
+    const FLOATmatrix3D mInvRotation = !penBrush->en_mRotation;
+    const FLOAT3D vOriginRelative = (cr_vOrigin-penBrush->en_plPlacement.pl_PositionVector)*mInvRotation;
+    const FLOAT3D vDirectionRelative = vDirection*mInvRotation;
+
+    // test only polygons near the ray in their original order
+    _aiRayPolygons.PopAll();
+    prtTree->FindPolygons(vOriginRelative, vDirectionRelative, cr_fHitDistance, _aiRayPolygons);
+
+    for (INDEX i = 0; i < _aiRayPolygons.Count(); i++) {
+      TestBrushPolygon(pbscSector, pbscSector->bsc_abpoPolygons[_aiRayPolygons[i]]);
+    }
+    return;
+  }
+
+  // for each polygon in the sector
+  FOREACHINSTATICARRAY(pbscSector->bsc_abpoPolygons, CBrushPolygon, itpoPolygon) {
+    TestBrushPolygon(pbscSector, itpoPolygon.Current());
+  }
+}
+
 /* Add a sector if needed. */
 inline void CCastRay::AddSector(CBrushSector *pbsc)
 {
+  // [Cecil] rays in a packet have their own lists of active sectors
+  if (cr_iPacketRay>=0) {
+    const ULONG ulRayBit = (1UL<<cr_iPacketRay);
+
+    if (pbsc->bsc_pbmBrushMip->IsFirstMip() && !(pbsc->bsc_ulRayPacketMask&ulRayBit)) {
+      _aapbscPacketSectors[cr_iPacketRay].Push() = pbsc;
+      pbsc->bsc_ulRayPacketMask|=ulRayBit;
+    }
+    return;
+  }
+
   // if not already active and in first mip of its brush
   if ( pbsc->bsc_pbmBrushMip->IsFirstMip()
     &&!(pbsc->bsc_ulFlags&BSCF_RAYTESTED)) {
@@ -617,82 +680,88 @@ void CCastRay::AddSectorsAroundEntity(CEntity *pen)
   ENDFOR}
 }
 
-/* Test entire world against ray. */
-void CCastRay::TestWholeWorld(CWorld *pwoWorld)
+/* Test one entity of the world against ray. */
+void CCastRay::TestWorldEntity(CEntity *penInWorld)
 {
-  // for each entity in the world
-  {FOREACHINDYNAMICCONTAINER(pwoWorld->wo_cenEntities, CEntity, itenInWorld) {
-    // if it is the origin of the ray
-    if (itenInWorld==cr_penOrigin || itenInWorld==cr_penIgnore) {
-      // skip it
-      continue;
-    }
+  // if it is the origin of the ray
+  if (penInWorld==cr_penOrigin || penInWorld==cr_penIgnore) {
+    // skip it
+    return;
+  }
 
-    // if it is a brush and testing against brushes is disabled
-    if( (itenInWorld->en_RenderType == CEntity::RT_BRUSH ||
-         itenInWorld->en_RenderType == CEntity::RT_FIELDBRUSH) && 
-         !cr_bHitBrushes) {
+  // if it is a brush and testing against brushes is disabled
+  if( (penInWorld->en_RenderType == CEntity::RT_BRUSH ||
+       penInWorld->en_RenderType == CEntity::RT_FIELDBRUSH) && 
+       !cr_bHitBrushes) {
+    // skip it
+    return;
+  }
+
+  // if it is a model and testing against models is enabled
+  if(((penInWorld->en_RenderType == CEntity::RT_MODEL
+    ||(penInWorld->en_RenderType == CEntity::RT_EDITORMODEL
+       && _wrpWorldRenderPrefs.IsEditorModelsOn()))
+    && cr_ttHitModels != TT_NONE)
+  //  and if cast type is TT_FULL_SEETROUGH then model is not
+  //  ENF_SEETROUGH
+    && !((cr_ttHitModels == TT_FULLSEETHROUGH || cr_ttHitModels == TT_COLLISIONBOX) &&
+         (penInWorld->en_ulFlags&ENF_SEETHROUGH))) {
+    // test it against the model entity
+    TestModel(penInWorld);
+  // if it is a ska model
+  } else if(((penInWorld->en_RenderType == CEntity::RT_SKAMODEL
+    ||(penInWorld->en_RenderType == CEntity::RT_SKAEDITORMODEL
+       && _wrpWorldRenderPrefs.IsEditorModelsOn()))
+    && cr_ttHitModels != TT_NONE)
+  //  and if cast type is TT_FULL_SEETROUGH then model is not
+  //  ENF_SEETROUGH
+    && !((cr_ttHitModels == TT_FULLSEETHROUGH || cr_ttHitModels == TT_COLLISIONBOX) &&
+         (penInWorld->en_ulFlags&ENF_SEETHROUGH))) {
+    TestSkaModel(penInWorld);
+  } else if (penInWorld->en_RenderType == CEntity::RT_TERRAIN) {
+    TestTerrain(penInWorld);
+  // if it is a brush
+  } else if (penInWorld->en_RenderType == CEntity::RT_BRUSH ||
+    (penInWorld->en_RenderType == CEntity::RT_FIELDBRUSH
+    &&_wrpWorldRenderPrefs.IsFieldBrushesOn() && cr_bHitFields)) {
+    // get its brush
+    CBrush3D &brBrush = *penInWorld->en_pbrBrush;
+
+    // get relevant mip as if in manual mip brushing mode
+    CBrushMip *pbmMip = brBrush.GetBrushMipByDistance(
+      _wrpWorldRenderPrefs.GetManualMipBrushingFactor());
+
+    // if it has no brush mip for that mip factor
+    if (pbmMip==NULL) {
       // skip it
-      continue;
+      return;
     }
 
-    // if it is a model and testing against models is enabled
-    if(((itenInWorld->en_RenderType == CEntity::RT_MODEL
-      ||(itenInWorld->en_RenderType == CEntity::RT_EDITORMODEL
-         && _wrpWorldRenderPrefs.IsEditorModelsOn()))
-      && cr_ttHitModels != TT_NONE)
-    //  and if cast type is TT_FULL_SEETROUGH then model is not
-    //  ENF_SEETROUGH
-      && !((cr_ttHitModels == TT_FULLSEETHROUGH || cr_ttHitModels == TT_COLLISIONBOX) &&
-           (itenInWorld->en_ulFlags&ENF_SEETHROUGH))) {
+    // if it has zero sectors
+    if (pbmMip->bm_abscSectors.Count()==0){
       // test it against the model entity
-      TestModel(itenInWorld);
-    // if it is a ska model
-    } else if(((itenInWorld->en_RenderType == CEntity::RT_SKAMODEL
-      ||(itenInWorld->en_RenderType == CEntity::RT_SKAEDITORMODEL
-         && _wrpWorldRenderPrefs.IsEditorModelsOn()))
-      && cr_ttHitModels != TT_NONE)
-    //  and if cast type is TT_FULL_SEETROUGH then model is not
-    //  ENF_SEETROUGH
-      && !((cr_ttHitModels == TT_FULLSEETHROUGH || cr_ttHitModels == TT_COLLISIONBOX) &&
-           (itenInWorld->en_ulFlags&ENF_SEETHROUGH))) {
-      TestSkaModel(itenInWorld);
-    } else if (itenInWorld->en_RenderType == CEntity::RT_TERRAIN) {
-      TestTerrain(itenInWorld);
-    // if it is a brush
-    } else if (itenInWorld->en_RenderType == CEntity::RT_BRUSH ||
-      (itenInWorld->en_RenderType == CEntity::RT_FIELDBRUSH
-      &&_wrpWorldRenderPrefs.IsFieldBrushesOn() && cr_bHitFields)) {
-      // get its brush
-      CBrush3D &brBrush = *itenInWorld->en_pbrBrush;
-
-      // get relevant mip as if in manual mip brushing mode
-      CBrushMip *pbmMip = brBrush.GetBrushMipByDistance(
-        _wrpWorldRenderPrefs.GetManualMipBrushingFactor());
-
-      // if it has no brush mip for that mip factor
-      if (pbmMip==NULL) {
-        // skip it
-        continue;
-      }
-
-      // if it has zero sectors
-      if (pbmMip->bm_abscSectors.Count()==0){
-        // test it against the model entity
-        TestModel(itenInWorld);
-
-      // if it has some sectors
-      } else {
-        // for each sector in the brush mip
-        FOREACHINDYNAMICARRAY(pbmMip->bm_abscSectors, CBrushSector, itbsc) {
-          // if the sector is not hidden
-          if (!(itbsc->bsc_ulFlags & BSCF_HIDDEN)) {
-            // test the ray against the sector
-            TestBrushSector(itbsc);
-          }
+      TestModel(penInWorld);
+
+    // if it has some sectors
+    } else {
+      // for each sector in the brush mip
+      FOREACHINDYNAMICARRAY(pbmMip->bm_abscSectors, CBrushSector, itbsc) {
+        // if the sector is not hidden
+        if (!(itbsc->bsc_ulFlags & BSCF_HIDDEN)) {
+          // test the ray against the sector
+          TestBrushSector(itbsc);
         }
       }
     }
+  }
+}
+
+/* Test entire world against ray. */
+void CCastRay::TestWholeWorld(CWorld *pwoWorld)
+{
+  // for each entity in the world
+  {FOREACHINDYNAMICCONTAINER(pwoWorld->wo_cenEntities, CEntity, itenInWorld) {
+    TestWorldEntity(itenInWorld);
   }}
 }
 
@@ -706,51 +775,7 @@ void CCastRay::TestThroughSectors(void)
     TestBrushSector(pbsc);
     // for each entity in the sector
     {FOREACHDSTOFSRC(pbsc->bsc_rsEntities, CEntity, en_rdSectors, pen)
-      // if it is the origin of the ray
-      if (pen==cr_penOrigin || pen==cr_penIgnore) {
-        // skip it
-        continue;
-      }
-      // if it is a model and testing against models is enabled
-      if(((pen->en_RenderType == CEntity::RT_MODEL
-        ||(pen->en_RenderType == CEntity::RT_EDITORMODEL
-           && _wrpWorldRenderPrefs.IsEditorModelsOn()))
-        && cr_ttHitModels != TT_NONE)
-      //  and if cast type is TT_FULL_SEETROUGH then model is not
-      //  ENF_SEETROUGH
-        && !((cr_ttHitModels == TT_FULLSEETHROUGH || cr_ttHitModels == TT_COLLISIONBOX) &&
-             (pen->en_ulFlags&ENF_SEETHROUGH))) {
-        // test it against the model entity
-        TestModel(pen);
-      // if is is a ska model
-      } else if(((pen->en_RenderType == CEntity::RT_SKAMODEL
-        ||(pen->en_RenderType == CEntity::RT_SKAEDITORMODEL
-           && _wrpWorldRenderPrefs.IsEditorModelsOn()))
-        && cr_ttHitModels != TT_NONE)
-      //  and if cast type is TT_FULL_SEETROUGH then model is not
-      //  ENF_SEETROUGH
-        && !((cr_ttHitModels == TT_FULLSEETHROUGH || cr_ttHitModels == TT_COLLISIONBOX) &&
-             (pen->en_ulFlags&ENF_SEETHROUGH))) {
-        // test it against the ska model entity
-        TestSkaModel(pen);
-      // if it is a terrain
-      } else if( pen->en_RenderType == CEntity::RT_TERRAIN) {
-        CTerrain *ptrTerrain = pen->GetTerrain();
-        ASSERT(ptrTerrain!=NULL);
-        // if terrain hasn't allready been tested
-        if(!ptrTerrain->tr_lnInActiveTerrains.IsLinked()) {
-          // test it now and add it to list of tested terrains
-          TestTerrain(pen);
-          _lhTestedTerrains.AddTail(ptrTerrain->tr_lnInActiveTerrains);
-        }
-      // if it is a non-hidden brush
-      } else if ( (pen->en_RenderType == CEntity::RT_BRUSH) &&
-                  !(pen->en_ulFlags&ENF_HIDDEN) ) {
-        // get its brush
-        CBrush3D &brBrush = *pen->en_pbrBrush;
-        // add all sectors in the brush
-        AddAllSectorsOfBrush(&brBrush);
-      }
+      TestSectorEntity(pen);
     ENDFOR}
   }
 
@@ -762,16 +787,72 @@ void CCastRay::TestThroughSectors(void)
   ASSERT(_lhTestedTerrains.IsEmpty());
 }
 
+/* [Cecil] Test one entity from an active sector against ray. */
+void CCastRay::TestSectorEntity(CEntity *pen)
+{
+  // if it is the origin of the ray
+  if (pen==cr_penOrigin || pen==cr_penIgnore) {
+    // skip it
+    return;
+  }
+  // if it is a model and testing against models is enabled
+  if(((pen->en_RenderType == CEntity::RT_MODEL
+    ||(pen->en_RenderType == CEntity::RT_EDITORMODEL
+       && _wrpWorldRenderPrefs.IsEditorModelsOn()))
+    && cr_ttHitModels != TT_NONE)
+  //  and if cast type is TT_FULL_SEETROUGH then model is not
+  //  ENF_SEETROUGH
+    && !((cr_ttHitModels == TT_FULLSEETHROUGH || cr_ttHitModels == TT_COLLISIONBOX) &&
+         (pen->en_ulFlags&ENF_SEETHROUGH))) {
+    // test it against the model entity
+    TestModel(pen);
+  // if is is a ska model
+  } else if(((pen->en_RenderType == CEntity::RT_SKAMODEL
+    ||(pen->en_RenderType == CEntity::RT_SKAEDITORMODEL
+       && _wrpWorldRenderPrefs.IsEditorModelsOn()))
+    && cr_ttHitModels != TT_NONE)
+  //  and if cast type is TT_FULL_SEETROUGH then model is not
+  //  ENF_SEETROUGH
+    && !((cr_ttHitModels == TT_FULLSEETHROUGH || cr_ttHitModels == TT_COLLISIONBOX) &&
+         (pen->en_ulFlags&ENF_SEETHROUGH))) {
+    // test it against the ska model entity
+    TestSkaModel(pen);
+  // if it is a terrain
+  } else if( pen->en_RenderType == CEntity::RT_TERRAIN) {
+    CTerrain *ptrTerrain = pen->GetTerrain();
+    ASSERT(ptrTerrain!=NULL);
+
+    // rays in a packet have their own lists of tested terrains
+    if (cr_iPacketRay>=0) {
+      CStaticStackArray<CTerrain *> &aptrTested = _aaptrPacketTerrains[cr_iPacketRay];
+
+      for (INDEX itr=0; itr<aptrTested.Count(); itr++) {
+        if (aptrTested[itr]==ptrTerrain) return;
+      }
+      TestTerrain(pen);
+      aptrTested.Push() = ptrTerrain;
+
+    // if terrain hasn't allready been tested
+    } else if(!ptrTerrain->tr_lnInActiveTerrains.IsLinked()) {
+      // test it now and add it to list of tested terrains
+      TestTerrain(pen);
+      _lhTestedTerrains.AddTail(ptrTerrain->tr_lnInActiveTerrains);
+    }
+  // if it is a non-hidden brush
+  } else if ( (pen->en_RenderType == CEntity::RT_BRUSH) &&
+              !(pen->en_ulFlags&ENF_HIDDEN) ) {
+    // get its brush
+    CBrush3D &brBrush = *pen->en_pbrBrush;
+    // add all sectors in the brush
+    AddAllSectorsOfBrush(&brBrush);
+  }
+}
+
 /*
- * Do the ray casting.
+ * Prepare the ray for testing.
  */
-void CCastRay::Cast(CWorld *pwoWorld)
+void CCastRay::BeginCast(void)
 {
-  // setup stat timers
-  const BOOL bMainLoopTimer = _sfStats.CheckTimer(CStatForm::STI_MAINLOOP);
-  if( bMainLoopTimer) _sfStats.StopTimer(CStatForm::STI_MAINLOOP);
-  _sfStats.StartTimer(CStatForm::STI_RAYCAST);
-
   // initially no polygon is found
   cr_pbpoBrushPolygon= NULL;
   cr_pbscBrushSector = NULL;
@@ -781,6 +862,28 @@ void CCastRay::Cast(CWorld *pwoWorld)
   } else {
     cr_ulPassablePolygons = BPOF_PORTAL|BPOF_OCCLUDER;
   }
+}
+
+/*
+ * Finish testing the ray.
+ */
+void CCastRay::EndCast(void)
+{
+	// calculate the hit point from the hit distance
+  cr_vHit = cr_vOrigin + (cr_vTarget-cr_vOrigin).Normalize()*cr_fHitDistance;
+}
+
+/*
+ * Do the ray casting.
+ */
+void CCastRay::Cast(CWorld *pwoWorld)
+{
+  // setup stat timers
+  const BOOL bMainLoopTimer = _sfStats.CheckTimer(CStatForm::STI_MAINLOOP);
+  if( bMainLoopTimer) _sfStats.StopTimer(CStatForm::STI_MAINLOOP);
+  _sfStats.StartTimer(CStatForm::STI_RAYCAST);
+
+  BeginCast();
 
   // if origin entity is given
   if (cr_penOrigin!=NULL) {
@@ -797,8 +900,7 @@ void CCastRay::Cast(CWorld *pwoWorld)
     TestWholeWorld(pwoWorld);
   }
 
-	// calculate the hit point from the hit distance
-  cr_vHit = cr_vOrigin + (cr_vTarget-cr_vOrigin).Normalize()*cr_fHitDistance;
+  EndCast();
 
   // done with timing
   _sfStats.StopTimer(CStatForm::STI_RAYCAST);
@@ -830,6 +932,226 @@ void CWorld::CastRay(CCastRay &crRay)
 {
   crRay.Cast(this);
 }
+// [Cecil] Test one active sector against all rays of a packet that have it at the same step
+static void TestSectorWithPacket(CBrushSector *pbsc, CCastRay **apcrPacket, ULONG ulRays)
+{
+  CEntity *penBrush = pbsc->bsc_pbmBrushMip->bm_pbrBrush->br_penEntity;
+
+  // if entity isn't hidden
+  if (!(penBrush->en_ulFlags&ENF_HIDDEN)) {
+    CBrushRayTree *prtTree = (wld_bRayCastTrees ? pbsc->GetRayTree() : NULL);
+
+    // if the sector has a polygon tree
+    if (prtTree!=NULL) {
+      const FLOATmatrix3D mInvRotation = !penBrush->en_mRotation;
+      const FLOAT3D &vBrush = penBrush->en_plPlacement.pl_PositionVector;
+
+      // gather a box around all ray segments in brush space
+      FLOATaabbox3D boxRays;
+      ULONG ulTreeRays = 0;
+
+      for (INDEX iRay = 0; iRay < CASTRAY_PACKET; iRay++) {
+        if (!(ulRays&(1UL<<iRay))) continue;
+        CCastRay &cr = *apcrPacket[iRay];
+
+        FLOAT3D vDirection = cr.cr_vTarget-cr.cr_vOrigin;
+        const FLOAT fLength = vDirection.Length();
+
+        // very short rays test all polygons on their own, like individual casts
+        if (fLength<=0.0001f) {
+          cr.TestBrushSector(pbsc);
+          continue;
+        }
+
+        vDirection/=fLength;
+
+        const FLOAT3D vOriginRelative = (cr.cr_vOrigin-vBrush)*mInvRotation;
+        const FLOAT3D vEndRelative = vOriginRelative + (vDirection*mInvRotation)*cr.cr_fHitDistance;
+        boxRays |= FLOATaabbox3D(vOriginRelative, vEndRelative);
+        ulTreeRays |= (1UL<<iRay);
+      }
+
+      if (ulTreeRays!=0) {
+        // polygons that any ray segment can touch are within the box, so each ray still
+        // tests all polygons that its own tree query would find, in the same order
+        boxRays.Expand(0.01f);
+
+        _aiRayPolygons.PopAll();
+        prtTree->FindPolygonsInBox(boxRays, _aiRayPolygons);
+
+        for (INDEX i = 0; i < _aiRayPolygons.Count(); i++) {
+          CBrushPolygon &bpo = pbsc->bsc_abpoPolygons[_aiRayPolygons[i]];
+
+          for (INDEX iRay = 0; iRay < CASTRAY_PACKET; iRay++) {
+            if (ulTreeRays&(1UL<<iRay)) {
+              apcrPacket[iRay]->TestBrushPolygon(pbsc, bpo);
+            }
+          }
+        }
+      }
+
+    // test each polygon against all rays in a row
+    } else {
+      FOREACHINSTATICARRAY(pbsc->bsc_abpoPolygons, CBrushPolygon, itbpo) {
+        for (INDEX iRay = 0; iRay < CASTRAY_PACKET; iRay++) {
+          if (ulRays&(1UL<<iRay)) {
+            apcrPacket[iRay]->TestBrushPolygon(pbsc, itbpo.Current());
+          }
+        }
+      }
+    }
+  }
+
+  // test each entity in the sector against all rays in a row
+  {FOREACHDSTOFSRC(pbsc->bsc_rsEntities, CEntity, en_rdSectors, pen)
+    for (INDEX iRay = 0; iRay < CASTRAY_PACKET; iRay++) {
+      if (ulRays&(1UL<<iRay)) {
+        apcrPacket[iRay]->TestSectorEntity(pen);
+      }
+    }
+  ENDFOR}
+}
+
+// [Cecil] Cast a packet of rays from the same origin entity through their sectors side by side
+// Each ray keeps its own list of active sectors in the same order as if it was cast alone,
+// but rays that reach the same sector at the same step share the polygon query and the entity walk
+static void CastRayPacket(CCastRay **apcrPacket, INDEX ctRays)
+{
+  ASSERT(ctRays>0 && ctRays<=CASTRAY_PACKET);
+
+  // gather sectors around the origin only once
+  CCastRay &crFirst = *apcrPacket[0];
+  crFirst.cr_iPacketRay = 0;
+  crFirst.AddSectorsAroundEntity(crFirst.cr_penOrigin);
+
+  const CStaticStackArray<CBrushSector *> &apbscFirst = _aapbscPacketSectors[0];
+
+  for (INDEX iRay = 1; iRay < ctRays; iRay++) {
+    apcrPacket[iRay]->cr_iPacketRay = iRay;
+
+    for (INDEX ias = 0; ias < apbscFirst.Count(); ias++) {
+      CBrushSector *pbsc = apbscFirst[ias];
+      _aapbscPacketSectors[iRay].Push() = pbsc;
+      pbsc->bsc_ulRayPacketMask |= (1UL<<iRay);
+    }
+  }
+
+  // go through active sectors of all rays (sectors are added during iteration!)
+  for (INDEX ias = 0;; ias++) {
+    ULONG ulPending = 0;
+
+    for (INDEX iRay = 0; iRay < ctRays; iRay++) {
+      if (ias<_aapbscPacketSectors[iRay].Count()) {
+        ulPending |= (1UL<<iRay);
+      }
+    }
+
+    // no ray has any more sectors
+    if (ulPending==0) break;
+
+    // test each distinct sector at this step with all rays that have it
+    while (ulPending!=0) {
+      INDEX iFirst = 0;
+      while (!(ulPending&(1UL<<iFirst))) iFirst++;
+
+      CBrushSector *pbsc = _aapbscPacketSectors[iFirst][ias];
+      ULONG ulRays = 0;
+
+      for (INDEX iRay = iFirst; iRay < ctRays; iRay++) {
+        if ((ulPending&(1UL<<iRay)) && _aapbscPacketSectors[iRay][ias]==pbsc) {
+          ulRays |= (1UL<<iRay);
+        }
+      }
+
+      ulPending &= ~ulRays;
+      TestSectorWithPacket(pbsc, apcrPacket, ulRays);
+    }
+  }
+
+  // finish all rays and release their sectors
+  for (INDEX iRay = 0; iRay < ctRays; iRay++) {
+    CCastRay &cr = *apcrPacket[iRay];
+    cr.EndCast();
+    cr.cr_iPacketRay = -1;
+
+    CStaticStackArray<CBrushSector *> &apbsc = _aapbscPacketSectors[iRay];
+
+    for (INDEX ias = 0; ias < apbsc.Count(); ias++) {
+      apbsc[ias]->bsc_ulRayPacketMask = 0;
+    }
+
+    apbsc.PopAll();
+    _aaptrPacketTerrains[iRay].PopAll();
+  }
+}
+
+/*
+ * [Cecil] Cast multiple rays at once.
+ */
+void CWorld::CastRays(CCastRay **apcrRays, INDEX ctRays)
+{
+  // setup stat timers
+  const BOOL bMainLoopTimer = _sfStats.CheckTimer(CStatForm::STI_MAINLOOP);
+  if( bMainLoopTimer) _sfStats.StopTimer(CStatForm::STI_MAINLOOP);
+  _sfStats.StartTimer(CStatForm::STI_RAYCAST);
+
+  _apcrWholeWorld.PopAll();
+  _apcrPending.PopAll();
+
+  for (INDEX iRay = 0; iRay < ctRays; iRay++) {
+    CCastRay &cr = *apcrRays[iRay];
+    cr.BeginCast();
+
+    // rays without an origin are tested against the whole world together
+    if (cr.cr_penOrigin==NULL) {
+      _apcrWholeWorld.Push() = &cr;
+    } else {
+      _apcrPending.Push() = &cr;
+    }
+  }
+
+  // cast rays from the same origin entity in packets
+  while (_apcrPending.Count() > 0) {
+    CEntity *penOrigin = _apcrPending[0]->cr_penOrigin;
+
+    CCastRay *apcrPacket[CASTRAY_PACKET];
+    INDEX ctPacket = 0;
+    INDEX ctLeft = 0;
+
+    for (INDEX iRay = 0; iRay < _apcrPending.Count(); iRay++) {
+      CCastRay *pcr = _apcrPending[iRay];
+
+      if (pcr->cr_penOrigin==penOrigin && ctPacket<CASTRAY_PACKET) {
+        apcrPacket[ctPacket++] = pcr;
+      } else {
+        _apcrPending[ctLeft++] = pcr;
+      }
+    }
+
+    _apcrPending.PopUntil(ctLeft - 1);
+    CastRayPacket(apcrPacket, ctPacket);
+  }
+
+  // test each entity against all rays in a row while it's still in the cache
+  const INDEX ctWholeWorld = _apcrWholeWorld.Count();
+
+  if (ctWholeWorld > 0) {
+    {FOREACHINDYNAMICCONTAINER(wo_cenEntities, CEntity, iten) {
+      for (INDEX iRay = 0; iRay < ctWholeWorld; iRay++) {
+        _apcrWholeWorld[iRay]->TestWorldEntity(iten);
+      }
+    }}
+
+    for (INDEX iRay = 0; iRay < ctWholeWorld; iRay++) {
+      _apcrWholeWorld[iRay]->EndCast();
+    }
+  }
+
+  // done with timing
+  _sfStats.StopTimer(CStatForm::STI_RAYCAST);
+  if( bMainLoopTimer) _sfStats.StartTimer(CStatForm::STI_MAINLOOP);
+}
+
 /*
  * Continue to cast already cast ray
  */
@@ -837,3 +1159,163 @@ void CWorld::ContinueCast(CCastRay &crRay)
 {
   crRay.ContinueCast(this);
 }
+
+// [Cecil] Amount of benchmark rays cast from the same place in similar directions
+#define BENCHMARK_SPREAD 16
+
+// [Cecil] Result of one benchmarked ray
+struct BenchmarkRay_t {
+  CEntity *penOrigin;
+  FLOAT3D vOrigin;
+  FLOAT3D vTarget;
+
+  CEntity *penHit;
+  CBrushPolygon *pbpoHit;
+  FLOAT fHitDistance;
+
+  inline void Clear(void) {};
+};
+
+// [Cecil] Remember or compare the result of one benchmark ray
+static void CheckBenchmarkRay(BenchmarkRay_t &ray, const CCastRay &crRay, BOOL bCompare, INDEX &ctMismatches)
+{
+  if (!bCompare) {
+    ray.penHit = crRay.cr_penHit;
+    ray.pbpoHit = crRay.cr_pbpoBrushPolygon;
+    ray.fHitDistance = crRay.cr_fHitDistance;
+
+  } else if (ray.penHit != crRay.cr_penHit || ray.pbpoHit != crRay.cr_pbpoBrushPolygon
+          || ray.fHitDistance != crRay.cr_fHitDistance) {
+    ctMismatches++;
+  }
+}
+
+// [Cecil] Cast all benchmark rays and return time spent in seconds
+static DOUBLE CastBenchmarkRays(CWorld *pwo, CStaticArray<BenchmarkRay_t> &aRays, BOOL bCompare, INDEX &ctMismatches)
+{
+  CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+
+  for (INDEX iRay = 0; iRay < aRays.Count(); iRay++) {
+    BenchmarkRay_t &ray = aRays[iRay];
+
+    CCastRay crRay(ray.penOrigin, ray.vOrigin, ray.vTarget);
+    crRay.cr_ttHitModels = CCastRay::TT_COLLISIONBOX;
+    pwo->CastRay(crRay);
+
+    CheckBenchmarkRay(ray, crRay, bCompare, ctMismatches);
+  }
+
+  return (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+}
+
+// [Cecil] Cast all benchmark rays in batches and return time spent in seconds
+static DOUBLE CastBenchmarkRaysBatched(CWorld *pwo, CStaticArray<BenchmarkRay_t> &aRays, INDEX &ctMismatches)
+{
+  // cast each spread of pellets in one batch
+  const INDEX ctBatch = BENCHMARK_SPREAD;
+  CCastRay *apcrRays[ctBatch];
+
+  CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+
+  for (INDEX iFirst = 0; iFirst < aRays.Count(); iFirst += ctBatch) {
+    const INDEX ct = Min(ctBatch, aRays.Count() - iFirst);
+
+    for (INDEX i = 0; i < ct; i++) {
+      BenchmarkRay_t &ray = aRays[iFirst + i];
+      apcrRays[i] = new CCastRay(ray.penOrigin, ray.vOrigin, ray.vTarget);
+      apcrRays[i]->cr_ttHitModels = CCastRay::TT_COLLISIONBOX;
+    }
+
+    pwo->CastRays(apcrRays, ct);
+
+    for (INDEX i = 0; i < ct; i++) {
+      CheckBenchmarkRay(aRays[iFirst + i], *apcrRays[i], TRUE, ctMismatches);
+      delete apcrRays[i];
+    }
+  }
+
+  return (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+}
+
+// [Cecil] Cast the same random rays through the current world with and without polygon trees
+void BenchmarkRayCasts(INDEX ctRays)
+{
+  CWorld *pwo = _pwoCurrentWorld;
+
+  if (pwo == NULL) {
+    CPrintF(TRANS("No world is currently loaded!\n"));
+    return;
+  }
+
+  ctRays = Clamp(ctRays, (INDEX)1, (INDEX)1000000);
+
+  // gather entities inside sectors that rays can be cast from
+  CDynamicContainer<CEntity> cenOrigins;
+
+  {FOREACHINDYNAMICCONTAINER(pwo->wo_cenEntities, CEntity, iten) {
+    if (iten->en_RenderType != CEntity::RT_BRUSH && iten->en_RenderType != CEntity::RT_FIELDBRUSH
+     && !iten->en_rdSectors.IsEmpty()) {
+      cenOrigins.Add(iten);
+    }
+  }}
+
+  if (cenOrigins.Count() == 0) {
+    CPrintF(TRANS("No entities to cast rays from!\n"));
+    return;
+  }
+
+  // generate rays from a fixed seed in spreads of pellets from the same entity,
+  // every other spread being cast through the whole world
+  CStaticArray<BenchmarkRay_t> aRays;
+  aRays.New(ctRays);
+
+  ULONG ulSeed = 0x5EED;
+  CEntity *pen = NULL;
+  ANGLE aSpreadH = 0.0f;
+  ANGLE aSpreadP = 0.0f;
+
+  for (INDEX iRay = 0; iRay < ctRays; iRay++) {
+    BenchmarkRay_t &ray = aRays[iRay];
+
+    // start a new spread
+    if (iRay % BENCHMARK_SPREAD == 0) {
+      pen = cenOrigins.Pointer((NextRandomSeed(ulSeed) >> 8) % cenOrigins.Count());
+
+      aSpreadH = ((NextRandomSeed(ulSeed) >> 8) & 0xFFFF) / FLOAT(0xFFFF) * 360.0f;
+      aSpreadP = ((NextRandomSeed(ulSeed) >> 8) & 0xFFFF) / FLOAT(0xFFFF) * 160.0f - 80.0f;
+    }
+
+    // scatter pellets within a few degrees
+    const ANGLE aH = aSpreadH + ((NextRandomSeed(ulSeed) >> 8) & 0xFFFF) / FLOAT(0xFFFF) * 10.0f - 5.0f;
+    const ANGLE aP = aSpreadP + ((NextRandomSeed(ulSeed) >> 8) & 0xFFFF) / FLOAT(0xFFFF) * 10.0f - 5.0f;
+
+    FLOAT3D vDirection;
+    AnglesToDirectionVector(ANGLE3D(aH, aP, 0), vDirection);
+
+    ray.penOrigin = ((iRay / BENCHMARK_SPREAD) & 1) ? NULL : pen;
+    ray.vOrigin = pen->en_plPlacement.pl_PositionVector;
+    ray.vTarget = ray.vOrigin + vDirection * 500.0f;
+  }
+
+  const INDEX bOldTrees = wld_bRayCastTrees;
+  INDEX ctMismatches = 0;
+
+  // build all trees beforehand to measure only the queries
+  wld_bRayCastTrees = TRUE;
+  CastBenchmarkRays(pwo, aRays, FALSE, ctMismatches);
+
+  wld_bRayCastTrees = FALSE;
+  const DOUBLE dLinear = CastBenchmarkRays(pwo, aRays, FALSE, ctMismatches);
+
+  wld_bRayCastTrees = TRUE;
+  const DOUBLE dTrees = CastBenchmarkRays(pwo, aRays, TRUE, ctMismatches);
+  const DOUBLE dBatched = CastBenchmarkRaysBatched(pwo, aRays, ctMismatches);
+
+  wld_bRayCastTrees = bOldTrees;
+
+  CPrintF(TRANS("Cast %d rays from %d entities:\n"), ctRays, cenOrigins.Count());
+  CPrintF(TRANS("  without polygon trees: %.2f ms (%.2f us per ray)\n"), dLinear * 1000.0, dLinear * 1e6 / ctRays);
+  CPrintF(TRANS("  with polygon trees:    %.2f ms (%.2f us per ray)\n"), dTrees * 1000.0, dTrees * 1e6 / ctRays);
+  CPrintF(TRANS("  in batches of rays:    %.2f ms (%.2f us per ray)\n"), dBatched * 1000.0, dBatched * 1e6 / ctRays);
+  CPrintF(TRANS("  mismatching results: %d\n"), ctMismatches);
+}
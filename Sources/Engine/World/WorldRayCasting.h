@@ -40,6 +40,7 @@ public:
   ULONG cr_ulPassablePolygons;          // flags mask for pass-through testing
   CBrushPolygon *cr_pbpoIgnore;         // polygon that is origin of the continuted ray (is never hit by the ray)
   CEntity *cr_penIgnore;                // entity that is origin of the continuted ray (is never hit by the ray)
+  INDEX cr_iPacketRay;                  // [Cecil] index of the ray in a packet that's being cast (-1 if cast alone)
 
   /* Internal construction helper. */
   void Init(CEntity *penOrigin, const FLOAT3D &vOrigin, const FLOAT3D &vTarget);
@@ -64,13 +65,19 @@ public:
   /* Test against a terrain */
   void TestTerrain(CEntity *penTerrain);
 
+  /* Test against a brush polygon. */
+  void TestBrushPolygon(CBrushSector *pbscSector, CBrushPolygon &bpoPolygon);
   /* Test against a brush sector. */
   void TestBrushSector(CBrushSector *pbscSector);
 
+  /* Test one entity of the world against ray. */
+  void TestWorldEntity(CEntity *penInWorld);
   /* Test entire world against ray. */
   void TestWholeWorld(CWorld *pwoWorld);
   /* Test active sectors recusively. */
   void TestThroughSectors(void);
+  /* [Cecil] Test one entity from an active sector against ray. */
+  void TestSectorEntity(CEntity *pen);
   
 
 public:
@@ -109,6 +116,11 @@ public:
   CCastRay(CEntity *penOrigin, const FLOAT3D &vOrigin, const FLOAT3D &vTarget);
   ~CCastRay(void);
 
+  /* Prepare the ray for testing. */
+  void BeginCast(void);
+  /* Finish testing the ray. */
+  void EndCast(void);
+
   /* Do the ray casting. */
   void Cast(CWorld *pwoWorld);
   /* Continue cast. */
@@ -24,6 +24,32 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 static CListHead _lhOpen;
 static CListHead _lhClosed;
 
+// [Cecil] Navigation markers gathered from one world sector
+struct SectorMarkers_t {
+  INDEX iFirst; // first marker in _apnmSectorMarkers (-1 if not gathered yet)
+  INDEX ct; // amount of markers
+
+  inline void Clear(void) {};
+};
+
+// [Cecil] Path found from one marker to another
+struct CachedPath_t {
+  CNavigationMarker *pnmSrc;
+  CNavigationMarker *pnmDst;
+  CNavigationMarker *pnmNext; // first marker after the source or NULL if there's no path
+
+  inline void Clear(void) {};
+};
+
+// [Cecil] Navigation data that is valid only during one tick
+static CWorld *_pwoCached = NULL;
+static TICK _tckCachedGame = -1;
+static TICK _tckCachedReal = -1;
+
+static CStaticArray<SectorMarkers_t> _asmSectors; // per sector index in the world
+static CStaticStackArray<CNavigationMarker *> _apnmSectorMarkers;
+static CStaticStackArray<CachedPath_t> _acpPaths;
+
 FLOAT NodeDistance(CPathNode *ppn0, CPathNode *ppn1)
 {
   return (
@@ -193,6 +219,70 @@ static void ClearPath(CEntity *penThis)
 #endif
 }
 
+// [Cecil] Reset navigation data cached for another tick or another world
+static void ValidateNavigationCache(CWorld *pwo)
+{
+  // real time is also checked so the data can't survive a world change that restarts game ticks
+  const TICK tckGame = _pTimer->GetGameTick();
+  const TICK tckReal = _pTimer->GetRealTime();
+
+  if (pwo == _pwoCached && tckGame == _tckCachedGame && tckReal == _tckCachedReal) {
+    return;
+  }
+
+  _pwoCached = pwo;
+  _tckCachedGame = tckGame;
+  _tckCachedReal = tckReal;
+
+  _acpPaths.PopAll();
+  _apnmSectorMarkers.PopAll();
+
+  // mark all sectors as not gathered yet
+  const INDEX ctSectors = pwo->wo_baBrushes.ba_apbsc.Count();
+
+  if (_asmSectors.Count() != ctSectors) {
+    _asmSectors.Clear();
+    if (ctSectors > 0) _asmSectors.New(ctSectors);
+  }
+
+  for (INDEX iSector = 0; iSector < ctSectors; iSector++) {
+    _asmSectors[iSector].iFirst = -1;
+    _asmSectors[iSector].ct = 0;
+  }
+}
+
+// [Cecil] Get range of navigation markers in a sector, gathering them on first use during the tick
+static void GetSectorMarkers(CBrushSector *pbsc, INDEX &iFirst, INDEX &ct)
+{
+  // check if the sector can be found in the index
+  const CStaticArray<CBrushSector *> &apbsc = _pwoCached->wo_baBrushes.ba_apbsc;
+  const INDEX iSector = pbsc->bsc_iInWorld;
+  const BOOL bIndexed = (iSector >= 0 && iSector < apbsc.Count() && apbsc[iSector] == pbsc);
+
+  // already gathered
+  if (bIndexed && _asmSectors[iSector].iFirst >= 0) {
+    iFirst = _asmSectors[iSector].iFirst;
+    ct = _asmSectors[iSector].ct;
+    return;
+  }
+
+  // gather navigation markers in the same order as they are in the sector
+  iFirst = _apnmSectorMarkers.Count();
+
+  {FOREACHDSTOFSRC(pbsc->bsc_rsEntities, CEntity, en_rdSectors, pen)
+    if (IsOfClass(pen, "NavigationMarker")) {
+      _apnmSectorMarkers.Push() = (CNavigationMarker *)pen;
+    }
+  ENDFOR}
+
+  ct = _apnmSectorMarkers.Count() - iFirst;
+
+  if (bIndexed) {
+    _asmSectors[iSector].iFirst = iFirst;
+    _asmSectors[iSector].ct = ct;
+  }
+}
+
 // find marker closest to a given position
 static void FindClosestMarker(
     CEntity *penThis, const FLOAT3D &vSrc, CEntity *&penMarker, FLOAT3D &vPath)
@@ -201,12 +291,13 @@ static void FindClosestMarker(
   FLOAT fMinDist = UpperLimit(0.0f);
   // for each sector this entity is in
   {FOREACHSRCOFDST(penThis->en_rdSectors, CBrushSector, bsc_rsEntities, pbsc)
+    // [Cecil] Get navigation markers in that sector from the index
+    INDEX iFirstMarker, ctMarkers;
+    GetSectorMarkers(pbsc, iFirstMarker, ctMarkers);
+
     // for each navigation marker in that sector
-    {FOREACHDSTOFSRC(pbsc->bsc_rsEntities, CEntity, en_rdSectors, pen)
-      if (!IsOfClass(pen, "NavigationMarker")) {
-        continue;
-      }
-      CNavigationMarker &nm = (CNavigationMarker&)*pen;
+    for (INDEX iMarker = iFirstMarker; iMarker < iFirstMarker + ctMarkers; iMarker++) {
+      CNavigationMarker &nm = *_apnmSectorMarkers[iMarker];
 
       // get distance from source
       FLOAT fDist = (vSrc-nm.GetPlacement().pl_PositionVector).Length();
@@ -216,7 +307,7 @@ static void FindClosestMarker(
         fMinDist = fDist;
         pnmMin = &nm;
       }
-    ENDFOR}
+    }
   ENDFOR}
 
   // if none found
@@ -235,6 +326,8 @@ static void FindClosestMarker(
 // find first marker for path navigation
 void PATH_FindFirstMarker(CEntity *penThis, const FLOAT3D &vSrc, const FLOAT3D &vDst, CEntity *&penMarker, FLOAT3D &vPath)
 {
+  ValidateNavigationCache(penThis->en_pwoWorld);
+
   // find closest markers to source and destination positions
   CNavigationMarker *pnmSrc;
   FLOAT3D vSrcPath;
@@ -256,9 +349,53 @@ void PATH_FindFirstMarker(CEntity *penThis, const FLOAT3D &vSrc, const FLOAT3D &
   penMarker = pnmSrc;
 }
 
+// [Cecil] Find the first marker after the source marker on the shortest path to the destination
+static CNavigationMarker *FindNextOnPath(CEntity *penThis, CNavigationMarker *pnmSrc, CNavigationMarker *pnmDst)
+{
+  // reuse path that has already been found during this tick
+  for (INDEX iPath = 0; iPath < _acpPaths.Count(); iPath++) {
+    const CachedPath_t &cp = _acpPaths[iPath];
+
+    if (cp.pnmSrc == pnmSrc && cp.pnmDst == pnmDst) {
+      return cp.pnmNext;
+    }
+  }
+
+  CNavigationMarker *pnmNext = NULL;
+
+  // try to find shortest path to the destination
+  BOOL bFound = FindPath(pnmSrc, pnmDst);
+
+  // if not found
+  if (!bFound) {
+    // just clean up
+    delete pnmDst->GetPathNode();
+
+  } else {
+    // find the first marker position after current
+    CPathNode *ppn = pnmDst->GetPathNode();
+    while (ppn->pn_ppnParent!=NULL && ppn->pn_ppnParent->pn_pnmMarker!=pnmSrc) {
+      ppn = ppn->pn_ppnParent;
+    }
+    pnmNext = ppn->pn_pnmMarker;
+  }
+
+  // clean up
+  ClearPath(penThis);
+
+  CachedPath_t &cpNew = _acpPaths.Push();
+  cpNew.pnmSrc = pnmSrc;
+  cpNew.pnmDst = pnmDst;
+  cpNew.pnmNext = pnmNext;
+
+  return pnmNext;
+}
+
 // find next marker for path navigation
 void PATH_FindNextMarker(CEntity *penThis, const FLOAT3D &vSrc, const FLOAT3D &vDst, CEntity *&penMarker, FLOAT3D &vPath)
 {
+  ValidateNavigationCache(penThis->en_pwoWorld);
+
   // find closest marker to destination position
   CNavigationMarker *pnmDst;
   FLOAT3D vDstPath;
@@ -272,29 +409,19 @@ void PATH_FindNextMarker(CEntity *penThis, const FLOAT3D &vSrc, const FLOAT3D &v
     return;
   }
 
-  // try to find shortest path to the destination
-  BOOL bFound = FindPath((CNavigationMarker*)penMarker, pnmDst);
+  // [Cecil] Find shortest path to the destination or reuse it from this tick
+  CNavigationMarker *pnmNext = FindNextOnPath(penThis, (CNavigationMarker*)penMarker, pnmDst);
 
   // if not found
-  if (!bFound) {
-    // just clean up and fail
-    delete pnmDst->GetPathNode();
-    ClearPath(penThis);
+  if (pnmNext == NULL) {
+    // fail
     penMarker = NULL;
     vPath = vSrc;
     return;
   }
 
-  // find the first marker position after current
-  CPathNode *ppn = pnmDst->GetPathNode();
-  while (ppn->pn_ppnParent!=NULL && ppn->pn_ppnParent->pn_pnmMarker!=penMarker) {
-    ppn = ppn->pn_ppnParent;
-  }
-  penMarker = ppn->pn_pnmMarker;
+  penMarker = pnmNext;
 
   // go there
   vPath = penMarker->GetPlacement().pl_PositionVector;
-
-  // clean up
-  ClearPath(penThis);
 }